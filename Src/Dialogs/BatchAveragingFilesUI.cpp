@@ -16,6 +16,7 @@ limitations under the License.
 
 #include    <owl/pch.h>
 
+#include    "Strings.Utils.h"
 #include    "Files.TGoF.h"
 #include    "Dialogs.Input.h"
 
@@ -201,27 +202,48 @@ if ( tg.allrisv ) {
     }
 
 
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Scalar case can also compute the robust stats, which need all files at once, within some memory bound
+bool                scalaraveraging     = tg.alleeg || ( tg.allris && ( ! tg.allrisv || risvtos ) );
+bool                robuststats         = false;
+int                 robustmemory        = (int) ( BatchAveragingRobustMemory / MegaByte );
+
+
+if ( scalaraveraging ) {
+
+    robuststats = GetAnswerFromUser ( "Do you also want the Median and MAD?", BatchAveragingTitle );
+
+    if ( robuststats ) {
+
+        if ( ! GetValueFromUser ( "Memory bound for the Median and MAD, in [MB]:", BatchAveragingTitle, robustmemory, IntegerToString ( robustmemory ) ) )
+            return;
+
+        Maxed ( robustmemory, 1 );
+        }
+    }
+
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 TFileName           meanfile;
 //TFileName         nmeanfile;
 TFileName           sdfile;
 //TFileName         snrfile;
-//TFileName         medianfile;
-//TFileName         madfile;
+TFileName           medianfile;
+TFileName           madfile;
 //TFileName         sphmeanfile;
 TFileName           sphsdfile;
 //TFileName         sphsnrfile;
 
 
-if      (   tg.alleeg 
                                         // Vectorial to scalar ris is also done here
-       || ( tg.allris && ( ! tg.allrisv || risvtos ) ) )    BatchAveragingScalar        (   gof,
+if      ( scalaraveraging )                                 BatchAveragingScalar        (   gof,
                                                                                             meanfile,           sdfile,             0,
-                                                                                            0,                  0,
+                                                                                            robuststats ? (char*) medianfile : 0,   robuststats ? (char*) madfile : 0,
 //                                                                                          meanfile,           sdfile,             snrfile,
 //                                                                                          medianfile,   madfile,
-                                                                                            true,               true
+                                                                                            true,               true,
+                                                                                            (size_t) robustmemory * MegaByte
                                                                                         );
 else if   ( tg.allrisv ) {
 
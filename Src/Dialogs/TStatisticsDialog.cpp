@@ -3226,6 +3226,8 @@ TFileName           VerbFile;
 TFileName           TFile;
 TFileName           DFile;
 TFileName           PFile;
+TFileName           PMaxStatFile;
+TFileName           PClusterMassFile;
 TFileName           TDataFile;
 TFileName           DDataFile;
 TFileName           PDataFile;
@@ -3274,6 +3276,8 @@ for ( int proci = 0; proci < numprocessings; proci++ ) {
     bool                exporttfile     = ! iscsvfile /*( writenumtf > 1 )*/ && IsTTest         ( processing ); // t values exist
     bool                exportdfile     = ! iscsvfile /*( writenumtf > 1 )*/ && IsRandomization ( processing ); // t values don't exist, use the average of differences instead
     bool                exportpfile     = ! iscsvfile /*( writenumtf > 1 )*/;
+                                            // randomization also provides max-statistic and cluster-mass corrected p-values
+    bool                exportpcorrfile = exportpfile && IsRandomization ( processing );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -3334,6 +3338,8 @@ for ( int proci = 0; proci < numprocessings; proci++ ) {
     StringCopy      ( TFile,         BaseFileName,       ".", InfixT,     ".",   ext             );
     StringCopy      ( DFile,         BaseFileName,       ".", InfixDelta, ".",   ext             ); // can duplicate the intermediate files Mean.Delta or Delta.Mean
     StringCopy      ( PFile,         BaseFileName,       ".", PValueName, ".",   ext             );
+    StringCopy      ( PMaxStatFile,     BaseFileName,    ".", PValueName, "." InfixMaxStat     ".",   ext );
+    StringCopy      ( PClusterMassFile, BaseFileName,    ".", PValueName, "." InfixClusterMass ".",   ext );
     StringCopy      ( TDataFile,     BaseFileName,       ".", InfixT,     ".",   FILEEXT_DATA    );
     StringCopy      ( DDataFile,     BaseFileName,       ".", InfixDelta, ".",   FILEEXT_DATA    );
     StringCopy      ( PDataFile,     BaseFileName,       ".", PValueName, ".",   FILEEXT_DATA    );
@@ -3502,6 +3508,13 @@ for ( int proci = 0; proci < numprocessings; proci++ ) {
         verbose.Put ( "p file:",            buff );
         }
 
+    if ( exportpcorrfile ) {
+        StringCopy ( buff, GroupBaseFileName, ".", PValueName, "." InfixMaxStat     ".",   IsFreqLoop () ? FILEEXT_FREQ : ext );
+        verbose.Put ( "Max-statistic corrected p file:",    buff );
+        StringCopy ( buff, GroupBaseFileName, ".", PValueName, "." InfixClusterMass ".",   IsFreqLoop () ? FILEEXT_FREQ : ext );
+        verbose.Put ( "Cluster-mass corrected p file:",     buff );
+        }
+
     if ( iscsvfile ) {
         if ( IsTTest         ( processing ) )   verbose.Put ( "t values transposed in a Data file:", TDataFile );
         if ( IsRandomization ( processing ) )   verbose.Put ( "Delta values transposed in a Data file:", DDataFile );
@@ -3673,6 +3686,8 @@ for ( int proci = 0; proci < numprocessings; proci++ ) {
     TExportTracks*      expt        = exporttfile ? new TExportTracks : 0;
     TExportTracks*      expd        = exportdfile ? new TExportTracks : 0;
     TExportTracks*      expp        = exportpfile ? new TExportTracks : 0;
+    TExportTracks*      exppmax     = exportpcorrfile ? new TExportTracks : 0;
+    TExportTracks*      exppcluster = exportpcorrfile ? new TExportTracks : 0;
 
 
     int                 writenumvars    = IsTAnova ( processing ) ? 1 : numvars;
@@ -3729,9 +3744,41 @@ for ( int proci = 0; proci < numprocessings; proci++ ) {
         }
 
 
+    if ( exppmax ) {
+
+        StringCopy ( exppmax->Filename, PMaxStatFile );
+
+        exppmax->NumTracks             = writenumvars;
+        exppmax->NumTime               = writenumtf;
+        exppmax->SamplingFrequency     = samplfreq;
+        exppmax->MaxValue              = 1.0;
+
+        if ( outputvarnames )       exppmax->ElectrodesNames   = VarNames;
+
+        exppmax->Begin ();
+        }
+
+
+    if ( exppcluster ) {
+
+        StringCopy ( exppcluster->Filename, PClusterMassFile );
+
+        exppcluster->NumTracks             = writenumvars;
+        exppcluster->NumTime               = writenumtf;
+        exppcluster->SamplingFrequency     = samplfreq;
+        exppcluster->MaxValue              = 1.0;
+
+        if ( outputvarnames )       exppcluster->ElectrodesNames   = VarNames;
+
+        exppcluster->Begin ();
+        }
+
+
     if ( expt && expt->IsFileTextual () )   (ofstream&) (*expt)    << StreamFormatLeft;
     if ( expd && expd->IsFileTextual () )   (ofstream&) (*expd)    << StreamFormatLeft;
     if ( expp && expp->IsFileTextual () )   (ofstream&) (*expp)    << StreamFormatLeft;
+    if ( exppmax     && exppmax    ->IsFileTextual () )   (ofstream&) (*exppmax    )    << StreamFormatLeft;
+    if ( exppcluster && exppcluster->IsFileTextual () )   (ofstream&) (*exppcluster)    << StreamFormatLeft;
 
 
     for ( int tf0 = 0; tf0 < writenumtf;   tf0++ )
@@ -3745,12 +3792,17 @@ for ( int proci = 0; proci < numprocessings; proci++ ) {
         if ( expt )     expt->Write ( t   );
         if ( expd )     expd->Write ( avg );
         if ( expp )     expp->Write ( p   );
+
+        if ( exppmax     )  exppmax    ->Write ( Format_p_value ( Results[ 2 ] ( tf0, v, Test_p_value_MaxStat     ), outputp, thresholdingpvalues, pvaluesthreshold ) );
+        if ( exppcluster )  exppcluster->Write ( Format_p_value ( Results[ 2 ] ( tf0, v, Test_p_value_ClusterMass ), outputp, thresholdingpvalues, pvaluesthreshold ) );
         } // for variable, tf
 
 
     if ( expt )     delete expt;
     if ( expd )     delete expd;
     if ( expp )     delete expp;
+    if ( exppmax     )  delete exppmax;
+    if ( exppcluster )  delete exppcluster;
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -4126,6 +4178,13 @@ for ( int proci = 0; proci < numprocessings; proci++ ) {
 
                                         // merge logp
         sprintf ( (char*) templ, "%s\\*." InfixLogP     ".%s", (char*) dir, ext );
+        MergeTracksToFreqFiles ( templ, FreqType );
+
+                                        // merge max-statistic and cluster-mass corrected p's
+        sprintf ( (char*) templ, "%s\\*." InfixMaxStat     ".%s", (char*) dir, ext );
+        MergeTracksToFreqFiles ( templ, FreqType );
+
+        sprintf ( (char*) templ, "%s\\*." InfixClusterMass ".%s", (char*) dir, ext );
         MergeTracksToFreqFiles ( templ, FreqType );
 
                                         // merge t
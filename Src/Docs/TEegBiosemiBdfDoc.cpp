@@ -45,6 +45,7 @@ MaxSamplesPerBlock  = 0;
 BlockSize           = 0;
 
 NumElectrodesInFile = 0;
+RecordsCacheClock   = 0;
 }
 
 
@@ -800,6 +801,40 @@ Gains  .Resize ( NumElectrodes );
 Offsets.Resize ( NumElectrodes );
 
 
+Record          .Resize ( BlockSize );
+ChannelsOffset  .Resize ( NumElectrodesInFile );
+
+ChannelsOffset[ 0 ]         = 0;
+
+for ( int el = 1; el < NumElectrodesInFile; el++ )
+    ChannelsOffset[ el ]    = ChannelsOffset[ el - 1 ] + ChannelsSampling[ el - 1 ].ChannelSize;
+
+                                        // channels can have lower sampling rates than the max one, computing once which sample goes to which time frame
+ResamplingIndexes.Resize ( NumElectrodes, MaxSamplesPerBlock );
+
+double              mspb1           = MaxSamplesPerBlock - 1;   // !converted to double!
+
+for ( int el  = 0; el  < NumElectrodes;      el++  )
+for ( int tf0 = 0; tf0 < MaxSamplesPerBlock; tf0++ )
+
+    ResamplingIndexes ( el, tf0 )   = mspb1 == 0 ? 0 : Round ( ( tf0 / mspb1 ) * ( ChannelsSampling[ el ].SamplesPerBlock - 1 ) );
+
+                                        // as many decoded records as the memory budget allows - none if a single record is already too big
+size_t              recordmemory    = (size_t) NumElectrodes * MaxSamplesPerBlock * sizeof ( float );
+int                 numslots        = recordmemory == 0 ? 0 : (int) min ( BdfRecordsCacheMaxMemory / recordmemory, (size_t) BdfRecordsCacheMaxRecords );
+
+if ( numslots > 0 )
+    RecordsCache.Resize ( numslots, NumElectrodes, MaxSamplesPerBlock );
+else
+    RecordsCache.DeallocateMemory ();
+
+RecordsCacheBlock   .Resize ( numslots );
+RecordsCacheUse     .Resize ( numslots );
+RecordsCacheBlock   = -1;
+RecordsCacheUse     = 0;
+RecordsCacheClock   = 0;
+
+
 ElectrodesNames.Set ( TotalElectrodes, ElectrodeNameSize );
 
 for ( int i = 1; i <= NumElectrodes; i++ )
@@ -821,84 +856,143 @@ return true;
 
 
 //----------------------------------------------------------------------------
-void    TEegBiosemiBdfDoc::ReadRawTracks ( long tf1, long tf2, TArray2<float> &buff, int tfoffset )
+                                        // BDF samples are 24 bits little endian: loading them in the upper 3 bytes, then an arithmetic shift does the sign extension
+inline  int     Bdf24To32 ( const UCHAR* p )
 {
-int                 blockmax        = tf2 / MaxSamplesPerBlock;
-double              mspb1           = MaxSamplesPerBlock - 1;   // !converted to double!
+return  (int) ( (UINT) p[ 0 ] << 8 | (UINT) p[ 1 ] << 16 | (UINT) p[ 2 ] << 24 ) >> 8;
+}
 
 
-                                        // loop through all blocks
-for ( int   block           = tf1 / MaxSamplesPerBlock,
-            firsttfinblock  = tf1 % MaxSamplesPerBlock,
-            firsttf         = tf1;   
-                block <= blockmax;
-                    block++,
-                    tfoffset       += MaxSamplesPerBlock - firsttfinblock,
-                    firsttfinblock  = 0,
-                    firsttf         = block * MaxSamplesPerBlock ) {
+//----------------------------------------------------------------------------
+                                        // Reading a whole data record in a single I/O
+void    TEegBiosemiBdfDoc::ReadRecord ( int block )
+{
+InputStream->seekg ( DataOrg + (LONGLONG) block * BlockSize );
 
-                                        // max number of tf to be read in this block
-    int     numtfinblock    = MaxSamplesPerBlock - firsttfinblock;
-                                        // origin of next full track to be read
-//  long    nextelpos       = DataOrg + block * BlockSize;
-//  int     tfremainingread = tf2 - firsttf + 1;
+InputStream->read  ( (char*) Record.GetArray (), BlockSize );
+}
 
-                                        // read a whole block at once
-    InputStream->seekg ( DataOrg + block * BlockSize );
 
-                                        // within a single block, values for a given track are consecutives
-    TEegBdfChannel*     toch    = ChannelsSampling;
+//----------------------------------------------------------------------------
+                                        // Decoding numtf time frames of a channel from the current Record, converting to physical values and upsampling if needed
+void    TEegBiosemiBdfDoc::DecodeChannel ( int el, int firsttfinblock, int numtf, float* toB )
+{
+const UCHAR*        toR             = Record.GetArray () + ChannelsOffset[ el ];
+double              gain            = Gains  [ el ];
+double              offset          = Offsets[ el ];
+int                 cellsize        = CellSize ( FileType );
 
-    for ( int el = 0; el < NumElectrodes; el++, toch++ ) {
-                                        // get that channel length
-        int     spb1        = toch->SamplesPerBlock - 1;
-                                        // get the complete line for this electrode
-        InputStream->read ( (char*) Tracks.GetArray (), toch->ChannelSize );
+                                        // channel at full sampling rate: straight, contiguous decoding loops
+if ( ChannelsSampling[ el ].SamplesPerBlock == MaxSamplesPerBlock ) {
 
-                                        // taken from EGI MFF, but there seems to be a problem for the first TFs to be read...
-/*                                        // optimal jump to where data are
-        InputStream->seekg ( nextelpos + firsttfinblock * CellSize ( FileType ), ios::beg );
-                                        // so that we can read the min # of data: min of remaining block or remaining data
-        uint    tfminread   = min ( toch->SamplesPerBlock - firsttfinblock, tfremainingread );
-                                        // still put the data at offset position
-        InputStream->read ( &Tracks[ firsttfinblock * CellSize ( FileType ), tfminread * CellSize ( FileType ) ] );
-                                        // next channel beginning
-        nextelpos          += toch->ChannelSize;
-*/
+    toR    += firsttfinblock * cellsize;
 
+    if ( IsEdf ( FileType ) ) {
 
-        if ( IsEdf ( FileType ) ) {
+        const short*        toS             = (const short*) toR;
 
-            for ( int tfi = firsttf, tf0 = 0; tfi <= tf2 && tf0 < numtfinblock; tfi++, tf0++ ) {
+        for ( int tf0 = 0; tf0 < numtf; tf0++ )
+            toB[ tf0 ]  = toS[ tf0 ] * gain + offset;
+        }
+    else
+        for ( int tf0 = 0; tf0 < numtf; tf0++, toR += 3 )
+            toB[ tf0 ]  = Bdf24To32 ( toR ) * gain + offset;
+    }
 
-                short*  toS     = (short*) Tracks.GetArray () + Round ( ( ( firsttfinblock + tf0 ) / mspb1 ) * spb1 );
+else {                                  // lower sampling rate: repeating samples through the resampling indexes
+    const int*          toI             = &ResamplingIndexes ( el, firsttfinblock );
 
-                buff ( el, tfoffset + tf0 )  = *toS * Gains[ el ] + Offsets[ el ];
+    if ( IsEdf ( FileType ) ) {
 
-//              if ( buff ( el, tfoffset + tf0 )    == -MAXSHORT-1 )    buff ( el, tfoffset + tf0 ) = 0;
-                } // for tfi
-            } // if Edf
+        const short*        toS             = (const short*) toR;
 
-        else { // Bdf
+        for ( int tf0 = 0; tf0 < numtf; tf0++ )
+            toB[ tf0 ]  = toS[ toI[ tf0 ] ] * gain + offset;
+        }
+    else
+        for ( int tf0 = 0; tf0 < numtf; tf0++ )
+            toB[ tf0 ]  = Bdf24To32 ( toR + 3 * toI[ tf0 ] ) * gain + offset;
+    }
+}
 
-            for ( int tfi = firsttf, tf0 = 0; tfi <= tf2 && tf0 < numtfinblock; tfi++, tf0++ ) {
 
-                UCHAR*  toT     = &Tracks[ 3 * Round ( ( ( firsttfinblock + tf0 ) / mspb1 ) * spb1 ) ];
+//----------------------------------------------------------------------------
+                                        // Returns the cache slot holding the given decoded record, reading and decoding it into the least recently used slot if needed
+int     TEegBiosemiBdfDoc::GetDecodedRecord ( int block )
+{
+int                 numslots        = RecordsCacheBlock.GetDim ();
+int                 lruslot         = 0;
+
+RecordsCacheClock++;
+
+for ( int slot = 0; slot < numslots; slot++ ) {
+
+    if ( RecordsCacheBlock[ slot ] == block ) {
+
+        RecordsCacheUse[ slot ] = RecordsCacheClock;
+
+        return  slot;
+        }
+
+    if ( RecordsCacheUse[ slot ] < RecordsCacheUse[ lruslot ] )
+        lruslot     = slot;
+    }
+
+
+ReadRecord ( block );
+
+for ( int el = 0; el < NumElectrodes; el++ )
+
+    DecodeChannel ( el, 0, MaxSamplesPerBlock, &RecordsCache ( lruslot, el, 0 ) );
+
+
+RecordsCacheBlock[ lruslot ]    = block;
+RecordsCacheUse  [ lruslot ]    = RecordsCacheClock;
+
+return  lruslot;
+}
+
+
+//----------------------------------------------------------------------------
+void    TEegBiosemiBdfDoc::ReadRawTracks ( long tf1, long tf2, TArray2<float> &buff, int tfoffset )
+{
+int                 blockmax        = tf2 / MaxSamplesPerBlock;
+bool                usecache        = RecordsCache.IsAllocated ();
+
+                                        // loop through all blocks
+for ( int   block           = tf1 / MaxSamplesPerBlock,
+            firsttfinblock  = tf1 % MaxSamplesPerBlock,
+            firsttf         = tf1;   
+                block <= blockmax;
+                    block++,
+                    tfoffset       += MaxSamplesPerBlock - firsttfinblock,
+                    firsttfinblock  = 0,
+                    firsttf         = block * MaxSamplesPerBlock ) {
+
+                                        // number of tf to be read in this block
+    int     numtfinblock    = min ( (long) MaxSamplesPerBlock - firsttfinblock, tf2 - firsttf + 1 );
+
 
-                long    l       = *((long *) toT);
+    if ( usecache ) {
+                                        // consecutive calls, like scrolling or processing by blocks, will hit the same records
+        int     slot            = GetDecodedRecord ( block );
 
-                toT    += 2;
+        for ( int el = 0; el < NumElectrodes; el++ )
 
-                *( ((uchar *) &l) + 3 ) = (uchar) ( ( *toT & 0x80 ) ? 0xFF : 0x00 );
-//              toT++;
+            CopyVirtualMemory ( buff[ el ] + tfoffset, &RecordsCache ( slot, el, firsttfinblock ), numtfinblock * sizeof ( float ) );
+        }
+
+    else {                              // records too big to be cached
+        ReadRecord ( block );
+
+        for ( int el = 0; el < NumElectrodes; el++ )
 
-                buff ( el, tfoffset + tf0 )  = l * Gains[ el ] + Offsets[ el ];
-                } // for tfi
-            } // if Bdf
-        } // for el
+            DecodeChannel ( el, firsttfinblock, numtfinblock, buff[ el ] + tfoffset );
+        }
     } // for block
 }
 
+
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
@@ -16,6 +16,7 @@ limitations under the License.
 
 #pragma once
 
+#include    "TArray3.h"
 #include    "TTracksDoc.h"
 
 namespace crtl {
@@ -62,6 +63,10 @@ inline int      CellSize    ( EdfType t )   { return IsEdf  ( t ) ? 2 : IsBdf (
                                         // EDF recommended max block size
 constexpr int   EdfMaxBlockSize     = 0xF000; // 61440;
 
+                                        // Decoded records kept in memory, and shared by successive reads
+constexpr size_t    BdfRecordsCacheMaxMemory    = 64 * MegaByte;
+constexpr int       BdfRecordsCacheMaxRecords   = 64;
+
 
 //----------------------------------------------------------------------------
 
@@ -95,10 +100,22 @@ protected:
     int             NumElectrodesInFile;
     TArray1<UCHAR>  Tracks;
 
+    TArray1<UCHAR>  Record;             // a whole data record, as stored in file
+    TArray1<int>    ChannelsOffset;     // position of each channel within a record
+    TArray2<int>    ResamplingIndexes;  // for each channel, index of the sample used for each of the MaxSamplesPerBlock time frames
+
+    TArray3<float>  RecordsCache;       // LRU cache of decoded records: [slot][electrode][time frame within record]
+    TArray1<int>    RecordsCacheBlock;  // record held by each slot, -1 if none
+    TArray1<UINT>   RecordsCacheUse;    // last access to each slot
+    UINT            RecordsCacheClock;
+
 
     bool            SetArrays           ()  final;
     void            ReadNativeMarkers   ()  final;
     int             GetTrailingSize     ();
+    void            ReadRecord          ( int block );
+    void            DecodeChannel       ( int el, int firsttfinblock, int numtf, float* toB );
+    int             GetDecodedRecord    ( int block );
     static int      GetTrailingSize     ( const char* file, int BlockSize, int MaxSamplesPerBlock, EdfType FileType, const TArray1<TEegBdfChannel>& ChannelsSampling );
 };
 
@@ -42,7 +42,8 @@ BuffSize            = 0;
 
 bool    TEegCartoolSefDoc::Close ()
 {
-FileStream.Close ();
+FileStream .Close ();
+FileMapping.Close ();
 
 return  TFileDocument::Close ();
 }
@@ -166,6 +167,15 @@ if ( GetDocPath () ) {
         }
 
 
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // map the whole file, data will then be paged in on demand and shared with any other reader
+                                        // still keeping FileStream opened as a fall-back in case mapping fails
+    if ( FileMapping.Open ( GetDocPath () )
+      && FileMapping.GetSize () < DataOrg + (LONGLONG) BuffSize * NumTimeFrames )
+                                        // truncated file, let the stream reading handle it as before
+        FileMapping.Close ();
+
+
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // search for actual auxiliary channels, which could be anywhere
     int             oldnumaux       = NumAux;
@@ -231,6 +241,15 @@ return true;
 //----------------------------------------------------------------------------
 void    TEegCartoolSefDoc::ReadRawTracks ( long tf1, long tf2, TArray2<float> &buff, int tfoffset )
 {
+                                        // zero-copy from the mapped file, no seek, no intermediate buffer
+if ( FileMapping.IsOpen () ) {
+
+    MultiplexedToTracks ( (const float*) FileMapping.GetData ( DataOrg + (LONGLONG) BuffSize * tf1 ), NumElectrodes, NumElectrodes, tf2 - tf1 + 1, buff, tfoffset );
+
+    return;
+    }
+
+
 int                 el;
 float*              toT;
 
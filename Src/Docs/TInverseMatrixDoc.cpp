@@ -630,6 +630,142 @@ else {
 }
 
 
+//----------------------------------------------------------------------------
+                                        // Batched version of MultiplyMatrix: the inverse matrix is multiplied by blocks of maps at once,
+                                        // i.e. a matrix-matrix product instead of many matrix-vector ones, so that the inverse matrix is
+                                        // streamed from memory once per block, instead of once per map.
+                                        // With  RegularizationAutoLocal, maps are first grouped by their own best regularization.
+                                        // Size of inv tells if results are vectorial or scalar, and should have been allocated by caller.
+                                        // Computation is done in single precision, or optionally in double precision.
+void    TInverseMatrixDoc::MultiplyMatrices (   int             reg,    
+                                                const TMaps&    maps,   TMaps&      inv,
+                                                bool            doubleprecision 
+                                            )   const
+{
+int                 nummaps         = maps.GetNumMaps ();
+
+if ( nummaps == 0 || inv.GetNumMaps () < nummaps )
+    return;
+
+
+bool                vectorialinverse    = IsVector ( AtomTypeUseOriginal );
+bool                vectorialresults    = inv.GetDimension () == 3 * NumSolPoints;
+int                 numlines            = GetNumLines ();
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // regularization used for each map
+TArray1<int>        mapsreg ( nummaps );
+
+if ( reg == RegularizationAutoLocal ) {
+
+    OmpParallelFor
+
+    for ( int nc = 0; nc < nummaps; nc++ )
+
+        mapsreg[ nc ]   = GetBestRegularization ( &maps[ nc ], 0, 0 );
+    }
+else
+    mapsreg     = Clip ( reg, 0, GetMaxRegularization () - 1 );
+
+
+TArray1<int>        regmaps ( nummaps );
+
+
+for ( int regi = 0; regi < GetMaxRegularization (); regi++ ) {
+                                        // all maps for current regularization
+    int                 numregmaps      = 0;
+
+    for ( int nc = 0; nc < nummaps; nc++ )
+
+        if ( mapsreg[ nc ] == regi )
+
+            regmaps[ numregmaps++ ] = nc;
+
+    if ( numregmaps == 0 )
+        continue;
+
+                                        // row-major inverse matrix can be seen as its column-major transposed, without any copy
+    const AMatrix       Mt          ( const_cast<AReal*> ( M[ regi ].GetArray () ), NumElectrodes, numlines, false, true );
+    arma::mat           Mtd;
+
+    if ( doubleprecision )
+        Mtd     = arma::conv_to<arma::mat>::from ( Mt );
+
+    int                 numblocks       = ( numregmaps + InverseMultiplyBlockSize - 1 ) / InverseMultiplyBlockSize;
+
+
+    OmpParallelBegin
+                                        // per-thread block buffers
+    AMatrix             eegblock;
+    AMatrix             invblock;
+
+    OmpFor
+
+    for ( int blocki = 0; blocki < numblocks; blocki++ ) {
+
+        int                 i1              = blocki * InverseMultiplyBlockSize;
+        int                 blocksize       = NoMore ( InverseMultiplyBlockSize, numregmaps - i1 );
+
+                                        // maps transferred as columns
+        eegblock.AResizeFast ( NumElectrodes, blocksize );
+
+        for ( int bi = 0; bi < blocksize; bi++ )
+
+            CopyVirtualMemory ( eegblock.colptr ( bi ), maps[ regmaps[ i1 + bi ] ].GetArray (), NumElectrodes * AtomSize () );
+
+                                        // results as columns, vectorial results being interleaved X,Y,Z
+        if ( doubleprecision )  invblock    = arma::conv_to<AMatrix>::from ( Mtd.t () * arma::conv_to<arma::mat>::from ( eegblock ) );
+        else                    invblock    = Mt.t () * eegblock;
+
+                                        // dispatch according to inverse and results types
+        for ( int bi = 0; bi < blocksize; bi++ ) {
+
+            const AReal*        toinv           = invblock.colptr ( bi );
+            TMap&               result          = inv[ regmaps[ i1 + bi ] ];
+
+            if      (   vectorialinverse &&   vectorialresults
+                   || ! vectorialinverse && ! vectorialresults )
+                                        // same dimensions
+                CopyVirtualMemory ( result.GetArray (), toinv, numlines * AtomSize () );
+
+            else if (   vectorialinverse && ! vectorialresults )
+                                        // inverse is vectorial, results are scalar so return the norm of vectors
+                for ( int sp = 0; sp < NumSolPoints; sp++, toinv += 3 )
+
+                    result[ sp ]    = sqrt ( Square ( toinv[ 0 ] ) + Square ( toinv[ 1 ] ) + Square ( toinv[ 2 ] ) );
+
+            else /*! vectorialinverse && vectorialresults*/
+                                        // inverse is scalar, results are vectorial so return dummy vectors ( value, 0, 0 )
+                for ( int sp = 0; sp < NumSolPoints; sp++ ) {
+
+                    result[ 3 * sp     ]    = toinv[ sp ];
+                    result[ 3 * sp + 1 ]    = 0;
+                    result[ 3 * sp + 2 ]    = 0;
+                    }
+            } // for bi
+        } // for blocki
+
+    OmpParallelEnd
+    } // for regi
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Inverse matrix times the columns [fromcol..fromcol+numcols-1] of eeg, done in one matrix-matrix product
+                                        // Results are not converted: inv has the raw inverse lines (3 per solution point if vectorial) x numcols
+void    TInverseMatrixDoc::MultiplyColumns ( int reg, const AMatrix& eeg, int fromcol, int numcols, AMatrix& inv )  const
+{
+reg     = reg == RegularizationAutoLocal ? 0 
+                                         : Clip ( reg, 0, GetMaxRegularization () - 1 );
+
+                                        // row-major inverse matrix can be seen as its column-major transposed, without any copy
+const AMatrix       Mt          ( const_cast<AReal*> ( M[ reg ].GetArray () ), NumElectrodes, GetNumLines (), false, true );
+
+inv     = Mt.t () * eeg.cols ( fromcol, fromcol + numcols - 1 );
+}
+
+
 //----------------------------------------------------------------------------
 // The real impact of  AveragingPrecedence  occurs when reading a vectorial inverse to a scalar buffer
 // otherwise the sums remain in their native dimensions, or better (scalar in a vector)
@@ -27,7 +27,14 @@ limitations under the License.
 
 namespace crtl {
 
+class       TMaps;
+
+//----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
+                                        // Number of maps multiplied at once by the inverse matrix, in the batched version
+constexpr int       InverseMultiplyBlockSize    = 256;
+
+
 //----------------------------------------------------------------------------
                                         // Base class for any inverse matrix
 
@@ -80,6 +87,10 @@ public:
     void            MultiplyMatrix ( int reg, const TArray2<float>&         eeg,    int tf, TArray1<float>&            inv )    const; 
     void            MultiplyMatrix ( int reg, const TArray2<float>&         eeg,    int tf, TArray1<TVector3Float>&    inv )    const; 
     void            MultiplyMatrix ( int reg, const AMatrix&                eeg,    int tf, TArray1<TVector3Float>&    inv )    const; 
+                                        // batched version, for a whole set of maps - results dimension tells if results are scalar or vectorial
+    void            MultiplyMatrices ( int reg, const TMaps&                maps,           TMaps&                     inv, bool doubleprecision = false )  const;
+                                        // raw inverse lines x a range of columns, f.ex. from a lead field, as a single matrix-matrix product
+    void            MultiplyColumns  ( int reg, const AMatrix&              eeg,    int fromcol, int numcols, AMatrix&     inv )    const;
 
 
 protected:
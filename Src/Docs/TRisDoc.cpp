@@ -122,6 +122,10 @@ if ( IsExtension ( safepath, FILEEXT_IS ) ) {
 else { // as other tracks / ris, can be used to convert type on the fly
 */
 
+                                        // Windows will not overwrite a file which is still mapped, so get all the data in memory first
+    ReleaseFileMapping ();
+
+
     TExportTracks     expfile;
 
     StringCopy ( expfile.Filename, safepath );
@@ -162,8 +166,27 @@ return TTracksDoc::CanClose ();
 }
 
 
+                                        // Data are not available from the file anymore, which is going to be overwritten - keeping a copy in memory
+void    TRisDoc::ReleaseFileMapping ()
+{
+std::lock_guard<std::recursive_mutex>   readinglock ( ReadingLock );
+
+if ( ! FileMapping.IsOpen () )
+    return;
+
+
+Tracks.Resize ( TotalTracks, NumTimeFrames );
+
+MultiplexedToTracks ( GetMappedTF ( 0 ), NumTracks, NumTracks, NumTimeFrames, Tracks, 0 );
+
+FileMapping.Close ();
+}
+
+
 bool	TRisDoc::Close ()
 {
+FileMapping.Close ();
+
 return  TFileDocument::Close ();
 }
 
@@ -262,10 +285,22 @@ if ( GetDocPath () ) {
                                         // NumTracks is the actual number of lines in the buffer
     NumTracks           = ( IsVector ( AtomTypeUseOriginal ) ? 3 : 1 ) * NumElectrodes;
 
+    DataOrg             = sizeof ( risheader );
+
+
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // map the whole file: opening is immediate, data is paged in on demand and shared with any other reader
+                                        // otherwise, falling back to loading everything in memory
+    if ( FileMapping.Open ( GetDocPath () )
+      && FileMapping.GetSize () < DataOrg + (LONGLONG) NumTracks * NumTimeFrames * sizeof ( float ) )
+
+        FileMapping.Close ();
+
 
     if ( ! SetArrays () ) {
 
-        FileStream.Close ();
+        FileStream .Close ();
+        FileMapping.Close ();
 
         return false;
         }
@@ -273,14 +308,17 @@ if ( GetDocPath () ) {
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // read in the values
-    TArray1<float>      onetf ( NumTracks );
+    if ( ! FileMapping.IsOpen () ) {
 
-    for ( int tf=0; tf < NumTimeFrames; tf++ ) {
+        TArray1<float>      onetf ( NumTracks );
+
+        for ( int tf=0; tf < NumTimeFrames; tf++ ) {
 
-        FileStream.Read ( onetf.GetArray (), onetf.MemorySize () );
+            FileStream.Read ( onetf.GetArray (), onetf.MemorySize () );
 
-        for ( int el=0; el < NumTracks; el++ )
-            Tracks ( el, tf )   = onetf ( el );
+            for ( int el=0; el < NumTracks; el++ )
+                Tracks ( el, tf )   = onetf ( el );
+            }
         }
 
 
@@ -315,8 +353,9 @@ OffGfp          = NumElectrodes + PseudoTrackOffsetGfp;
 OffDis          = NumElectrodes + PseudoTrackOffsetDis;
 OffAvg          = NumElectrodes + PseudoTrackOffsetAvg;
 
-                                        // do all allocations stuff
-Tracks.Resize ( TotalTracks, NumTimeFrames );
+                                        // do all allocations stuff - nothing to load if file is mapped
+if ( ! FileMapping.IsOpen () )
+    Tracks.Resize ( TotalTracks, NumTimeFrames );
 
 
 ElectrodesNames.Set ( TotalElectrodes, ElectrodeNameSize );
@@ -342,7 +381,35 @@ return true;
 //----------------------------------------------------------------------------
 void    TRisDoc::ReadRawTracks ( long tf1, long tf2, TArray2<float> &buff, int tfoffset )
 {
-if ( IsVector ( AtomTypeUseOriginal ) ) {
+if ( FileMapping.IsOpen () ) {
+
+    long                numtf           = tf2 - tf1 + 1;
+
+    if ( IsVector ( AtomTypeUseOriginal ) ) {
+                                        // same tiling as MultiplexedToTracks, while computing the norms
+        for ( long tf0 = 0; tf0 < numtf;         tf0 += MultiplexedTileSize )
+        for ( int  sp0 = 0; sp0 < NumElectrodes; sp0 += MultiplexedTileSize ) {
+
+            long            tfmax           = min ( tf0 + MultiplexedTileSize, numtf         );
+            int             spmax           = min ( sp0 + MultiplexedTileSize, NumElectrodes );
+
+            for ( int sp = sp0; sp < spmax; sp++ ) {
+
+                const float*    toT             = GetMappedTF ( tf1 + tf0 ) + 3 * sp;
+                float*          b               = buff[ sp ] + tfoffset + tf0;
+
+                for ( long tf = tf0; tf < tfmax; tf++, toT += NumTracks )
+
+                    *b++    = NormVector3 ( toT[ 0 ], toT[ 1 ], toT[ 2 ] );
+                }
+            }
+        }
+    else // scalar or positive
+
+        MultiplexedToTracks ( GetMappedTF ( tf1 ), NumTracks, NumElectrodes, numtf, buff, tfoffset );
+    }
+
+else if ( IsVector ( AtomTypeUseOriginal ) ) {
 
     float*              toTx;
     float*              toTy;
@@ -382,7 +449,27 @@ int                 numtf           = tf2 - tf1 + 1;
 //Clipped ( tf1, tf2, (long) 0, (long) NumTimeFrames - 1 );
 
 
-if ( IsVector ( AtomTypeUseOriginal ) ) {
+if ( FileMapping.IsOpen () ) {
+                                        // file is multiplexed: scanning each time frame only once, accumulating all solution points at once
+    TArray1<double>     sum ( NumElectrodes );
+
+    for ( long tf = tf1; tf <= tf2; tf++ ) {
+
+        const float*        toT             = GetMappedTF ( tf );
+
+        if ( IsVector ( AtomTypeUseOriginal ) )
+            for ( int sp = 0; sp < NumElectrodes; sp++, toT += 3 )
+                sum[ sp ]  += NormVector3 ( toT[ 0 ], toT[ 1 ], toT[ 2 ] );
+        else
+            for ( int sp = 0; sp < NumElectrodes; sp++, toT++ )
+                sum[ sp ]  += *toT;
+        }
+
+    for ( int sp = 0; sp < NumElectrodes; sp++ )
+        inv[ sp ]   = sum[ sp ] / numtf;
+    }
+
+else if ( IsVector ( AtomTypeUseOriginal ) ) {
 
     const float*        toTx;
     const float*        toTy;
@@ -435,7 +522,35 @@ int                 numtf           = tf2 - tf1 + 1;
 //Clipped ( tf1, tf2, (long) 0, (long) NumTimeFrames - 1 );
 
 
-if ( IsVector ( AtomTypeUseOriginal ) ) {
+if ( FileMapping.IsOpen () ) {
+                                        // file is multiplexed: scanning each time frame only once, accumulating all solution points at once
+    bool                isvector        = IsVector ( AtomTypeUseOriginal );
+    TArray2<double>     sum ( NumElectrodes, 3 );
+
+    for ( long tf = tf1; tf <= tf2; tf++ ) {
+
+        const float*        toT             = GetMappedTF ( tf );
+
+        for ( int sp = 0; sp < NumElectrodes; sp++ )
+
+            if ( isvector ) {
+                sum ( sp, 0 )  += *toT++;
+                sum ( sp, 1 )  += *toT++;
+                sum ( sp, 2 )  += *toT++;
+                }
+            else
+                sum ( sp, 0 )  += *toT++;
+        }
+
+    for ( int sp = 0; sp < NumElectrodes; sp++ ) {
+
+        inv[ sp ].X     = sum ( sp, 0 ) / numtf;
+        inv[ sp ].Y     = sum ( sp, 1 ) / numtf;
+        inv[ sp ].Z     = sum ( sp, 2 ) / numtf;
+        }
+    }
+
+else if ( IsVector ( AtomTypeUseOriginal ) ) {
 
     const float*        toTx;
     const float*        toTy;
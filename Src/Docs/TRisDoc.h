@@ -51,12 +51,13 @@ public:
     bool            Open            ( int mode, const char* path = 0 )  final;
     bool            CanClose        ()                                  final;
     bool            Close           ()                                  final;
-    bool            IsOpen          ()                                  final   { return Tracks.IsAllocated (); }
+    bool            IsOpen          ()                                  final   { return Tracks.IsAllocated () || FileMapping.IsOpen (); }
     bool            CommitRis       ( bool force = false );
 
 
     static bool     ReadFromHeader  ( const char* file, ReadFromHeaderType what, void* answer );
     void            ReadRawTracks   ( long tf1, long tf2, TArray2<float> &buff, int tfoffset = 0 )  final;
+    void            ReleaseFileMapping  ()                              final;  // loading all the data in memory, then unmapping
 
 
     const char*     GetInverseTitle ()  const final         { return owl::TFileDocument::GetTitle (); } 
@@ -67,13 +68,15 @@ public:
 
 protected:
 
-    TTracks<float>  Tracks;             // NumElectrodes == NumSolPoints here
+    TTracks<float>  Tracks;             // NumElectrodes == NumSolPoints here - left empty while the file is mapped
 
     int             NumTracks;          // 1 or 3 * NumElectrodes, in the case of vectorial data
     int             TotalTracks;
 
 
     bool            SetArrays       ()  final;
+                                        // Mapped file access: NumTracks values for each time frame
+    const float*    GetMappedTF     ( long tf )                         const   { return (const float*) FileMapping.GetData ( DataOrg + (LONGLONG) tf * NumTracks * sizeof ( float ) ); }
 };
 
 
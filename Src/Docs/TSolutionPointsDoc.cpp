@@ -29,6 +29,7 @@ limitations under the License.
 #include    "Files.Stream.h"
 
 #include    "TVolumeDoc.h"
+#include    "Geometry.TPointsIndex.h"
 
 #pragma     hdrstop
 //-=-=-=-=-=-=-=-=-
@@ -186,43 +187,6 @@ return  true;
 }
 
 
-//----------------------------------------------------------------------------
-void	TSolutionPointsDoc::Sort ( TPointFloatI* ListSPI, int l, int r )
-{
-int                 i               = l;
-int                 j               = r;
-double              x,  y,  z;
-TPointFloatI        p;
-
-x   = ListSPI[( l + r ) / 2].X;
-y   = ListSPI[( l + r ) / 2].Y;
-z   = ListSPI[( l + r ) / 2].Z;
-
-do {
-    while (  ListSPI[i].Z <  z ||
-           ( ListSPI[i].Z == z && ListSPI[i].X <  x ) ||
-           ( ListSPI[i].Z == z && ListSPI[i].X == x && ListSPI[i].Y < y ) ) i++;
-
-    while (  z <  ListSPI[j].Z ||
-           ( z == ListSPI[j].Z && x <  ListSPI[j].X ) ||
-           ( z == ListSPI[j].Z && x == ListSPI[j].X && y < ListSPI[j].Y ) ) j--;
-
-    if ( i <= j ) {
-        p             = ListSPI[i];
-        ListSPI[i++]  = ListSPI[j];
-        ListSPI[j--]  = p;
-        }
-    } while ( i <= j );
-
-
-if ( l < j )
-    Sort ( ListSPI, l, j );
-
-if ( i < r )
-    Sort ( ListSPI, i, r );
-}
-
-
 //----------------------------------------------------------------------------
 void    TSolutionPointsDoc::SetBounding ()
 {
@@ -554,6 +518,8 @@ TEasyStats          stat3;
 
 stat1.Reset ();     stat2.Reset ();     stat3.Reset ();
 
+auto                spindex         = Points.GetIndex ();
+
 
 for ( int sp = 0; sp < GetNumSolPoints (); sp += step ) {
 
@@ -565,7 +531,7 @@ for ( int sp = 0; sp < GetNumSolPoints (); sp += step ) {
     pf[ 1 ] =                   p1[ 1 ];
     pf[ 2 ] =                   p1[ 2 ];
 
-    p2      = Points[ GetNearestElementIndex ( pf ) ];
+    p2      = Points[ spindex->GetNearest ( pf ) ];
 
 //    stat1.Add ( p2[ 0 ] - pf[ 0 ] );
     stat1.Add ( fabs ( p2[ 0 ] - pf[ 0 ] ) );
@@ -576,7 +542,7 @@ for ( int sp = 0; sp < GetNumSolPoints (); sp += step ) {
     pf[ 1 ] = 2 * center[ 1 ] - p1[ 1 ];
     pf[ 2 ] =                   p1[ 2 ];
 
-    p2      = Points[ GetNearestElementIndex ( pf ) ];
+    p2      = Points[ spindex->GetNearest ( pf ) ];
 
 //    stat2.Add ( p2[ 0 ] - pf[ 0 ] );
     stat2.Add ( fabs ( p2[ 0 ] - pf[ 0 ] ) );
@@ -587,7 +553,7 @@ for ( int sp = 0; sp < GetNumSolPoints (); sp += step ) {
     pf[ 1 ] =                   p1[ 1 ];
     pf[ 2 ] = 2 * center[ 2 ] - p1[ 2 ];
 
-    p2      = Points[ GetNearestElementIndex ( pf ) ];
+    p2      = Points[ spindex->GetNearest ( pf ) ];
 
 //    stat3.Add ( p2[ 0 ] - pf[ 0 ] );
     stat3.Add ( fabs ( p2[ 0 ] - pf[ 0 ] ) );
@@ -904,27 +870,12 @@ Gauge.HappyEnd ();
 
 
 //----------------------------------------------------------------------------
-                                        // scan all points for the closest match
+                                        // query the spatial index for the closest match
 int     TSolutionPointsDoc::GetNearestElementIndex ( const TPointFloat& p, double dmax )     const
 {
 const TPoints&      Points          = GetPoints ( DisplaySpace3D );
-TPointFloat         delta;
-int                 index           = TIndexNull;
-double              d;
-double              dmin            = Highest ( dmin );
-
-
-for ( int sp = 0; sp < GetNumSolPoints (); sp++ ) {
-
-    delta   = Points[ sp ] - p;
-
-    d       = delta.Norm2 ();
-
-    if ( d < dmin ) {
-        dmin    = d;
-        index   = sp;
-        }
-    }
+double              dmin;
+int                 index           = Points.GetIndex ()->GetNearest ( p, &dmin );
 
 
 return dmax > 0 ? dmin < Square ( dmax ) ? index : TIndexNull
@@ -976,27 +927,30 @@ if ( step <= 0 )
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 const TPoints&      points          = GetPoints ( DisplaySpace3D );
+auto                spindex         = points.GetIndex ();
+
+
+OmpParallelBegin
                                         // neighborhood info for a single electrode
-TArray2<double>     neigh ( numsolp, NumNeighborhoodInfo );
+vector<TPointsNeighbor> neigh;
 
+OmpFor
 
 for ( int spi1 = 0; spi1 < numsolp; spi1++ ) {
+                                        // self + nearest neighbors, sorted by distance
+    spindex->GetKNearest ( points[ spi1 ], maxnumneigh + 1, neigh );
 
-    for ( int spi2 = 0; spi2 < numsolp; spi2++ ) {
-                                        // index
-        neigh ( spi2, NeighborhoodIndex    )    = spi2;
-                                        // Norm2 is enough for sorting
-        neigh ( spi2, NeighborhoodDistance )    = spi1 == spi2 ? 0 : ( points[ spi1 ] - points[ spi2 ] ).Norm2 ();
-        }
+                                        // self always comes first, even with duplicated points
+    auto                toself          = find_if ( neigh.begin (), neigh.end (), [ spi1 ] ( const TPointsNeighbor& n ) { return n.Index == spi1; } );
 
-                                        // sort by distance2
-    neigh.SortRows ( NeighborhoodDistance, Ascending );
+    if ( toself != neigh.end () )
+        rotate ( neigh.begin (), toself, toself + 1 );
 
                                         // transfer all distances and their respective index
-    for ( int spi2 = 0; spi2 <= maxnumneigh; spi2++ ) {
+    for ( int spi2 = 0; spi2 < (int) neigh.size (); spi2++ ) {
 
-        neighborhood ( spi1, spi2, NeighborhoodIndex    )   = neigh ( spi2, NeighborhoodIndex     );
-        neighborhood ( spi1, spi2, NeighborhoodDistance )   = sqrt ( neigh ( spi2, NeighborhoodDistance ) ) / step; // normalized by the median distance
+        neighborhood ( spi1, spi2, NeighborhoodIndex    )   = neigh[ spi2 ].Index;
+        neighborhood ( spi1, spi2, NeighborhoodDistance )   = spi2 == 0 ? 0 : sqrt ( neigh[ spi2 ].Distance2 ) / step;  // normalized by the median distance
         }
     }
 
@@ -1140,33 +1094,13 @@ if ( /*! MRIBounding.Contains ( *Bounding ) ||*/ outmri > 50 && (double) outmri
     }
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Create a temp SP list, with indexes
-
-TPointFloatI*       ListSPI         = new TPointFloatI [ GetNumSolPoints () ];
-
-for ( int sp = 0; sp < GetNumSolPoints (); sp++ ) {
-    ListSPI[ sp ].X     = Points[ sp ].X + MRIOrigin.X;
-    ListSPI[ sp ].Y     = Points[ sp ].Y + MRIOrigin.Y;
-    ListSPI[ sp ].Z     = Points[ sp ].Z + MRIOrigin.Z;
-    ListSPI[ sp ].Index = sp;
-    }
-                                        // sort in Z/X/Y increasing order
-Sort ( ListSPI, 0, GetNumSolPoints () - 1 );
-
-
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Create the right interpolation (4NN or 1NN)
 double              step            = DisplaySpaces[ DisplaySpace3D ].MedianDistance;
 
 
-if      ( interpol == SPInterpolation1NN  )   ComputeInterpol1NN ( ListSPI, step, MRIGrey, greyvolfilled );
-else if ( interpol == SPInterpolation4NN  )   ComputeInterpol4NN ( ListSPI, step, MRIGrey, greyvolfilled );
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-delete[]    ListSPI;
+if      ( interpol == SPInterpolation1NN  )   ComputeInterpol1NN ( step, MRIGrey, greyvolfilled );
+else if ( interpol == SPInterpolation4NN  )   ComputeInterpol4NN ( step, MRIGrey, greyvolfilled );
 
 
 return  interpol == SPInterpolation1NN && HasInterpol1NN ()
@@ -1175,52 +1109,12 @@ return  interpol == SPInterpolation1NN && HasInterpol1NN ()
 
 
 //----------------------------------------------------------------------------
-void	TSolutionPointsDoc::ComputeInterpol4NN ( const TPointFloatI* ListSPI, double step, const TVolumeDoc* MRIGrey, const Volume& greyvol )
+void	TSolutionPointsDoc::ComputeInterpol4NN ( double step, const TVolumeDoc* MRIGrey, const Volume& greyvol )
 {
-                                        // We are going to build an index in the Z axis, for faster access to points
-
-int                 mridim3         = MRIGrey->GetSize ()->GetZExtent (); // scan MRI fully, not only the clipping, in case SPs overflowing...
-TArray2<int>        zindex ( 2, mridim3 );
-//double            mindz           = 4 * step;
-double              mindz           = 4 / sqrt ( 3.0 ) * step;
-int                 zminmri         = MRIBounding.ZMin () - 1;  // round the double bounding
-int                 zmaxmri         = MRIBounding.ZMax () + 1;
-
-zindex.ResetMemory ();
-
-                                        // scan Z
-OmpParallelFor
-
-for ( int iz = 0; iz < mridim3; iz++ ) {
-
-                                        // set default meaningful limits
-    zindex ( 0 , iz ) = 0;
-    zindex ( 1 , iz ) = GetNumSolPoints () - 1;
-
-    int                 spdl;
-    const TPointFloatI* tosp;
-
-    for ( spdl = 0, tosp = &ListSPI[ spdl ]; spdl < GetNumSolPoints (); spdl++, tosp++ )
-           // at least 4 "slices" from top     or at least 4 "slices" below current z
-        if ( ( zmaxmri - tosp->Z ) <= mindz || tosp->Z >= iz - mindz ) {
-            zindex ( 0 , iz ) = spdl;
-            break;
-            }
-
-    for ( ; spdl < GetNumSolPoints (); spdl++, tosp++ )
-           // at least 4 "slices" from bottom  and at least 4 "slices" above current z
-        if ( ( tosp->Z - zminmri ) >= mindz && tosp->Z > iz + mindz ) {
-            zindex ( 1 , iz ) = spdl;
-            break;
-            }
-    }
-
-
-                                        // to scan all points, without the indexing scheme (slow but safe)
-//for ( int iz = 0; iz < mridim3; iz++ ) {
-//    zindex ( 0 , iz ) = 0;
-//    zindex ( 1 , iz ) = GetNumSolPoints () - 1;
-//    }
+                                        // neighbors are searched with the spatial index, in the solution points space
+const TPoints&      Points          = GetPoints ( DisplaySpace3D );
+auto                spindex         = Points.GetIndex ();
+TPointFloat         MRIOrigin       = MRIGrey->GetOrigin ();
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1252,7 +1146,7 @@ int                 mrithreshold    = MRIGrey->GetCsfCut ();
 OmpParallelBegin
 
 TArray2<float>      distlist ( 4, NumDistList );// list of the distances of the current closest 4 points
-//TArray2<float>    distlist ( GetNumSolPoints (), NumDistList );// list of the distances to all points
+vector<TPointsNeighbor> neighbors;
 TPointFloat         pvol;
 TPointFloat         pmri;
 
@@ -1285,35 +1179,14 @@ for ( int pvolZ = 0; pvolZ < volsize.Z; pvolZ++ ) {
         distlist ( 0 , Distance ) = distlist ( 1 , Distance ) = distlist ( 2 , Distance ) = distlist ( 3 , Distance ) = Highest<float> ();
         distlist ( 0 , Index    ) = distlist ( 1 , Index    ) = distlist ( 2 , Index    ) = distlist ( 3 , Index    ) = 0;
 
-                                        // find 4 nearest neighbors, "by hand"
-        int                 lastzimax       = zindex ( 1, (int) pmri.Z );
-        int                 spdl;
-        const TPointFloatI* tosp;
-
-        for ( spdl = zindex ( 0, (int) pmri.Z ), tosp = ListSPI + spdl; spdl <= lastzimax; spdl++, tosp++ ) {
+                                        // find 4 nearest neighbors, back in the solution points space
+        spindex->GetKNearest ( pmri - MRIOrigin, 4, neighbors );
 
-                                        // save us some sqrt
-            float       d       = ( *tosp - pmri ).Norm2 ();
-
-                                        // insertion sort
-            if ( d >= distlist ( 3 , Distance ) )  continue;
-            if ( d >= distlist ( 2 , Distance ) ) {
-                distlist ( 3 , Distance ) = d; distlist ( 3 , Index ) = tosp->Index;
-                continue;
-                }
-            if ( d >= distlist ( 1 , Distance ) ) {
-                MoveVirtualMemory ( distlist.GetArray () + 6, distlist.GetArray () + 4, 2 * distlist.AtomSize () );
-                distlist ( 2 , Distance ) = d; distlist ( 2 , Index ) = tosp->Index;
-                continue;
-                }
-            if ( d >= distlist ( 0 , Distance ) ) {
-                MoveVirtualMemory ( distlist.GetArray () + 4, distlist.GetArray () + 2, 4 * distlist.AtomSize () );
-                distlist ( 1 , Distance ) = d; distlist ( 1 , Index ) = tosp->Index;
-                continue;
-                }
-                MoveVirtualMemory ( distlist.GetArray () + 2, distlist.GetArray (),     6 * distlist.AtomSize () );
-                distlist ( 0 , Distance ) = d; distlist ( 0 , Index ) = tosp->Index;
-            } // for sp
+        for ( int ni = 0; ni < (int) neighbors.size (); ni++ ) {
+                                        // still squared distances, saving us some sqrt
+            distlist ( ni , Distance ) = neighbors[ ni ].Distance2;
+            distlist ( ni , Index    ) = neighbors[ ni ].Index;
+            }
 
 
         //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1404,73 +1277,16 @@ OmpParallelEnd
 
 }
 
-/*                                        // force overwriting all solution points
-for ( spdl = 0, tosp = &ListSPI[ spdl ]; spdl < GetNumSolPoints (); spdl++, tosp++ ) {
-
-    x   = AbsoluteToVolumeX ( tosp->x + 0.5 );
-    y   = AbsoluteToVolumeY ( tosp->y + 0.5 );
-    z   = AbsoluteToVolumeZ ( tosp->z + 0.5 );
-
-    if ( x < 0 || x >= voldim1
-      || y < 0 || y >= voldim2
-      || z < 0 || z >= voldim3 )
-        continue;
-
-    toi4     = & Interpol4NN ( x, y, z );
-
-    toi4->i1 = (ushort) tosp->Index;
-    toi4->w1 = TWeightedPoints4SumWeights;
-    toi4->i2 = toi4->i3 = toi4->i4 = 0;
-    toi4->w2 = toi4->w3 = toi4->w4 = 0;
-    }
-*/
 
 
 //----------------------------------------------------------------------------
-void	TSolutionPointsDoc::ComputeInterpol1NN ( const TPointFloatI* ListSPI, double step, const TVolumeDoc* MRIGrey, const Volume& greyvol )
+void	TSolutionPointsDoc::ComputeInterpol1NN ( double step, const TVolumeDoc* MRIGrey, const Volume& greyvol )
 {
-                                        // We are going to build an index in the Z axis, for faster access to points
-int                 mridim3         = MRIGrey->GetSize ()->GetZExtent (); // scan MRI fully, not only the clipping, in case SPs overflowing...
-TArray2<int>        zindex ( 2, mridim3 );
+                                        // neighbors are searched with the spatial index, in the solution points space
+const TPoints&      Points          = GetPoints ( DisplaySpace3D );
+auto                spindex         = Points.GetIndex ();
+TPointFloat         MRIOrigin       = MRIGrey->GetOrigin ();
 double              mintoeuclidean  = sqrt ( 3.0 );   // min distance can be on 1 axis, search has to be in all 3 dimensions so we need a conversion factor
-double              mindz           = 2 * mintoeuclidean * step;
-int                 zminmri         = MRIBounding.ZMin () - 1;  // round the double bounding
-int                 zmaxmri         = MRIBounding.ZMax () + 1;
-
-zindex.ResetMemory ();
-
-                                        // scan Z
-OmpParallelFor
-
-for ( int iz = 0; iz < mridim3; iz++ ) {
-
-                                        // set default meaningful limits
-    zindex ( 0 , iz ) = 0;
-    zindex ( 1 , iz ) = GetNumSolPoints () - 1;
-
-    int                 spdl;
-    const TPointFloatI* tosp;
-
-    for ( spdl = 0, tosp = &ListSPI[ spdl ]; spdl < GetNumSolPoints (); spdl++, tosp++ )
-           // at least 2 "slices" from top     or at least 2 "slices" below current z
-        if ( ( zmaxmri - tosp->Z ) <= mindz || tosp->Z >= iz - mindz ) {
-            zindex ( 0 , iz ) = spdl;
-            break;
-            }
-
-    for ( ; spdl < GetNumSolPoints (); spdl++, tosp++ )
-           // at least 2 "slices" from bottom  and at least 2 "slices" above current z
-        if ( ( tosp->Z - zminmri ) >= mindz && tosp->Z > iz + mindz ) {
-            zindex ( 1 , iz ) = spdl;
-            break;
-            }
-    }
-
-                                        // to scan all points, without the indexing scheme (slow but safe)
-//for ( int iz = 0; iz < mridim3; iz++ ) {
-//    zindex ( 0 , iz ) = 0;
-//    zindex ( 1 , iz ) = GetNumSolPoints () - 1;
-//    }
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1492,12 +1308,15 @@ Interpol1NN     = UndefinedInterpolation1NN;
 //double            mindinterpol    = Square ( step / 2 );    // Euclidian distance
 //double            mindinterpol    = step * 0.50 /** ( IsGridAligned () ? 0.66 : 1.33 )*/;  // Max distance
 double              mindinterpol    = step * 0.50 * mintoeuclidean;  // Max distance
+double              searchradius    = mindinterpol * mintoeuclidean * 1.001;    // Euclidean sphere containing the Max distance cube
 int                 mrithreshold    = MRIGrey->GetCsfCut ();
 
 OmpParallelBegin
 
+vector<int>         candidates;
 TPointFloat         pvol;
 TPointFloat         pmri;
+TPointFloat         psp;
 
 OmpFor
                                         // scan interpolation box
@@ -1528,15 +1347,14 @@ for ( int pvolZ = 0; pvolZ < volsize.Z; pvolZ++ ) {
         double              mind    = Highest ( mind );
         int                 mini    = UndefinedInterpolation1NN;
 
-                                        // find 1 nearest neighbors
-        int                 lastzimax   = zindex ( 1, (int) pmri.Z );
-        int                 spdl;
-        const TPointFloatI* tosp;
+                                        // find 1 nearest neighbors, among the ones that could be within the cube
+        psp     = pmri - MRIOrigin;
 
-        for ( spdl = zindex ( 0, (int) pmri.Z ), tosp = ListSPI + spdl; spdl <= lastzimax; spdl++, tosp++ ) {
+        spindex->GetWithinRadius ( psp, searchradius, candidates );
 
+        for ( int ci = 0; ci < (int) candidates.size (); ci++ ) {
 
-            TPointFloat     delta   = *tosp - pmri;
+            TPointFloat     delta   = Points[ candidates[ ci ] ] - psp;
                                         // use Max distance -> cubic shape
             delta.Absolute ();
 
@@ -1544,9 +1362,9 @@ for ( int pvolZ = 0; pvolZ < volsize.Z; pvolZ++ ) {
 
             if ( d < mind ) {
                 mind    = d;
-                mini    = tosp->Index;
+                mini    = candidates[ ci ];
                 }
-            } // for sp
+            } // for candidates
 
 
         //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1562,24 +1380,6 @@ for ( int pvolZ = 0; pvolZ < volsize.Z; pvolZ++ ) {
 OmpParallelEnd
 }
 
-/*                                        // force SP to voxels
-for ( spdl = 0, tosp = &ListSPI[ spdl ]; spdl < GetNumSolPoints (); spdl++, tosp++ ) {
-                                        // formula tested in full resolution + downsampled
-    pvol.Set         ( tosp );
-
-    MRIGrey->ToAbs   ( pvol );
-    AbsoluteToVolume ( pvol );
-
-    pvol.Round ();
-//  pvol   += 0.5;                  // !not Round, we shift but keep the point in float!
-
-    if ( ! Interpol1NN.WithinBoundary ( pvol ) )
-        continue;
-
-    Interpol1NN ( pvol ) = (ushort) tosp->Index;
-    }
-return;
-*/
 
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
@@ -134,12 +134,11 @@ protected:
     void            SetBounding         ();
     void            SetMedianDistance   ();
     void            SetOriginShift      ();
-    void            Sort                ( TPointFloatI* ListSPI, int l, int r );
     void            FindOrientation     ();
 
 
-    void            ComputeInterpol1NN ( const TPointFloatI* ListSPI, double step, const TVolumeDoc* MRIGrey, const Volume& greyvol );
-    void            ComputeInterpol4NN ( const TPointFloatI* ListSPI, double step, const TVolumeDoc* MRIGrey, const Volume& greyvol );
+    void            ComputeInterpol1NN ( double step, const TVolumeDoc* MRIGrey, const Volume& greyvol );
+    void            ComputeInterpol4NN ( double step, const TVolumeDoc* MRIGrey, const Volume& greyvol );
 };
 
 
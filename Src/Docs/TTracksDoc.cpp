@@ -17,6 +17,10 @@ limitations under the License.
 #pragma     hdrstop
 //-=-=-=-=-=-=-=-=-
 
+#if defined(CHECKASSERT)
+#include    <assert.h>
+#endif
+
 #include    "TTracksDoc.h"
 
 #include    "MemUtil.h"
@@ -1166,6 +1170,8 @@ if ( ! UpdateSession ( newsession ) )   // some sessions can be fishy
                                         // OK, this is the new session!
 CurrSequence    = newsession;
 
+FiltersStream.Reset ();
+
 
 InitDateTime    ();
                                         // restore old state
@@ -1268,6 +1274,39 @@ InitLimits ( InitFast );
 }
 
 
+//----------------------------------------------------------------------------
+                                        // Default is to fall back to the regular file reading
+void    TTracksDoc::ReleaseFileMapping ()
+{
+std::lock_guard<std::recursive_mutex>   readinglock ( ReadingLock );
+
+FileMapping.Close ();
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Files store all tracks for each time frame, while our buffers store all time frames for each track
+                                        // Transposing by square tiles keeps both the source rows and the destination rows in cache
+void    TTracksDoc::MultiplexedToTracks ( const float* data, int numdatatracks, int numtracks, long numtf, TArray2<float>& buff, int tfoffset )
+{
+for ( long tf0 = 0; tf0 < numtf;     tf0 += MultiplexedTileSize )
+for ( int  el0 = 0; el0 < numtracks; el0 += MultiplexedTileSize ) {
+
+    long            tfmax           = min ( tf0 + MultiplexedTileSize, numtf     );
+    int             elmax           = min ( el0 + MultiplexedTileSize, numtracks );
+
+    for ( int el = el0; el < elmax; el++ ) {
+
+        const float*    toD             = data + (size_t) tf0 * numdatatracks + el;
+        float*          toB             = buff[ el ] + tfoffset + tf0;
+
+        for ( long tf = tf0; tf < tfmax; tf++, toD += numdatatracks )
+            *toB++  = *toD;
+        }
+    }
+}
+
+
 //----------------------------------------------------------------------------
                                         // check for spaces in names
 void    TTracksDoc::ElectrodesNamesCleanUp ()
@@ -1387,6 +1426,8 @@ if ( oldfiltersactivated == activate )
                                         // set new state
 FiltersActivated    = activate;
 
+FiltersStream.Reset ();
+
 
 if ( ! silent ) {                       // something has changed, notify
 
@@ -1441,6 +1482,9 @@ if ( SamplingFrequency <= 0 && Filters.SamplingFrequency > 0 )
 
     SetSamplingFrequency ( Filters.SamplingFrequency );
 
+                                        // any previous filters states are now irrelevant
+FiltersStream.Reset ();
+
                                         // a priori, turn on filtering
 //bool                oldfiltersactivated = ActivateFilters ();
                                         // SetFiltersActivated does not notify in this case
@@ -1479,6 +1523,9 @@ return true;
 // * New reference
 //
 // * Post-filtering: Envelope, Threshold
+//
+// * Optional streaming (SetFiltersStreaming): when reading contiguous blocks, the temporal filters
+//   keep their states from the previous block, so only the right margin is needed, and each TF is read once
 
 
 void    TTracksDoc::GetTracks   (   long                tf1,            long                tf2,
@@ -1489,6 +1536,9 @@ void    TTracksDoc::GetTracks   (   long                tf1,            long
                                     const TRois*        rois      
                                 )
 {
+                                        // views and background readers could be reading concurrently
+std::lock_guard<std::recursive_mutex>   readinglock ( ReadingLock );
+
                                         // Checking parameters consistency
 
                                         // should resolve to a meaningful type
@@ -1525,6 +1575,16 @@ bool                dotemporalfilters   = doanyfilter && Filters.HasTemporalFilt
 bool                dofilterauxs        = doanyfilter && CheckToBool ( Filters.FiltersParam.FilterAuxs );
 
 
+int                 filtersmargin       = dotemporalfilters ? AtLeast ( 1, Filters.GetSafeMargin () ) : 0;    // !make sure it has at least 1 TF so we don't need BuffDiss!
+const TSelection*   filtersauxtracks    = dofilterauxs ? 0 : &AuxTracks;
+
+                                        // Sequential streaming: when this block directly follows the previous one, filters states are carried on,
+                                        // only the look-ahead margin is needed on the right side, and only the not-yet-read time frames are read
+bool                dostream            = dotemporalfilters && FiltersStream.IsActive () && Filters.CanStream ();
+bool                docontinuestream    = dostream && FiltersStream.CanContinue ( Filters, tf1, NumElectrodes, filtersmargin );
+long                streamtf2           = tf2;
+
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // wrapping up all the handling of time limits & data mirroring for temporal filters
 TTracksFiltersLimits<float>  timelimits;
@@ -1532,10 +1592,10 @@ TTracksFiltersLimits<float>  timelimits;
 long                numtf               = tf2 - tf1 + 1;
 
 
-if ( dotemporalfilters )
+if ( dotemporalfilters && ! docontinuestream )
                                         // Adjust the time parameters and set the time margins for temporal filtering
     timelimits.UpdateTimeRange  (   tf1,        tf2,        numtf,      tfoffset,   // !update values with new limits!
-                                    AtLeast ( 1, Filters.GetSafeMargin () ),        // !make sure it has at least 1 TF so we don't need BuffDiss!
+                                    filtersmargin,
                                     NumTimeFrames
                                 );
 
@@ -1543,12 +1603,13 @@ if ( dotemporalfilters )
                                         // Note that the previous content could be lost, though this usually is not a problem, as for filtered data, the buffer is usually evaluated as a whole
                                         // If this is still a problem, make sure the buffer is allocated large enough beforehand
 buff.Resize (   AtLeast ( buff.GetDim1 (), NumElectrodes + ( pseudotracks ? NumPseudoTracks : 0 ) ),
-                AtLeast ( buff.GetDim2 (), (int) ( tfoffset + numtf )                             )  );
+                AtLeast ( buff.GetDim2 (), (int) ( tfoffset + numtf + ( docontinuestream ? filtersmargin : 0 ) ) )  );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // We have to care for an optional 1 TF buffer used for dissimilarity computation
-if ( pseudotracks ) {
+                                        // When streaming, BuffDiss already holds the last TF of the previous block
+if ( pseudotracks && ! docontinuestream ) {
     
     if      ( tf1 == 0 )                        // original or modified tf1 - Dissimilarity can not be computed 
 
@@ -1563,7 +1624,29 @@ if ( pseudotracks ) {
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // read raw Eeg tracks from file
                                         // tfoffset & numtf might have been modified if filtering
-ReadRawTracks ( tf1, tf2, buff, tfoffset );
+if ( docontinuestream ) {
+                                        // start from the raw look-ahead of the previous block
+    int                 numlookahead    = FiltersStream.RestoreLookAhead ( buff, NumElectrodes, tfoffset );
+    long                lasttf          = min ( tf2 + filtersmargin, NumTimeFrames - 1 );
+
+    if ( tf1 + numlookahead <= lasttf )
+
+        ReadRawTracks ( tf1 + numlookahead, lasttf, buff, tfoffset + numlookahead );
+
+#if defined(CHECKASSERT)
+                                        // the look-ahead of the previous block + the newly read part should be exactly what a direct read returns
+    TArray2<float>      rawbuff ( NumElectrodes, (int) ( lasttf - tf1 + 1 ) );
+
+    ReadRawTracks ( tf1, lasttf, rawbuff, 0 );
+
+    for ( int el = 0; el < NumElectrodes; el++ )
+    for ( long tf = 0; tf <= lasttf - tf1; tf++ )
+        assert ( buff ( el, tfoffset + tf ) == rawbuff ( el, tf ) );
+#endif
+    }
+else
+
+    ReadRawTracks ( tf1, tf2, buff, tfoffset );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1572,20 +1655,107 @@ if ( doanyfilter
   || IsEffectiveReference ( reference ) ) { // !filters semantic do not include the reference for the moment!
 
 
-    if ( dotemporalfilters )
+    if ( docontinuestream ) {
+                                        // temporal filters from the previous states, then all the remaining filters on the block only
+        FiltersStream.Continue  (   Filters,
+                                    buff,       NumElectrodes,  
+                                    tf1,        tf2,        tfoffset,
+                                    NumTimeFrames,
+                                    filtersauxtracks
+                                );
+
+#if defined(CHECKASSERT)
+                                        // First block after the stream start, with causal filters: it should exactly match the regular filtering of both blocks at once
+                                        // Non-causal filters run their backward pass on each block look-ahead only, so there is no exact reference for them
+        if ( FiltersStream.GetNumBlocks () == 2
+          && Filters.Causal == FilterCausal
+          && tf2 + filtersmargin <= NumTimeFrames - 1 ) {
+
+            long                rtf1            = FiltersStream.GetFirstTf ();
+            long                rtf2            = tf2;
+            long                rnumtf          = rtf2 - rtf1 + 1;
+            int                 rtfoffset       = 0;
+            TArray2<float>      rbuff ( NumElectrodes, (int) ( rnumtf + 2 * filtersmargin ) );
+            TTracksFiltersLimits<float>  rtimelimits;
+
+            rtimelimits.UpdateTimeRange (   rtf1,       rtf2,       rnumtf,     rtfoffset,
+                                            filtersmargin,
+                                            NumTimeFrames
+                                        );
+
+            ReadRawTracks ( rtf1, rtf2, rbuff, rtfoffset );
+
+            rtimelimits.MirrorData      (   rbuff,      NumElectrodes,  
+                                            rnumtf,     rtfoffset   );
+
+            Filters.ApplyFilters        (   rbuff,      NumElectrodes,  
+                                            rnumtf,     rtfoffset,
+                                            reference,  referencetracks,    &ValidTracks,   filtersauxtracks,
+                                            FilterTemporal
+                                        );
+
+            rtimelimits.RestoreTimeRange(   rbuff,      NumElectrodes,  
+                                            rtf1,       rtf2,       rnumtf,     rtfoffset,
+                                            0
+                                        );
+
+            double              maxvalue        = 0;
+            double              maxdiff         = 0;
+
+            for ( int el = 0; el < NumElectrodes; el++ )
+            for ( long tf = 0; tf < numtf; tf++ ) {
+                Maxed ( maxvalue, (double) fabs ( rbuff ( el, tf1 - rtf1 + tf ) ) );
+                Maxed ( maxdiff,  (double) fabs ( rbuff ( el, tf1 - rtf1 + tf ) - buff ( el, tfoffset + tf ) ) );
+                }
+
+            assert ( maxdiff <= 1e-6 * maxvalue + SingleFloatEpsilon );
+            }
+#endif
+
+        Filters.ApplyFilters    (   buff,       NumElectrodes,  
+                                    numtf,      tfoffset,
+                                    reference,  referencetracks,    &ValidTracks,   filtersauxtracks,
+                                    FilterNonTemporal
+                                );
+        }
+
+    else if ( dostream ) {
 
         timelimits.MirrorData       (   buff,   NumElectrodes,  
                                         numtf,  tfoffset        );
 
+                                        // same as below, but the temporal filters also keep their states at the end of the requested block
+        FiltersStream.Start     (   Filters,
+                                    buff,       NumElectrodes,
+                                    numtf,      filtersmargin,
+                                    streamtf2 + 1,  (int) ( tf2 - streamtf2 ),  // tf2 has been updated to the end of the right margin, minus any mirroring
+                                    filtersauxtracks
+                                );
+
+        Filters.ApplyFilters    (   buff,       NumElectrodes,  
+                                    numtf,      tfoffset,
+                                    reference,  referencetracks,    &ValidTracks,   filtersauxtracks,
+                                    FilterNonTemporal
+                                );
+        }
+
+    else {
+
+        if ( dotemporalfilters )
+
+            timelimits.MirrorData       (   buff,   NumElectrodes,  
+                                            numtf,  tfoffset        );
+
                                             // do ALL filters at once, including reference, with the correct sequence
-    Filters.ApplyFilters    (   buff,       NumElectrodes,  
-                                numtf,      tfoffset,
-                                reference,  referencetracks,    &ValidTracks,   dofilterauxs ? 0 : &AuxTracks,
-                                doanyfilter ? AllFilters : NoFilter
-                            );
+        Filters.ApplyFilters    (   buff,       NumElectrodes,  
+                                    numtf,      tfoffset,
+                                    reference,  referencetracks,    &ValidTracks,   filtersauxtracks,
+                                    doanyfilter ? AllFilters : NoFilter
+                                );
+        }
 
 
-    if ( dotemporalfilters )
+    if ( dotemporalfilters && ! docontinuestream )
 
         timelimits.RestoreTimeRange (   buff,       NumElectrodes,  
                                         tf1,        tf2,        numtf,      tfoffset,       // !restore original time limits!
@@ -1597,7 +1767,7 @@ if ( doanyfilter
 
         Filters.ApplyFilters    (   BuffDiss,   NumElectrodes,
                                     1,          0,
-                                    reference,  referencetracks,    &ValidTracks,   dofilterauxs ? 0 : &AuxTracks,
+                                    reference,  referencetracks,    &ValidTracks,   filtersauxtracks,
                                     doanyfilter ? FilterNonTemporal : NoFilter              // just to make sure we skip the temporal filters
                                 );
     } // filter or reference
@@ -1704,6 +1874,15 @@ if ( pseudotracks ) {
     } // if pseudotracks
 
 
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // When streaming, keep the last filtered TF for the dissimilarity of the next block
+if ( dostream )
+
+    for ( int el = 0; el < NumElectrodes; el++ )
+
+        BuffDiss ( el, 0 )  = buff ( el, tfoffset + numtf - 1 );
+
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // optional ROI-ing
 if ( rois )
@@ -1766,6 +1945,8 @@ if ( *aux != AuxTracks ) {
     AuxTracks = *aux;
                                         // update the remaining valid tracks
     SetValidTracks ();
+                                        // auxiliaries are not always filtered
+    FiltersStream.Reset ();
                                         // update in case of average reference
     if ( Reference == ReferenceAverage )
         SetReferenceType ( Reference );
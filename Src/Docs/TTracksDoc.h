@@ -16,6 +16,8 @@ limitations under the License.
 
 #pragma once
 
+#include    <mutex>
+
 #include    "Time.TDateTime.h"
 #include    "TLimits.h"
 #include    "TSelection.h"
@@ -63,6 +65,9 @@ constexpr int       EegMaxPointsDisplay                 = FifteenMinutesMaxTimeF
 
 constexpr int       EegNumPointsWideDisplay             = 3000;             // how big a file must be until considered a recording / raw file
 
+                                        // Tiles size, in time frames and tracks, when transposing multiplexed file data to tracks buffers
+constexpr int       MultiplexedTileSize                 = 64;               // 2 x 16KB of floats, which fits in L1 cache
+
 
 //----------------------------------------------------------------------------
                                         // Specializing content types
@@ -236,6 +241,8 @@ public:
 
                                         // Reading the RAW TRACKS directly from the file
     virtual void    ReadRawTracks       ( long tf1, long tf2, TArray2<float> &buff, int tfoffset = 0 )    = 0;
+                                        // Windows will not overwrite a file which is still mapped, so any writer to this file calls this first - doc remains readable
+    virtual void    ReleaseFileMapping  ();
 
                                         // Retrieving tracks with optional filter / re-reference / pseudo-tracks / ROIs computation
     virtual void    GetTracks           ( long tf1, long tf2, TArray2<float> &buff, int tfoffset = 0, AtomType atomtype = AtomTypeUseCurrent, PseudoTracksType pseudotracks = NoPseudoTracks, ReferenceType reference = ReferenceAsInFile, const TSelection* referencetracks = 0, const TRois *rois = 0 );
@@ -253,6 +260,11 @@ public:
             bool    DeactivateFilters   ( bool silent = false ) { return SetFiltersActivated ( false, silent ); }
     const   TTracksFilters<float>*  GetFilters ()       const   { return &Filters; }
             TTracksFilters<float>*  GetFilters ()               { return &Filters; }
+                                        // Sequential reading of contiguous blocks: temporal filters carry their states from one GetTracks to the next, and each time frame is read only once
+            bool    IsFiltersStreaming  ()              const   { return FiltersStream.IsActive (); }
+            void    SetFiltersStreaming ( bool streaming )      { FiltersStream.SetActive ( streaming ); }
+                                        // Reading goes through shared buffers and file handles, this lock serializes it with any background reader (TTracksBlocksReader)
+    std::recursive_mutex&   GetReadingLock ()           { return ReadingLock; }
 
 
     static bool     ReadFromHeader      ( const char *file, ReadFromHeaderType what, void* answer );    // fall-back for derived classes
@@ -261,6 +273,7 @@ public:
 protected:
 
     TFileStream     FileStream;         // Wrapper to some low-level file access (currently used only in TEegCartoolSefDoc for faster R/W)
+    TFileMapping    FileMapping;        // Optional read-only mapping of the whole file (currently used in TEegCartoolSefDoc and TRisDoc)
     LONGLONG        DataOrg;            // All files will need a direct access to the data
 
                                         // Typology of tracks
@@ -295,6 +308,8 @@ protected:
 
     TTracksFilters<float>   Filters;            // encapsulates all legal tracks filters
     bool                    FiltersActivated;   // applying or not said filters
+    TTracksFiltersStream<float> FiltersStream;  // optional states of the temporal filters between consecutive calls to GetTracks
+    std::recursive_mutex    ReadingLock;        // held while reading / filtering tracks
 
     int             NumInverseSolutions;
 
@@ -308,6 +323,8 @@ protected:
 
                                         
     virtual bool    SetArrays               () = 0;     // Initializing arrays at opening time
+                                        // Cache-blocked copy from multiplexed data [tf][numdatatracks] to buff[track][tfoffset + tf], for the first numtracks tracks
+    static void     MultiplexedToTracks     ( const float* data, int numdatatracks, int numtracks, long numtf, TArray2<float>& buff, int tfoffset );
     void            ElectrodesNamesCleanUp  ();
     void            CheckElectrodesNamesDuplicates  ();
 };
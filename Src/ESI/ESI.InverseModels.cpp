@@ -425,8 +425,6 @@ void    ComputeRegularizationFactors (
 AVector             D;
                                         // get eigenvalues of matrix, which will give us the magnitude of the values
 AEigenvaluesArma ( KKt, D );
-                                        // biggest eigenvalue
-double              biggesteigen    = D.max ();
 
 
 //TFileName           _file;
@@ -434,6 +432,16 @@ double              biggesteigen    = D.max ();
 //ofstream    ofs ( _file );
 //ofs << StreamFormatFloat32 << D;
 
+                                        // biggest eigenvalue
+ComputeRegularizationFactors ( D.max (), eigenvaluedownfactor, regulvalues, regulnames );
+}
+
+                                        // Same, but when the biggest eigenvalue is already known
+void    ComputeRegularizationFactors (
+                                double                      biggesteigen,   double          eigenvaluedownfactor, 
+                                TVector<double>&            regulvalues,    TStrings&       regulnames 
+                                )
+{
                                         // Safety measure - at that point it wouldn't really matter anyway...
 if ( IsNotAProperNumber ( biggesteigen ) )  biggesteigen = 1;
 
@@ -456,6 +464,143 @@ for ( int reg = 0; reg < regulvalues.GetDim1 (); reg++ ) {
 
 
 //----------------------------------------------------------------------------
+void    TTikhonovInverses::Reset ()
+{
+Regularizer     = TikhonovCentering;
+Factorized      = false;
+BiggestEigen    = 1;
+NullIndex       = -1;
+
+BV.ARelease ();
+V .ARelease ();
+D .ARelease ();
+B .ARelease ();
+A .ARelease ();
+}
+
+
+void    TTikhonovInverses::Set  (   const AMatrix&          b,      const ASymmetricMatrix&     a, 
+                                    TikhonovRegularizerType regularizer 
+                                )
+{
+Reset ();
+
+Regularizer     = regularizer;
+
+int                 numel           = a.n_rows;
+
+if ( numel == 0 )
+    return;
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // For the centering matrix H = I - u * u^T, with u = 1 / sqrt ( numel ), A and H commute only if A * u = 0
+AVector             u ( numel );
+
+u.fill ( 1 / sqrt ( (double) numel ) );
+
+double              trace           = arma::trace ( a );
+
+if ( regularizer == TikhonovCentering
+  && arma::norm ( a * u ) > 1e-4 * AtLeast ( SingleFloatEpsilon, fabs ( trace ) ) ) {
+                                        // no common eigenvectors, keep everything for the plain way
+    B           = b;
+    A           = a;
+
+    AEigenvaluesArma ( A, D );
+
+    BiggestEigen    = D.max ();
+
+    D.ARelease ();
+
+    if ( IsNotAProperNumber ( BiggestEigen ) )  BiggestEigen = 1;
+
+    return;
+    }
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Single eigen decomposition
+if ( regularizer == TikhonovCentering ) {
+                                        // shifting u eigenvalue above all the others, so that it can not be mixed with other null eigenvectors
+    ASymmetricMatrix    au      = a + (AReal) ( 2 * fabs ( trace ) + 1 ) * ( u * u.t () );
+
+    AEigenvaluesEigenvectorsArma ( au, D, V );
+                                        // ascending order: u is now the last one
+    NullIndex   = numel - 1;
+                                        // not regularized, and not inverted either, as A * u = 0
+    D ( NullIndex ) = 0;
+    }
+else
+    AEigenvaluesEigenvectorsArma ( a, D, V );
+
+
+BiggestEigen    = D.max ();
+
+if ( IsNotAProperNumber ( BiggestEigen ) )  BiggestEigen = 1;
+
+                                        // can be computed once for all
+BV              = b * V;
+
+Factorized      = true;
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Inverted spectrum, with the same tolerance as the pseudo-inverse
+AVector TTikhonovInverses::GetSpectrum ( double regul )     const
+{
+AVector             S ( D.n_rows );
+
+if ( ! Factorized )
+    return  S;
+
+
+double              maxeigen        = 0;
+
+for ( int i = 0; i < (int) D.n_rows; i++ )
+    if ( i != NullIndex )
+        Maxed ( maxeigen, D ( i ) + regul );
+
+                                        // tolerance formula, as from Matlab / Armadillo pinv
+double              tolerance       = GetMachineEpsilon<AReal> () * D.n_rows * maxeigen;
+
+
+for ( int i = 0; i < (int) D.n_rows; i++ ) {
+
+    double          eigen           = i == NullIndex ? 0 : D ( i ) + regul;
+
+    S ( i )     = eigen > tolerance ? 1 / eigen : 0;
+    }
+
+return  S;
+}
+
+
+//----------------------------------------------------------------------------
+AMatrix TTikhonovInverses::GetInverse ( double regul )  const
+{
+if ( ! Factorized )
+
+    return  B * APseudoInverseSymmetric ( Regularizer == TikhonovCentering ? A + regul * ACenteringMatrix ( A.n_rows )
+                                                                           : A + regul * AMatrixIdentity  ( A.n_rows ) );
+
+                                        // scaling the columns of B * V, then back to the original space
+AMatrix             BVS             = BV;
+
+BVS.each_row ()    %= GetSpectrum ( regul ).t ();
+
+return  BVS * V.t ();
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Resolution matrix R = J * K, J being the inverse matrix and K the lead field
+                                        // Each R entry is the norm of the 3x3 (or 1x3 for scalar inverses) block between 2 solution points
+                                        // R is computed by blocks of columns, each block being a single matrix-matrix product
+                                        // fileresmat : full R, each time frame being the Point Spread Function of one solution point
+                                        // fileresmatt: full R transposed, each time frame being the Cross-Talk Function of one solution point
+                                        // fileresmats: summary metrics, one per time frame, as listed in ResolutionMetrics
 void    ComputeResolutionMatrix (   
                                 const AMatrix&      K,              const TPoints&      solpoints,
                                 const char*         fileinverse,
@@ -475,13 +620,22 @@ bool                isresmatt       = StringIsNotEmpty ( fileresmatt );
 if ( ! (    numel > 0 && numsolp > 0
          && StringIsNotEmpty ( fileinverse ) 
          && ( isresmat || isresmats || isresmatt ) 
-         && ! solpoints.IsEmpty ()                  ) )
+         && (int) solpoints == numsolp              ) )
     return;
 
 
 
 TOpenDoc<TInverseMatrixDoc> isdoc ( fileinverse, OpenDocHidden );
 
+if ( isdoc.IsNotOpen ()
+  || isdoc->GetNumSolPoints  () != numsolp
+  || isdoc->GetNumElectrodes () != numel   )
+    return;
+
+                                        // number of inverse lines per solution point
+int                 numlinessp      = isdoc->GetNumLines () / numsolp;
+int                 numblocks       = ( numsolp + ResolutionMatrixBlockSize - 1 ) / ResolutionMatrixBlockSize;
+
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
@@ -489,73 +643,136 @@ TSuperGauge         gauge;
 
 gauge.Set ( "Resolution Matrix" );
 
-gauge.AddPart ( 0,          2 * numsolp,    95 );
+gauge.AddPart ( 0,          2 * numblocks,  95 );
 gauge.AddPart ( 1,          3,               5 );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-TTracks<float>          resmat ( isresmat || isresmatt  ? numsolp : 0, isresmat || isresmatt    ? numsolp : 0 );    // big matrix, showing the Point Spread Function
-TTracks<float>          resmats( isresmats              ? numsolp : 0, isresmats                ? 1       : 0 );    // smaller one, summarizing the spreading per each SP
-//TTracks<float>        resmatt( isresmatt              ? numsolp : 0, isresmatt                ? numsolp : 0 );    // big matrix transposed, showing the Kernels
+TTracks<float>          resmat ( isresmat || isresmatt  ? numsolp : 0, isresmat || isresmatt    ? numsolp              : 0 );  // big matrix, showing the Point Spread Function
+TTracks<float>          resmats( isresmats              ? numsolp : 0, isresmats                ? NumResolutionMetrics : 0 );  // smaller one, summarizing the spreading per each SP
+
+                                        // Cross-Talk Functions are rows of R, so they are cumulated block after block
+TArray1<double>         ctfsumwr    ( numsolp );
+TArray1<double>         ctfsumw     ( numsolp );
+TArray1<float>          ctfpeak     ( numsolp );
+TArray1<int>            ctfpeaki    ( numsolp );
 
-OmpParallelBegin
+ctfsumwr    = 0;
+ctfsumw     = 0;
+ctfpeak     = -1;
+ctfpeaki    = 0;
 
-TArray1<TVector3Float>  invx   ( numsolp );
-TArray1<TVector3Float>  invy   ( numsolp );
-TArray1<TVector3Float>  invz   ( numsolp );
-TVector<float>          inv    ( numsolp );
+AMatrix                 Rblock;
+AMatrix                 psfblock;
 
-OmpFor
 
-for ( int spi = 0; spi < numsolp; spi++ ) {
+for ( int blocki = 0; blocki < numblocks; blocki++ ) {
 
     gauge.Next ( 0 );
 
-                                // we need to multiply the 3 components of each solution point
-    isdoc->MultiplyMatrix ( regularization, K, 3 * spi    , invx );
-    isdoc->MultiplyMatrix ( regularization, K, 3 * spi + 1, invy );
-    isdoc->MultiplyMatrix ( regularization, K, 3 * spi + 2, invz );
+    int                 sp1             = blocki * ResolutionMatrixBlockSize;
+    int                 blocksize       = NoMore ( ResolutionMatrixBlockSize, numsolp - sp1 );
 
-                                // gather all x, y, and z results
-    for ( int spi2 = 0; spi2 < numsolp; spi2++ )
+                                        // the 3 dipole components of each solution point of this block, all at once
+    isdoc->MultiplyColumns ( regularization, K, 3 * sp1, 3 * blocksize, Rblock );
 
-        inv[ spi2 ] = sqrt ( invx[ spi2 ].Norm2 () + invy[ spi2 ].Norm2 () + invz[ spi2 ].Norm2 () );
+    psfblock.set_size ( numsolp, blocksize );
 
-                                // store the whole columns / row in the big matrix
-    if ( isresmat || isresmatt )
-        inv.SetColumn ( resmat,  spi );
 
+    gauge.Next ( 0 );
 
-//  if ( isresmatt )
-//      inv.SetRow    ( resmatt, spi );
+    OmpParallelFor
 
+    for ( int bi = 0; bi < blocksize; bi++ ) {
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                // sum-up all weighted radii
-    gauge.Next ( 0 );
+        int                 spi             = sp1 + bi;
+        double              sumwr           = 0;
+        double              sumw            = 0;
+        float               peak            = -1;
+        int                 peaki           = spi;
+
+        for ( int spi2 = 0; spi2 < numsolp; spi2++ ) {
 
-    if ( isresmats ) {
+            double              sum2            = 0;
+                                        // all inverse lines x all 3 dipole components
+            for ( int di = 0; di < 3; di++ ) {
 
-        double      sumwr       = 0;
-        double      sumw        = 0;
+                const AReal*        toR             = Rblock.colptr ( 3 * bi + di ) + numlinessp * spi2;
 
-        for ( int spi2 = 0; spi2 < numsolp; spi2++ ) {
+                for ( int li = 0; li < numlinessp; li++ )
+                    sum2   += Square ( toR[ li ] );
+                }
+
+            float               w               = sqrt ( sum2 );
+
+            psfblock ( spi2, bi )   = w;
 
-                sumwr  += Square ( inv[ spi2 ] * ( solpoints[ spi2 ] - solpoints[ spi ] ).Norm () );
-                sumw   += Square ( inv[ spi2 ] );
+                                        // sum-up all weighted radii
+            sumwr  += Square ( w * ( solpoints[ spi2 ] - solpoints[ spi ] ).Norm () );
+            sumw   += Square ( w );
+
+            if ( w > peak ) {
+                peak    = w;
+                peaki   = spi2;
                 }
+            } // for spi2
+
+                                        // store the whole column in the big matrix
+        if ( isresmat || isresmatt ) {
 
-        resmats ( spi, 0 )  = sqrt ( sumwr / NonNull ( sumw ) );
-        } // if resmats
+            for ( int spi2 = 0; spi2 < numsolp; spi2++ )
+                resmat ( spi2, spi )    = psfblock ( spi2, bi );
 
-                                    // !to see where is the actual SP!
-    if ( isresmat || isresmatt )
-        resmat ( spi, spi ) = -1;
+                                        // !to see where is the actual SP!
+            resmat ( spi, spi ) = -1;
+            }
 
-    } // dor spi
 
-OmpParallelEnd
+        if ( isresmats ) {
+
+            resmats ( spi, ResolutionPsfSpatialDispersion )     = sqrt ( sumwr / NonNull ( sumw ) );
+            resmats ( spi, ResolutionPsfLocalizationError )     = ( solpoints[ peaki ] - solpoints[ spi ] ).Norm ();
+            resmats ( spi, ResolutionPsfPeakAmplitude     )     = peak;
+            }
+        } // for bi
+
+
+    if ( ! isresmats )
+        continue;
+
+                                        // cumulate current columns into each row
+    OmpParallelFor
+
+    for ( int spi2 = 0; spi2 < numsolp; spi2++ ) {
+
+        for ( int bi = 0; bi < blocksize; bi++ ) {
+
+            int                 spi             = sp1 + bi;
+            float               w               = psfblock ( spi2, bi );
+
+            ctfsumwr[ spi2 ]   += Square ( w * ( solpoints[ spi ] - solpoints[ spi2 ] ).Norm () );
+            ctfsumw [ spi2 ]   += Square ( w );
+
+            if ( w > ctfpeak[ spi2 ] ) {
+                ctfpeak [ spi2 ]    = w;
+                ctfpeaki[ spi2 ]    = spi;
+                }
+            } // for bi
+        } // for spi2
+
+    } // for blocki
+
+
+if ( isresmats )
+
+    for ( int spi = 0; spi < numsolp; spi++ ) {
+
+        resmats ( spi, ResolutionCtfSpatialDispersion )     = sqrt ( ctfsumwr[ spi ] / NonNull ( ctfsumw[ spi ] ) );
+        resmats ( spi, ResolutionCtfLocalizationError )     = ( solpoints[ ctfpeaki[ spi ] ] - solpoints[ spi ] ).Norm ();
+        resmats ( spi, ResolutionCtfPeakAmplitude     )     = ctfpeak[ spi ];
+        }
+
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
@@ -654,12 +871,11 @@ if ( regularization ) {
     TStrings            regulnames;
 
 
-    ComputeRegularizationFactors ( KKt, EigenvalueToRegularizationFactorMN, regulvalues, regulnames );
+                                        // single decomposition for all regularizations, with the centering matrix
+    TTikhonovInverses   tikhonov ( Kt, KKt, TikhonovCentering );
 
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // centering matrix
-    ASymmetricMatrix    H           = ACenteringMatrix ( numel );
+    ComputeRegularizationFactors ( tikhonov.GetBiggestEigenvalue (), EigenvalueToRegularizationFactorMN, regulvalues, regulnames );
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -668,7 +884,7 @@ if ( regularization ) {
 
         gauge.Next ( gaugemnpseudoinverse );
 
-        J               = Kt * APseudoInverseSymmetric ( KKt + regulvalues[ reg ] * H );
+        J               = tikhonov.GetInverse ( regulvalues[ reg ] );
 
         WriteInverseMatrixFile  (   J,          false, 
                                     xyznames,   spnamesin,  &spsrejected, 
@@ -840,12 +1056,11 @@ if ( regularization ) {
     TStrings            regulnames;
 
 
-    ComputeRegularizationFactors ( KW2Kt, EigenvalueToRegularizationFactorWMN, regulvalues, regulnames );
+                                        // single decomposition for all regularizations, with the centering matrix
+    TTikhonovInverses   tikhonov ( W2Kt, KW2Kt, TikhonovCentering );
 
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // centering matrix
-    ASymmetricMatrix    H           = ACenteringMatrix ( numel );
+    ComputeRegularizationFactors ( tikhonov.GetBiggestEigenvalue (), EigenvalueToRegularizationFactorWMN, regulvalues, regulnames );
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -854,7 +1069,7 @@ if ( regularization ) {
 
         gauge.Next ( gaugewmnpseudoinverse );
 
-        J               = W2Kt * APseudoInverseSymmetric ( KW2Kt + regulvalues[ reg ] * H );
+        J               = tikhonov.GetInverse ( regulvalues[ reg ] );
 
         WriteInverseMatrixFile  (   J,          false, 
                                     xyznames,   spnamesin,  &spsrejected, 
@@ -1352,12 +1567,11 @@ if ( regularization ) {
     TStrings            regulnames;
 
 
-    ComputeRegularizationFactors ( KW1BtBW1Kt, EigenvalueToRegularizationFactorLORETA, regulvalues, regulnames );
+                                        // single decomposition for all regularizations, with the centering matrix
+    TTikhonovInverses   tikhonov ( W1BtBW1Kt, KW1BtBW1Kt, TikhonovCentering );
 
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // centering matrix
-    ASymmetricMatrix    H           = ACenteringMatrix ( numel );
+    ComputeRegularizationFactors ( tikhonov.GetBiggestEigenvalue (), EigenvalueToRegularizationFactorLORETA, regulvalues, regulnames );
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1366,7 +1580,7 @@ if ( regularization ) {
 
         gauge.Next ( gaugeloretapseudoinverse );
 
-        J               = W1BtBW1Kt * APseudoInverseSymmetric ( KW1BtBW1Kt + regulvalues[ reg ] * H );
+        J               = tikhonov.GetInverse ( regulvalues[ reg ] );
 
 
         gauge.Next ( gaugeloretapseudoinverse );
@@ -1444,9 +1658,6 @@ int                 numsolp         = numsolp3 / 3;
 
 gauge.Next ( gaugesloretaglobal );
 
-                                        // centering matrix
-ASymmetricMatrix    H           = ACenteringMatrix ( numel );
-
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // we need these guys a few times
@@ -1463,7 +1674,6 @@ ASymmetricMatrix    KKt             = K * Kt;
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 AMatrix             T;
-AMatrix             Sj;
 
 
 if ( regularization ) {
@@ -1478,7 +1688,10 @@ if ( regularization ) {
                                         // The problem is that it makes the optimal L-corner search more difficult, so we
                                         // need to "zoom in" the regularization factors to spread a bit the searched curve.
                                         // The current 2.5 factor was estimated by comparing the reg curve with standard LORETA.
-    ComputeRegularizationFactors ( KKt, EigenvalueToRegularizationFactorSLORETA, regulvalues, regulnames );
+                                        // single decomposition for all regularizations, with the centering matrix
+    TTikhonovInverses   tikhonov ( Kt, KKt, TikhonovCentering );
+
+    ComputeRegularizationFactors ( tikhonov.GetBiggestEigenvalue (), EigenvalueToRegularizationFactorSLORETA, regulvalues, regulnames );
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1487,27 +1700,25 @@ if ( regularization ) {
 
         gauge.Next ( gaugesloretapseudoinverse );
                                         // simple minimum norm inverse matrix
-        T               = Kt * APseudoInverseSymmetric ( KKt + regulvalues[ reg ] * H );
+        T               = tikhonov.GetInverse ( regulvalues[ reg ] );
 
 
         gauge.Next ( gaugesloretapseudoinverse );
-                                        // Estimated variance, = Resolution Matrix
-                                        // we could extract 3 rows and 3 cols from T and K to have Sj33 directly
-        Sj              = T * K;
 
 
         gauge.Next ( gaugesloretapseudoinverse );
 
         OmpParallelBegin
 
+        AMatrix33       Sj33;
         AMatrix33       Sj33inv;
 
         OmpFor
 
         for ( int sp3 = 0; sp3 < numsolp3; sp3 += 3 ) {
 
-                                        // extract (reference to) 3x3 diagonal part
-            const AMatrix33&    Sj33    = Sj.submat ( sp3, sp3, sp3 + 2, sp3 + 2 );
+                                        // Estimated variance, = Resolution Matrix - only its 3x3 diagonal part is needed
+            Sj33        = T.rows ( sp3, sp3 + 2 ) * K.cols ( sp3, sp3 + 2 );
 
                                         // to standardize with the standard deviation, we need the inverse square root of a matrix
             Sj33inv     = AMatrixInverseSquareRoot ( Sj33 );
@@ -1536,23 +1747,21 @@ else { // no regularization
 
 
     gauge.Next ( gaugesloretapseudoinverse );
-                                        // Estimated variance, = Resolution Matrix
-                                        // we could extract 3 rows and 3 cols from T and K to have Sj33 directly
-    Sj              = T * K;
 
 
     gauge.Next ( gaugesloretapseudoinverse );
 
     OmpParallelBegin
 
+    AMatrix33       Sj33;
     AMatrix33       Sj33inv;
 
     OmpFor
 
     for ( int sp3 = 0; sp3 < numsolp3; sp3 += 3 ) {
 
-                                        // extract 3x3 diagonal part
-        const AMatrix33&    Sj33    = Sj.submat ( sp3, sp3, sp3 + 2, sp3 + 2 );
+                                        // Estimated variance, = Resolution Matrix - only its 3x3 diagonal part is needed
+        Sj33        = T.rows ( sp3, sp3 + 2 ) * K.cols ( sp3, sp3 + 2 );
 
                                         // to standardize with the standard deviation, we need the inverse square root of a matrix
         Sj33inv     = AMatrixInverseSquareRoot ( Sj33 );
@@ -1776,6 +1985,38 @@ for ( int reg = 0; reg < numreg; reg++ ) {
 } // inverseeloreta
 
 
+//----------------------------------------------------------------------------
+                                        // Diagonal of the Dale noise variance  T * ( regul * H ) * T^T
+                                        // H being the centering matrix, each diagonal term is  regul * ( |Ti|^2 - ( Sum Ti )^2 / numel )
+                                        // so we can skip the full ( 3 * numsolp )^2 matrix product
+void    ComputeDaleNoiseVariance    (   const AMatrix&  T,  double  regul,  AVector&    sjdale  )
+{
+int                 numsolp3        = T.n_rows;
+int                 numel           = T.n_cols;
+
+sjdale.AResizeFast ( numsolp3 );
+
+
+OmpParallelFor
+
+for ( int i = 0; i < numsolp3; i++ ) {
+
+    double          sum             = 0;
+    double          sum2            = 0;
+
+    for ( int el = 0; el < numel; el++ ) {
+
+        double      v               = T ( i, el );
+
+        sum    += v;
+        sum2   += v * v;
+        }
+
+    sjdale ( i )    = AtLeast ( 0.0, regul * ( sum2 - sum * sum / numel ) );
+    }
+}
+
+
 //----------------------------------------------------------------------------
 void    ComputeInverseDale      (   
                                 const AMatrix&      Kin,            TSelection              spsrejected,
@@ -1841,7 +2082,7 @@ ASymmetricMatrix    KKt             = K * Kt;
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 AMatrix             T;
-AMatrix             SjDale;             // variance according to Dale formula, focusing only on the noise part
+AVector             SjDale;             // variance according to Dale formula, focusing only on the noise part - diagonal only
 double              regvalue;
 
 
@@ -1854,7 +2095,10 @@ if ( regularization ) {
     TStrings            regulnames;
 
 
-    ComputeRegularizationFactors ( KKt, EigenvalueToRegularizationFactorDale, regulvalues, regulnames );
+                                        // single decomposition for all regularizations, with the centering matrix
+    TTikhonovInverses   tikhonov ( Kt, KKt, TikhonovCentering );
+
+    ComputeRegularizationFactors ( tikhonov.GetBiggestEigenvalue (), EigenvalueToRegularizationFactorDale, regulvalues, regulnames );
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1867,12 +2111,12 @@ if ( regularization ) {
 
         gauge.Next ( gaugedalepseudoinverse );
                                         // simple minimum norm inverse matrix
-        T               = Kt * APseudoInverseSymmetric ( KKt + regvalue * H );
+        T               = tikhonov.GetInverse ( regvalue );
 
 
         gauge.Next ( gaugedalepseudoinverse );
                                         // Dale formula, a priori noise model
-        SjDale          = T * ( ( regvalue * H ) * T.t () );
+        ComputeDaleNoiseVariance ( T, regvalue, SjDale );
 
 
         gauge.Next ( gaugedalepseudoinverse );
@@ -1886,9 +2130,9 @@ if ( regularization ) {
         for ( int sp3 = 0; sp3 < numsolp3; sp3 += 3 ) {
 
                                       // Dale - power should be 0.25, but 0.30 looks less superficial
-            Diag ( 0, 0 ) = SjDale ( sp3    , sp3     ) ? 1 / powl ( SjDale ( sp3    , sp3     ), 0.25 /*0.30*/ ) : 1;
-            Diag ( 1, 1 ) = SjDale ( sp3 + 1, sp3 + 1 ) ? 1 / powl ( SjDale ( sp3 + 1, sp3 + 1 ), 0.25 /*0.30*/ ) : 1;
-            Diag ( 2, 2 ) = SjDale ( sp3 + 2, sp3 + 2 ) ? 1 / powl ( SjDale ( sp3 + 2, sp3 + 2 ), 0.25 /*0.30*/ ) : 1;
+            Diag ( 0, 0 ) = SjDale ( sp3     ) ? 1 / powl ( SjDale ( sp3     ), 0.25 /*0.30*/ ) : 1;
+            Diag ( 1, 1 ) = SjDale ( sp3 + 1 ) ? 1 / powl ( SjDale ( sp3 + 1 ), 0.25 /*0.30*/ ) : 1;
+            Diag ( 2, 2 ) = SjDale ( sp3 + 2 ) ? 1 / powl ( SjDale ( sp3 + 2 ), 0.25 /*0.30*/ ) : 1;
 
                                         // Dale rescale submatrix of 3 rows for current solution point
             T.rows ( sp3, sp3 + 2 )     = Diag * T.rows ( sp3, sp3 + 2 );
@@ -1921,7 +2165,7 @@ else { // no regularization - actually this case shouldn't be used, as there is
 
     gauge.Next ( gaugedalepseudoinverse );
                                         // Dale formula, a priori noise model
-    SjDale          = T * ( ( regvalue * H ) * T.t () );
+    ComputeDaleNoiseVariance ( T, regvalue, SjDale );
 
 
     gauge.Next ( gaugedalepseudoinverse );
@@ -1935,9 +2179,9 @@ else { // no regularization - actually this case shouldn't be used, as there is
     for ( int sp3 = 0; sp3 < numsolp3; sp3 += 3 ) {
 
                                       // Dale - power should be 0.25, but 0.30 looks less superficial
-        Diag ( 0, 0 ) = SjDale ( sp3    , sp3     ) ? 1 / powl ( SjDale ( sp3    , sp3     ), 0.25 /*0.30*/ ) : 1;
-        Diag ( 1, 1 ) = SjDale ( sp3 + 1, sp3 + 1 ) ? 1 / powl ( SjDale ( sp3 + 1, sp3 + 1 ), 0.25 /*0.30*/ ) : 1;
-        Diag ( 2, 2 ) = SjDale ( sp3 + 2, sp3 + 2 ) ? 1 / powl ( SjDale ( sp3 + 2, sp3 + 2 ), 0.25 /*0.30*/ ) : 1;
+        Diag ( 0, 0 ) = SjDale ( sp3     ) ? 1 / powl ( SjDale ( sp3     ), 0.25 /*0.30*/ ) : 1;
+        Diag ( 1, 1 ) = SjDale ( sp3 + 1 ) ? 1 / powl ( SjDale ( sp3 + 1 ), 0.25 /*0.30*/ ) : 1;
+        Diag ( 2, 2 ) = SjDale ( sp3 + 2 ) ? 1 / powl ( SjDale ( sp3 + 2 ), 0.25 /*0.30*/ ) : 1;
 
                                         // Dale rescale submatrix of 3 rows for current solution point
         T.rows ( sp3, sp3 + 2 )     = Diag * T.rows ( sp3, sp3 + 2 );
@@ -2388,7 +2632,10 @@ if ( regularization ) {
     TStrings            regulnames;
 
 
-    ComputeRegularizationFactors ( KWjKt, EigenvalueToRegularizationFactorLAURA, regulvalues, regulnames );
+                                        // single decomposition for all regularizations, with the identity matrix
+    TTikhonovInverses   tikhonov ( WjKt, KWjKt, TikhonovIdentity );
+
+    ComputeRegularizationFactors ( tikhonov.GetBiggestEigenvalue (), EigenvalueToRegularizationFactorLAURA, regulvalues, regulnames );
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -2400,14 +2647,11 @@ if ( regularization ) {
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Matrices with Tikhonov regularization
-    ASymmetricMatrix    I               = AMatrixIdentity ( numel );
-
-
     for ( int reg = 0; reg < numreg; reg++ ) {
 
         gauge.Next ( gaugelaurapseudoinverse );
 
-        J               = WjKt * APseudoInverseSymmetric ( KWjKt + regulvalues[ reg ] * I );
+        J               = tikhonov.GetInverse ( regulvalues[ reg ] );
 
 
         gauge.Next ( gaugelaurapseudoinverse );
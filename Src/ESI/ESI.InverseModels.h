@@ -111,6 +111,81 @@ void    ComputeRegularizationFactors (
                                 TVector<double>&            regulvalues,    TStrings&       regulnames 
                                 );
 
+void    ComputeRegularizationFactors (
+                                double                      biggesteigen,   double          eigenvaluedownfactor, 
+                                TVector<double>&            regulvalues,    TStrings&       regulnames 
+                                );
+
+
+//----------------------------------------------------------------------------
+                                        // Regularization term added to the inverted matrix
+enum            TikhonovRegularizerType
+                {
+                TikhonovCentering,      // centering matrix H
+                TikhonovIdentity,       // identity matrix I
+                };
+
+                                        // Computes all the Tikhonov regularized inverses   J(regul) = B * ( A + regul * R )^+
+                                        // from a single eigen decomposition of A, R being either the centering or the identity matrix.
+                                        // Since A and R share their eigenvectors, only the spectrum has to be changed for each regularization:
+                                        //      J(regul) = ( B * V ) * diag ( 1 / ( D + regul ) ) * V^T
+                                        // For the centering matrix, this holds when A is average referenced, which is the case of all our lead fields.
+                                        // If not, it falls back to one pseudo-inverse per regularization, with the exact same results.
+                                        // The factors are internal only: each regularization is returned, and saved, as a full matrix.
+class   TTikhonovInverses
+{
+public:
+                    TTikhonovInverses   ()                                                                          { Reset (); }
+                    TTikhonovInverses   ( const AMatrix& B, const ASymmetricMatrix& A, TikhonovRegularizerType r )  { Set ( B, A, r ); }
+
+
+    void            Reset               ();
+    void            Set                 ( const AMatrix& B, const ASymmetricMatrix& A, TikhonovRegularizerType regularizer );
+
+
+    double          GetBiggestEigenvalue()                  const   { return    BiggestEigen;   }
+
+    AMatrix         GetInverse          ( double regul )    const;  // full inverse matrix  B * ( A + regul * R )^+
+
+
+protected:
+
+    TikhonovRegularizerType Regularizer;
+    bool                    Factorized;
+    double                  BiggestEigen;
+
+    AMatrix                 BV;         // B * V
+    AMatrix                 V;          // eigenvectors of A
+    AVector                 D;          // eigenvalues of A
+    int                     NullIndex;  // eigenvector which is not regularized by the centering matrix, -1 otherwise
+
+    AMatrix                 B;          // only kept when not factorized
+    ASymmetricMatrix        A;
+
+
+    AVector         GetSpectrum         ( double regul )    const;  // central diagonal part, the pseudo-inverted  D + regul
+};
+
+//----------------------------------------------------------------------------
+                                        // Resolution matrix  R = J * K  is computed by blocks of solution points, to limit memory usage
+constexpr int       ResolutionMatrixBlockSize   = 256;
+
+                                        // Summary metrics, one per time frame of the summary file, for each solution point:
+                                        //  - Point Spread Function  (PSF, column of R): how the source at this point is spread to all points
+                                        //  - Cross-Talk Function    (CTF, row of R):    how all points leak into the estimate of this point
+enum            ResolutionMetrics
+                {
+                ResolutionPsfSpatialDispersion,     // sqrt of the distances variance, weighted by the squared PSF
+                ResolutionPsfLocalizationError,     // distance from the point to the PSF peak
+                ResolutionPsfPeakAmplitude,         // PSF peak value
+                ResolutionCtfSpatialDispersion,
+                ResolutionCtfLocalizationError,
+                ResolutionCtfPeakAmplitude,
+
+                NumResolutionMetrics
+                };
+
+
 void    ComputeResolutionMatrix (   
                                 const AMatrix&      K,              const TPoints&      solpoints,
                                 const char*         fileinverse,
@@ -23,8 +23,10 @@ limitations under the License.
 #include    "CartoolTypes.h"
 #include    "Strings.Utils.h"
 #include    "Geometry.TPoints.h"
+#include    "Geometry.TPointsIndex.h"
 #include    "Geometry.TDipole.h"
 #include    "TArray1.h"
+#include    "TArray2.h"
 #include    "TArray3.h"
 #include    "Math.Resampling.h"
 #include    "Dialogs.TSuperGauge.h"
@@ -110,121 +112,165 @@ else if ( IsMouse () ) {
 
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
-                                        // Nearest neighbors interpolation
-/*void    InterpolateLeadFieldNN ( Matrix& K, TPoints& inputsolpoint, int nnsize, int nnpower, TPoints& outputsolpoint )
+                                        // Nearest neighbors interpolation, for any kind of solution points (not only grid-aligned)
+                                        // Weights are inversely proportional to the normalized distances, at the given power
+                                        // Neighbors come from the spatial index, while bruteforce runs the original method: computing and sorting all distances
+                                        // for each point, then summing up in double precision - it gives the exact same results as before the spatial index
+                                        // can update spsrejected
+void    InterpolateLeadFieldNN      (   AMatrix&        K,                  const TPoints&          inputsolpoint,  
+                                        TPoints&        outputsolpoint,     TSelection&             spsrejected,
+                                        int             nnsize,             double                  nnpower,
+                                        bool            bruteforce
+                                    )
 {
+int                 numsolpsrc      = (int) inputsolpoint;
+int                 numsolptrg      = (int) outputsolpoint;
+
+if ( numsolpsrc == 0 || numsolptrg == 0 )
+    return;
+
+Clipped ( nnsize, 1, numsolpsrc );
+
+
 TSuperGauge         gauge;
 
 gauge.Set ( "Lead Field Interpolation" );
 
-gauge.AddPart ( 0, (int) outputsolpoint, 100 );
+gauge.AddPart ( 0, numsolptrg, 100 );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // get all dimensions
-int                 numel           = K.Nrows ();
-//int                 numsolpsrc3     = K.Ncols ();
-//int                 numsolpsrc      = numsolpsrc3 / 3;
-int                 numsolptrg      = (int) outputsolpoint;
+int                 numel           = K.n_rows;
 int                 numsolptrg3     = numsolptrg  * 3;
 
                                         // allocate new downsampled matrix
-Matrix              Ktrg ( numel, numsolptrg3 );
-
+AMatrix             Ktrg            = AMatrixZero ( numel, numsolptrg3 );
 
-TArray2< double >   dist ( (int) inputsolpoint, 2 );
 double              step            = inputsolpoint.GetMedianDistance ();
-int                 ini;
-double              sumx;
-double              sumy;
-double              sumz;
-double              sumw;
-//TEasyStats          statd ( (int) outputsolpoint );
-//TFileName           buff;
+auto                spindex         = inputsolpoint.GetIndex ();
+const TPoints&      outputpoints    = outputsolpoint;
 
 
+OmpParallelBegin
+
+vector<TPointsNeighbor> neighbors;
+
+#if defined(CHECKASSERT)
+bool                sorteddist      = true;
+#else
+bool                sorteddist      = bruteforce;
+#endif
+                                        // original method: all distances to the target point, sorted
+TArray2<double>     dist ( sorteddist ? numsolpsrc : 0, 2 );
+
+OmpFor
                                         // scan each target point
-for ( int outi = 0; outi < (int) outputsolpoint; outi++ ) {
+for ( int outi = 0; outi < numsolptrg; outi++ ) {
 
     gauge.Next ( 0 );
 
+                                        // caller wants to ignore this point, let the LF to 0
+    if ( spsrejected[ outi ] )
+        continue;
+
+
+    if ( sorteddist ) {
                                         // compute all relative distances to target point
-    for ( int ini = 0; ini < (int) inputsolpoint; ini++ ) {
-        dist ( ini, 0 )     = ( *inputsolpoint[ ini ] - *outputsolpoint[ outi ] ).Norm2 ();
-        dist ( ini, 1 )     = ini;
-        }
+        for ( int ini = 0; ini < numsolpsrc; ini++ ) {
+            dist ( ini, 0 )     = ( inputsolpoint[ ini ] - outputpoints[ outi ] ).Norm2 ();
+            dist ( ini, 1 )     = ini;
+            }
 
                                         // sort by distances
-    dist.Sort ( Ascending, 0 );
+        dist.SortRows ( 0, Ascending );
+        }
 
-//    statd.Add ( dist ( 0, 0 ) );
 
-                                        // special case: landing right onto a point?
-    if ( dist ( 0, 0 ) == 0 ) {
-                                        // get index of source point
-        ini      = dist ( 0, 1 );
-                                        // then simply copy that single point values
-        for ( int el = 0; el < numel; el++ ) {
-            Ktrg[ el ][ 3 * outi     ]  = K[ el ][ 3 * ini     ];
-            Ktrg[ el ][ 3 * outi + 1 ]  = K[ el ][ 3 * ini + 1 ];
-            Ktrg[ el ][ 3 * outi + 2 ]  = K[ el ][ 3 * ini + 2 ];
+    if ( bruteforce ) {
+
+        neighbors.resize ( nnsize );
+
+        for ( int nni = 0; nni < nnsize; nni++ ) {
+            neighbors[ nni ].Index      = (int) dist ( nni, 1 );
+            neighbors[ nni ].Distance2  = dist ( nni, 0 );
             }
+        }
+    else {
+
+        spindex->GetKNearest ( outputpoints[ outi ], nnsize, neighbors );
 
-        } // dist == 0
+#if defined(CHECKASSERT)
+                                        // same distances as the original method - only the order of equidistant neighbors could differ
+        assert ( (int) neighbors.size () == nnsize );
 
-    else { // dist != 0
+        for ( int nni = 0; nni < nnsize; nni++ )
+            assert ( RelativeDifference ( neighbors[ nni ].Distance2, dist ( nni, 0 ) ) < 1e-5 );
+#endif
+        }
+
+
+    auto                tocols          = Ktrg.cols ( 3 * outi, 3 * outi + 2 );
+
+                                        // special case: landing right onto a point?
+    if ( neighbors[ 0 ].Distance2 == 0 ) {
+                                        // then simply copy that single point values
+        int                 ini             = neighbors[ 0 ].Index;
+
+        tocols  = K.cols ( 3 * ini, 3 * ini + 2 );
+        continue;
+        }
 
-        sumw        = 0;
                                         // weights are inversely proportional to distance
-        for ( int nni = 0; nni < nnsize; nni++ ) {
-            dist ( nni, 0 )     = 1 / Power ( sqrt ( dist ( nni, 0 ) ) / step, nnpower );
-            sumw               += dist ( nni, 0 );
-            }
+    double              sumw            = 0;
+
+    for ( int nni = 0; nni < nnsize; nni++ ) {
+        neighbors[ nni ].Distance2  = 1 / Power ( sqrt ( neighbors[ nni ].Distance2 ) / step, nnpower );
+        sumw                       += neighbors[ nni ].Distance2;
+        }
 
-//#if defined(CHECKASSERT)
-//      assert ( sumw != 0 );
-//#endif
 
-                                        // compute interpolated values
+    if ( bruteforce )
+                                        // compute interpolated values, each electrode summed up in double precision
         for ( int el = 0; el < numel; el++ ) {
 
-            sumx    = sumy  = sumz  = 0;
+            double              sumx            = 0;
+            double              sumy            = 0;
+            double              sumz            = 0;
 
             for ( int nni = 0; nni < nnsize; nni++ ) {
-                ini         = dist ( nni, 1 );
 
-                sumx       += K[ el ][ 3 * ini     ] * dist ( nni, 0 );
-                sumy       += K[ el ][ 3 * ini + 1 ] * dist ( nni, 0 );
-                sumz       += K[ el ][ 3 * ini + 2 ] * dist ( nni, 0 );
-                } // for nni
+                int                 ini             = neighbors[ nni ].Index;
 
-            Ktrg[ el ][ 3 * outi     ]  = sumx / sumw;
-            Ktrg[ el ][ 3 * outi + 1 ]  = sumy / sumw;
-            Ktrg[ el ][ 3 * outi + 2 ]  = sumz / sumw;
-            } // for el
+                sumx       += K ( el, 3 * ini     ) * neighbors[ nni ].Distance2;
+                sumy       += K ( el, 3 * ini + 1 ) * neighbors[ nni ].Distance2;
+                sumz       += K ( el, 3 * ini + 2 ) * neighbors[ nni ].Distance2;
+                }
 
-        } // dist != 0
+            Ktrg ( el, 3 * outi     )   = sumx / sumw;
+            Ktrg ( el, 3 * outi + 1 )   = sumy / sumw;
+            Ktrg ( el, 3 * outi + 2 )   = sumz / sumw;
+            }
 
-    } // for outi
+    else
+                                        // compute interpolated values, the 3 dipole components at once
+        for ( int nni = 0; nni < nnsize; nni++ ) {
 
-/*
-statd.Sort ( true );
-statd.Show ( "Min Distances" );
+            int                 ini             = neighbors[ nni ].Index;
+
+            tocols += K.cols ( 3 * ini, 3 * ini + 2 ) * (AReal) ( neighbors[ nni ].Distance2 / sumw );
+            }
+
+    } // for outi
 
-TVector<double>     curve;
-statd.ComputeHistogram ( 0, 0, 0, 3, 3, true, curve );
+OmpParallelEnd
 
-TFileName           _file;
-StringCopy ( _file, "E:\\Data\\NN Shortest Distance Histo.ep" );
-curve.WriteFile ( _file );
-* /
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // return downsampled version
 K   = Ktrg;
-
 }
-*/
+
 
 //----------------------------------------------------------------------------
                                         // Linear interpolation between 2 vectors (could be any dimensions BTW)
@@ -375,6 +421,8 @@ for ( int ini = 0; ini < (int) inputsolpoint; ini++ ) {
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+OmpParallelBegin
+
 int                 index [ 8 ];
 TPointFloat         v000;
 TPointFloat         v001;
@@ -385,11 +433,8 @@ TPointFloat         v101;
 TPointFloat         v110;
 TPointFloat         v111;
 
-
-//TEasyStats          statd ( (int) outputsolpoint );
-//TFileName           buff;
-
-                                        // scan each target point
+OmpFor
+                                        // scan each target point, each one writing to its own columns
 for ( int outi = 0; outi < (int) outputsolpoint; outi++ ) {
 
     gauge.Next ( 0 );
@@ -419,7 +464,9 @@ for ( int outi = 0; outi < (int) outputsolpoint; outi++ ) {
 
         if ( spvol.GetValueChecked ( p.X,     p.Y,     p.Z     ) == 0 ) {
 
+            OmpCriticalBegin (InterpolateLeadFieldLinear)
             spsrejected.Set ( outi );   // shouldn't happen, but let's update the rejected points
+            OmpCriticalEnd
             continue;                   // let the LF to 0
             } // neighbor not OK
 
@@ -448,7 +495,9 @@ for ( int outi = 0; outi < (int) outputsolpoint; outi++ ) {
           && spvol.GetValueChecked ( p.X,     p.Y + 1, p.Z + 1 ) != 0
           && spvol.GetValueChecked ( p.X + 1, p.Y + 1, p.Z + 1 ) != 0 ) ) {
 
+        OmpCriticalBegin (InterpolateLeadFieldLinear)
         spsrejected.Set ( outi );       // in case SP without enough neighbors, default is to just clear up the LF at this position - update the rejected points, too
+        OmpCriticalEnd
         continue;                       // let the LF to 0
         } // neighbors not OK
 
@@ -486,16 +535,7 @@ for ( int outi = 0; outi < (int) outputsolpoint; outi++ ) {
 
     } // for outi
 
-/*
-statd.Show ( "Min Distances" );
-
-TVector<double>     curve;
-statd.ComputeHistogram ( 0, 0, 0, 3, 3, true, curve );
-
-TFileName           _file;
-StringCopy ( _file, "E:\\Data\\NN Shortest Distance Histo.ep" );
-curve.WriteFile ( _file );
-*/
+OmpParallelEnd
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // return downsampled version
@@ -1334,12 +1374,74 @@ int             potisosp;
 #define     PotentialIsotropicNLayersMaxTerms       300
 #define     PotentialIsotropicNLayersError          1e-6
 
+                                        // Shell-dependent factor of term n, fn from equ. 2I 3I 4I p.340
+                                        // It only depends on the radii and conductivities, not on the dipole or the electrode direction
+long double     IsotropicNShellTerm (   int                     n,
+                                        const TArray1<double>&  R,          const TArray1<double>&  sigma
+                                    )
+{
+int                 numlayers       = R.GetDim ();
+long double         m11, m12, m21, m22;
+long double         p11, p12, p21, p22;
+long double         t11, t12, t21, t22;
+
+                                        // Mixing up radii and (isotropic) conductivities here (equ. 4I p.340)
+
+                                        // init matrix to identity - also fine if numlayers == 1
+m11 = 1;    m12 = 0;
+m21 = 0;    m22 = 1;
+
+                                        // !index shift of -1 compared to article!
+for ( int k = 0; k < numlayers - 1; k++ ) {
+
+                                        // here we can see that only the ratio of the conductivities between 2 successive layers matters
+    long double     sksk1       = sigma[ k ] / sigma[ k + 1 ];
+                                        // here we can see that only the relative radii ratio to the electrode / outer shell matters
+                                        // radii are already within a normalized sphere, Re = R[numlayers-1] = 1
+    p11     = n        + ( n + 1 ) *   sksk1;                                           p12     =            ( n + 1 ) * ( sksk1 - 1 ) * powl ( 1 / R[ k ], 2 * n + 1 );
+    p21     =              n       * ( sksk1 - 1 ) * powl (     R[ k ], 2 * n + 1 );    p22     = ( n + 1 ) +  n       *   sksk1;
+
+                                        // copying to temp
+    t11     = m11; t12     = m12; 
+    t21     = m21; t22     = m22;
+
+                                        // right multiplication   M1 x M2 x ... x Mnumlayers-1
+    m11     = t11 * p11 + t12 * p21;    m12     = t11 * p12 + t12 * p22;
+    m21     = t21 * p11 + t22 * p21;    m22     = t21 * p12 + t22 * p22;
+    }
+
+                                        // also fine if numlayers == 1
+long double         mden            = powl ( 2 * n + 1, numlayers - 1 );
+
+//m11    /= mden;    m12    /= mden;    // not needed
+m21    /= mden;    m22    /= mden;
+
+                                        // Isotropic conductivities in all layers -> fn = gn (equ. 2I 3I p.340)
+return  n / ( n * m22 + ( 1 + n ) * m21 );
+}
+
+                                        // Tabulating all the fn terms once per head model, i.e. per electrode, as they are shared by all solution points
+                                        // Results are the very same as the term by term computation, only without the repeated layers products
+void            IsotropicNShellTerms(   const TArray1<double>&  R,          const TArray1<double>&  sigma,
+                                        int                     maxterms,   TArray1<long double>&   fn
+                                    )
+{
+fn.Resize ( maxterms + 1 );
+
+fn[ 0 ]     = 0;                        // series starts at n = 1
+
+for ( int n = 1; n <= maxterms; n++ )
+
+    fn[ n ]     = IsotropicNShellTerm ( n, R, sigma );
+}
+
 
 double          PotentialIsotropicNShellExactSphericalLegendre  (   
                                                 TDipole&                dipole,     PotentialFlags          flags,
                                                 const TPointFloat&      electrodepos,
                                                 const TArray1<double>&  R,          const TArray1<double>&  sigma,
-                                                int                     maxterms,   double                  convergence
+                                                int                     maxterms,   double                  convergence,
+                                                const TArray1<long double>* fnterms
                                                 )
 {
 if ( electrodepos.IsNull () )
@@ -1457,10 +1559,11 @@ if ( RelativeDifference ( fabs ( cosalpha ), 1 ) < SingleFloatEpsilon ) {
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+                                        // use the caller's tabulated terms, if they go far enough
+if ( fnterms != 0 && fnterms->GetDim () <= maxterms )
+    fnterms     = 0;
+
 long double         RoRe;
-long double         m11, m12, m21, m22;
-long double         p11, p12, p21, p22;
-long double         t11, t12, t21, t22;
 long double         fn;
 //long double       Pn;
 //long double       Pln;
@@ -1479,41 +1582,8 @@ for ( int n = 1; n <= maxterms; n++ ) {
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Mixing up radii and (isotropic) conductivities here (equ. 4I p.340)
-
-                                        // init matrix to identity - also fine if numlayers == 1
-    m11 = 1;    m12 = 0;
-    m21 = 0;    m22 = 1;
-
-                                        // !index shift of -1 compared to article!
-    for ( int k = 0; k < numlayers - 1; k++ ) {
-
-                                        // here we can see that only the ratio of the conductivities between 2 successive layers matters
-        long double     sksk1       = sigma[ k ] / sigma[ k + 1 ];
-                                        // here we can see that only the relative radii ratio to the electrode / outer shell matters
-                                        // radii are already within a normalized sphere, Re = R[numlayers-1] = 1
-        p11     = n        + ( n + 1 ) *   sksk1;                                           p12     =            ( n + 1 ) * ( sksk1 - 1 ) * powl ( 1 / R[ k ], 2 * n + 1 );
-        p21     =              n       * ( sksk1 - 1 ) * powl (     R[ k ], 2 * n + 1 );    p22     = ( n + 1 ) +  n       *   sksk1;
-
-                                        // copying to temp
-        t11     = m11; t12     = m12; 
-        t21     = m21; t22     = m22;
-
-                                        // right multiplication   M1 x M2 x ... x Mnumlayers-1
-        m11     = t11 * p11 + t12 * p21;    m12     = t11 * p12 + t12 * p22;
-        m21     = t21 * p11 + t22 * p21;    m22     = t21 * p12 + t22 * p22;
-        }
-
-                                        // also fine if numlayers == 1
-    long double mden        = powl ( 2 * n + 1, numlayers - 1 );
-
-//  m11    /= mden;    m12    /= mden;  // not needed
-    m21    /= mden;    m22    /= mden;
-
-
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Isotropic conductivities in all layers -> fn = gn (equ. 2I 3I p.340)
-    fn      = n / ( n * m22 + ( 1 + n ) * m21 );
+                                        // Mixing up radii and (isotropic) conductivities
+    fn      = fnterms ? (*fnterms)[ n ] : IsotropicNShellTerm ( n, R, sigma );
 
 
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1733,6 +1803,13 @@ for ( int ei = 0; ei < numel; ei++ ) {
         R[ 5 ]  = 1;
         }
 
+                                        // shells terms of the series are the same for all solution points of this electrode
+    TArray1<long double>    fnterms;
+
+    if ( lfpreset.IsIsotropicNShellSpherical () )
+
+        IsotropicNShellTerms ( R, sigma, PotentialIsotropicNLayersMaxTerms, fnterms );
+
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Here we use the n layers corrected solution points
@@ -1772,7 +1849,8 @@ for ( int ei = 0; ei < numel; ei++ ) {
             PotentialIsotropicNShellExactSphericalLegendre  (   dipolesph,  ComputeLeadField,
                                                                 electrodepos,
                                                                 R,          sigma, 
-                                                                PotentialIsotropicNLayersMaxTerms, PotentialIsotropicNLayersError
+                                                                PotentialIsotropicNLayersMaxTerms, PotentialIsotropicNLayersError,
+                                                                &fnterms
                                                             );
                                         // rescaling for sphere of arbitrary radius
                                // not sure why this 1000     radius converted to [m]
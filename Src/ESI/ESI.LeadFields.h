@@ -105,6 +105,10 @@ public:
 
 void            InterpolateLeadFieldLinear      (   AMatrix&            K,              const TPoints&      inputsolpoint,  
                                                     TPoints&            outputsolpoint, TSelection&         spsrejected     );
+void            InterpolateLeadFieldNN          (   AMatrix&            K,              const TPoints&      inputsolpoint,  
+                                                    TPoints&            outputsolpoint, TSelection&         spsrejected,
+                                                    int                 nnsize,         double              nnpower,
+                                                    bool                bruteforce = false  );
 void            CheckNullLeadField              (   const AMatrix&      K,              TSelection&         spsrejected     );
 
 void            RejectPointsFromLeadField       (   AMatrix&            K,              const TSelection&   spsrejected     );
@@ -177,11 +181,22 @@ double          PotentialIsotropic3ShellApproxSphericalAry (
                                             const TArray1<double>&  R,          const TArray1<double>&  sigma
                                             );
 
+long double     IsotropicNShellTerm         (
+                                            int                     n,
+                                            const TArray1<double>&  R,          const TArray1<double>&  sigma
+                                            );
+
+void            IsotropicNShellTerms        (
+                                            const TArray1<double>&  R,          const TArray1<double>&  sigma,
+                                            int                     maxterms,   TArray1<long double>&   fn
+                                            );
+
 double          PotentialIsotropicNShellExactSphericalLegendre (   
                                             TDipole&                dipole,     PotentialFlags          flags,
                                             const TPointFloat&      electrodepos,
                                             const TArray1<double>&  R,          const TArray1<double>&  sigma,
-                                            int                     maxterms,   double                  convergence
+                                            int                     maxterms,   double                  convergence,
+                                            const TArray1<long double>* fnterms = 0     // optional tabulated shells terms, from IsotropicNShellTerms
                                             );
 
 
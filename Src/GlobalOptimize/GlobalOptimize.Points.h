@@ -169,6 +169,7 @@ public:
     void            Reset ();
 
     double          Evaluate                ( TEasyStats *stat = 0 );
+    bool            IsEvaluateThreadSafe    ()  const   { return true; }
 
     void            Transform               ( TPointFloat &p )  const;
     TVector3Float   GetTranslation          ()  const   { return TVector3Float ( (GLfloat) HasValue ( TranslationX ) ? GetValue ( TranslationX ) : 0, 
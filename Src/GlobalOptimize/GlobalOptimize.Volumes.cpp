@@ -22,7 +22,6 @@ limitations under the License.
 #include    "Math.Histo.h"
 #include    "Math.Resampling.h"
 #include    "GlobalOptimize.Tracks.h"
-#include    "TCacheVolumes.h"
 #include    "TFilters.h"
 #include    "Dialogs.TSuperGauge.h"
 
@@ -267,26 +266,29 @@ if     ( How == SagittalPlaneSymmetric
       || How == SagittalPlaneSymmetricT1
       || How == SagittalPlaneSymmetricT1Gad )
 
-    EvaluateSagittalPlaneMatrix ();
+    EvaluateSagittalPlaneMatrix ( NormToMRI, Center );
 
 else if ( How == TransversePlaneGuillotine )
                                         // !original NormToMRI will be lost!
-    EvaluateTransversePlaneGuillotineMatrix ( NormToMRI );
+    EvaluateTransversePlaneGuillotineMatrix ( NormToMRI, Center );
 
 else if ( How == TransversePlaneLongest
        || How == TransversePlaneBiggestBox
        || How == TransversePlaneBiggestSurface ) {
                                         // !original NormToMRI will be lost!
-    EvaluateTransversePlaneMatrix ( NormToMRI );
+    EvaluateTransversePlaneMatrix ( NormToMRI, Center );
 
     CenterSlice ();
     }
 
 else if ( IsTransversePlaneMNI ( How ) ) {
                                         // doing this will return the slice adjusted to the MNI space - another option, but not the one we want here
-//  EvaluateTransversePlaneMatrix ( NormToMRI );
+//  EvaluateTransversePlaneMatrix ( NormToMRI, Center );
 
                                         // instead, we just update the translation and the rotation, skipping the scaling
+    if ( HasValue( TranslationZ ) )             Center[ UpDownIndex    ]    = GetValue ( TranslationZ );
+    if ( HasValue( TranslationY ) )             Center[ FrontBackIndex ]    = GetValue ( TranslationY );
+
                                                 NormToMRI.SetTranslation ( Center[ 0 ], Center[ 1 ], Center[ 2 ] );
 
     if ( HasValue( RotationX ) )                NormToMRI.RotateX ( GetValue ( RotationX ), MultiplyRight );
@@ -315,27 +317,27 @@ else                                                return  0;
 
 
 //----------------------------------------------------------------------------
-inline void TVolumeProperties::EvaluateSagittalPlaneMatrix ()
+inline void TVolumeProperties::EvaluateSagittalPlaneMatrix ( TMatrix44& normtomri, TPointDouble& center )  const
 {
                                         // compute the transformation matrix
-NormToMRI       = InvStandardOrient;
+normtomri       = InvStandardOrient;
 
 
-if ( HasValue( TranslationX ) ) Center[ LeftRightIndex ]    = GetValue ( TranslationX );
-if ( HasValue( TranslationY ) ) Center[ FrontBackIndex ]    = GetValue ( TranslationY );
-if ( HasValue( TranslationZ ) ) Center[ UpDownIndex    ]    = GetValue ( TranslationZ );
+if ( HasValue( TranslationX ) ) center[ LeftRightIndex ]    = GetValue ( TranslationX );
+if ( HasValue( TranslationY ) ) center[ FrontBackIndex ]    = GetValue ( TranslationY );
+if ( HasValue( TranslationZ ) ) center[ UpDownIndex    ]    = GetValue ( TranslationZ );
 
 
-                                NormToMRI.Translate ( Center[ 0 ], Center[ 1 ], Center[ 2 ], MultiplyLeft );
+                                normtomri.Translate ( center[ 0 ], center[ 1 ], center[ 2 ], MultiplyLeft );
 
 
-if ( HasValue( ShearYtoX ) || HasValue( ShearZtoX ) )   NormToMRI.ShearX  ( GetValue ( ShearYtoX ), GetValue ( ShearZtoX ), MultiplyRight );
-if ( HasValue( ShearXtoY ) || HasValue( ShearZtoY ) )   NormToMRI.ShearY  ( GetValue ( ShearXtoY ), GetValue ( ShearZtoY ), MultiplyRight );
-if ( HasValue( ShearXtoZ ) || HasValue( ShearYtoZ ) )   NormToMRI.ShearZ  ( GetValue ( ShearXtoZ ), GetValue ( ShearYtoZ ), MultiplyRight );
+if ( HasValue( ShearYtoX ) || HasValue( ShearZtoX ) )   normtomri.ShearX  ( GetValue ( ShearYtoX ), GetValue ( ShearZtoX ), MultiplyRight );
+if ( HasValue( ShearXtoY ) || HasValue( ShearZtoY ) )   normtomri.ShearY  ( GetValue ( ShearXtoY ), GetValue ( ShearZtoY ), MultiplyRight );
+if ( HasValue( ShearXtoZ ) || HasValue( ShearYtoZ ) )   normtomri.ShearZ  ( GetValue ( ShearXtoZ ), GetValue ( ShearYtoZ ), MultiplyRight );
 
-if ( HasValue( RotationX ) )    NormToMRI.RotateX ( GetValue ( RotationX ), MultiplyRight );
-if ( HasValue( RotationY ) )    NormToMRI.RotateY ( GetValue ( RotationY ), MultiplyRight );
-if ( HasValue( RotationZ ) )    NormToMRI.RotateZ ( GetValue ( RotationZ ), MultiplyRight );
+if ( HasValue( RotationX ) )    normtomri.RotateX ( GetValue ( RotationX ), MultiplyRight );
+if ( HasValue( RotationY ) )    normtomri.RotateY ( GetValue ( RotationY ), MultiplyRight );
+if ( HasValue( RotationZ ) )    normtomri.RotateZ ( GetValue ( RotationZ ), MultiplyRight );
 }
 
 
@@ -358,9 +360,11 @@ double              dx              = Bound.GetRadius ( LeftRightIndex ) * dxrel
 
 double              normz           = NonNull ( Bound.GetRadius ( UpDownIndex    ) );
 double              normy           = NonNull ( Bound.GetRadius ( FrontBackIndex ) );
+TMatrix44           normtomri;
+TPointDouble        center ( Center );
 
 
-EvaluateSagittalPlaneMatrix ();
+EvaluateSagittalPlaneMatrix ( normtomri, center );
 
 //SetOvershootingOption ( interpolate, Vol.Array, LinearDim, true );
 
@@ -383,7 +387,7 @@ auto    getvalue = [ & ] ( double nx, double ny, double nz ) {
 
     TPointDouble        point ( nx, ny, nz );
 
-    NormToMRI.Apply ( point );
+    normtomri.Apply ( point );
 
     return  Vol.GetValueChecked ( point.X, point.Y, point.Z, InterpolateLinear );
 };
@@ -452,16 +456,16 @@ return  sumslice / sumw;
 
 
 //----------------------------------------------------------------------------
-inline void TVolumeProperties::EvaluateTransversePlaneGuillotineMatrix ( TMatrix44& normtomri )
+inline void TVolumeProperties::EvaluateTransversePlaneGuillotineMatrix ( TMatrix44& normtomri, TPointDouble& center )  const
 {
                                         // compute the transformation matrix
 normtomri       = NormToMRI;
 
                                         // and set updated center
-if ( HasValue( TranslationZ ) )             Center[ UpDownIndex    ]    = GetValue ( TranslationZ );
+if ( HasValue( TranslationZ ) )             center[ UpDownIndex    ]    = GetValue ( TranslationZ );
 
 
-                                            normtomri.Translate ( Center[ 0 ], Center[ 1 ], Center[ 2 ], MultiplyLeft );
+                                            normtomri.Translate ( center[ 0 ], center[ 1 ], center[ 2 ], MultiplyLeft );
 
 
 if ( HasValue( RotationX ) )                normtomri.RotateX ( GetValue ( RotationX ), MultiplyRight );
@@ -481,6 +485,7 @@ TPointInt           Step;
 double              sumslice        = 0;
 int                 numsum          = 0;
 TMatrix44           normtomri;
+TPointDouble        center ( Center );
 
 //SetOvershootingOption ( interpolate, Vol.Array, LinearDim, true );
 
@@ -498,7 +503,7 @@ if ( stat )
     stat->Reset ();
 
 
-EvaluateTransversePlaneGuillotineMatrix ( normtomri );
+EvaluateTransversePlaneGuillotineMatrix ( normtomri, center );
 
 
 MaxCorner.X     =   Bound.Radius() / 1.73;
@@ -662,7 +667,7 @@ NormToMRI.SetTranslation ( Center[ 0 ], Center[ 1 ], Center[ 2 ] );
 
 
 //----------------------------------------------------------------------------
-inline void TVolumeProperties::EvaluateTransversePlaneMatrix ( TMatrix44& normtomri )
+inline void TVolumeProperties::EvaluateTransversePlaneMatrix ( TMatrix44& normtomri, TPointDouble& center )  const
 {
                                         // Either:
                                         //   Translate + InvStandardOrient or
@@ -670,11 +675,11 @@ inline void TVolumeProperties::EvaluateTransversePlaneMatrix ( TMatrix44& normto
 normtomri       = NormToMRI;
 
                                         // and set updated center
-if ( HasValue( TranslationZ ) )             Center[ UpDownIndex    ]    = GetValue ( TranslationZ );
-if ( HasValue( TranslationY ) )             Center[ FrontBackIndex ]    = GetValue ( TranslationY );
+if ( HasValue( TranslationZ ) )             center[ UpDownIndex    ]    = GetValue ( TranslationZ );
+if ( HasValue( TranslationY ) )             center[ FrontBackIndex ]    = GetValue ( TranslationY );
 
                                         // force set pre-translation
-                                            normtomri.SetTranslation ( Center[ 0 ], Center[ 1 ], Center[ 2 ] );
+                                            normtomri.SetTranslation ( center[ 0 ], center[ 1 ], center[ 2 ] );
 
 
 if ( HasValue( RotationX ) )                normtomri.RotateX ( GetValue ( RotationX ), MultiplyRight );
@@ -694,6 +699,7 @@ TPointInt           MaxCorner;
 int                 fb1             = INT_MAX;
 int                 fb2             = INT_MAX;
 TMatrix44           normtomri;
+TPointDouble        center ( Center );
 TPointDouble        point;
 
 //SetOvershootingOption ( interpolate, Vol.Array, LinearDim, true );
@@ -701,7 +707,7 @@ TPointDouble        point;
 if ( stat )
     stat->Reset ();
 
-EvaluateTransversePlaneMatrix ( normtomri );
+EvaluateTransversePlaneMatrix ( normtomri, center );
 
                                         // take the radius of bounding box:
                                         // - bounding box: this is where the data are, so restrict the scan
@@ -769,6 +775,7 @@ int                 fb2             = INT_MAX;
 int                 lr1             = INT_MAX;
 int                 lr2             = INT_MAX;
 TMatrix44           normtomri;
+TPointDouble        center ( Center );
 TPointDouble        point;
 
 //SetOvershootingOption ( interpolate, Vol.Array, LinearDim, true );
@@ -776,7 +783,7 @@ TPointDouble        point;
 if ( stat )
     stat->Reset ();
 
-EvaluateTransversePlaneMatrix ( normtomri );
+EvaluateTransversePlaneMatrix ( normtomri, center );
 
                                         // take the radius of bounding box:
                                         // - bounding box: this is where the data are, so restrict the scan
@@ -888,6 +895,7 @@ int                 fb2             = INT_MAX;
 int                 lr1             = INT_MAX;
 int                 lr2             = INT_MAX;
 TMatrix44           normtomri;
+TPointDouble        center ( Center );
 TPointDouble        point;
 double              normx           = Bound.GetRadius ( LeftRightIndex );
 
@@ -896,7 +904,7 @@ double              normx           = Bound.GetRadius ( LeftRightIndex );
 if ( stat )
     stat->Reset ();
 
-EvaluateTransversePlaneMatrix ( normtomri );
+EvaluateTransversePlaneMatrix ( normtomri, center );
 
                                         // take the radius of bounding box:
                                         // - bounding box: this is where the data are, so restrict the scan
@@ -1051,6 +1059,7 @@ double  TVolumeProperties::EvaluateTransversePlaneMNI ( TEasyStats* stat )
 {
 const Volume&       mnidata         = *MniSlicedoc->GetData ();
 TMatrix44           normtomri;
+TPointDouble        center ( Center );
 double              normz           = MniSlicedoc->GetBounding ()->GetZExtent () / 2.0;
 double              error           = 0;
 
@@ -1059,7 +1068,7 @@ double              error           = 0;
 if ( stat )
     stat->Reset ();
 
-EvaluateTransversePlaneMatrix ( normtomri );
+EvaluateTransversePlaneMatrix ( normtomri, center );
 
 
 OmpParallelForSum ( error )
@@ -1498,8 +1507,6 @@ if ( Iteration < 100 ) {
 //----------------------------------------------------------------------------
         TFitVolumeOnVolume::TFitVolumeOnVolume ()
 {
-FromVolumesSmoothed = 0;
-
 Reset ();
 }
 
@@ -1508,8 +1515,6 @@ Reset ();
                                                  const TVolumeDoc*  tovolume,   RemapIntensityType      toremap,    TMatrix44*  torel_toabs,
                                                  FitVolumeType      flags )
 {
-FromVolumesSmoothed = 0;
-
 SetFitVolumeOnVolume    (   fromvolume,     fromremap,  fromrel_fromabs,
                             tovolume,       toremap,    torel_toabs,
                             flags 
@@ -1600,13 +1605,6 @@ SetMask ( FromVolume, FromMask );
 SetMask ( ToVolume,   ToMask   );
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // allocate cache for the From volume (+- 2 step values around current smoothing)
-#define             MaxVolumeCache      5
-
-FromVolumesSmoothed = new TCacheVolumes<MriType> ( MaxVolumeCache );
-
-
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // convert values, like histogram equalization or binarization
 FromRemap           = fromremap;
@@ -1630,6 +1628,23 @@ FromBound       = TBoundingBox<double> ( FromMask, false, 1 );
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // save these data for the inner loop
 FromNormExt     = TPointDouble ( FromBound.GetXExtent () / 2, FromBound.GetYExtent () / 2, FromBound.GetZExtent () / 2 );
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Gaussian pyramids, computed once for the whole optimization
+                                        // slices and small volumes will not go as deep
+NumPyramidLevels    = 1;
+
+while ( NumPyramidLevels < FitVolumeMaxPyramidLevels
+     && ToMask  .MinSize () >= 3
+     && FromMask.MinSize () >= 3
+     && min ( ToBound.MinSize (), FromBound.MinSize () ) / ( 1 << NumPyramidLevels ) >= FitVolumePyramidMinVoxels )
+
+    NumPyramidLevels++;
+
+
+SetPyramid ( FromVolume, FromRemap, FromPyramid );
+SetPyramid ( ToVolume,   ToRemap,   ToPyramid   );
 }
 
 
@@ -1666,12 +1681,13 @@ FromAbs_ToAbs   .SetIdentity ();
 ToRel_FromRel   .SetIdentity ();
 FromRel_ToRel   .SetIdentity ();
 
-if ( FromVolumesSmoothed != 0 )
-    delete  FromVolumesSmoothed;
-FromVolumesSmoothed = 0;
+NumPyramidLevels    = 1;
+PyramidLevel        = 0;
 
-ToVolumeSmoothed.DeallocateMemory ();
-ToVolumeSmoothedStep= INT_MAX;
+for ( int level = 0; level < FitVolumeMaxPyramidLevels; level++ ) {
+    FromPyramid[ level ].DeallocateMemory ();
+    ToPyramid  [ level ].DeallocateMemory ();
+    }
 
 FromNormExt   .Reset ();
 }
@@ -1774,6 +1790,109 @@ FromVolume /= NonNull ( maxv );
 }
 
 
+//----------------------------------------------------------------------------
+
+#define             StepToGaussianSmooth(S)     (2 * (S))
+                                        // odd kernel size
+//#define             StepToGaussianSmooth(S)     (2 * (S) + 1)
+
+                                        // Voxel ( x, y, z ) of level l is voxel ( 2^l x, 2^l y, 2^l z ) of the full volume, after a smoothing of matching size
+                                        // Volume is expected to be already remapped
+void    TFitVolumeOnVolume::SetPyramid ( const Volume& volume, RemapIntensityType remap, Volume* pyramid )
+{
+for ( int level = 1; level < NumPyramidLevels; level++ ) {
+
+    int                 step            = 1 << level;
+                                        // use a copy, because filtering ahead
+    Volume              smoothed ( volume );
+    FctParams           p;
+
+    p ( FilterParamDiameter )     = StepToGaussianSmooth ( step );
+
+    smoothed.Filter ( FilterTypeFastGaussian,   p, false );
+
+                                        // don't re-do if done at initialization, nor undo the smoothing of binary volumes
+    if ( ! ( remap == RemapIntensityInvert || remap == RemapIntensityBinarize || remap == RemapIntensityMask ) )
+
+        RemapVolume ( smoothed, remap );
+
+                                        // decimation is safe, as smoothing above removed the highest frequencies
+    Volume&             decimated       = pyramid[ level ];
+
+    decimated.Resize ( ( smoothed.GetDim1 () + step - 1 ) / step,
+                       ( smoothed.GetDim2 () + step - 1 ) / step,
+                       ( smoothed.GetDim3 () + step - 1 ) / step );
+
+
+    OmpParallelFor
+
+    for ( int x = 0; x < decimated.GetDim1 (); x++ )
+    for ( int y = 0; y < decimated.GetDim2 (); y++ )
+    for ( int z = 0; z < decimated.GetDim3 (); z++ )
+
+        decimated ( x, y, z )   = smoothed ( step * x, step * y, step * z );
+    }
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Coarse-to-fine optimization: each coarse level runs on the decimated volumes with a looser precision,
+                                        // then its best solution is promoted as the center of narrower ranges for the next finer level
+void    TFitVolumeOnVolume::GetSolution (   GOMethod    method,             int         how, 
+                                            double      requestedprecision, double      outliersprecision, 
+                                            const char* title,
+                                            TEasyStats* stat 
+                                        )
+{
+                                        // saving the caller's ranges
+int                 numparams       = GetTotalDims ();
+TArray1<double>     savedmin ( numparams );
+TArray1<double>     savedmax ( numparams );
+
+for ( int g = 0, p = 0; g < NumGroups; g++ )
+for ( int dim = 0;      dim < Groups[ g ].GetNumDims (); dim++, p++ ) {
+    savedmin[ p ]   = Groups[ g ][ dim ].Min;
+    savedmax[ p ]   = Groups[ g ][ dim ].Max;
+    }
+
+
+for ( PyramidLevel = NumPyramidLevels - 1; PyramidLevel > 0; PyramidLevel-- ) {
+                                        // f.ex. 1e-4 -> 1e-2 at level 1 and 4.6e-2 at level 2
+    TGlobalOptimize::GetSolution ( method, how, Power ( requestedprecision, 1.0 / ( PyramidLevel + 1 ) ), outliersprecision, title, 0 );
+
+                                        // promoting the best solution: GetSolution restarts from the middle of the ranges
+                                        // ranges are derived from the original ones, as box scans have already zoomed into them
+    double              shrink          = Power ( FitVolumePyramidRangeShrink, NumPyramidLevels - PyramidLevel );
+
+    for ( int g = 0, p = 0; g < NumGroups; g++ )
+    for ( int dim = 0;      dim < Groups[ g ].GetNumDims (); dim++, p++ ) {
+
+        TGOParam&           param           = Groups[ g ][ dim ];
+        double              halfrange       = ( savedmax[ p ] - savedmin[ p ] ) * shrink / 2;
+
+                                        // never going beyond the caller's limits
+        param.Min   = max ( savedmin[ p ], param.Value - halfrange );
+        param.Max   = min ( savedmax[ p ], param.Value + halfrange );
+        }
+    }
+
+                                        // full resolution, with the requested precision and final quality
+PyramidLevel    = 0;
+
+TGlobalOptimize::GetSolution ( method, how, requestedprecision, outliersprecision, title, stat );
+
+                                        // matrices from the final parameters
+EvaluateMatrices ();
+
+
+for ( int g = 0, p = 0; g < NumGroups; g++ )
+for ( int dim = 0;      dim < Groups[ g ].GetNumDims (); dim++, p++ ) {
+    Groups[ g ][ dim ].Min  = savedmin[ p ];
+    Groups[ g ][ dim ].Max  = savedmax[ p ];
+    }
+}
+
+
 //----------------------------------------------------------------------------
                                         // estimate the equivalent target distance in the source space
 double  TFitVolumeOnVolume::DistanceTargetToSource ( double dt )
@@ -1809,25 +1928,31 @@ double  TFitVolumeOnVolume::Evaluate ( TEasyStats *stat )
 TPointInt           ToFirst;
 TPointInt           ToLast;
 int                 ToStep;
-int                 ToSmooth;
 TPointInt           FromFirst;
 TPointInt           FromLast;
 int                 FromStep;
-int                 FromSmooth;
+TMatrix44           toabs_fromabs;
+TMatrix44           fromabs_toabs;
+TMatrix44           torel_fromrel;
+TMatrix44           fromrel_torel;
 
 
-EvaluateMatrices ();
+EvaluateMatrices ( toabs_fromabs, fromabs_toabs, torel_fromrel, fromrel_torel );
+
+                                        // current pyramid level volumes
+Volume*             tovolume        = PyramidLevel ? &ToPyramid  [ PyramidLevel ] : &ToVolume;
+Volume*             fromvolume      = PyramidLevel ? &FromPyramid[ PyramidLevel ] : &FromVolume;
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // constant stepping
-ToStep        = 1;
+                                        // stepping of the current level, each visited voxel standing for a whole ToStep^3 block
+ToStep          = 1 << PyramidLevel;
 //ToStep          = AtLeast ( 1, Truncate ( ToBound.Step ( 128, false ) ) );
 
-                                        // shift the first position so that by consecutive ToStep jumps, we will land on the center
-ToFirst.X       = ToBound.XMin () + ( Truncate ( ToCenter.X - ToBound.XMin () ) % ToStep );
-ToFirst.Y       = ToBound.YMin () + ( Truncate ( ToCenter.Y - ToBound.YMin () ) % ToStep );
-ToFirst.Z       = ToBound.ZMin () + ( Truncate ( ToCenter.Z - ToBound.ZMin () ) % ToStep );
+                                        // first position is a multiple of ToStep, so that consecutive jumps land exactly on the level voxels
+ToFirst.X       = ToStep * RoundAbove ( ToBound.XMin () / ToStep );
+ToFirst.Y       = ToStep * RoundAbove ( ToBound.YMin () / ToStep );
+ToFirst.Z       = ToStep * RoundAbove ( ToBound.ZMin () / ToStep );
 
                                         // max # of jumps from modified ToFirst, while remaining inside boundary limits
 ToLast .X       = ToFirst.X + TruncateTo ( ToBound.XMax () - ToFirst.X, ToStep );
@@ -1837,103 +1962,24 @@ ToLast .Z       = ToFirst.Z + TruncateTo ( ToBound.ZMax () - ToFirst.Z, ToStep )
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // constant stepping, using the same sampling as in target space
-FromStep      = 1;
+FromStep        = ToStep;
 //FromStep        = AtLeast ( 1, Truncate ( FromBound.Step ( 128, false ) ) );
 //FromStep      = AtLeast ( 1, Truncate ( DistanceTargetToSource ( ToStep ) ) );
 
-                                        // shift the first position so that by consecutive FromStep jumps, we will land on the center
-FromFirst.X     = FromBound.XMin () + ( Truncate ( FromCenter.X - FromBound.XMin () ) % FromStep );
-FromFirst.Y     = FromBound.YMin () + ( Truncate ( FromCenter.Y - FromBound.YMin () ) % FromStep );
-FromFirst.Z     = FromBound.ZMin () + ( Truncate ( FromCenter.Z - FromBound.ZMin () ) % FromStep );
+                                        // first position is a multiple of FromStep, so that consecutive jumps land exactly on the level voxels
+FromFirst.X     = FromStep * RoundAbove ( FromBound.XMin () / FromStep );
+FromFirst.Y     = FromStep * RoundAbove ( FromBound.YMin () / FromStep );
+FromFirst.Z     = FromStep * RoundAbove ( FromBound.ZMin () / FromStep );
 
                                         // max # of jumps from modified FromFirst, while remaining inside boundary limits
 FromLast .X     = FromFirst.X + TruncateTo ( FromBound.XMax () - FromFirst.X, FromStep );
 FromLast .Y     = FromFirst.Y + TruncateTo ( FromBound.YMax () - FromFirst.Y, FromStep );
 FromLast .Z     = FromFirst.Z + TruncateTo ( FromBound.ZMax () - FromFirst.Z, FromStep );
 
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // do some filtering
-ToSmooth        = ToStep;
-//ToSmooth        = 2 * ToStep;           // best results
-//ToSmooth        = ToRemap == RemapIntensityBinarize || ToRemap == RemapIntensityMask ? 0 : 2 * ToStep;           // best results
-
-                                        // estimate the From step equivalent to the To step
-FromSmooth      = ToSmooth;
-//FromSmooth      = 2 * FromStep;
-//FromSmooth      = FromRemap == RemapIntensityBinarize || FromRemap == RemapIntensityMask ? 0 : max ( 1, Round ( DistanceTargetToSource ( ToSmooth ) ) );
-//FromSmooth      = AtLeast ( 1, Round ( DistanceTargetToSource ( ToSmooth ) ) );
-
-//if ( VkQuery () ) DBGV4 ( FromStep, FromSmooth, ToStep, ToSmooth, "FromStep, FromSmooth, ToStep, ToSmooth" );
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-bool                tosmoothing     = false; // true;
-bool                fromsmoothing   = false; // true;
-bool                reloadfromvolume= fromsmoothing;
-                                        // With smoothing:
-                                        // - work with local filtered copies
-                                        // - both volumes can be downsampled differently
-Volume*             tovolume        = ! tosmoothing     ? &ToVolume     
-                                                        : &ToVolumeSmoothed;
-
-Volume*             fromvolume      = ! fromsmoothing   ? &FromVolume
-                                                          // get a cache slot for this smoothing factor
-                                                        : FromVolumesSmoothed->GetCache ( FromVolume.GetDim1 (), FromVolume.GetDim2 (), FromVolume.GetDim3 (), 
-                                                                                          FromSmooth, reloadfromvolume );
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Any To smoothing?
-
-#define             StepToGaussianSmooth(S)     (2 * (S))
-                                        // odd kernel size
-//#define             StepToGaussianSmooth(S)     (2 * (S) + 1)
-
-
-if ( tosmoothing && ToSmooth != ToVolumeSmoothedStep ) {
-                                        // use copies, because filtering ahead
-    ToVolumeSmoothed    = ToVolume;
-
-    ToVolumeSmoothedStep= ToSmooth;
-
-
-    FctParams           p;
-
-    p ( FilterParamDiameter )     = StepToGaussianSmooth ( ToVolumeSmoothedStep );
-
-    ToVolumeSmoothed.Filter ( FilterTypeFastGaussian,   p, false );
-
-    if ( ToRemap != RemapIntensityInvert )  // don't re-do, if done at initialization
-
-        RemapVolume ( ToVolumeSmoothed, ToRemap   );
-
-                                        // updating mask - maybe a tiny bit better
-//  SetMask ( ToVolumeSmoothed, ToMask );
-    } // new filtered volume
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // should reload the data, according to caches?
-if ( fromsmoothing && reloadfromvolume ) {
-                                        // set a copy
-    fromvolume->Insert ( FromVolume );
-
-
-    FctParams           p;
-
-    p ( FilterParamDiameter )     = StepToGaussianSmooth ( FromSmooth );
-
-    fromvolume->Filter ( FilterTypeFastGaussian,    p, false );
-
-
-    if ( FromRemap != RemapIntensityInvert )  // don't re-do, if done at initialization
-
-        RemapVolume ( *fromvolume, FromRemap );
-
-                                    // updating mask - maybe a tiny bit better
-//  SetMask ( *fromvolume, FromMask );
-    } // new filtered volume
+                                        // full resolution voxel to level voxel
+double              tolevel         = 1.0 / ToStep;
+                                        // 1 patch interactive intensity remapping
+double              fromrescale     = HasValue( FitVolumeFromIntensityRescale ) ? exp ( GetValue ( FitVolumeFromIntensityRescale ) ) : 1;
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1975,16 +2021,14 @@ if ( IsEqualSizes ( Flags ) || IsSourceBigger ( Flags ) ) {
                                         // target to source
             TPointDouble        pf  ( x, y, z );
     //      TransformTargetToSource ( pf );
-            ToRel_FromRel.Apply ( pf );
+            torel_fromrel.Apply ( pf );
 
 
-            double              fromv       = fromvolume->GetValueChecked ( pf.X, pf.Y, pf.Z, volumeinterpolation );
-            double              tov         = tovolume  ->GetValue        (    x,    y,    z );
+            double              fromv       = fromvolume->GetValueChecked ( pf.X * tolevel, pf.Y * tolevel, pf.Z * tolevel, volumeinterpolation );
+            double              tov         = tovolume  ->GetValue        ( x / ToStep,     y / ToStep,     z / ToStep );
 
-                                        // 1 patch interactive intensity remapping
-            if ( HasValue( FitVolumeFromIntensityRescale ) )
-                fromv  *= exp ( GetValue ( FitVolumeFromIntensityRescale ) );
-    //          fromv   = ( fromv - GetValue ( FitVolumeFromIntensityOffset ) ) * exp ( GetValue ( FitVolumeFromIntensityRescale ) );
+            fromv  *= fromrescale;
+    //      fromv   = ( fromv - GetValue ( FitVolumeFromIntensityOffset ) ) * exp ( GetValue ( FitVolumeFromIntensityRescale ) );
 
                                         // !which formula is used will affect the quality intervals!
 //          double              dv          = tov - fromv;
@@ -2030,20 +2074,18 @@ if ( IsEqualSizes ( Flags ) || IsTargetBigger ( Flags ) ) {
                                         // source to target
             TPointDouble        pf ( x, y, z );
     //      TransformSourceToTarget ( pf );
-            FromRel_ToRel.Apply ( pf );
+            fromrel_torel.Apply ( pf );
 
                                         // should not be already included in To
             if ( IsEqualSizes ( Flags ) && ToMask.GetValueChecked ( pf ) )
                 continue;
 
 
-            double              fromv       = fromvolume->GetValue        (    x,    y,    z );
-            double              tov         = tovolume  ->GetValueChecked ( pf.X, pf.Y, pf.Z, volumeinterpolation );
+            double              fromv       = fromvolume->GetValue        ( x / FromStep,   y / FromStep,   z / FromStep );
+            double              tov         = tovolume  ->GetValueChecked ( pf.X * tolevel, pf.Y * tolevel, pf.Z * tolevel, volumeinterpolation );
 
-                                        // 1 patch interactive intensity remapping
-            if ( HasValue( FitVolumeFromIntensityRescale ) )
-                fromv  *= exp ( GetValue ( FitVolumeFromIntensityRescale ) );
-    //          fromv   = ( fromv - GetValue ( FitVolumeFromIntensityOffset ) ) * exp ( GetValue ( FitVolumeFromIntensityRescale ) );
+            fromv  *= fromrescale;
+    //      fromv   = ( fromv - GetValue ( FitVolumeFromIntensityOffset ) ) * exp ( GetValue ( FitVolumeFromIntensityRescale ) );
 
                                         // !which formula is used will affect the quality intervals!
 //          double              dv          = tov - fromv;
@@ -2391,17 +2433,23 @@ return  pabstat.SD ();
 //----------------------------------------------------------------------------
 
 void    TFitVolumeOnVolume::EvaluateMatrices ()
+{
+EvaluateMatrices ( ToAbs_FromAbs, FromAbs_ToAbs, ToRel_FromRel, FromRel_ToRel );
+}
+
+                                        // Evaluate can not write to the members, as there could be concurrent calls
+void    TFitVolumeOnVolume::EvaluateMatrices ( TMatrix44& toabs_fromabs, TMatrix44& fromabs_toabs, TMatrix44& torel_fromrel, TMatrix44& fromrel_torel )  const
 {
                                         // compute the transformation matrix
-ToAbs_FromAbs.SetIdentity ();
+toabs_fromabs.SetIdentity ();
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // global scaling first
-if ( HasValue( Scale  ) )                   ToAbs_FromAbs.Scale  ( GetValue ( Scale ), GetValue ( Scale ), GetValue ( Scale ), MultiplyLeft );
-if ( HasValue( ScaleX ) )                   ToAbs_FromAbs.ScaleX ( GetValue ( ScaleX ), MultiplyLeft );
-if ( HasValue( ScaleY ) )                   ToAbs_FromAbs.ScaleY ( GetValue ( ScaleY ), MultiplyLeft );
-if ( HasValue( ScaleZ ) )                   ToAbs_FromAbs.ScaleZ ( GetValue ( ScaleZ ), MultiplyLeft );
+if ( HasValue( Scale  ) )                   toabs_fromabs.Scale  ( GetValue ( Scale ), GetValue ( Scale ), GetValue ( Scale ), MultiplyLeft );
+if ( HasValue( ScaleX ) )                   toabs_fromabs.ScaleX ( GetValue ( ScaleX ), MultiplyLeft );
+if ( HasValue( ScaleY ) )                   toabs_fromabs.ScaleY ( GetValue ( ScaleY ), MultiplyLeft );
+if ( HasValue( ScaleZ ) )                   toabs_fromabs.ScaleZ ( GetValue ( ScaleZ ), MultiplyLeft );
 
 //if ( HasValue( Scale  ) )                   DBGV ( GetValue ( Scale  ),  HasValue( Scale  )" );
 //if ( HasValue( ScaleX ) )                   DBGV3 ( GetValue ( ScaleX ), GetValue ( ScaleY ), GetValue ( ScaleZ ),  HasValue( ScaleX ), GetValue ( ScaleY ), GetValue ( ScaleZ )" );
@@ -2409,41 +2457,41 @@ if ( HasValue( ScaleZ ) )                   ToAbs_FromAbs.ScaleZ ( GetValue ( Sc
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // rotations
-if ( HasValue( RotationX ) )                ToAbs_FromAbs.RotateX ( GetValue ( RotationX ), MultiplyLeft );
-if ( HasValue( RotationY ) )                ToAbs_FromAbs.RotateY ( GetValue ( RotationY ), MultiplyLeft );
-if ( HasValue( RotationZ ) )                ToAbs_FromAbs.RotateZ ( GetValue ( RotationZ ), MultiplyLeft );
+if ( HasValue( RotationX ) )                toabs_fromabs.RotateX ( GetValue ( RotationX ), MultiplyLeft );
+if ( HasValue( RotationY ) )                toabs_fromabs.RotateY ( GetValue ( RotationY ), MultiplyLeft );
+if ( HasValue( RotationZ ) )                toabs_fromabs.RotateZ ( GetValue ( RotationZ ), MultiplyLeft );
 
 //if ( HasValue( RotationX ) )                   DBGV3 ( GetValue ( RotationX ), GetValue ( RotationY ), GetValue ( RotationZ ), "GetValue ( RotationX ), GetValue ( RotationY ), GetValue ( RotationZ )" );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // translations
-if ( HasValue( TranslationX ) )             ToAbs_FromAbs.TranslateX ( GetValue ( TranslationX ), MultiplyLeft );
-if ( HasValue( TranslationY ) )             ToAbs_FromAbs.TranslateY ( GetValue ( TranslationY ), MultiplyLeft );
-if ( HasValue( TranslationZ ) )             ToAbs_FromAbs.TranslateZ ( GetValue ( TranslationZ ), MultiplyLeft );
+if ( HasValue( TranslationX ) )             toabs_fromabs.TranslateX ( GetValue ( TranslationX ), MultiplyLeft );
+if ( HasValue( TranslationY ) )             toabs_fromabs.TranslateY ( GetValue ( TranslationY ), MultiplyLeft );
+if ( HasValue( TranslationZ ) )             toabs_fromabs.TranslateZ ( GetValue ( TranslationZ ), MultiplyLeft );
 
 //if ( HasValue( TranslationX ) )                   DBGV3 ( GetValue ( TranslationX ), GetValue ( TranslationY ), GetValue ( TranslationZ ), "GetValue ( TranslationX ), GetValue ( TranslationY ), GetValue ( TranslationZ )" );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // temporarily adjust origin
-                                            ToAbs_FromAbs.Translate ( HasValue( FitVolumeShearShiftX ) ? GetValue ( FitVolumeShearShiftX ) : 0,
+                                            toabs_fromabs.Translate ( HasValue( FitVolumeShearShiftX ) ? GetValue ( FitVolumeShearShiftX ) : 0,
                                                                       HasValue( FitVolumeShearShiftY ) ? GetValue ( FitVolumeShearShiftY ) : 0,
                                                                       HasValue( FitVolumeShearShiftZ ) ? GetValue ( FitVolumeShearShiftZ ) : 0 , MultiplyLeft );
 
-if ( HasValue( FitVolumeNormCenterRotateX ) )   ToAbs_FromAbs.RotateX ( GetValue ( FitVolumeNormCenterRotateX ), MultiplyLeft );
-if ( HasValue( FitVolumeNormCenterRotateZ ) )   ToAbs_FromAbs.RotateZ ( GetValue ( FitVolumeNormCenterRotateZ ), MultiplyLeft );
+if ( HasValue( FitVolumeNormCenterRotateX ) )   toabs_fromabs.RotateX ( GetValue ( FitVolumeNormCenterRotateX ), MultiplyLeft );
+if ( HasValue( FitVolumeNormCenterRotateZ ) )   toabs_fromabs.RotateZ ( GetValue ( FitVolumeNormCenterRotateZ ), MultiplyLeft );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // shearing
 
-if ( HasValue( FitVolumeShearXtoY ) )       ToAbs_FromAbs.ShearX ( GetValue ( FitVolumeShearXtoY ), 0, MultiplyLeft );
-if ( HasValue( FitVolumeShearXtoZ ) )       ToAbs_FromAbs.ShearX ( 0, GetValue ( FitVolumeShearXtoZ ), MultiplyLeft );
-if ( HasValue( FitVolumeShearYtoX ) )       ToAbs_FromAbs.ShearY ( GetValue ( FitVolumeShearYtoX ), 0, MultiplyLeft );
-if ( HasValue( FitVolumeShearYtoZ ) )       ToAbs_FromAbs.ShearY ( 0, GetValue ( FitVolumeShearYtoZ ), MultiplyLeft );
-if ( HasValue( FitVolumeShearZtoX ) )       ToAbs_FromAbs.ShearZ ( GetValue ( FitVolumeShearZtoX ), 0, MultiplyLeft );
-if ( HasValue( FitVolumeShearZtoY ) )       ToAbs_FromAbs.ShearZ ( 0, GetValue ( FitVolumeShearZtoY ), MultiplyLeft );
+if ( HasValue( FitVolumeShearXtoY ) )       toabs_fromabs.ShearX ( GetValue ( FitVolumeShearXtoY ), 0, MultiplyLeft );
+if ( HasValue( FitVolumeShearXtoZ ) )       toabs_fromabs.ShearX ( 0, GetValue ( FitVolumeShearXtoZ ), MultiplyLeft );
+if ( HasValue( FitVolumeShearYtoX ) )       toabs_fromabs.ShearY ( GetValue ( FitVolumeShearYtoX ), 0, MultiplyLeft );
+if ( HasValue( FitVolumeShearYtoZ ) )       toabs_fromabs.ShearY ( 0, GetValue ( FitVolumeShearYtoZ ), MultiplyLeft );
+if ( HasValue( FitVolumeShearZtoX ) )       toabs_fromabs.ShearZ ( GetValue ( FitVolumeShearZtoX ), 0, MultiplyLeft );
+if ( HasValue( FitVolumeShearZtoY ) )       toabs_fromabs.ShearZ ( 0, GetValue ( FitVolumeShearZtoY ), MultiplyLeft );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -2461,16 +2509,16 @@ if ( HasValue( FitVolumePerspectiveZtoXYDelta ) && GetValue ( FitVolumePerspecti
 
                                         // !!!!! test should be < 0 (better results), but test > 0 gives a real perspective impression?????
     if ( GetValue ( FitVolumePerspectiveZtoXYDelta ) < 0 )     // perspective in the other direction?
-        ToAbs_FromAbs.ScaleZ        ( -1, MultiplyLeft );   // inversion
+        toabs_fromabs.ScaleZ        ( -1, MultiplyLeft );   // inversion
 
-    ToAbs_FromAbs.TranslateZ        (  shift, MultiplyLeft );
+    toabs_fromabs.TranslateZ        (  shift, MultiplyLeft );
 
-    ToAbs_FromAbs.PerspectiveZtoXY  ( perspnear, perspfar, MultiplyLeft );
+    toabs_fromabs.PerspectiveZtoXY  ( perspnear, perspfar, MultiplyLeft );
                                         // de-shift + compensate for mid-planes perspective shift
-    ToAbs_FromAbs.TranslateZ        ( -shift - Square ( radiusz ) / shift, MultiplyLeft );
+    toabs_fromabs.TranslateZ        ( -shift - Square ( radiusz ) / shift, MultiplyLeft );
 
     if ( GetValue ( FitVolumePerspectiveZtoXYDelta ) < 0 )     // perspective in the other direction?
-        ToAbs_FromAbs.ScaleZ        ( -1, MultiplyLeft );   // inversion
+        toabs_fromabs.ScaleZ        ( -1, MultiplyLeft );   // inversion
     }
 
 
@@ -2486,16 +2534,16 @@ if ( HasValue( FitVolumePerspectiveZtoXDelta ) && GetValue ( FitVolumePerspectiv
 
                                         // !!!!! test should be < 0 (better results), but test > 0 gives a real perspective impression?????
     if ( GetValue ( FitVolumePerspectiveZtoXDelta ) < 0 )      // perspective in the other direction?
-        ToAbs_FromAbs.ScaleZ        ( -1, MultiplyLeft );   // inversion
+        toabs_fromabs.ScaleZ        ( -1, MultiplyLeft );   // inversion
 
-    ToAbs_FromAbs.TranslateZ        (  shift, MultiplyLeft );
+    toabs_fromabs.TranslateZ        (  shift, MultiplyLeft );
 
-    ToAbs_FromAbs.PerspectiveZtoX   ( perspnear, perspfar, MultiplyLeft );
+    toabs_fromabs.PerspectiveZtoX   ( perspnear, perspfar, MultiplyLeft );
                                         // de-shift + compensate for mid-planes perspective shift
-    ToAbs_FromAbs.TranslateZ        ( -shift - Square ( radiusz ) / shift, MultiplyLeft );
+    toabs_fromabs.TranslateZ        ( -shift - Square ( radiusz ) / shift, MultiplyLeft );
 
     if ( GetValue ( FitVolumePerspectiveZtoXDelta ) < 0 )      // perspective in the other direction?
-        ToAbs_FromAbs.ScaleZ        ( -1, MultiplyLeft );   // inversion
+        toabs_fromabs.ScaleZ        ( -1, MultiplyLeft );   // inversion
     }
 
 
@@ -2513,42 +2561,42 @@ if ( HasValue( FitVolumePerspectiveZtoYDelta ) && GetValue ( FitVolumePerspectiv
 
                                         // !!!!! test should be < 0 (better results), but test > 0 gives a real perspective impression?????
     if ( GetValue ( FitVolumePerspectiveZtoYDelta ) < 0 )      // perspective in the other direction?
-        ToAbs_FromAbs.ScaleZ        ( -1, MultiplyLeft );   // inversion
+        toabs_fromabs.ScaleZ        ( -1, MultiplyLeft );   // inversion
 
-    ToAbs_FromAbs.TranslateZ        (  shift, MultiplyLeft );
+    toabs_fromabs.TranslateZ        (  shift, MultiplyLeft );
 
-    ToAbs_FromAbs.PerspectiveZtoY   ( perspnear, perspfar, MultiplyLeft );
+    toabs_fromabs.PerspectiveZtoY   ( perspnear, perspfar, MultiplyLeft );
                                         // de-shift + compensate for mid-planes perspective shift
-    ToAbs_FromAbs.TranslateZ        ( -shift - Square ( radiusz ) / shift, MultiplyLeft );
+    toabs_fromabs.TranslateZ        ( -shift - Square ( radiusz ) / shift, MultiplyLeft );
 
     if ( GetValue ( FitVolumePerspectiveZtoYDelta ) < 0 )      // perspective in the other direction?
-        ToAbs_FromAbs.ScaleZ        ( -1, MultiplyLeft );   // inversion
+        toabs_fromabs.ScaleZ        ( -1, MultiplyLeft );   // inversion
     }
 */
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // restore temporary origin
 
-if ( HasValue( FitVolumeNormCenterRotateZ ) )   ToAbs_FromAbs.RotateZ ( - GetValue ( FitVolumeNormCenterRotateZ ), MultiplyLeft );
-if ( HasValue( FitVolumeNormCenterRotateX ) )   ToAbs_FromAbs.RotateX ( - GetValue ( FitVolumeNormCenterRotateX ), MultiplyLeft );
+if ( HasValue( FitVolumeNormCenterRotateZ ) )   toabs_fromabs.RotateZ ( - GetValue ( FitVolumeNormCenterRotateZ ), MultiplyLeft );
+if ( HasValue( FitVolumeNormCenterRotateX ) )   toabs_fromabs.RotateX ( - GetValue ( FitVolumeNormCenterRotateX ), MultiplyLeft );
 
-                                            ToAbs_FromAbs.Translate ( HasValue( FitVolumeShearShiftX ) ? - GetValue ( FitVolumeShearShiftX ) : 0,
+                                            toabs_fromabs.Translate ( HasValue( FitVolumeShearShiftX ) ? - GetValue ( FitVolumeShearShiftX ) : 0,
                                                                       HasValue( FitVolumeShearShiftY ) ? - GetValue ( FitVolumeShearShiftY ) : 0,
                                                                       HasValue( FitVolumeShearShiftZ ) ? - GetValue ( FitVolumeShearShiftZ ) : 0 , MultiplyLeft );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // make the transform relative, from voxel space to voxel space
-ToRel_FromRel   = FromAbs_FromRel * ToAbs_FromAbs * ToRel_ToAbs;
+torel_fromrel   = FromAbs_FromRel * toabs_fromabs * ToRel_ToAbs;
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Set inverse transforms
-FromAbs_ToAbs   = ToAbs_FromAbs;
-FromAbs_ToAbs.Invert ();
+fromabs_toabs   = toabs_fromabs;
+fromabs_toabs.Invert ();
 
-FromRel_ToRel   = ToRel_FromRel;
-FromRel_ToRel.Invert ();
+fromrel_torel   = torel_fromrel;
+fromrel_torel.Invert ();
 }
 
 
@@ -30,7 +30,6 @@ namespace crtl {
 //----------------------------------------------------------------------------
 
 template <class TypeD> class        TCacheVolume;
-template <class TypeD> class        TCacheVolumes;
 
 
 //----------------------------------------------------------------------------
@@ -121,14 +120,15 @@ public:
     void            GetSolution ( GOMethod method, int how, double requestedprecision, double outliersprecision, const char* title, TEasyStats* stat = 0 );
 
     double          Evaluate ( TEasyStats *stat = 0 );
+    bool            IsEvaluateThreadSafe ()     const       { return true; }
 
-    inline void     EvaluateSagittalPlaneMatrix             ();
+    inline void     EvaluateSagittalPlaneMatrix             ( TMatrix44& normtomri, TPointDouble& center )  const;
     double          EvaluateSagittalPlaneSymmetric          ( TEasyStats *stat = 0 );
 
-    inline void     EvaluateTransversePlaneGuillotineMatrix ( TMatrix44& normtomri );
+    inline void     EvaluateTransversePlaneGuillotineMatrix ( TMatrix44& normtomri, TPointDouble& center )  const;
     double          EvaluateTransversePlaneGuillotine       ( TEasyStats* stat = 0 );
 
-    inline void     EvaluateTransversePlaneMatrix           ( TMatrix44& normtomri );
+    inline void     EvaluateTransversePlaneMatrix           ( TMatrix44& normtomri, TPointDouble& center )  const;
     double          EvaluateTransversePlaneLongest          ( TEasyStats* stat = 0 );
     double          EvaluateTransversePlaneBiggestBox       ( TEasyStats* stat = 0 );
     double          EvaluateTransversePlaneBiggestSurface   ( TEasyStats* stat = 0 );
@@ -159,6 +159,7 @@ public:
     void            Reset ();
 
     double          Evaluate            ( TEasyStats* stat = 0 );
+    bool            IsEvaluateThreadSafe ()     const       { return true; }
 
     double          GetMinimumDistance  ( TPointFloat& p );
     inline void     Transform           ( TPointFloat& p );
@@ -229,6 +230,15 @@ inline  bool        IsSourceBigger  ( const FitVolumeType& f )      { return
 //                    };
 
 
+//----------------------------------------------------------------------------
+                                        // Coarse-to-fine optimization: level l is the Gaussian smoothed volume, decimated by 2^l
+constexpr int       FitVolumeMaxPyramidLevels       = 3;
+                                        // coarsest level should still span that many voxels in each dimension
+constexpr int       FitVolumePyramidMinVoxels       = 16;
+                                        // parameters range shrinking, each time the best solution is promoted to the next finer level
+constexpr double    FitVolumePyramidRangeShrink     = 0.5;
+
+
 //----------------------------------------------------------------------------
                                         // Currently, only affine transforms is used, including shearing
                                         // but NOT Pinching / Flattening, which are non-linear - these could not be saved in a matrix
@@ -278,8 +288,11 @@ public:
                                                 const TVolumeDoc*   tovolume,       RemapIntensityType      toremap,     TMatrix44*  torel_toabs,
                                                 FitVolumeType       flags );
 
+    void            GetSolution             ( GOMethod method, int how, double requestedprecision, double outliersprecision, const char *title, TEasyStats *stat = 0 );
     double          Evaluate                ( TEasyStats *stat = 0 );
-    void            EvaluateMatrices        ();
+    bool            IsEvaluateThreadSafe    ()  const   { return true; }
+    void            EvaluateMatrices        ();     // updates the public matrices from the current parameters
+    void            EvaluateMatrices        ( TMatrix44& toabs_fromabs, TMatrix44& fromabs_toabs, TMatrix44& torel_fromrel, TMatrix44& fromrel_torel )   const;
 //  void            TransformTargetToSource ( TPointDouble &p );    // !any update in this function should be reverted and included in the next     function!
 //  void            TransformSourceToTarget ( TPointDouble &p );    // !any update in this function should be reverted and included in the previous function!
     void            TransformToTarget       ( const Volume& volume, FilterTypes filtertype, InterpolationType interpolate, int numsubsampling, int niftitransform, int niftiintentcode, const char* niftiintentname, const char *file, char *title = 0 );
@@ -296,10 +309,10 @@ public:
 
 private:
 
-    TCacheVolumes<MriType>* FromVolumesSmoothed;    // we need a set of caches, as according to the current transform, we might need different scaling alternatively
-
-    Volume          ToVolumeSmoothed;       // we don't need caches for this one, as steps always get smaller and smaller (no coming back and forth)
-    int             ToVolumeSmoothedStep;   // remember current smoothing
+    int             NumPyramidLevels;       // level 0 being the full resolution volumes themselves
+    int             PyramidLevel;           // level currently being optimized
+    Volume          FromPyramid[ FitVolumeMaxPyramidLevels ];   // smoothed & decimated volumes, built once
+    Volume          ToPyramid  [ FitVolumeMaxPyramidLevels ];
 
     TPointDouble    FromNormExt;            // used internally to normalize points
     TMatrix44       TempMat;
@@ -307,6 +320,7 @@ private:
 
     void            SetMask                 ( Volume& volume, Volume& mask );
     void            RemapVolume             ( Volume& volume, RemapIntensityType remap );
+    void            SetPyramid              ( const Volume& volume, RemapIntensityType remap, Volume* pyramid );
 
 };
 
@@ -25,6 +25,7 @@ limitations under the License.
 #include    "TVector.h"
 #include    "Files.TVerboseFile.h"
 #include    "Dialogs.TSuperGauge.h"
+#include    "System.OpenMP.h"
 
 #include    "TMaps.h"
 #include    "TExportTracks.h"
@@ -540,9 +541,10 @@ for ( int g = 0, paramoffset = 0; g < NumGroups; paramoffset += Groups[ g ].GetN
                                         // ToValue & buddies are just pointers
 void    TGlobalOptimize::ResetToValue ()
 {
-ToValues.clear ();
-ToMin   .clear ();
-ToMax   .clear ();
+ToValues .clear ();
+ToMin    .clear ();
+ToMax    .clear ();
+ToIndexes.clear ();
 }
 
 
@@ -561,10 +563,97 @@ void    TGlobalOptimize::SetToValue ()
 ResetToValue ();
 
                                         // browse through all groups/dimensions, and store to quick access ToValue
-for ( int g   = 0; g   < NumGroups; g++ )
-for ( int dim = 0; dim < Groups[ g ].GetNumDims (); dim++ )
+for ( int g   = 0, p = 0; g   < NumGroups; g++ )
+for ( int dim = 0;        dim < Groups[ g ].GetNumDims (); dim++, p++ ) {
 
     SetToValue ( Groups[ g ][ dim ] );
+
+    ToIndexes[ Groups[ g ][ dim ].Type ]    = p;
+    }
+}
+
+
+//----------------------------------------------------------------------------
+void    TGlobalOptimize::GetAllValues ( double* values )    const
+{
+for ( int g   = 0, p = 0; g   < NumGroups; g++ )
+for ( int dim = 0;        dim < Groups[ g ].GetNumDims (); dim++, p++ )
+
+    values[ p ]     = Groups[ g ][ dim ].Value;
+}
+
+
+void    TGlobalOptimize::SetAllValues ( const double* values )
+{
+for ( int g   = 0, p = 0; g   < NumGroups; g++ )
+for ( int dim = 0;        dim < Groups[ g ].GetNumDims (); dim++, p++ )
+
+    Groups[ g ][ dim ].Value    = values[ p ];
+}
+
+
+//----------------------------------------------------------------------------
+thread_local const TGlobalOptimize* TGlobalOptimize::BoundOptimizer = 0;
+thread_local const double*          TGlobalOptimize::BoundValues    = 0;
+
+                                        // The shared parameters are left untouched, so that many threads can evaluate different candidates at the same time
+double  TGlobalOptimize::EvaluateValues ( const double* values, TEasyStats *stat )
+{
+BoundOptimizer      = this;
+BoundValues         = values;
+
+double              result          = Evaluate ( stat );
+
+BoundOptimizer      = 0;
+BoundValues         = 0;
+
+return  result;
+}
+
+                                        // Candidates are run in parallel only if the derived class allows it, and if its own inner parallel blocks
+                                        // will run serialized in each thread, as these threads will not see the bound values
+                                        // Batches smaller than the number of threads (cross-hair steps, simplex vertices...) are better left to the inner parallel blocks of each evaluation
+                                        // Otherwise, candidates are evaluated one after the other through the shared parameters, which are restored afterward
+void    TGlobalOptimize::EvaluateBatch ( const TArray2<double>& candidates, int numcandidates, double* results )
+{
+if ( numcandidates <= 0 )
+    return;
+
+
+if ( IsEvaluateThreadSafe () 
+  && numcandidates >= GetNumMaxThreads () 
+  && numcandidates > 1 
+  && ! IsInParallelCode    () 
+  && ! IsNestedParallelism () ) {
+
+    OmpParallelBegin
+
+    OmpForDynamic
+
+    for ( int ci = 0; ci < numcandidates; ci++ )
+
+        results[ ci ]   = EvaluateValues ( candidates[ ci ] );
+
+    OmpParallelEnd
+    }
+
+else {
+
+    TArray1<double>     savedvalues ( GetTotalDims () );
+
+    GetAllValues ( savedvalues.GetArray () );
+
+
+    for ( int ci = 0; ci < numcandidates; ci++ ) {
+
+        SetAllValues ( candidates[ ci ] );
+
+        results[ ci ]   = Evaluate ();
+        }
+
+
+    SetAllValues ( savedvalues.GetArray () );
+    }
 }
 
 
@@ -686,28 +775,49 @@ TMultiArray<double> subgrid ( subindexes );
                                         // This method looks at all dimensions at the same time
                                         // searching for the min in the n-dimensional space at once
 
+                                        // candidates are evaluated by batches
+int                 numsubgrid      = subgrid.GetLinearDim ();
+int                 batchsize       = min ( numsubgrid, GOEvaluateBatchSize );
+TArray2<double>     candidates      ( batchsize, GetTotalDims () );
+TArray1<double>     batchresults    ( batchsize );
+
                                         // linear loop across sub-grid
-for ( int subli = 0; subli < subgrid.GetLinearDim (); subli++ ) {
+for ( int batchli = 0; batchli < numsubgrid; batchli += batchsize ) {
 
-    subgrid.LinearToIndexes ( subli, subindexes );
+    int             numcandidates   = min ( batchsize, numsubgrid - batchli );
 
 
-    for ( int p = 0; p < numparams; p++ )
+    for ( int ci = 0; ci < numcandidates; ci++ ) {
+
+        subgrid.LinearToIndexes ( batchli + ci, subindexes );
+
+
+        for ( int p = 0; p < numparams; p++ )
                                         // setting current parameter' value
-        params[ p ]->Value  = params[ p ]->GetSubValue ( subindexes[ p ] );
+            params[ p ]->Value  = params[ p ]->GetSubValue ( subindexes[ p ] );
+
+                                        // other parameters keep their current values
+        GetAllValues ( candidates[ ci ] );
+        }
+
+
+    EvaluateBatch ( candidates, numcandidates, batchresults.GetArray () );
 
+                                        // cumulating in the sub-grid order, whatever the order of evaluation
+    for ( int ci = 0; ci < numcandidates; ci++ ) {
 
-    double          result      = Evaluate ();
+        subgrid.LinearToIndexes ( batchli + ci, subindexes );
 
                                         // downsample to grid
-    for ( int p = 0; p < numparams; p++ )
+        for ( int p = 0; p < numparams; p++ )
 
-        indexes[ p ]    = subindexes[ p ] / params[ p ]->NumSubSteps;
+            indexes[ p ]    = subindexes[ p ] / params[ p ]->NumSubSteps;
                                         // cumulating within results bucket
-    results ( indexes )    += result;
+        results ( indexes )    += batchresults[ ci ];
 
                                         // stats on all available results
-    stats.Add ( result, ThreadSafetyIgnore );
+        stats.Add ( batchresults[ ci ], ThreadSafetyIgnore );
+        }
     }
 
 
@@ -759,6 +869,8 @@ stats.Reset ();
 int                 numparams   = (int) params;
 TArray1<int>        minindexes ( numparams );
 TArray1<double>     minvalues  ( numparams );
+TArray2<double>     candidates;
+TArray1<double>     axisresults;
 
 minindexes  = -1;
 minvalues   = DBL_MAX;
@@ -767,16 +879,27 @@ minvalues   = DBL_MAX;
 for ( int p = 0; p < numparams; p++ ) {
     
     double          savedvalue      = params[ p ]->Value;
-    double          result          = 0;
+    int             numsubsteps     = params[ p ]->GetTotalSteps ();
     double          value           = 0;
 
+    candidates .Resize ( numsubsteps, GetTotalDims () );
+    axisresults.Resize ( numsubsteps );
 
-    for ( int substepi = 0; substepi < params[ p ]->GetTotalSteps (); substepi++ ) {
+                                        // whole axis evaluated at once
+    for ( int substepi = 0; substepi < numsubsteps; substepi++ ) {
                                         // setting current parameter' value
         params[ p ]->Value  = params[ p ]->GetSubValue ( substepi );
-                                        // cumulate current at grid resolution
-        result      = Evaluate ();
 
+        GetAllValues ( candidates[ substepi ] );
+        }
+
+    EvaluateBatch ( candidates, numsubsteps, axisresults.GetArray () );
+
+
+    for ( int substepi = 0; substepi < numsubsteps; substepi++ ) {
+
+        double          result      = axisresults[ substepi ];
+                                        // cumulate current at grid resolution
         value      += result;
 
                                         // stats on all available results
@@ -842,13 +965,17 @@ EvaluateSimplexValues ( params, simplex );
                                         // Just evaluating simplex
 void    TGlobalOptimize::EvaluateSimplexValues ( TBunchOfGOParam& params, TSimplex& simplex )
 {
-                                        // Computing values for each vertex
-for ( int v = 0; v < simplex.GetSimplexDim (); v++ ) {
+int                 simplexdim      = simplex.GetSimplexDim ();
+TArray2<double>     candidates ( simplexdim, GetTotalDims () );
+
+for ( int v = 0; v < simplexdim; v++ ) {
                                         // Set parameters from simplex
     simplex.ToParams ( v, params );
-                                        // Compute & store value for this vertex
-    simplex.Value ( v ) = Evaluate ();
+
+    GetAllValues ( candidates[ v ] );
     }
+                                        // Compute & store value for all vertices at once
+EvaluateBatch ( candidates, simplexdim, simplex.Value.GetArray () );
 }
 
 
@@ -1039,8 +1166,11 @@ if ( contractv < min ( reflectv, worstv1 ) ) {
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // 5.4) Shrink
 
+TArray2<double>     candidates   ( simplexdim - 1, GetTotalDims () );
+TArray1<double>     shrinkvalues ( simplexdim - 1 );
+
                                         // shrink all but the best vertex
-for ( int v = 0; v < simplexdim; v++ ) {
+for ( int v = 0, ci = 0; v < simplexdim; v++ ) {
 
     if ( v == simplex.BestVertex )
         continue;
@@ -1051,9 +1181,16 @@ for ( int v = 0; v < simplexdim; v++ ) {
                                         // copy to parameters
     VectorToParams  ( simplex[ v ] );
 
-    simplex.Value ( v )  = Evaluate ();
+    GetAllValues    ( candidates[ ci++ ] );
     }
 
+                                        // all shrunk vertices evaluated at once
+EvaluateBatch ( candidates, simplexdim - 1, shrinkvalues.GetArray () );
+
+for ( int v = 0, ci = 0; v < simplexdim; v++ )
+    if ( v != simplex.BestVertex )
+        simplex.Value ( v )  = shrinkvalues[ ci++ ];
+
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // need to find the best value
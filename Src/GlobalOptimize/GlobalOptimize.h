@@ -24,6 +24,7 @@ limitations under the License.
 #endif
 
 #include    "TArray1.h"
+#include    "TArray2.h"
 #include    "Math.Stats.h"
 
 #include    "TBaseDoc.h"
@@ -215,6 +216,8 @@ constexpr double    GOMaxEvaluation             = 1e30;
 
 constexpr double    GOMaxCoeffRelDiff           = 1e-6;
 constexpr int       GOMaxIterations             = 2000;
+                                        // max # of candidates evaluated together, bounding the memory used by big box scans
+constexpr int       GOEvaluateBatchSize         = 1024;
 
                                         // less than 2 steps does not make any sense
 constexpr int       NumStepsMin                 =   2;
@@ -269,6 +272,10 @@ public:
     virtual void    GetSolution     ( GOMethod method, int how, double requestedprecision, double outliersprecision, const char *title, TEasyStats *stat = 0 );
                                         // function to be called by the optimization
     virtual double  Evaluate        ( TEasyStats *stat = 0 )   = 0;
+                                        // Evaluate called on an explicit set of values, in the flattened groups / dimensions order, GetValue being bound to them for the current thread only
+    double          EvaluateValues  ( const double* values, TEasyStats *stat = 0 );
+                                        // derived classes can allow concurrent evaluations if their Evaluate only reads parameters through GetValue / HasValue, and keeps any scratch data local
+    virtual bool    IsEvaluateThreadSafe ()                 const   { return false; }
                                         // ZoomIn each group, each parameter
     void            ZoomIn          ( double *newcenters );
                                         // for the derived class, to monitor each GetSolution step
@@ -279,12 +286,12 @@ public:
     void            SetValue        ( int type, double value )      { if ( HasValue ( type ) )  *ToValues[ type ] = value; }      // force set AN EXISTING PARAMETER
 #if defined (_DEBUG)
                                         // missing type will crash, better give some warning
-    double          GetValue        ( int type )            const   { if ( HasValue ( type ) ) return  *ToValues.at ( type );   /*assert ( HasValue ( type ) );*/ DBGV ( type, "TGlobalOptimize::GetValue: undefined type" );    return 0; }
+    double          GetValue        ( int type )            const   { if ( HasValue ( type ) ) return  IsBoundThread () ? BoundValues[ ToIndexes.at ( type ) ] : *ToValues.at ( type );   /*assert ( HasValue ( type ) );*/ DBGV ( type, "TGlobalOptimize::GetValue: undefined type" );    return 0; }
     double          GetMinValue     ( int type )            const   { if ( HasValue ( type ) ) return  *ToMin   .at ( type );   /*assert ( HasValue ( type ) );*/ DBGV ( type, "TGlobalOptimize::GetMinValue: undefined type" ); return 0; }
     double          GetMaxValue     ( int type )            const   { if ( HasValue ( type ) ) return  *ToMax   .at ( type );   /*assert ( HasValue ( type ) );*/ DBGV ( type, "TGlobalOptimize::GetMaxValue: undefined type" ); return 0; }
 #else
                                         // or test HasValue at each call, which could be sub-optimal?
-    double          GetValue        ( int type )            const   { return  *ToValues.at ( type );   }    // retrieve existing parameter, WITHOUT TESTING FOR EXISTENCE, as this is the only way for 'const'
+    double          GetValue        ( int type )            const   { return  IsBoundThread () ? BoundValues[ ToIndexes.at ( type ) ] : *ToValues.at ( type );   }    // retrieve existing parameter, WITHOUT TESTING FOR EXISTENCE, as this is the only way for 'const'
     double          GetMinValue     ( int type )            const   { return  *ToMin   .at ( type );   }    // retrieve existing parameter, WITHOUT TESTING FOR EXISTENCE, as this is the only way for 'const'
     double          GetMaxValue     ( int type )            const   { return  *ToMax   .at ( type );   }    // retrieve existing parameter, WITHOUT TESTING FOR EXISTENCE, as this is the only way for 'const'
 #endif
@@ -320,6 +327,11 @@ protected:
     double          NelderMead              ( TArray1<TGOParam*>& params, TSimplex& simplex, TEasyStats& stats, bool forceevaluate = false );
 
     int             GetGroupOffset          ( int group );
+                                        // all parameters' values, in the flattened groups / dimensions order
+    void            GetAllValues            ( double* values )  const;
+    void            SetAllValues            ( const double* values );
+                                        // each row of candidates holds all parameters' values, results are stored by candidate index
+    void            EvaluateBatch           ( const TArray2<double>& candidates, int numcandidates, double* results );
 
 
 private:
@@ -332,6 +344,13 @@ private:
     std::unordered_map<int, double*>    ToValues;
     std::unordered_map<int, double*>    ToMin;
     std::unordered_map<int, double*>    ToMax;
+    std::unordered_map<int, int>        ToIndexes;  // index in the flattened groups / dimensions order
+
+                                        // values currently evaluated by a given thread, if any
+    static thread_local const TGlobalOptimize*  BoundOptimizer;
+    static thread_local const double*           BoundValues;
+
+    bool            IsBoundThread   ()                      const   { return  BoundOptimizer == this; }
 
     void            ResetToValue    ();
     void            SetToValue      ();
@@ -23,8 +23,25 @@ namespace crtl {
 
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
-                                        // Not thread safe for the moment due to use of global  RandomUniform
-void    TMicroStates::GetRandomMaps (   int     nclusters,  TMaps&      maps    )
+                                        // Each K-Means run has its own random generator, seeded from the main one, the run index and the trial index
+                                        // Results therefore only depend on the main seed, and not on the number of threads nor on the scheduling
+inline UINT KMeansRunSeed   ( UINT baseseed, int runi, int trial )
+{
+UINT                seed            = baseseed ^ ( (UINT) runi * 0x9E3779B9 ) ^ ( (UINT) trial * 0x85EBCA6B );
+                                        // scrambling all bits, as successive seeds should give very different sequences
+seed   ^= seed >> 16;
+seed   *= 0x7FEB352D;
+seed   ^= seed >> 15;
+seed   *= 0x846CA68B;
+seed   ^= seed >> 16;
+                                        // 0 is reserved for a random device seed
+return  seed ? seed : 1;
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Thread safe, as long as each thread has its own random generator
+void    TMicroStates::GetRandomMaps (   int     nclusters,  TMaps&      maps,   TRandUniform&   randunif    )
 {
                                         // Not really optimal, but has a small memory footprint and actually runs fast due to the small chances of conflicts
 TArray1<int>        picked ( nclusters );
@@ -35,7 +52,7 @@ long                randtf;
 for ( int nc = 0; nc < nclusters; nc++ ) {
                                         // Probability is uniform across all existing maps
                                         // !If one wants reproducible results, then use a fixed see when calling Reload!
-    randtf      = RandomUniform ( (UINT) NumTimeFrames );
+    randtf      = randunif ( (UINT) NumTimeFrames );
 
                                         // all picks should differ from each others!
     goodpick    = true;
@@ -67,11 +84,12 @@ bool    TMicroStates::SegmentKMeans_Once    (
                                             TMaps&          maps,       TLabeling&          labels,
                                             PolarityType    polarity,
                                             double          &gev,
-                                            CentroidType    centroid,   bool                ranking
+                                            CentroidType    centroid,   bool                ranking,
+                                            TRandUniform&   randunif
                                             )
 {
                                         // 0.1) Ramdomly picking maps from data as inital templates - also doing the initial labeling
-GetRandomMaps   ( nclusters, maps );
+GetRandomMaps   ( nclusters, maps, randunif );
 
                                         // 0.2) Maps -> Labels
 maps.CentroidsToLabeling    (  
@@ -172,6 +190,9 @@ return true;
 
 
 //----------------------------------------------------------------------------
+                                        // Runs many K-Means, and keeps the one with the highest GEV
+                                        // Runs are independent from each others, so they are run in parallel, each thread with its own workspace.
+                                        // When there are only a few runs, it is better to let the inner loops use all the threads, which gives the very same results.
 int     TMicroStates::SegmentKMeans (   int             nclusters,
                                         TMaps&          maps,           TLabeling&          labels,
                                         PolarityType    polarity,
@@ -180,62 +201,88 @@ int     TMicroStates::SegmentKMeans (   int             nclusters,
                                         bool            ranking
                                       )
 {
-double              tempgev;
-double              bestgev;
-TMaps               tempmaps   ( nclusters, NumRows );
-TLabeling           templabels ( NumTimeFrames );
+                                        // 1 cluster will always give the same results
+int                 numeffrandomruns    = nclusters == 1 ? 1 : numrandomruns;
+                                        // Max number of trials for a single run, in case of erroneous empty maps
+constexpr int       KMeansMaxTrials     = 10;
+                                        // all runs random generators will derive from this seed
+UINT                baseseed            = RandomUniform ( (UINT) UINT_MAX );
+
+double              bestgev             = Lowest ( bestgev );
+int                 bestrun             = -1;
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-bestgev             = Lowest ( bestgev );
-int                 numeffrandomruns    = 0;    // used to count the real number of trials
+OmpParallelIfBegin ( numeffrandomruns >= GetNumMaxThreads () )
 
-                                        // runs many time the segmentation
-for ( int runagain = 0; runagain < numrandomruns; runagain++, numeffrandomruns++ ) {
+                                        // per-thread workspace
+TMaps               tempmaps        ( nclusters, NumRows );
+TLabeling           templabels      ( NumTimeFrames );
+double              tempgev;
+                                        // per-thread best results
+TMaps               threadmaps      ( nclusters, NumRows );
+TLabeling           threadlabels    ( NumTimeFrames );
+double              threadgev       = Lowest ( threadgev );
+int                 threadrun       = -1;
 
-                                        // exhaust the Gauge until we are done
-    if ( nclusters == 1 && runagain >= 1            // 1 cluster
-      || numeffrandomruns > 10 * numrandomruns ) {  // we are looping way too much with erroneous empty maps
 
-        Gauge.Next ();
-        continue;
-        }
+OmpFor
 
+for ( int runi = 0; runi < numeffrandomruns; runi++ ) {
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // early stop or error?
-                                        // Parallelized part
-    if ( ! SegmentKMeans_Once   (
-                                nclusters, 
-                                tempmaps,   templabels, // store results to temp variables
-                                polarity, 
-                                tempgev, 
-                                centroid,   ranking
-                                ) )
-        {
-        runagain--;                     // segmentation failed, restart it
-
-        continue;
+    bool                ok              = false;
+
+    for ( int trial = 0; trial < KMeansMaxTrials && ! ok; trial++ ) {
+                                        // deterministic generator for this run & trial
+        TRandUniform        randunif ( KMeansRunSeed ( baseseed, runi, trial ) );
+
+        ok  = SegmentKMeans_Once    (
+                                    nclusters, 
+                                    tempmaps,   templabels, // store results to temp variables
+                                    polarity, 
+                                    tempgev, 
+                                    centroid,   ranking,
+                                    randunif
+                                    );
         }
 
-                                        // only increment when successful
+
     Gauge.Next ();
 
     if ( ! GroupGauge.IsAlive () && CartoolObjects.CartoolApplication->IsInteractive () )
         CartoolObjects.CartoolApplication->SetMainTitle    ( Gauge );
 
+                                        // is the last run better than the current thread best?
+    if ( ok && tempgev > threadgev ) {
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // is the last trial better than the current best?
-    if ( tempgev > bestgev ) {
-
-        bestgev     = tempgev;          // our current best global explained variance
-        labels      = templabels;       // our current best maps and labeling
-        maps        = tempmaps;
+        threadgev       = tempgev;
+        threadrun       = runi;
+        threadmaps      = tempmaps;
+        threadlabels    = templabels;
         }
+    } // for runi
+
+                                        // Reduction across threads, with ties solved by the lowest run index, so results do not depend on scheduling
+OmpCriticalBegin (SegmentKMeans)
+
+if ( threadrun >= 0
+  && ( threadgev > bestgev || threadgev == bestgev && threadrun < bestrun ) ) {
+
+    bestgev     = threadgev;            // our current best global explained variance
+    bestrun     = threadrun;
+    labels      = threadlabels;         // our current best maps and labeling
+    maps        = threadmaps;
+    }
+
+OmpCriticalEnd
+
+OmpParallelEnd
+
+                                        // exhaust the Gauge for the skipped runs
+if ( numeffrandomruns < numrandomruns )
 
-    } // for runagain
+    Gauge.Next ( SuperGaugeDefaultPart, SuperGaugeNoTitle, numrandomruns - numeffrandomruns );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 \************************************************************************/
 
+#include    <queue>
+
 #include    "TMicroStates.h"
 
 #pragma     hdrstop
@@ -22,150 +24,202 @@ limitations under the License.
 namespace crtl {
 
 //----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+                                        // Heap entry for the T-AAHC initialization: best remaining partner of a given map
+struct  TAAHCNeighbor
+{
+    float           Corr;
+    int             Index1;
+    int             Index2;
+
+    bool            operator    <       ( const TAAHCNeighbor& op2 )    const   { return Corr < op2.Corr; }
+};
+
+                                        // Inserts a new candidate into the sorted list of neighbors of map index1, keeping only the 'numneighbors' best ones
+inline void InsertTAAHCNeighbor (   int                 index1,         int                 index2,         float       corr,
+                                    int&                numfound,       int                 numneighbors,
+                                    TArray2<int>&       neighbors,      TArray2<float>&     neighborscorr
+                                )
+{
+if ( numfound == numneighbors && corr <= neighborscorr ( index1, numneighbors - 1 ) )
+    return;
+
+int                 inserti         = numfound < numneighbors ? numfound++ : numneighbors - 1;
+
+for ( ; inserti > 0 && neighborscorr ( index1, inserti - 1 ) < corr; inserti-- ) {
+    neighbors     ( index1, inserti )   = neighbors     ( index1, inserti - 1 );
+    neighborscorr ( index1, inserti )   = neighborscorr ( index1, inserti - 1 );
+    }
+
+neighbors     ( index1, inserti )   = index2;
+neighborscorr ( index1, inserti )   = corr;
+}
+
+                                        // (Re)computes the list of neighbors of map index1, from all the still unpaired maps
+                                        // Returns the actual number of neighbors found
+int     FillTAAHCNeighbors  (   const TMaps&        maps,           int                 index1,
+                                const TArray1<int>& partner,        PolarityType        polarity,
+                                TArray1<float>&     allcorr,        // working buffer, linear in the number of maps
+                                int                 numneighbors,
+                                TArray2<int>&       neighbors,      TArray2<float>&     neighborscorr
+                            )
+{
+int                 nummaps         = allcorr.GetDim1 ();
+
+OmpParallelFor
+
+for ( int index2 = 0; index2 < nummaps; index2++ )
+
+    if ( index2 != index1 && partner[ index2 ] < 0 )
+
+        allcorr[ index2 ]   = Project ( maps[ index1 ], maps[ index2 ], polarity );
+
+
+int                 numfound        = 0;
+
+for ( int index2 = 0; index2 < nummaps; index2++ )
+
+    if ( index2 != index1 && partner[ index2 ] < 0 )
+
+        InsertTAAHCNeighbor ( index1, index2, allcorr[ index2 ], numfound, numneighbors, neighbors, neighborscorr );
+
+return  numfound;
+}
+
+
 //----------------------------------------------------------------------------
                                         // Initializing the Topographical Atomize and Agglomerate Hierarchical Clustering (T-AAHC)
                                         // It begins with all data points being assigned to a single cluster, with itself as the centroid.
-                                        // It then computes the correlations between all pairs of maps, sort this big table, and 
-                                        // proceed to merge these highest pairs together.
+                                        // It then merges the most correlated pair of maps, then the next most correlated pair among the remaining maps, etc...
                                         // It stops when all data has been paired, resulting in (NumTimeFrames/2) clusters of 2 maps,
                                         // each with a corresponding (forced) mean centroid.
                                         // A single cluster of 1 map can remain if NumTimeFrames is odd, which will be taken care of
                                         // in the main loop.
                                         // This type of initialization is the "best" one, as it works through all the data.
-                                        // However this can be quite expensive, and not suitable for Resting States analysis.
-                                        // In the latter case, one could assume some data continuity and simply assign pairs
-                                        // of successive maps as a fair starting point. Results, however, would change if data would be reshuffled.
+                                        // Historically, this was done by computing and sorting the triangular table of all correlations, which was
+                                        // quadratic in memory. We now only keep, for each map, the short list of its 'numneighbors' best partners,
+                                        // plus a heap of the best partner of each map. When all the neighbors of a map have been paired, its list
+                                        // is simply recomputed from the remaining maps. This gives the exact same greedy pairing, with memory
+                                        // linear in the number of maps. 'numneighbors' bounds the working set, at the cost of more re-computations.
 int     TMicroStates::SegmentTAAHC_Init (   TMaps&          maps,           TLabeling&          labels,      
                                             PolarityType    polarity,       
                                             CentroidType  /*centroid*/,
-                                            bool            ranking
+                                            bool            ranking,
+                                            int             numneighbors
                                         ) 
 {
-int                 nclusters       = NumTimeFrames;
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // There is a lot to do on the first call!
-
-                                        // 0.0) Allocate a big array, but only on first call (promised)
-                                        // init prototypes and copy maps
-
                                         // allocate and copy ALL data: each map is its own template at first
 maps.CopyFrom ( Data, NumTimeFrames );
-        
 
 //maps.Normalize ();                // not needed here, input data has done it already
 
-                                        // set initial labeling: each map is its own template
-OmpParallelFor
+Clipped ( numneighbors, 1, AtLeast ( 1, NumTimeFrames - 1 ) );
 
-for ( long tf = 0; tf < NumTimeFrames; tf++ )
 
-    labels.SetLabel ( tf, tf, PolarityDirect );          
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // 0.1) For each map, compute the list of its most correlated maps
+TArray2<int>        neighbors       ( NumTimeFrames, numneighbors );
+TArray2<float>      neighborscorr   ( NumTimeFrames, numneighbors );
+TArray1<int>        numleft         ( NumTimeFrames );  // remaining number of neighbors in each list
+TArray1<int>        headi           ( NumTimeFrames );  // current best neighbor in each list
+TArray1<int>        partner         ( NumTimeFrames );  // paired map, or -1
+TArray1<float>      allcorr         ( NumTimeFrames );
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // 0.1) Compute all possible correlations between all maps
-                                        // This is the historical version. It is optimal in the sense it doesn't car for the data ordering
-                                        // Another option would be to simply assign pairs of successive data points. But then it would depend on the initial data ordering, which would still be OK for regular cases
-int                 numtriangular       = ( NumTimeFrames * ( NumTimeFrames - 1 ) ) / 2;
-TArray2<float>      allcorr ( numtriangular, 3 );
+partner     = -1;
 
 OmpParallelFor
 
-for ( int nc1 = 0; nc1 < NumTimeFrames; nc1++ ) {
+for ( int index1 = 0; index1 < NumTimeFrames; index1++ ) {
 
-//  Gauge.Next ();
+    int                 numfound        = 0;
 
-    for ( int nc2 = nc1 + 1; nc2 < NumTimeFrames; nc2++ ) {
-                                        // exact index for insertion - mandatory for parallelization
-        int     inserti     = numtriangular - ( ( NumTimeFrames - nc1 ) * ( NumTimeFrames - nc1 - 1 ) ) / 2 + nc2 - nc1 - 1;
+    for ( int index2 = 0; index2 < NumTimeFrames; index2++ )
 
-        allcorr ( inserti, 0 )  = nc1;
-        allcorr ( inserti, 1 )  = nc2;
-        allcorr ( inserti, 2 )  = Project              ( maps[ nc1 ], maps[ nc2 ], polarity );
-//      allcorr ( inserti, 2 )  = NormalizedDifference ( maps[ nc1 ], maps[ nc2 ], polarity );
-        } // for nc2
-    } // for nc1
+        if ( index2 != index1 )
 
-                                        // sort by increasing correlation / decreasing distance
-allcorr.SortRows ( 2, Ascending );
+            InsertTAAHCNeighbor ( index1, index2, Project ( maps[ index1 ], maps[ index2 ], polarity ), numfound, numneighbors, neighbors, neighborscorr );
 
+    numleft[ index1 ]   = numfound;
+    headi  [ index1 ]   = 0;
+    } // for index1
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // 0.2) Scan all pairs, introduce them by order of importance, ie correlation
-int                 lastcorri       = numtriangular - 1;
+                                        // heap of the best partner of each map
+std::priority_queue<TAAHCNeighbor>  bestpairs;
 
-                                        // Consume all pairs from the triangular matrix
-do {
-                                        // move the end of the correlation list (best)
-    for ( ; lastcorri >= 0 && allcorr ( lastcorri, 0 ) == UndefinedLabel; ) {
+for ( int index1 = 0; index1 < NumTimeFrames; index1++ )
 
-        lastcorri--;
+    if ( numleft[ index1 ] > 0 )
 
-        Gauge.Next ();
-        }
+        bestpairs.push ( { neighborscorr ( index1, 0 ), index1, neighbors ( index1, 0 ) } );
 
-    if ( lastcorri < 0 )                // no more pairs
-        break;
 
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // 0.2) Pair the maps, by order of importance, ie correlation
+while ( ! bestpairs.empty () ) {
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // use the array to get the most correlated pair of the remaining solo maps
-    LabelType       index1      = allcorr ( lastcorri, 0 );
-    LabelType       index2      = allcorr ( lastcorri, 1 );
+    TAAHCNeighbor       best            = bestpairs.top ();
 
-                                        // a single remaining map will be processed by the Atomize step
-    if (   index1 == UndefinedLabel 
-        || index2 == UndefinedLabel )
-        break;
+    bestpairs.pop ();
 
+    int                 index1          = best.Index1;
+    int                 index2          = best.Index2;
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // update correlation table with new indexes
-    OmpParallelBegin
+    if ( partner[ index1 ] >= 0 )       // already paired from another entry
+        continue;
 
-    OmpFor
-    for ( int aci = lastcorri; aci >= 0; aci-- ) {
+                                        // best neighbor has been taken meanwhile: advance to the next free one, and re-insert
+    if ( partner[ index2 ] >= 0 ) {
 
-        if ( allcorr ( aci, 0 ) == index1 || allcorr ( aci, 1 ) == index1
-          || allcorr ( aci, 0 ) == index2 || allcorr ( aci, 1 ) == index2 )
+        do {
+            headi  [ index1 ]++;
+            numleft[ index1 ]--;
+            } while ( numleft[ index1 ] > 0 && partner[ neighbors ( index1, headi[ index1 ] ) ] >= 0 );
 
-            allcorr ( aci, 0 )  =
-            allcorr ( aci, 1 )  = UndefinedLabel;
+                                        // list exhausted? recompute it from all remaining maps
+        if ( numleft[ index1 ] == 0 ) {
 
-        if ( allcorr ( aci, 0 ) > index2 )   allcorr ( aci, 0 )--;
-        if ( allcorr ( aci, 1 ) > index2 )   allcorr ( aci, 1 )--;
-        }
+            numleft[ index1 ]   = FillTAAHCNeighbors    (   maps,       index1, 
+                                                            partner,    polarity,
+                                                            allcorr,
+                                                            numneighbors,
+                                                            neighbors,  neighborscorr 
+                                                        );
+            headi  [ index1 ]   = 0;
+            }
+
+                                        // a single remaining map will be processed by the Atomize step
+        if ( numleft[ index1 ] > 0 )
 
-                                        // update labeling
-    OmpFor
-    for ( long tf = 0; tf < NumTimeFrames; tf++ ) {
+            bestpairs.push ( { neighborscorr ( index1, headi[ index1 ] ), index1, neighbors ( index1, headi[ index1 ] ) } );
 
-        if      ( labels[ tf ] == index2 )  labels[ tf ] = index1;   // merge index2 into index1 (the smallest index value)
-        else if ( labels[ tf ] >  index2 )  labels[ tf ]--;          // shift labels after index2
+        continue;
         }
 
-    OmpParallelEnd
+                                        // here we have the most correlated pair of the remaining solo maps
+    partner[ index1 ]   = index2;
+    partner[ index2 ]   = index1;
+
+    Gauge.Next ();
+    }
 
-                                        // update maps, shift rows up
-    if ( nclusters - 1 - index2 > 0 )
 
-//      MoveVirtualMemory ( maptarray[ index2 ], maptarray[ index2 + 1 ],
-//                              ( nclusters - 1 - index2 ) * maptarray.GetDim2 () * maptarray.AtomSize () );
-        for ( int i = index2; i < nclusters - 1; i++ )
-            maps[ i ]   = maps[ i + 1 ];
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // 0.3) Labeling: each pair gets the index of its first map, then indexes are compacted
+                                        // This is the same ordering as merging the second map of each pair into the first one, then shifting down all the remaining ones
+int                 nclusters       = 0;
 
+for ( long tf = 0; tf < NumTimeFrames; tf++ )
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // we now have one less cluster
-    nclusters--;
+    if ( partner[ tf ] < 0 || partner[ tf ] > tf )
 
-    } while ( true );
+        labels.SetLabel ( tf, nclusters++, PolarityDirect );
+    else
+        labels.SetLabel ( tf, labels[ partner[ tf ] ], PolarityDirect );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // 0.3) Recompute all maps, as we have pairs now
+                                        // 0.4) Recompute all maps, as we have pairs now
 maps.LabelingToCentroids    ( 
                             Data,       &ToData, 
                             nclusters, 
@@ -215,8 +269,6 @@ else {
                                         // Loop down to the requested number of clusters
 TSelection          clustertf ( NumTimeFrames, OrderSorted );
 TSelection          index2tf  ( NumTimeFrames, OrderSorted );
-                                        // pointer to specialized function, according to polarity
-bool    (*keepbestlabeling) ( const TMap&, const TMap&, double&, double )   = polarity == PolarityEvaluate ? &KeepBestLabelingEvaluate : &KeepBestLabelingDirect;
 
 
                                         // decrement number of clusters until down to the requested one
@@ -275,27 +327,22 @@ for ( int nc = startclust; nc > nclusters; ) {
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // 1.2) distribute maps from cluster index to all others
     if ( index != UndefinedLabel ) {
+                                        // search to which cluster each map should be distributed, all maps at once
+                                        // scan again each cluster, but not index!
+        TSelection          othermaps ( nc, OrderSorted );
 
-        for ( TIteratorSelectedForward tfi ( index2tf ); (bool) tfi; ++tfi ) {
+        othermaps.Set   ( 0, nc - 1 );
+        othermaps.Reset ( index );
 
-            labels.Reset ( tfi() );
-            
-                                        // search to which cluster it should be distributed
-            double          maxcorr     = Lowest ( maxcorr );
-
-                                        // scan again each cluster
-            for ( int nc1 = 0; nc1 < nc; nc1++ )
-
-                if ( nc1 != index )     // but not index!
                                         // !Don't allocate at all if negative correlation - final Labeling will fill the holes later on!
                                         // In fact, using correlation threshold of 0.5, instead 0, is the actual limit used since forever, and seems to give better results
-                    if ( (*keepbestlabeling) (   tempmaps[ nc1 ],    Data[ tfi() ], maxcorr, 0.5 /*0*/  ) )
-
-                        labels.SetLabel ( tfi(), nc1 );
-
-
-            labels.UpdatePolarities ( Data, tfi(), tfi(), tempmaps, polarity );
-            } // for index tf's
+        tempmaps.CentroidsToLabeling    (   
+                                        Data, 
+                                        index2tf, 
+                                        nc, 
+                                        &othermaps, labels, 
+                                        polarity,   0.5 /*0*/
+                                        );
 
     
         OmpParallelFor
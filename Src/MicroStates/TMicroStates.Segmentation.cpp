@@ -727,7 +727,7 @@ Gauge.SetRange ( gaugesegglobal,        numclusters * 3 + 2 );
 //Gauge.SetRange ( gaugesegcluster,       numclusters );
 Gauge.SetRange ( gaugesegcluster,       clusteringmethod == ClusteringKMeans  ? numclusters * numrandomtrials
                                                           /*ClusteringTAAHC*/ : //  NumTimeFrames  
-                                                                                  ( NumTimeFrames * ( NumTimeFrames - 1 ) ) / 2     // size of triangular matrix
+                                                                                  NumTimeFrames / 2                                 // number of initial pairs
                                                                                 + ( NumTimeFrames - minclusters + 1 ) 
                                                                                 + ( numclusters - 1 ) * ( numclusters - 2 )     );
 
@@ -48,6 +48,8 @@ constexpr CentroidType  MEGCentroidMethod           = MeanCentroid;     // alway
 constexpr CentroidType  ESICentroidMethod           = MedianCentroid;   // Median gives sharper shapes/contours, counterpart is it basically forces to store all the data, and is more time-consuming to compute
 constexpr double        ESICentroidTopData          = 0.25;             // top part of ranked data to optionally keep
 
+constexpr int           TAAHCInitNumNeighbors       = 32;               // T-AAHC initialization only keeps that many best neighbors per map, instead of the full triangular correlation matrix - lower values bound the memory, at the cost of more re-computations
+
                                         // Flag used to generate all known criteria for tests
 //#define             UseAllCriteria
 
@@ -540,7 +542,7 @@ protected:
 //  TArray1<long>   AbsTFToRelTF;
 
 
-    TRandUniform    RandomUniform;      // used in GetRandomMaps
+    TRandUniform    RandomUniform;      // used to seed the K-Means runs
 
     TSuperGauge     Gauge;
     TSuperGauge     GroupGauge;         // global gauge, used if more than 1 group
@@ -556,10 +558,10 @@ protected:
     void            ComputeGevPerCluster    ( int nclusters, const TMaps& maps, const TLabeling& labels, TVector<double>& gevpercluster ) const;
 
                                         // Clustering methods
-    bool            SegmentKMeans_Once      ( int nclusters, TMaps& maps, TLabeling& labels, PolarityType polarity, double &gev, CentroidType centroid, bool ranking /*, TArray1<double> dispersion*/ );
-    void            GetRandomMaps           ( int nclusters, TMaps& maps );
+    bool            SegmentKMeans_Once      ( int nclusters, TMaps& maps, TLabeling& labels, PolarityType polarity, double &gev, CentroidType centroid, bool ranking, TRandUniform& randunif /*, TArray1<double> dispersion*/ );
+    void            GetRandomMaps           ( int nclusters, TMaps& maps, TRandUniform& randunif );
 //  void            GetRandomMapsPP         ( int nclusters, TMaps& maps, PolarityType polarity );
-    int             SegmentTAAHC_Init       (                TMaps& maps, TLabeling& labels, PolarityType polarity, CentroidType centroid, bool ranking );
+    int             SegmentTAAHC_Init       (                TMaps& maps, TLabeling& labels, PolarityType polarity, CentroidType centroid, bool ranking, int numneighbors = TAAHCInitNumNeighbors );
 
                                         // Clustering criteria
     void            ComputeAllWBA           ( int nclusters, int nummaps, const TMaps& maps, const TLabeling& labels, PolarityType polarity, TArray2<double>& var );
@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 \************************************************************************/
 
+#include    <algorithm>
+
 #include    "Files.BatchAveragingFiles.h"
 
 #include    "Math.Stats.h"
@@ -34,12 +36,37 @@ limitations under the License.
 namespace crtl {
 
 //----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+                                        // Exact median by selection, no full sort needed - !values will be reordered!
+                                        // Follows the same conventions as TEasyStats::Median: strict value returns the upper center value for even numbers
+double  SelectMedian    ( float* values, int numvalues, bool strictvalue )
+{
+if ( numvalues <= 0 )
+    return  0;
+
+if ( numvalues == 1 )
+    return  values[ 0 ];
+
+                                        // index of the center value, in ascending order
+int                 halfi           = numvalues / 2;
+
+std::nth_element ( values, values + halfi, values + numvalues );
+
+if ( strictvalue || IsOdd ( numvalues ) )
+    return  values[ halfi ];
+
+                                        // lower center value is the max of the lower part
+return  ( values[ halfi ] + *std::max_element ( values, values + halfi ) ) / 2;
+}
+
+
 //----------------------------------------------------------------------------
                                         // !Doesn't test for files consistencies, this should be done by the caller!
 void    BatchAveragingScalar    (   const TGoF& gof,
                                     char*       meanfile,       char*       sdfile,         char*       snrfile,
                                     char*       medianfile,     char*       madfile,
-                                    bool        openresults,    bool        showgauge 
+                                    bool        openresults,    bool        showgauge,
+                                    size_t      robustmemory
                                 )
 {
 ClearString ( meanfile   );
@@ -102,16 +129,6 @@ CheckNoOverwrite    ( filemedian );
 CheckNoOverwrite    ( filemad    );
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-TSuperGauge         Gauge;
-
-if ( showgauge ) {
-    Gauge.Set           ( BatchAveragingTitle );
-    Gauge.AddPart       ( 0, (int) gof );
-    }
-
-
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 TOpenDoc<TTracksDoc>    eegdoc;
@@ -122,18 +139,30 @@ if ( ! eegdoc.Open ( gof[ 0 ], OpenDocHidden ) )
 int                 numtracks           = eegdoc->GetNumElectrodes ();
 int                 numtf               = eegdoc->GetNumTimeFrames ();
 int                 lineardim           = numtracks * numtf;
+int                 numfiles            = (int) gof;
 
                                         
 bool                nonrobust       = meanfile   || sdfile || snrfile;
 bool                robust          = medianfile || madfile;
+                                        // Robust stats need all files at once, so they are processed by tiles of consecutive time frames
+                                        // Tiles are read by batches of 1 tile per thread, each batch, with its reading buffer, fitting within robustmemory
+int                 numbatchtiles   = robust ? GetNumMaxThreads () : 1;
+int                 tilenumtf       = robust ? Clip ( (int) NoMore ( (size_t) numtf, robustmemory / ( (size_t) numbatchtiles * ( numfiles + 1 ) * numtracks * sizeof ( float ) ) ), 1, ( numtf + numbatchtiles - 1 ) / numbatchtiles ) 
+                                             : numtf;
+int                 numtiles        = ( numtf + tilenumtf - 1 ) / tilenumtf;
+int                 numbatches      = ( numtiles + numbatchtiles - 1 ) / numbatchtiles;
+int                 batchnumtf      = min ( numbatchtiles * tilenumtf, numtf );
+
 TTracks<float>      eegbuff;
 TTracks<float>      sum;
 TTracks<float>      sum2;
 TTracks<float>      snr;
-TGoEasyStats        stat;
+TTracks<float>      median;
+TTracks<float>      mad;
+TArray1<float>      batchdata;          // [ track ][ tf ][ file ] all files values of a given cell being contiguous
 
 
-                    eegbuff .Resize ( numtracks, numtf );
+                    eegbuff .Resize ( numtracks, batchnumtf );
                                         // there is some potential duplicate allocations, but it is kepts as is for the sake of easier computation
 if ( nonrobust ) {
                     sum     .Resize ( numtracks, numtf );
@@ -141,8 +170,21 @@ if ( nonrobust ) {
     if ( snrfile )  snr     .Resize ( numtracks, numtf );
     }
 
-if ( robust )                           // this will be a lot...
-                    stat    .Resize ( lineardim, (int) gof );
+if ( robust ) {
+                    batchdata.Resize ( numtracks * batchnumtf * numfiles );
+    if ( medianfile)median  .Resize ( numtracks, numtf );
+    if ( madfile )  mad     .Resize ( numtracks, numtf );
+    }
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+TSuperGauge         Gauge;
+
+if ( showgauge ) {
+    Gauge.Set           ( BatchAveragingTitle );
+    Gauge.AddPart       ( 0, numfiles * numbatches );
+    }
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -160,63 +202,115 @@ expfile.SetAtomType ( AtomTypeScalar );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Without robust stats, there is a single batch of a single tile of the whole data set
+for ( int batchi = 0; batchi < numbatches; batchi++ ) {
 
-for ( int eegi = 0; eegi < (int) gof; eegi++ ) {
+    int                 tile1           = batchi * numbatchtiles;
+    int                 tile2           = min ( tile1 + numbatchtiles, numtiles ) - 1;
+    int                 tf1             = tile1 * tilenumtf;
+    int                 tf2             = min ( ( tile2 + 1 ) * tilenumtf, numtf ) - 1;
+    int                 batchtf         = tf2 - tf1 + 1;
+    int                 numreadfiles    = 0;
 
-    if ( Gauge.IsAlive () )
-        Gauge.Next ( 0 );
 
+    for ( int eegi = 0; eegi < numfiles; eegi++ ) {
+
+        if ( Gauge.IsAlive () )
+            Gauge.Next ( 0 );
 
-    if ( ! eegdoc.Open ( gof[ eegi ], OpenDocHidden ) )
-        continue;
+
+        if ( ! eegdoc.Open ( gof[ eegi ], OpenDocHidden ) )
+            continue;
 
         
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // try to recover the sampling frequency on each file
-    if ( expfile.SamplingFrequency == 0 && eegdoc->GetSamplingFrequency () > 0 )
+        if ( expfile.SamplingFrequency == 0 && eegdoc->GetSamplingFrequency () > 0 )
 
-        expfile.SamplingFrequency   = eegdoc->GetSamplingFrequency ();
+            expfile.SamplingFrequency   = eegdoc->GetSamplingFrequency ();
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // get whole data set
-    eegdoc->ReadRawTracks ( 0, numtf - 1, eegbuff );
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // get only current batch of tiles
+        eegdoc->ReadRawTracks ( tf1, tf2, eegbuff );
 
 
-    if ( robust )
+        if ( robust )
 
-        OmpParallelFor
+            OmpParallelFor
 
-        for ( int e  = 0; e  < numtracks; e++  )
-        for ( int tf = 0; tf < numtf;     tf++ )
+            for ( int e  = 0; e  < numtracks; e++  )
+            for ( int tf = 0; tf < batchtf;   tf++ )
 
-            stat[ e * numtf + tf ].Add ( eegbuff ( e, tf ) );
+                batchdata[ ( e * batchtf + tf ) * numfiles + numreadfiles ] = eegbuff ( e, tf );
 
 
-    if ( nonrobust ) {
+        if ( nonrobust ) {
 
-        OmpParallelFor
+            OmpParallelFor
 
-        for ( int i = 0; i < lineardim; i++ ) {
+            for ( int e  = 0; e  < numtracks; e++  )
+            for ( int tf = 0; tf < batchtf;   tf++ ) {
 
-            sum.GetValue ( i )     += eegbuff.GetValue ( i );
+                sum ( e, tf1 + tf )    += eegbuff ( e, tf );
 
-            if ( sdfile )
-                sum2.GetValue ( i )    += Square ( eegbuff.GetValue ( i ) );
+                if ( sdfile )
+                    sum2 ( e, tf1 + tf )   += Square ( eegbuff ( e, tf ) );
+                }
             }
-        }
 
 
-    eegdoc.Close ();
-    } // for eegi
+        numreadfiles++;
+
+        eegdoc.Close ();
+        } // for eegi
+
+
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // exact median and MAD of all the cells, 1 tile per thread
+    if ( robust ) {
+
+        OmpParallelBegin
+                                        // each thread has its own selection buffer
+        TArray1<float>      deviations ( numreadfiles );
+
+        OmpForDynamic
+
+        for ( int tilei = tile1; tilei <= tile2; tilei++ ) {
+
+            int                 ttf1            = tilei * tilenumtf - tf1;
+            int                 ttf2            = min ( ttf1 + tilenumtf, batchtf ) - 1;
+
+            for ( int e  = 0;    e  < numtracks; e++  )
+            for ( int tf = ttf1; tf <= ttf2;     tf++ ) {
+
+                float*              values          = batchdata.GetArray () + ( e * batchtf + tf ) * numfiles;
+
+                if ( medianfile )
+                    median ( e, tf1 + tf )  = SelectMedian ( values, numreadfiles, true );
+
+                if ( madfile ) {
+
+                    double              center          = SelectMedian ( values, numreadfiles, false );
+
+                    for ( int i = 0; i < numreadfiles; i++ )
+                        deviations[ i ] = fabs ( values[ i ] - center );
+                                        // rescaling to be an unbiased estimator of standard deviation sigma
+                    mad ( e, tf1 + tf ) = SelectMedian ( deviations.GetArray (), numreadfiles, false ) * MADToSigma;
+                    }
+                }
+            }
+
+        OmpParallelEnd
+        } // if robust
+
+    } // for batchi
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 if ( nonrobust ) {
 
-    int                 numfiles        = (int) gof;
-
     //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // compute SD
     if ( sdfile ) {
@@ -279,10 +373,7 @@ if ( medianfile ) {
 
     if ( CanOpenFile ( expfile.Filename, CanOpenFileWriteAndAsk ) ) {
 
-        for ( int e  = 0; e  < numtracks; e++  )
-        for ( int tf = 0; tf < numtf;     tf++ )
-
-            expfile.Write ( stat[ e * numtf + tf ].Median (), tf, e );
+        expfile.Write   ( median, Transposed );
 
         expfile.End ();
 
@@ -350,10 +441,7 @@ if ( madfile ) {
 
     if ( CanOpenFile ( expfile.Filename, CanOpenFileWriteAndAsk ) ) {
 
-        for ( int e  = 0; e  < numtracks; e++  )
-        for ( int tf = 0; tf < numtf;     tf++ )
-                                               // !destroys data!
-            expfile.Write ( stat[ e * numtf + tf ].MAD ( CanAlterData ), tf, e );
+        expfile.Write   ( mad, Transposed );
 
         expfile.End ();
 
@@ -21,6 +21,8 @@ namespace crtl {
 //----------------------------------------------------------------------------
 
 constexpr char*     BatchAveragingTitle         = "Batch Averaging";
+                                        // Upper memory bound used by the robust averaging, which needs all files at once
+constexpr size_t    BatchAveragingRobustMemory  = (size_t) 1 << 30;
 
 enum        FrequencyAnalysisType;
 enum        PolarityType;
@@ -30,7 +32,8 @@ class       TGoF;
 void    BatchAveragingScalar    (   const TGoF& gof,
                                     char*       meanfile,       char*       sdfile,         char*       snrfile,
                                     char*       medianfile,     char*       madfile,
-                                    bool        openresults,    bool        showgauge       = true
+                                    bool        openresults,    bool        showgauge       = true,
+                                    size_t      robustmemory    = BatchAveragingRobustMemory
                                 );
                                         // can also save the results as norms
 void    BatchAveragingVectorial (   const TGoF& gof, 
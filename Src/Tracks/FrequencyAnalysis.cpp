@@ -31,6 +31,7 @@ limitations under the License.
 #include    "Dialogs.TSuperGauge.h"
 
 #include    "TExportTracks.h"
+#include    "TTracksBlocksPipeline.h"
 
 #include    "TTracksDoc.h"
 #include    "TFreqCartoolDoc.h"             // TFreqFrequencyName
@@ -1448,8 +1449,6 @@ if ( verbosey == Interactive ) {
     CartoolObjects.CartoolApplication->SetMainTitle ( Gauge );
     }
 
-                                        // we read blocks of EEG data
-TArray2<float>      blockeeg ( eegdoc->GetTotalElectrodes (), blocksize );  // + EegFilterSideSize ); no filters here!
 TArray3<float>      results  (  expfile.NumTime,                                                        // !already transposed for direct file output!
                                 expfile.NumTracks, 
                                 expfile.NumFrequencies 
@@ -1509,12 +1508,15 @@ if ( IsFFTApproxMethod ( analysis ) ) {
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // MKL FFT processing objects
 mkl::TMklFft        fft;
-mkl::TMklFft        ffti;
+                                        // S-Transform: one inverse FFT descriptor per thread, set once and re-used for all the (electrode x frequency) tiles
+vector<mkl::TMklFft>    stffti ( IsSTMethod ( analysis ) ? GetNumMaxThreads () : 0 );
 
 if ( IsSTMethod ( analysis ) ) {
                                         // There is no available FFT rescaling option here, as we do the full (forward -> backward) transform
     fft .Set ( mkl::FromReal,      FFTRescalingForward,     blocksize );
-    ffti.Set ( mkl::BackToComplex, FFTRescalingBackward,    blocksize );
+
+    for ( auto& ffti : stffti )
+        ffti.Set ( mkl::BackToComplex, FFTRescalingBackward,    blocksize );
     }
 else { // FFT, Power Maps (also FFT), FFT Approximation
                                         // Recommended FFT rescaling is FFTRescalingParseval
@@ -1522,6 +1524,66 @@ else { // FFT, Power Maps (also FFT), FFT Approximation
     }
 
 
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // S-Transform set-up, done once for all electrodes:
+                                        //  - flattening the saved frequencies, so that (electrode x frequency) tiles can be spread across threads
+                                        //  - a bank of Gaussian kernels, which only depend on the block size and the frequency
+TArray1<int>            stsavedband;    // saved frequency index -> frequency band index
+TArray1<int>            stsavedfreq;    // saved frequency index -> frequency index
+vector<TVector<AReal>>  stkernels;      // frequency index -> first half of the Gaussian kernel, truncated to its non-null part
+TArray2<AComplex>       stspectra;      // analytic signal of each saved electrode, in the frequency domain
+
+
+if ( IsSTMethod ( analysis ) ) {
+
+    stsavedband.Resize ( numsavedfreqs );
+    stsavedfreq.Resize ( numsavedfreqs );
+
+    int                         maxfreq_i   = 0;
+    const TOneFrequencyBand*    fb          = freqbands.data ();
+
+    for ( int fbi = 0, savedfi0 = 0; fbi < numfreqbands; fbi++, fb++ )
+    for ( int fi = fb->SaveFreqMin_i; fi <= fb->SaveFreqMax_i; fi += fb->SaveFreqStep_i, savedfi0++ ) {
+
+        stsavedband[ savedfi0 ] = fbi;
+        stsavedfreq[ savedfi0 ] = fi;
+
+        Maxed ( maxfreq_i, fi + ( fb->AvgNumFreqs - 1 ) * fb->AvgFreqStep_i );
+        }
+
+                                        // Phase output doesn't use any Gaussian weighting
+    if ( outputatomtype != OutputAtomPhase ) {
+                                        // !Gaussian is centered on 0 / blocksize (not on mid-part)!
+        auto    STGaussian  = [] ( int i, int fi2 ) { return (AReal) expl ( -2.0 * Square ( Pi * i / (double) fi2 ) ); };
+
+        stkernels.resize ( maxfreq_i + 1 );
+
+        fb      = freqbands.data ();
+
+        for ( int fbi = 0; fbi < numfreqbands; fbi++, fb++ )
+        for ( int fi = fb->SaveFreqMin_i; fi <= fb->SaveFreqMax_i; fi += fb->SaveFreqStep_i )
+        for ( int downf = 0, fi2 = fi; downf < fb->AvgNumFreqs; downf++, fi2 += fb->AvgFreqStep_i ) {
+
+            if ( fi2 == 0 || stkernels[ fi2 ].GetDim () > 0 )
+                continue;
+                                        // kernel is symmetrical, so we need only its first half, up to blocksize / 2
+                                        // it also underflows single precision at ~2.3 x fi2, all products past this point are null
+            int         kernelsize      = 1;
+
+            while ( kernelsize <= blocksize / 2 && STGaussian ( kernelsize, fi2 ) != 0 )
+                kernelsize++;
+
+            stkernels[ fi2 ].Resize ( kernelsize );
+
+            for ( int i = 0; i < kernelsize; i++ )
+                stkernels[ fi2 ] ( i )  = STGaussian ( i, fi2 );
+            }
+        }
+                                        // real FFT returns only the first freqsize values, all the others being null
+    stspectra.Resize ( numelsave, freqsize );
+    }
+
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // For a REAL INPUT SIGNAL, the optimized FFT will return only ~HALF OF THE RESULTS, namely the "positive" frequencies
                                         // But we still need to ACCOUNT for the corresponding "negative" frequencies, either for the norm or energy, for the Parseval equality to be correct
@@ -1542,305 +1604,351 @@ if ( verbosey == Interactive ) {
     CartoolObjects.CartoolApplication->SetMainTitle ( Gauge );
     }
 
-                                        // scan all blocks
-for ( int blocki0 = 0, firsttf = timemin; blocki0 < numblocks; blocki0++, firsttf += blockstep ) {
-
-    if ( verbosey == Interactive && ! IsSTMethod ( analysis ) ) {
-        Gauge.Next ( gaugefreqloop );
-        CartoolObjects.CartoolApplication->SetMainTitle ( Gauge );
-        }
+auto    IsGoodBlock     = [ &badepochs, &analysis, &rejectmarkers ] ( int fromtf, int totf )
+{
+if ( badepochs != SkippingBadEpochsList 
+  || IsSTMethod ( analysis ) )          // we need the data anyway
+    return  true;
 
+for ( int i = 0; i < (int) rejectmarkers; i++ )
 
-    int             fromtf          = firsttf;
-    int             totf            = firsttf + blocksize - 1;
-
+    if ( rejectmarkers[ i ]->IsOverlappingInterval ( fromtf, totf ) )
+        return  false;
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+return  true;
+};
 
-    bool            goodblock       = true;
+                                        // Called from the reading thread
+auto    ReadBlock       = [ &eegdoc, &timemin, &blockstep, &blocksize, &datatypein, &ref, &refsel, &IsGoodBlock ] ( int blocki0, TArray2<float>& blockeeg )
+{
+int                 fromtf          = timemin + blocki0 * blockstep;
+int                 totf            = fromtf  + blocksize - 1;
 
+if ( ! IsGoodBlock ( fromtf, totf ) )
+    return;
+                                        // read the block of time frames, with all electrodes, without filters and pseudos
+eegdoc->GetTracks   (   fromtf,         totf, 
+                        blockeeg,       0, 
+                        datatypein, 
+                        ComputePseudoTracks, 
+                        ref,            &refsel 
+                    );
+};
 
-    if ( badepochs == SkippingBadEpochsList 
-      && ! IsSTMethod ( analysis ) ) {    // we need the data anyway
+                                        // non-overlapping blocks are contiguous: any temporal filter can then carry its states from one block to the next, each TF being read only once
+bool                oldfiltersstreaming = eegdoc->IsFiltersStreaming ();
 
-        for ( int i = 0; i < (int) rejectmarkers; i++ )
+eegdoc->SetFiltersStreaming ( blockstep == blocksize );
 
-            if ( rejectmarkers[ i ]->IsOverlappingInterval ( fromtf, totf ) ) {
+                                        // we read blocks of EEG data in the background, the next block being read while the current one is processed
+TTracksBlocksReader<TArray2<float>>     blocksreader;
 
-                goodblock   = false;
-                break;
-                }
-        }
+blocksreader.Start ( numblocks, eegdoc->GetTotalElectrodes (), blocksize, ReadBlock,   // + EegFilterSideSize ); no filters here!
+                     TracksBlocksPipelineNumBuffers ( (double) eegdoc->GetTotalElectrodes () * blocksize * sizeof ( float ) ) );
 
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-    if ( goodblock ) {
+                                        // scan all blocks
+for ( int blocki0 = 0, firsttf = timemin; blocki0 < numblocks; blocki0++, firsttf += blockstep ) {
 
-        numgoodblocks++;
-                                        // read the block of time frames, with all electrodes, without filters and pseudos
-        eegdoc->GetTracks   (   fromtf,         totf, 
-                                blockeeg,       0, 
-                                datatypein, 
-                                ComputePseudoTracks, 
-                                ref,            &refsel 
-                            );
+    if ( verbosey == Interactive && ! IsSTMethod ( analysis ) ) {
+        Gauge.Next ( gaugefreqloop );
+        CartoolObjects.CartoolApplication->SetMainTitle ( Gauge );
         }
 
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Settinp up our variables
-    if ( IsFFTApproxMethod ( analysis ) )
-
-        fftappr.ResetMemory ();
-
-
-    OmpParallelBegin
-                                        // Allocating on each new block seems OK compared to the following computation load - Allocating outside the parallel loop complexifies the code, and gains are not assured
-
-    TVector<AReal>      X;              // current block of input, real data
+    int             fromtf          = firsttf;
+    int             totf            = firsttf + blocksize - 1;
 
-    TVector<AComplex>   F;              // frequency results, complex
 
-                                        // Only for S-Transform:
-    TVector<AReal>      GaussianKernel;
-    TVector<AComplex>   FG;             // frequencies multiplied by Gaussian Kernel
-    TVector<AComplex>   ST;             // S-Transform results
-    TVector<AComplex>   SumST;
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+    bool            goodblock       = IsGoodBlock ( fromtf, totf );
 
-    if      ( IsSTMethod ( analysis ) ) {
+                                        // !retrieved for all blocks, even the bad ones, to stay in sync with the reading thread!
+    TArray2<float>& blockeeg        = blocksreader.Next ();
 
-        X               .Resize ( fft .GetDirectDomainSize ()   );
 
-        F               .Resize ( fft .GetDirectDomainSize ()   );  // !allocate more than the real FFT transform would do, as we need all frequencies for the Analytic Signal!
+    if ( goodblock )
 
-        GaussianKernel  .Resize ( fft .GetDirectDomainSize ()   );  // same reason
-        FG              .Resize ( fft .GetDirectDomainSize ()   );  // same reason
-        ST              .Resize ( ffti.GetDirectDomainSize ()   );
-        SumST           .Resize ( ffti.GetDirectDomainSize ()   );
-        }
-    else if ( IsFFTApproxMethod ( analysis ) ) {
+        numgoodblocks++;
 
-        X               .Resize ( fft.GetDirectDomainSize ()    );
-        F               .Resize ( fft.GetFrequencyDomainSize () );  // FFT optimization of real signal allows to allocate half data points
-        }
-    else { // all other FFT analysis
 
-        X               .Resize ( fft.GetDirectDomainSize ()    );
-        F               .Resize ( fft.GetFrequencyDomainSize () );  // FFT optimization of real signal allows to allocate half data points
-        }
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // S-Transform is processed on its own, in 2 parallel steps:
+                                        //  - forward FFT and analytic signal of each electrode, computed only once
+                                        //  - then all (electrode x saved frequency) tiles, re-using the Gaussian kernels bank and the per-thread inverse FFT
+                                        // S-Transform always has a single block, spanning the whole time range, so there is no need for a block dimension here
+    if ( IsSTMethod ( analysis ) ) {
 
+        OmpParallelBegin
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+        TVector<AReal>      X   ( fft.GetDirectDomainSize () ); // current block of input, real data
+        TVector<AComplex>   FG  ( blocksize );  // frequencies multiplied by Gaussian Kernel
+        TVector<AComplex>   ST  ( blocksize );  // S-Transform results
+        TVector<AComplex>   SumST ( blocksize );
 
-    OmpFor
-                                        // process only the selected electrodes
-                                        // also saving results, except for FFT Approximation where this is done on second part
-    for ( int eli = 0; eli < numelsave; eli++ ) {
+        mkl::TMklFft&       ffti            = stffti[ GetThreadId () ];
 
-        int         el      = elsave.GetValue ( eli );
 
-        if ( verbosey == Interactive && IsSTMethod ( analysis ) ) {
-            Gauge.Next ( gaugefreqloop );
-            CartoolObjects.CartoolApplication->SetMainTitle ( Gauge );
-            }
+        OmpFor
 
+        for ( int eli = 0; eli < numelsave; eli++ ) {
 
-        //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // transfer data + optional windowing
-        if ( goodblock ) {
+            int         el      = elsave.GetValue ( eli );
+            AComplex*   FA      = stspectra[ eli ];
 
+                                        // transfer data + optional windowing - S-Transform has no bad blocks
             if ( windowing == FreqWindowingHanning ) 
         
                 for ( int i = 0; i < blocksize; i++ )   X ( i ) = blockeeg ( el, i ) * windowingtable ( i );
 
             else
-    //          for ( int i = 0; i < blocksize; i++ )   X ( i ) = blockeeg ( el, i );
 
                 X.CopyMemoryFrom ( &blockeeg ( el, 0 ) );
-            }
-
-
-        //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-        if ( IsSTMethod ( analysis ) ) {
-
-                                        // real FFT only - will not touch anything past freqsize in the F vector, which will remain 0
-            fft ( X, F );
 
+                                        // real FFT only - will write the first freqsize values only
+            fft ( X, FA );
 
-            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Analytic signal (signal + i * Hilbert)
                                         // 1) double the frequencies - !but NOT for f=0 nor f=dim/2!
-            for ( int i = 1;        i < freqsize - 1; i++ )     F ( i ) *= 2;
-                                        // 2) then clear-up the negative frequencies
-//          for ( int i = freqsize; i < blocksize;    i++ )     F ( i )  = 0;   // !buffer was not touched by the real FFT, so it is still 0!
+            for ( int i = 1;        i < freqsize - 1; i++ )     FA[ i ] *= 2;
+                                        // 2) then clear-up the negative frequencies - they are simply not stored
+            } // for eli
 
+                                        // implicit barrier at the end of OmpFor - all spectra are now available
 
-            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // loop through the output bands
-            const TOneFrequencyBand*    fb          = freqbands.data ();
+        //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // electrodes-major order, so that consecutive tiles of a thread share the same spectrum
+                                        // dynamic scheduling, as tiles cost varies with the number of averaged frequencies
+        OmpForDynamic
 
-            for ( int fbi = 0, savedfi0 = 0; fbi < numfreqbands; fbi++, fb++ ) {
+        for ( int tilei = 0; tilei < numelsave * numsavedfreqs; tilei++ ) {
+
+            int                         eli         = tilei / numsavedfreqs;
+            int                         savedfi0    = tilei % numsavedfreqs;
+            const TOneFrequencyBand*    fb          = &freqbands[ stsavedband[ savedfi0 ] ];
+            int                         fi          = stsavedfreq[ savedfi0 ];
+            const AComplex*             FA          = stspectra[ eli ];
 
-                                        // process all the freqs within the current band
-                for ( int fi = fb->SaveFreqMin_i; fi <= fb->SaveFreqMax_i; fi += fb->SaveFreqStep_i, savedfi0++ ) {
+
+            if ( verbosey == Interactive && savedfi0 == 0 ) {
+                Gauge.Next ( gaugefreqloop );
+                CartoolObjects.CartoolApplication->SetMainTitle ( Gauge );
+                }
 
                                         // clear sum buffer
-                    SumST   = (AComplex) 0;
+            SumST   = (AComplex) 0;
 
 
-                    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-                    for ( int downf = 0, fi2 = fi; downf < fb->AvgNumFreqs; downf++, fi2 += fb->AvgFreqStep_i ) {
+            for ( int downf = 0, fi2 = fi; downf < fb->AvgNumFreqs; downf++, fi2 += fb->AvgFreqStep_i ) {
 
-                        if ( fi2 == 0 ) {   // 0 Hz - manually computing the mean of signal
+                if ( fi2 == 0 ) {   // 0 Hz - manually computing the mean of signal
 
-                            double      mean        = 0;
+                    double      mean        = 0;
                                         // we should have value of 0 in case of Hanning, but actually, we can still compute the average value
-//                          if ( windowing == FreqWindowingHanningBorder ) {
+//                  if ( windowing == FreqWindowingHanningBorder ) {
 
-                                for ( int i = 0; i < freqsize; i++ )    // data is 0 above freqsize
-                                    mean   +=  F[ i ].real ();
+                        for ( int i = 0; i < freqsize; i++ )    // data is 0 above freqsize
+                            mean   +=  FA[ i ].real ();
 
-                                mean   /= blocksize;
-//                              }
+                        mean   /= blocksize;
+//                      }
                                         // assigning single real value
-                            if      ( outputatomtype == OutputAtomComplex )     { SumST = (AComplex)          mean;    }    // we only have a real part
-                            if      ( outputatomtype == OutputAtomPhase   )     { SumST = (AComplex)          0;       }    // no imaginary -> phase is 0
-                            else if ( outputatomtype == OutputAtomNorm    )     { SumST = (AComplex) abs    ( mean );  }
-                            else if ( outputatomtype == OutputAtomNorm2   )     { SumST = (AComplex) Square ( mean );  }
-                            else if ( outputatomtype == OutputAtomReal    )     { SumST = (AComplex)          mean;    }    // case shouldn't happen - provide a default formula
-                            }
+                    if      ( outputatomtype == OutputAtomComplex )     { SumST = (AComplex)          mean;    }    // we only have a real part
+                    if      ( outputatomtype == OutputAtomPhase   )     { SumST = (AComplex)          0;       }    // no imaginary -> phase is 0
+                    else if ( outputatomtype == OutputAtomNorm    )     { SumST = (AComplex) abs    ( mean );  }
+                    else if ( outputatomtype == OutputAtomNorm2   )     { SumST = (AComplex) Square ( mean );  }
+                    else if ( outputatomtype == OutputAtomReal    )     { SumST = (AComplex)          mean;    }    // case shouldn't happen - provide a default formula
+                    }
 
-                        else {          // freqs > 0 [Hz]
+                else {          // freqs > 0 [Hz]
 
-                            if ( outputatomtype != OutputAtomPhase ) {
-                                        // pre-compute Gaussian for current frequency
-                                GaussianKernel ( 0 )    = 1.0;
+                                        // FG is only partially filled below, so clear it first
+                    FG.ResetMemory ();
 
-                                for ( int i = 1; i <= blocksize / 2; i++ )
-                                        // !Gaussian is centered on 0 / blocksize (not on mid-part)!
-                                    GaussianKernel ( i )             = 
-                                    GaussianKernel ( blocksize - i ) = expl ( -2.0 * Square ( Pi * i / (double) fi2 ) );
+                    if ( outputatomtype != OutputAtomPhase ) {
+                                        // pre-computed Gaussian for current frequency
+                        const TVector<AReal>&   kernel      = stkernels[ fi2 ];
 
                                         // 3) shift frequencies F to the "left", to be centered on current frequency fi2 (== multiplying by cosine of freq in time series)
                                         // 4) !Actual S-Transform part here, en plus of the Analytic signal: multiply by Gaussian to get smooth results!
-                                for ( int i = 0, k = fi2; i < blocksize; i++, k = ++k % blocksize )
+                                        // scanning only the non-null parts of the kernel, on both sides of 0 / blocksize, and of the analytic signal
+                        for ( int i = 0; i < kernel.GetDim (); i++ ) {
+
+                            int         kpos        = ( fi2 + i ) % blocksize;
+                            int         kneg        = ( fi2 - i + blocksize ) % blocksize;
 
-                                    FG ( i ) = F ( k ) * GaussianKernel ( i );
+                            if ( kpos < freqsize )              FG (             i )    = FA[ kpos ] * kernel ( i );
+                            if ( kneg < freqsize && i > 0 )     FG ( blocksize - i )    = FA[ kneg ] * kernel ( i );
+                            }
 
-                                } // Not Phase
-                            else { // Phase
+                        } // Not Phase
+                    else { // Phase
                                         // 3) !no weighted sum, i.e. No S-Transform, just Hilbert phase here!
                                         // reason is that we have "rotating" data, averaging them will not give a meaningful final angle
-                                for ( int i = 0, k = fi2; i < blocksize; i++, k = ++k % blocksize )
+                        for ( int i = 0, k = fi2; i < blocksize; i++, k = ( k + 1 ) % blocksize )
 
-                                    FG ( i ) = F ( k );
+                            if ( k < freqsize )
+                                FG ( i ) = FA[ k ];
 
-                                }
+                        }
 
 
-                            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // End of analytic signal:
                                         // 5) Invert FFT, using full inverse scaling
-                            ffti ( FG, ST );    // actually, we could use some in-place transform here, getting rid od FG
+                    ffti ( FG, ST );
 
 
-                            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // here clipping any bad epochs FROM the single data epoch
-                            if ( badepochs == SkippingBadEpochsList ) {
+                    if ( badepochs == SkippingBadEpochsList ) {
 
-                                for ( int mi = 0; mi < (int) rejectmarkers; mi++ ) {
+                        for ( int mi = 0; mi < (int) rejectmarkers; mi++ ) {
 
-                                    if ( rejectmarkers[ mi ]->IsOverlappingInterval ( fromtf, totf ) ) {
+                            if ( rejectmarkers[ mi ]->IsOverlappingInterval ( fromtf, totf ) ) {
 
-                                            // !markers could actually go beyond buffer!
-                                        int         mfrom       = Clip ( rejectmarkers[ mi ]->From, timemin, timemax ) - timemin;
-                                        int         mto         = Clip ( rejectmarkers[ mi ]->To,   timemin, timemax ) - timemin;
+                                    // !markers could actually go beyond buffer!
+                                int         mfrom       = Clip ( rejectmarkers[ mi ]->From, timemin, timemax ) - timemin;
+                                int         mto         = Clip ( rejectmarkers[ mi ]->To,   timemin, timemax ) - timemin;
 
-                                            // zero-ing results at markers intervals
-                                        for ( int i = mfrom; i <= mto; i++ )
-                                            ST ( i )  = (AComplex) 0;
-                                        }
-                                    } // for rejectmarkers
-                                } // if SkippingBadEpochsList
+                                    // zero-ing results at markers intervals
+                                for ( int i = mfrom; i <= mto; i++ )
+                                    ST ( i )  = (AComplex) 0;
+                                }
+                            } // for rejectmarkers
+                        } // if SkippingBadEpochsList
 
 
-                            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // apply windowing at the end, to get rid of lousy borders
                                         // this is also known as Cone Of Influence (COI)
-                            if ( windowing      == FreqWindowingHanningBorder 
-                              && outputatomtype != OutputAtomPhase ) {
+                    if ( windowing      == FreqWindowingHanningBorder 
+                      && outputatomtype != OutputAtomPhase ) {
                                         // the trick here is to have the width varying with the current frequency
                                         // also paying attention to avoid scaling twice the middle point of the lowest frequency
 
                                         // Formula that does a good job at cleaning the borders, using 2 (4/8) full cycles on each side (instead of 1)
                                         // It has to be reminded that with Hanning, weighting will be 50% at the middle of that window
-//                              constexpr double    numcyclesinhanning  = ( 2 * ( SqrtTwo * 6 / TwoPi ) ); // = 2.70 - from litterature
-                                constexpr double    numcyclesinhanning  = 2;
+//                      constexpr double    numcyclesinhanning  = ( 2 * ( SqrtTwo * 6 / TwoPi ) ); // = 2.70 - from litterature
+                        constexpr double    numcyclesinhanning  = 2;
 
-                                double      sthwd       = Clip ( blocksize / (double) fi2 * numcyclesinhanning, 0.0, blocksize / 2.0 );    
-                                int         sthwi       = Truncate ( sthwd );
+                        double      sthwd       = Clip ( blocksize / (double) fi2 * numcyclesinhanning, 0.0, blocksize / 2.0 );    
+                        int         sthwi       = Truncate ( sthwd );
 
                                         // weighting has a limited support (not applied on all data)
-                                for ( int i = 0; i < sthwi; i++ ){
+                        for ( int i = 0; i < sthwi; i++ ){
                                         // !using a floating point length, NOT an integer one, to avoid weird clipping artifacts!
                                         // we also use only the first half of the Hanning, the one going 0->1
-                                    double      h       = Hanning ( (double) i / sthwd / 2 );
+                            double      h       = Hanning ( (double) i / sthwd / 2 );
 
                                         // do 1 half Hanning 0->1 on the left, and the other half on the right 1->0
-                                    ST (                 i )   *= h;
-                                    ST ( blocksize - 1 - i )   *= h;
+                            ST (                 i )   *= h;
+                            ST ( blocksize - 1 - i )   *= h;
 
                                         // hard steps, useful for debugging / visualization
-//                                  h   = TruncateTo ( (double) i / sthwd, 1.0 / numcyclesinhanning );
-//                                  ST (                 i )    = h;
-//                                  ST ( blocksize - 1 - i )    = h;
-                                    }
-                                } // post-windowing
+//                          h   = TruncateTo ( (double) i / sthwd, 1.0 / numcyclesinhanning );
+//                          ST (                 i )    = h;
+//                          ST ( blocksize - 1 - i )    = h;
+                            }
+                        } // post-windowing
 
 
-                            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // ST is of complex type, some care should be taken for the averaging
                                         // converting to needed type
-                            for ( int i = 0; i < blocksize; i++ ) {
+                    for ( int i = 0; i < blocksize; i++ ) {
 
-                                if      ( outputatomtype == OutputAtomComplex )     { SumST ( i ) +=              ST ( i );         }
-                                else if ( outputatomtype == OutputAtomPhase   )     { SumST ( i ) += ArcTangent ( ST ( i ) );       }
-                                else if ( outputatomtype == OutputAtomNorm    )     { SumST ( i ) += abs        ( ST ( i ) );       }
-                                else if ( outputatomtype == OutputAtomNorm2   )     { SumST ( i ) += norm       ( ST ( i ) );       }
-                                else if ( outputatomtype == OutputAtomReal    )     { SumST ( i ) +=              ST ( i ).real (); } // saving ST ( i ) is the original data + filter; abs ( ST ( i ) ) is the envelope
-                                } // for i
+                        if      ( outputatomtype == OutputAtomComplex )     { SumST ( i ) +=              ST ( i );         }
+                        else if ( outputatomtype == OutputAtomPhase   )     { SumST ( i ) += ArcTangent ( ST ( i ) );       }
+                        else if ( outputatomtype == OutputAtomNorm    )     { SumST ( i ) += abs        ( ST ( i ) );       }
+                        else if ( outputatomtype == OutputAtomNorm2   )     { SumST ( i ) += norm       ( ST ( i ) );       }
+                        else if ( outputatomtype == OutputAtomReal    )     { SumST ( i ) +=              ST ( i ).real (); } // saving ST ( i ) is the original data + filter; abs ( ST ( i ) ) is the envelope
+                        } // for i
 
-                            } // freqs > 0 [Hz]
+                    } // freqs > 0 [Hz]
 
-                        } // for downfreq
+                } // for downfreq
 
-                    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // average of multiple frequencies
-                    SumST  /= fb->AvgNumFreqs;
+            SumST  /= fb->AvgNumFreqs;
 
 
-                    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // in case of downsampling, we don't fear any aliasing effect as a Gaussian has already been applied before
-                    for ( int i = 0, i0 = 0; i < blocksize; i += downsamplingfactor, i0++ ) // do all TFs
+            for ( int i = 0, i0 = 0; i < blocksize; i += downsamplingfactor, i0++ ) // do all TFs
 
-                        if      ( datatypeout == AtomTypeComplex )  {   results ( i0, eli, 2 * savedfi0     )   = SumST ( i ).real ();
-                                                                        results ( i0, eli, 2 * savedfi0 + 1 )   = SumST ( i ).imag ();     }
-                        else                                            results ( i0, eli,     savedfi0     )   = SumST ( i ).real ();
+                if      ( datatypeout == AtomTypeComplex )  {   results ( i0, eli, 2 * savedfi0     )   = SumST ( i ).real ();
+                                                                results ( i0, eli, 2 * savedfi0 + 1 )   = SumST ( i ).imag ();     }
+                else                                            results ( i0, eli,     savedfi0     )   = SumST ( i ).real ();
 
-                    } // for savefreqs
+            } // for tilei
 
-                } // for freqband
+        OmpParallelEnd
+
+        continue; // blocki0
+        } // if S-Transform
+
+
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Settinp up our variables
+    if ( IsFFTApproxMethod ( analysis ) )
+
+        fftappr.ResetMemory ();
+
+
+    OmpParallelBegin
+                                        // Allocating on each new block seems OK compared to the following computation load - Allocating outside the parallel loop complexifies the code, and gains are not assured
+
+    TVector<AReal>      X;              // current block of input, real data
+
+    TVector<AComplex>   F;              // frequency results, complex
+
+
+    if      ( IsFFTApproxMethod ( analysis ) ) {
+
+        X               .Resize ( fft.GetDirectDomainSize ()    );
+        F               .Resize ( fft.GetFrequencyDomainSize () );  // FFT optimization of real signal allows to allocate half data points
+        }
+    else { // all other FFT analysis
+
+        X               .Resize ( fft.GetDirectDomainSize ()    );
+        F               .Resize ( fft.GetFrequencyDomainSize () );  // FFT optimization of real signal allows to allocate half data points
+        }
+
+
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+    OmpFor
+                                        // process only the selected electrodes
+                                        // also saving results, except for FFT Approximation where this is done on second part
+    for ( int eli = 0; eli < numelsave; eli++ ) {
+
+        int         el      = elsave.GetValue ( eli );
+
+
+        //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // transfer data + optional windowing
+        if ( goodblock ) {
+
+            if ( windowing == FreqWindowingHanning ) 
+        
+                for ( int i = 0; i < blocksize; i++ )   X ( i ) = blockeeg ( el, i ) * windowingtable ( i );
+
+            else
+    //          for ( int i = 0; i < blocksize; i++ )   X ( i ) = blockeeg ( el, i );
+
+                X.CopyMemoryFrom ( &blockeeg ( el, 0 ) );
+            }
 
-            } // if S-Transform
 
         //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Note: FFT Approximation and bands can somehow produce some weird results (summing discontinuities)
                                         // so bands and sub-bands averaging should be avoided
-        else if ( IsFFTApproxMethod ( analysis ) ) {
+        if ( IsFFTApproxMethod ( analysis ) ) {
 
             if ( ! goodblock )
                 continue; // eli
@@ -2076,6 +2184,11 @@ for ( int blocki0 = 0, firsttf = timemin; blocki0 < numblocks; blocki0++, firstt
 
     } // for blocki0
 
+                                        // all blocks have been read by now, just cleaning up the reading thread
+blocksreader.Stop ();
+
+eegdoc->SetFiltersStreaming ( oldfiltersstreaming );
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 if ( verbosey == Interactive ) {
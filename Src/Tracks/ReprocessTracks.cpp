@@ -22,6 +22,7 @@ limitations under the License.
 #include    "Dialogs.Input.h"
 #include    "Dialogs.TSuperGauge.h"
 #include    "TExportTracks.h"
+#include    "TTracksBlocksPipeline.h"
 
 #include    "TTracksFilters.h"
 
@@ -857,14 +858,16 @@ if ( downsample )
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Buffers allocation
 
-if ( baselinecorr )                     // also check for baseline length!
-    Maxed ( maxtimechunk, baselinecorrnum );
-
                                         // output # of tracks - elsel already accounted for numaddedels
 int                 outnumtracks    = tracksoptions == ProcessRois ? ROIs->GetNumRois () : (int) elsel;
 
-                                        // allocate a max chunk buffer
-TTracks<float>      eegb        ( numtotalels, maxtimechunk );
+                                        // time chunks buffers are allocated by the reading / writing pipelines below
+                                        // input chunks also hold the margins of the temporal filters
+long                maxtimechunkin  = maxtimechunk + ( filters.HasAnyFilter () && filters.HasTemporalFilter () ? 2 * AtLeast ( 1, filters.GetSafeMargin () ) : 0 );
+                                        // number of buffers for each pipeline: double-buffering if all the in-flight input and output chunks fit in memory
+int                 numchunkbuffers = TracksBlocksPipelineNumBuffers ( ( (double) numtotalels * maxtimechunkin + (double) outnumtracks * maxtimechunk ) * sizeof ( float ) );
+                                        // time chunks could be as big as the whole file - otherwise a single input chunk, and output is written directly, like without pipelines
+bool                writebehind     = numchunkbuffers > 1;
                                         // some more optional buffers
 TVector<double>     eegbavg     ( sequenceoptions == AverageProcessing ? numels : 0 );
 
@@ -889,10 +892,12 @@ if ( ! silent ) {
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Simplified version of TTracksDoc::GetTracks
                                         // It allows for EEG buffer to have MORE TRACKS than the original input EEG, allowing us to include any added null channels in the processing
+                                        // It is also called from the reading thread, so it only works on the given buffer
+                                        // Optional stream carries the temporal filters states across contiguous chunks, so only the right margin is needed, and each TF is read once
 auto    GetTracks   =   [   &EEGDoc, 
-                            &eegb,          &numels,    &numtimeframes,
+                                            &numels,    &numtimeframes,
                             &filters,       &ref,       &refsel,        &validsel,      &auxsel
-                        ] ( long tf1, long tf2, long numtf, int tfoffset )
+                        ] ( TTracks<float>& eegb, long tf1, long tf2, long numtf, int tfoffset, TTracksFiltersStream<float>* stream )
 {
                                         // atom type, reference and filters have been resolved and set
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -901,48 +906,110 @@ bool                doanyfilter         = filters.HasAnyFilter ();
 bool                dotemporalfilters   = doanyfilter && filters.HasTemporalFilter ();
 bool                dofilterauxs        = doanyfilter && CheckToBool ( filters.FiltersParam.FilterAuxs );
 
+int                 filtersmargin       = dotemporalfilters ? AtLeast ( 1, filters.GetSafeMargin () ) : 0;    // !make sure it has at least 1 TF so we don't need BuffDiss!
+const TSelection*   filtersauxtracks    = dofilterauxs ? 0 : &auxsel;
+
+bool                dostream            = dotemporalfilters && stream && stream->IsActive () && filters.CanStream ();
+bool                docontinuestream    = dostream && stream->CanContinue ( filters, tf1, numels, filtersmargin );
+long                streamtf2           = tf2;
+
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 TTracksFiltersLimits<float>  timelimits;
 
-if ( dotemporalfilters )
+if ( dotemporalfilters && ! docontinuestream )
                                         // Adjust the time parameters and set the time margins for temporal filtering
     timelimits.UpdateTimeRange  (   tf1,        tf2,        numtf,      tfoffset,   // !update values with new limits!
-                                    AtLeast ( 1, filters.GetSafeMargin () ),        // !make sure it has at least 1 TF so we don't need BuffDiss!
+                                    filtersmargin,
                                     numtimeframes
                                 );
 
                                         // Adjust buffer to either original or expanded limits
                                         // Note that the previous content could be lost, though this usually is not a problem, as for filtered data, the buffer is usually evaluated as a whole
 eegb.Resize (             eegb.GetDim1 (),
-                AtLeast ( eegb.GetDim2 (), (int) numtf )  );
+                AtLeast ( eegb.GetDim2 (), (int) ( tfoffset + numtf + ( docontinuestream ? filtersmargin : 0 ) ) )  );
 
                                         // making sure any added channels will be 0
 eegb.ResetMemory ();
 
 
-EEGDoc->ReadRawTracks ( tf1, tf2, eegb, tfoffset );
+if ( docontinuestream ) {
+                                        // start from the raw look-ahead of the previous chunk
+    int                 numlookahead    = stream->RestoreLookAhead ( eegb, numels, tfoffset );
+    long                lasttf          = min ( tf2 + filtersmargin, numtimeframes - 1 );
+
+    if ( tf1 + numlookahead <= lasttf ) {
+                                        // views could be reading the same document concurrently
+        std::lock_guard<std::recursive_mutex>   readinglock ( EEGDoc->GetReadingLock () );
+
+        EEGDoc->ReadRawTracks ( tf1 + numlookahead, lasttf, eegb, tfoffset + numlookahead );
+        }
+    }
+else {                                  // views could be reading the same document concurrently
+    std::lock_guard<std::recursive_mutex>   readinglock ( EEGDoc->GetReadingLock () );
+
+    EEGDoc->ReadRawTracks ( tf1, tf2, eegb, tfoffset );
+    }
 
 
 if ( doanyfilter
   || IsEffectiveReference ( ref ) ) {   // !filters semantic do not include the reference for the moment!
 
 
-    if ( dotemporalfilters )
+    if ( docontinuestream ) {
+                                        // temporal filters from the previous states, then all the remaining filters on the chunk only
+        stream->Continue        (   filters,
+                                    eegb,       numels,
+                                    tf1,        tf2,        tfoffset,
+                                    numtimeframes,
+                                    filtersauxtracks
+                                );
+
+        filters.ApplyFilters    (   eegb,       numels,  
+                                    numtf,      tfoffset,
+                                    ref,        &refsel,    &validsel,  filtersauxtracks,
+                                    FilterNonTemporal
+                                );
+        }
+
+    else if ( dostream ) {
 
         timelimits.MirrorData       (   eegb,   numels,
                                         numtf,  tfoffset    );
 
+                                        // same as below, but the temporal filters also keep their states at the end of the requested chunk
+        stream->Start           (   filters,
+                                    eegb,       numels,
+                                    numtf,      filtersmargin,
+                                    streamtf2 + 1,  (int) ( tf2 - streamtf2 ),  // tf2 has been updated to the end of the right margin, minus any mirroring
+                                    filtersauxtracks
+                                );
+
+        filters.ApplyFilters    (   eegb,       numels,  
+                                    numtf,      tfoffset,
+                                    ref,        &refsel,    &validsel,  filtersauxtracks,
+                                    FilterNonTemporal
+                                );
+        }
+
+    else {
+
+        if ( dotemporalfilters )
+
+            timelimits.MirrorData       (   eegb,   numels,
+                                            numtf,  tfoffset    );
+
                                             // do ALL filters at once, including reference, with the correct sequence
-    filters.ApplyFilters    (   eegb,       numels,  
-                                numtf,      tfoffset,
-                                ref,        &refsel,    &validsel,  dofilterauxs ? 0 : &auxsel,
-                                doanyfilter ? AllFilters : NoFilter
-                            );
+        filters.ApplyFilters    (   eegb,       numels,  
+                                    numtf,      tfoffset,
+                                    ref,        &refsel,    &validsel,  filtersauxtracks,
+                                    doanyfilter ? AllFilters : NoFilter
+                                );
+        }
 
 
-    if ( dotemporalfilters )
+    if ( dotemporalfilters && ! docontinuestream )
 
         timelimits.RestoreTimeRange (   eegb,       numels,  
                                         tf1,        tf2,        numtf,      tfoffset,       // !restore original time limits!
@@ -951,20 +1018,31 @@ if ( doanyfilter
     } // filter or reference
 };
 
+                                        // Reading a whole time chunk - called from the reading thread
+                                        // Chunks are read in sequence, so the temporal filters can be streamed across the contiguous ones
+TTracksFiltersStream<float> chunksstream;
+
+auto    ReadChunk   =   [ &GetTracks, &timechunks, &chunksstream ] ( int chunki, TTracks<float>& eegb )
+{
+GetTracks   ( eegb, timechunks[ chunki ]->From, timechunks[ chunki ]->To, timechunks[ chunki ]->Length (), 0, &chunksstream );
+};
+
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Compute baseline correction values - this is not part of our time chunks
 TVector<float>      baseline ( baselinecorr ? numels : 0 );
 
 if ( baselinecorr ) {
-                                        // get the baseline chunk only
-    GetTracks   ( baselinecorrpre, baselinecorrpost, baselinecorrnum, 0 );
+                                        // get the baseline chunk only - released before the chunks pipelines start
+    TTracks<float>      eegbbaseline ( numtotalels, baselinecorrnum );
+
+    GetTracks   ( eegbbaseline, baselinecorrpre, baselinecorrpost, baselinecorrnum, 0, 0 );
 
 
     for ( int  e   = 0; e   < numels;          e++   )
     for ( long tfi = 0; tfi < baselinecorrnum; tfi++ )
 
-        baseline[ e ]  += eegb ( e , tfi );
+        baseline[ e ]  += eegbbaseline ( e , tfi );
 
     baseline   /= baselinecorrnum;
     }
@@ -982,12 +1060,18 @@ if ( rescalingoptions == GfpRescaling
 
     TMap            map ( numels );
 
+    TTracksBlocksReader<TTracks<float>> chunksreader;
+
+    chunksstream.SetActive ( true );    // new pass, new stream
+
+    chunksreader.Start ( timechunks.GetNumMarkers (), numtotalels, maxtimechunkin, ReadChunk, numchunkbuffers );
+
                                         // have to loop through all our valid time chunks
     for ( int i = 0; i < timechunks.GetNumMarkers (); i++ ) {
                                         // read chunk
         long            numtf           = timechunks[ i ]->Length ();
 
-        GetTracks   ( timechunks[ i ]->From, timechunks[ i ]->To, numtf, 0 );
+        TTracks<float>& eegb            = chunksreader.Next ();
 
 
         for ( long tfi = 0; tfi < numtf; tfi++ ) {
@@ -1109,6 +1193,30 @@ if ( concatenateoptions == ConcatenateTime && IsBatchFirstCall )
     expfile.Begin ( true );             // write some dummy header, now
 
 
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Reading, processing and writing are overlapped:
+                                        // next chunk is read in the background, while the current one is processed, and the previous one is written to file
+TTracksBlocksReader<TTracks<float>> chunksreader;
+
+chunksstream.SetActive ( true );        // new pass, new stream
+
+chunksreader.Start ( timechunks.GetNumMarkers (), numtotalels, maxtimechunkin, ReadChunk, numchunkbuffers );
+
+                                        // Called from the writing thread - expfile is not used by anyone else until the writer is stopped
+auto    WriteChunk  =   [ &expfile ] ( const TArray2<float>& eegbout, long numtf )
+{
+for ( long tfi = 0; tfi < numtf;                 tfi++ )
+for ( int  e   = 0; e   < eegbout.GetDim1 (); e++   )
+
+    expfile.Write ( eegbout ( e , tfi ) );
+};
+
+TTracksBlocksWriter<TArray2<float>> chunkswriter;
+
+if ( writebehind )
+    chunkswriter.Start ( outnumtracks, maxtimechunk, WriteChunk, numchunkbuffers );
+
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // loop through all our valid time chunks
 
@@ -1120,7 +1228,7 @@ for ( int i = 0; i < timechunks.GetNumMarkers (); i++ ) {
                                         // read chunk, store to relative origin TF 0
     long            numtf           = timechunks[ i ]->Length ();
 
-    GetTracks   ( timechunks[ i ]->From, timechunks[ i ]->To, numtf, 0 );
+    TTracks<float>& eegb            = chunksreader.Next ();
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1265,30 +1373,46 @@ for ( int i = 0; i < timechunks.GetNumMarkers (); i++ ) {
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Output loop
+                                        // Output loop - with write-behind, only copying the output tracks, the actual writing is done in the background
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
+    TArray2<float>*     eegbout     = writebehind ? &chunkswriter.GetBuffer () : 0;
+
+
     for ( long tfi = 0; tfi < numtf; tfi++ ) {
 
         Gauge.Next ( 0, SuperGaugeUpdateTitle );
 
 
-        if ( tracksoptions == ProcessTracks )
+        if ( tracksoptions == ProcessTracks ) {
                                         // this can include the optional null tracks, which are not computed, hence 0's
-            for ( TIteratorSelectedForward seli ( elsel ); (bool) seli; ++seli )
+            int     e       = 0;
+
+            for ( TIteratorSelectedForward seli ( elsel ); (bool) seli; ++seli, e++ )
 
-                expfile.Write ( eegb ( seli(), tfi ) );
+                if ( eegbout )  (*eegbout) ( e , tfi )  = eegb ( seli(), tfi );
+                else            expfile.Write ( eegb ( seli(), tfi ) );
+            }
 
         else // tracksoptions == ProcessRois
                                         // !NOT tested for optional null tracks!
             for ( int e = 0; e < outnumtracks; e++ )
 
-                expfile.Write ( eegbrois ( e , tfi ) );
+                if ( eegbout )  (*eegbout) ( e , tfi )  = eegbrois ( e , tfi );
+                else            expfile.Write ( eegbrois ( e , tfi ) );
 
         }
 
+
+    if ( writebehind )
+        chunkswriter.Push ( numtf );
+
     } // for timechunks
 
+                                        // wait for all the chunks to be written
+chunkswriter.Stop ();
+chunksreader.Stop ();
+
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // verbose file filling, one per new file, or only one in case of concatenation
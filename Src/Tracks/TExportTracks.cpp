@@ -62,6 +62,9 @@ const ExportTracksTypeSpec  ExportTracksTypes[ NumExportTracksType ] =
         TExportTracks::TExportTracks ()
 {
 of                  = 0;
+Staging             = 0;
+StagingSize         = 0;
+StagingUsed         = 0;
 
 Reset ();
 }
@@ -110,6 +113,8 @@ ClearString ( FreqTypeName, MaxCharFreqType );
 BlockFrequency      = 0;
 FrequencyNames.Reset ();
 
+WriteBehind         = true;
+
 
 CurrentPositionTrack= 0;
 CurrentPositionTime = 0;
@@ -124,6 +129,10 @@ EndOfHeader         = 0;
       : TDataFormat ( op )
 {
 of                  = op.of;            // or 0?
+                                        // staging is not shared
+Staging             = 0;
+StagingSize         = 0;
+StagingUsed         = 0;
 
 Filename            = op.Filename;
 Type                = op.Type;
@@ -154,6 +163,8 @@ StringCopy ( FreqTypeName, op.FreqTypeName, MaxCharFreqType - 1 );
 BlockFrequency      = op.BlockFrequency;
 FrequencyNames      = op.FrequencyNames;
 
+WriteBehind         = op.WriteBehind;
+
 CurrentPositionTrack= op.CurrentPositionTrack;
 CurrentPositionTime = op.CurrentPositionTime;
 DoneBegin           = op.DoneBegin;
@@ -201,6 +212,8 @@ StringCopy ( FreqTypeName, op2.FreqTypeName, MaxCharFreqType - 1 );
 BlockFrequency      = op2.BlockFrequency;
 FrequencyNames      = op2.FrequencyNames;
 
+WriteBehind         = op2.WriteBehind;
+
 CurrentPositionTrack= op2.CurrentPositionTrack;
 CurrentPositionTime = op2.CurrentPositionTime;
 DoneBegin           = op2.DoneBegin;
@@ -318,18 +331,7 @@ if ( IsFileTextual () )
 of->seekp ( EndOfHeader, ios::beg );
 
                                         // compute the correct size to be filled after the header
-size_t              sizetoreset;
-
-if      ( Type == ExportTracksRis   )   sizetoreset     = NumTracks * NumTime * ( IsVector ( AtomTypeUseOriginal ) ? 3 : 1 ) * sizeof ( float );
-else if ( Type == ExportTracksSef   )   sizetoreset     = NumTracks * NumTime * sizeof ( float );
-else if ( Type == ExportTracksBv    )   sizetoreset     = NumTracks * NumTime * sizeof ( float );   // BVTypeFloat32
-                                    //  sizetoreset     = NumTracks * NumTime * sizeof ( short );   // OK only for equal sampling frequencies across channels
-else if ( Type == ExportTracksEdf   )   sizetoreset     = ( ( NumTime + EdfTrailingTF ) / EdfTfPerRec ) * EdfBlockSize;
-else if ( Type == ExportTracksFreq  )   sizetoreset     = NumTracks * NumTime * NumFrequencies * ( IsComplex ( AtomTypeUseOriginal ) ? sizeof ( complex<float> ) : sizeof ( float ) );
-else                                    sizetoreset     = 0;
-
-
-AllocateFileSpace   ( of, sizetoreset, FILE_CURRENT );
+AllocateFileSpace   ( of, GetDataSize (), FILE_CURRENT );
 
 
 //of->flush ();
@@ -338,6 +340,153 @@ of->seekp ( EndOfHeader, ios::beg );
 }
 
 
+//----------------------------------------------------------------------------
+                                        // Size of the binary data following the header
+size_t  TExportTracks::GetDataSize ()   const
+{
+if      ( Type == ExportTracksRis   )   return  (size_t) NumTracks * NumTime * ( IsVector ( AtomTypeUseOriginal ) ? 3 : 1 ) * sizeof ( float );
+else if ( Type == ExportTracksSef   )   return  (size_t) NumTracks * NumTime * sizeof ( float );
+else if ( Type == ExportTracksBv    )   return  (size_t) NumTracks * NumTime * sizeof ( float );   // BVTypeFloat32
+                                    //  return  (size_t) NumTracks * NumTime * sizeof ( short );   // OK only for equal sampling frequencies across channels
+else if ( Type == ExportTracksEdf   )   return  (size_t) ( ( NumTime + EdfTrailingTF ) / EdfTfPerRec ) * EdfBlockSize;
+else if ( Type == ExportTracksFreq  )   return  (size_t) NumTracks * NumTime * NumFrequencies * ( IsComplex ( AtomTypeUseOriginal ) ? sizeof ( complex<float> ) : sizeof ( float ) );
+else                                    return  0;
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Binary output is not sent value by value to the stream, but converted into a staging chunk
+                                        // Chunks are written at once, either right away, or from a background thread for big outputs
+                                        // Positional writes going to consecutive positions are merged into the same chunk, so they end up as a single sequential write
+void    TExportTracks::StartStaging ()
+{
+StopStaging ();
+
+if ( ! IsFileBinary () )
+    return;
+
+
+size_t              datasize        = GetDataSize ();
+                                        // unknown size (dummy header) will use the biggest chunks
+StagingSize     = datasize == 0 ? ExportTracksStagingMaxSize : Clip ( datasize, ExportTracksStagingMinSize, ExportTracksStagingMaxSize );
+StagingUsed     = 0;
+
+
+if ( WriteBehind && datasize >= ExportTracksWriteBehindSize ) {
+
+    StagingWriter.Start ( 1, (int) StagingSize, [ this ] ( const TExportTracksStaging& staging, long size ) { WriteStaging ( staging, size ); } );
+
+    Staging     = &StagingWriter.GetBuffer ();
+    }
+else {
+    LocalStaging.Resize ( 1, (int) StagingSize );
+
+    Staging     = &LocalStaging;
+    }
+}
+
+
+void    TExportTracks::StopStaging ()
+{
+SyncStaging ();
+
+StagingWriter.Stop ();
+
+LocalStaging.Data.DeallocateMemory ();
+
+Staging         = 0;
+StagingUsed     = 0;
+}
+
+
+//----------------------------------------------------------------------------
+void    TExportTracks::WriteStaging ( const TExportTracksStaging& staging, long size )
+{
+if ( staging.Origin >= 0 )
+    of->seekp ( staging.Origin, ios::beg );
+
+of->write ( staging.Data.GetArray (), size );
+}
+
+
+void    TExportTracks::FlushStaging ()
+{
+if ( Staging == 0 || StagingUsed == 0 )
+    return;
+
+
+if ( StagingWriter.IsRunning () ) {
+
+    StagingWriter.Push ( (long) StagingUsed );
+                                        // waits for a free chunk
+    Staging     = &StagingWriter.GetBuffer ();
+    }
+else
+    WriteStaging ( *Staging, (long) StagingUsed );
+
+
+StagingUsed     = 0;
+}
+
+
+void    TExportTracks::SyncStaging ()
+{
+FlushStaging ();
+
+if ( StagingWriter.IsRunning () )
+    StagingWriter.Flush ();
+}
+
+
+//----------------------------------------------------------------------------
+char*   TExportTracks::StageReserve ( LONGLONG pos, size_t size )
+{
+if ( Staging == 0 || size > StagingSize )
+    return  0;
+
+                                        // sequential writes only follow a sequential chunk, positional writes only follow a positional chunk, right at its end
+bool                contiguous      = pos < 0 ? Staging->Origin < 0
+                                              : Staging->Origin >= 0 && pos == Staging->Origin + (LONGLONG) StagingUsed;
+
+                                        // flush if not going right after the current chunk, or if not enough room
+if ( StagingUsed > 0
+  && ( ! contiguous
+    || StagingUsed + size > StagingSize ) )
+
+    FlushStaging ();
+
+
+if ( StagingUsed == 0 )
+    Staging->Origin     = pos;
+
+
+char*               tos             = Staging->Data.GetArray () + StagingUsed;
+
+StagingUsed    += size;
+
+return  tos;
+}
+
+
+void    TExportTracks::Stage ( LONGLONG pos, const void* data, size_t size )
+{
+char*               tos             = StageReserve ( pos, size );
+
+if ( tos ) {
+    CopyVirtualMemory ( tos, data, size );
+    return;
+    }
+
+                                        // big write goes straight to the stream
+SyncStaging ();
+
+if ( pos >= 0 )
+    of->seekp ( pos, ios::beg );
+
+of->write ( (const char*) data, size );
+}
+
+
 //----------------------------------------------------------------------------
                                         // Compute the correct position for EDF files
 LONGLONG    TExportTracks::EDFseekp ( long tf, long e )
@@ -353,34 +502,45 @@ void    TExportTracks::End ()
 {
                                         // Some last-minute processing needed for EDF: trailing space, triggers
 if ( IsOpen () && Type == ExportTracksEdf ) {
-                                        // 1) pad the last block with 0
-    if ( EdfTrailingTF ) {
+                                        // 0, after conversion
+    EdfValue    = (short) ( EdfDigitalMin - EdfPhysicalMin * EdfRatio );
 
-        TIteratorSelectedForward    seli ( SelTracks );
+                                        // 1) last record might still be pending in memory: completing it with 0 and writing it
+    long            tfinrec         = CurrentPositionTime % EdfTfPerRec;
+    long            endtf           = CurrentPositionTime;
 
-        for ( int i = SelTracks.IsNotAllocated () ? 0 : seli(), j = 0; i >= 0 && ( SelTracks.IsAllocated () || i < NumTracks ); i = SelTracks.IsNotAllocated () ? i + 1 : ++seli, j++ ) {
+    if ( EdfRecord.IsAllocated () && ( tfinrec > 0 || CurrentPositionTrack > 0 ) ) {
+                                        // a partially written time frame is also completed
+        for ( int  e   = 0; e < NumTracks; e++ )
+        for ( long tf0 = tfinrec + ( e < CurrentPositionTrack ? 1 : 0 ); tf0 < EdfTfPerRec; tf0++ )
+            EdfRecord[ e * EdfTfPerRec + tf0 ]          = EdfValue;
+                                        // resetting trigger line
+        for ( long tf0 = tfinrec; tf0 < EdfTfPerRec; tf0++ )
+            EdfRecord[ NumTracks * EdfTfPerRec + tf0 ]  = 0;
 
-            for ( long tfi = NumTime; tfi < NumTime + EdfTrailingTF; tfi++ ) {
-                                        // 0, after conversion
-                EdfValue    = (short) ( EdfDigitalMin - EdfPhysicalMin * EdfRatio );
+        Stage ( EDFseekp ( CurrentPositionTime - tfinrec, 0 ), EdfRecord.GetArray (), EdfRecord.MemorySize () );
 
-                of->seekp ( EDFseekp ( tfi, j ) );
+        endtf   = CurrentPositionTime - tfinrec + EdfTfPerRec;
+        }
 
-                of->write ( (char *) &EdfValue, sizeof ( EdfValue ) );
-                }
-            }
-                                        // and again the status
-        for ( long tfi = NumTime; tfi < NumTime + EdfTrailingTF; tfi++ ) {
-                                        // resetting trigger line
-            EdfValue    = (short) 0;
+                                        // 2) then any remaining whole records, all filled with 0
+    if ( EdfRecord.IsAllocated () && endtf < NumTime + EdfTrailingTF ) {
 
-            of->seekp ( EDFseekp ( tfi, NumTracks ) );
+        for ( int  e   = 0; e < NumTracks;   e++   )
+        for ( long tf0 = 0; tf0 < EdfTfPerRec; tf0++ )
+            EdfRecord[ e * EdfTfPerRec + tf0 ]          = EdfValue;
 
-            of->write ( (char *) &EdfValue, sizeof ( EdfValue ) );
-            }
-        } // EdfTrailingTF
+        for ( long tf0 = 0; tf0 < EdfTfPerRec; tf0++ )
+            EdfRecord[ NumTracks * EdfTfPerRec + tf0 ]  = 0;
+
+        for ( long tfi = endtf; tfi < NumTime + EdfTrailingTF; tfi += EdfTfPerRec )
+
+            Stage ( EDFseekp ( tfi, 0 ), EdfRecord.GetArray (), EdfRecord.MemorySize () );
+        }
 
-                                        // 2) write the triggers
+                                        // triggers are written straight to the stream
+    StopStaging ();
+                                        // 3) write the triggers
     WriteTriggers ();
     } // if EDF
 
@@ -389,6 +549,8 @@ if ( IsOpen () && Type == ExportTracksEdf ) {
 
 CloseStream ();
 
+EdfRecord.DeallocateMemory ();
+
 DoneBegin           = false;
 }
 
@@ -411,6 +573,17 @@ ios::openmode       mode        = (ios::openmode )  (                       ios:
                                         // massage that file name - avoiding update, though
 TFileName           filename ( Filename, (TFilenameFlags) ( TFilenameExtendedPath | TFilenameSibling /*| TFilenameNoOverwrite*/ ) );
 
+                                        // an opened document could still map this very file, which Windows will refuse to overwrite
+OmpCriticalBegin (TExportTracksOpenStream)
+
+TTracksDoc*         mappeddoc   = CartoolObjects.CartoolDocManager ? dynamic_cast<TTracksDoc*> ( CartoolObjects.CartoolDocManager->IsOpen ( filename ) ) : 0;
+
+if ( mappeddoc )
+    mappeddoc->ReleaseFileMapping ();
+
+OmpCriticalEnd
+
+
 of          = new ofstream ( filename, mode );
 
 bool                isok        = of->good ();
@@ -430,6 +603,8 @@ if ( of == 0 )
     return;
 
 
+StopStaging ();
+
 of->close ();
 delete  of;
 of  = 0;
@@ -546,6 +721,13 @@ DoneBegin               = true;
 if ( ! dummyheader )                    // a dummy header means unknown size, so pre-allocation is not feasable
 
     PreFillFile ();
+
+
+if ( Type == ExportTracksEdf )
+    EdfRecord.Resize ( EdfBlockSize / sizeof ( short ) );
+
+
+StartStaging ();
 }
 
 
@@ -600,6 +782,9 @@ if ( Markers.IsEmpty ()
 
     return;
 
+                                        // triggers go straight to the stream
+SyncStaging ();
+
                                         // By safety, we don't want identical or unsorted triggers / markers
 Markers.SortAndCleanMarkers ();
 
@@ -841,6 +1026,7 @@ void    TExportTracks::WriteHeader ( bool overwrite )
 {
 char            buff[ KiloByte ];
 
+SyncStaging ();
                                         // go back to beginning, if needed
 of->seekp ( 0, ios::beg );
 
@@ -1446,7 +1632,7 @@ if      ( Type == ExportTracksEp
 else if ( Type == ExportTracksSef
        || Type == ExportTracksBv  ) {
 
-    of->write ( (char *) &value, sizeof ( float ) );
+    Stage ( -1, &value, sizeof ( float ) );
 
 
     CurrentPositionTrack = ++CurrentPositionTrack % NumTracks;
@@ -1457,13 +1643,12 @@ else if ( Type == ExportTracksSef
 
 else if ( Type == ExportTracksRis ) {
 
-    of->write ( (char *) &value, sizeof ( float ) );
-
     if ( IsVector ( AtomTypeUseOriginal ) ) {   // ouput vectorial, input scalar: complement with null Y / Z component
-        value   = 0;
-        of->write ( (char *) &value, sizeof ( float ) );
-        of->write ( (char *) &value, sizeof ( float ) );
+        float       vector[ 3 ]     = { value, 0, 0 };
+        Stage ( -1, vector, sizeof ( vector ) );
         }
+    else
+        Stage ( -1, &value, sizeof ( float ) );
 
 
     CurrentPositionTrack = ++CurrentPositionTrack % NumTracks;
@@ -1478,18 +1663,19 @@ else if ( Type == ExportTracksEdf ) {
                                         // do a nice rounding + final safety clipping
     EdfValue    = (short) Clip ( Round ( value ), SHRT_MIN, SHRT_MAX );
 
-    of->seekp ( EDFseekp ( CurrentPositionTime, CurrentPositionTrack ) );
+                                        // values are scattered within a record, which is assembled in memory then written at once
+    long        tfinrec     = CurrentPositionTime % EdfTfPerRec;
 
-    of->write ( (char *) &EdfValue, sizeof ( EdfValue ) );
+    EdfRecord[ CurrentPositionTrack * EdfTfPerRec + tfinrec ]   = EdfValue;
 
                                         // handle only once the status line
     if ( CurrentPositionTrack == NumTracks - 1 ) {
                                         // reset trigger line to 0
-        EdfValue    = (short) 0;
+        EdfRecord[ NumTracks * EdfTfPerRec + tfinrec ]          = 0;
 
-        of->seekp ( EDFseekp ( CurrentPositionTime, NumTracks ) );
-
-        of->write ( (char *) &EdfValue, sizeof ( EdfValue ) );
+                                        // record complete?
+        if ( tfinrec == EdfTfPerRec - 1 )
+            Stage ( EDFseekp ( CurrentPositionTime - tfinrec, 0 ), EdfRecord.GetArray (), EdfRecord.MemorySize () );
         }
 
 
@@ -1597,21 +1783,19 @@ else if ( Type == ExportTracksSef
        || Type == ExportTracksRis ) {
 
 
-    int     atomsize    = IsVector ( AtomTypeUseOriginal ) ? 3 * sizeof ( float ) : sizeof ( float );
-
-    of->seekp ( EndOfHeader + ( t * NumTracks + e ) * atomsize, ios::beg );
+    int         atomsize    = IsVector ( AtomTypeUseOriginal ) ? 3 * sizeof ( float ) : sizeof ( float );
+                                        // consecutive positions will be merged into a single write
+    LONGLONG    pos         = EndOfHeader + ( (LONGLONG) t * NumTracks + e ) * atomsize;
 
 
     if ( IsScalar ( AtomTypeUseOriginal ) )
 
-        of->write ( (char *) &value, sizeof ( float ) );
+        Stage ( pos, &value, sizeof ( float ) );
 
     else if ( IsVector ( AtomTypeUseOriginal ) ) {  // ouput vectorial, input scalar: complement with null Y / Z component
 
-        of->write ( (char *) &value, sizeof ( float ) );
-        value   = 0;
-        of->write ( (char *) &value, sizeof ( float ) );
-        of->write ( (char *) &value, sizeof ( float ) );
+        float       vector[ 3 ]     = { value, 0, 0 };
+        Stage ( pos, vector, sizeof ( vector ) );
         }
 
     }
@@ -1641,20 +1825,17 @@ if ( ! ( IsInsideLimits ( t, (long) 0, NumTime   - 1      )
 
 if      ( Type == ExportTracksFreq ) {
 
-    int     atomsize    = IsComplex ( AtomTypeUseOriginal ) ? sizeof ( complex<float> ) : sizeof ( float );
-
-    of->seekp ( EndOfHeader + ( ( t * NumTracks + e ) * NumFrequencies + f ) * atomsize, ios::beg );
+    int         atomsize    = IsComplex ( AtomTypeUseOriginal ) ? sizeof ( complex<float> ) : sizeof ( float );
+                                        // consecutive positions will be merged into a single write
+    LONGLONG    pos         = EndOfHeader + ( ( (LONGLONG) t * NumTracks + e ) * NumFrequencies + f ) * atomsize;
 
 
     if ( IsScalar ( AtomTypeUseOriginal ) )
 
-        of->write ( (char *) &value, sizeof ( float ) );
-    else {                              // convert to complex
-                                        // write real part
-        of->write ( (char *) &value, sizeof ( float ) );
-                                        // force imaginary to 0
-        value   = 0;
-        of->write ( (char *) &value, sizeof ( float ) );
+        Stage ( pos, &value, sizeof ( float ) );
+    else {                              // convert to complex, forcing imaginary part to 0
+        float       comp[ 2 ]       = { value, 0 };
+        Stage ( pos, comp, sizeof ( comp ) );
         }
 
     }
@@ -1688,19 +1869,19 @@ if ( ! ( IsInsideLimits ( t, (long) 0, NumTime   - 1      )
 
 if      ( Type == ExportTracksFreq ) {
 
-    int     atomsize    = IsComplex ( AtomTypeUseOriginal ) ? sizeof ( complex<float> ) : sizeof ( float );
-
-    of->seekp ( EndOfHeader + ( ( t * NumTracks + e ) * NumFrequencies + f ) * atomsize, ios::beg );
+    int         atomsize    = IsComplex ( AtomTypeUseOriginal ) ? sizeof ( complex<float> ) : sizeof ( float );
+                                        // consecutive positions will be merged into a single write
+    LONGLONG    pos         = EndOfHeader + ( ( (LONGLONG) t * NumTracks + e ) * NumFrequencies + f ) * atomsize;
 
 
     if ( IsScalar ( AtomTypeUseOriginal ) ) {   // convert to scalar
         float       value   = sqrt ( Square ( realpart ) + Square ( imagpart ) );
 //      float       value   = realpart;
-        of->write ( (char *) &value,    sizeof ( float ) );
+        Stage ( pos, &value, sizeof ( float ) );
         }
     else {
-        of->write ( (char *) &realpart, sizeof ( float ) );
-        of->write ( (char *) &imagpart, sizeof ( float ) );
+        float       comp[ 2 ]       = { realpart, imagpart };
+        Stage ( pos, comp, sizeof ( comp ) );
         }
 
     }
@@ -1736,7 +1917,7 @@ if ( ! DoneBegin )
 if ( IsVector ( AtomTypeUseOriginal ) && Type == ExportTracksRis ) {
 
                                         // output vectorial, input vectorial: write the vector
-    of->write ( (char *) & vector.X, vector.MemorySize () );
+    Stage ( -1, &vector.X, vector.MemorySize () );
 
 //  of->flush ();
 
@@ -1779,13 +1960,11 @@ else if ( Type == ExportTracksSef
        || Type == ExportTracksRis ) {
 
 
-    int     atomsize    = 3 * sizeof ( float );
+    int         atomsize    = 3 * sizeof ( float );
 
-    of->seekp ( EndOfHeader + ( t * NumTracks + e ) * atomsize, ios::beg );
+    float       xyz[ 3 ]        = { vector.X, vector.Y, vector.Z };
 
-    of->write ( (char *) &vector.X, sizeof ( float ) );
-    of->write ( (char *) &vector.Y, sizeof ( float ) );
-    of->write ( (char *) &vector.Z, sizeof ( float ) );
+    Stage ( EndOfHeader + ( (LONGLONG) t * NumTracks + e ) * atomsize, xyz, sizeof ( xyz ) );
     }
 
 
@@ -1810,7 +1989,7 @@ if      ( Type == ExportTracksSef
 
     UpdateApplication;
                                         // send the whole array at once
-    of->write ( (char *) values.GetMemoryAddress (), values.GetMemorySize () );
+    Stage ( -1, values.GetMemoryAddress (), values.GetMemorySize () );
 
 //  of->flush ();
     }
@@ -1890,7 +2069,7 @@ if      ( Type == ExportTracksSef
 
     UpdateApplication;
                                         // send the whole array at once
-    of->write ( (char *) map.GetMemoryAddress (), map.GetMemorySize () );
+    Stage ( -1, map.GetMemoryAddress (), map.GetMemorySize () );
 
 //  of->flush ();
     }
@@ -1956,14 +2135,25 @@ if ( ! DoneBegin )
 
 
 if ( transpose == Transposed ) {        // the "\n" is not handled correctly, caller must swap NumTime and NumTracks values to have it work correctly
+                                        // float binary files can be transposed straight into the staging chunk
+    bool                stagefloats     = Type == ExportTracksSef
+                                       || Type == ExportTracksBv
+                                       || ( Type == ExportTracksRis && ! IsVector ( AtomTypeUseOriginal ) );
+    int                 numel           = NumTracks * NumFiles;
 
     for ( long tf = 0; tf < NumTime; tf++ ) {
 
         if ( Gauge.IsAlive () )     Gauge.Next ();
         else                        UpdateApplication
-        
-        for ( int el = 0; el < NumTracks * NumFiles; el++ )
-            Write ( values ( el, tf ) );
+
+        float*          tos             = stagefloats ? (float*) StageReserve ( -1, numel * sizeof ( float ) ) : 0;
+
+        if ( tos )
+            for ( int el = 0; el < numel; el++ )
+                *tos++  = values ( el, tf );
+        else
+            for ( int el = 0; el < numel; el++ )
+                Write ( values ( el, tf ) );
         }
     } // Transposed
 
@@ -1978,7 +2168,7 @@ else { // NotTransposed
         else                        UpdateApplication
 
                                         // send the whole array at once
-        of->write ( (char *) values.GetMemoryAddress (), values.GetMemorySize () );
+        Stage ( -1, values.GetMemoryAddress (), values.GetMemorySize () );
 
 //      of->flush ();
 
@@ -2069,9 +2259,8 @@ else { // NotTransposed
         else                        UpdateApplication
 
 
-        of->seekp ( EndOfHeader, ios::beg );
                                         // send the whole array at once - caller is trusted to send the right amount of data here
-        of->write ( (char *) values.GetMemoryAddress (), values.GetMemorySize () );
+        Stage ( EndOfHeader, values.GetMemoryAddress (), values.GetMemorySize () );
 
 //      of->flush ();
 
@@ -20,15 +20,16 @@ limitations under the License.
 #include    "Files.Utils.h"
 #include    "Time.TDateTime.h"
 #include    "TMarkers.h"
+#include    "TArray1.h"
 
 #include    "TFreqDoc.h"
+#include    "TTracksBlocksPipeline.h"
 
 namespace crtl {
 
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
-template <class TypeD> class        TArray1;
 template <class TypeD> class        TArray2;
 template <class TypeD> class        TSetArray2;
 template <class TypeD> class        TVector;
@@ -117,6 +118,27 @@ constexpr double    EdfPhysicalMaxMargin    = 5;        // Boosting the max valu
 constexpr int       EdfDigitalMax           = 0x77FF;   // Digital max value, a little less than 0x7FFF / SHRT_MAX
 
 
+//----------------------------------------------------------------------------
+                                        // Binary output is converted into a staging chunk, which is then written at once
+constexpr size_t    ExportTracksStagingMinSize  =  64 * KiloByte;
+constexpr size_t    ExportTracksStagingMaxSize  =   4 * MegaByte;
+                                        // Outputs bigger than that are written from a background thread
+constexpr size_t    ExportTracksWriteBehindSize =  16 * MegaByte;
+
+                                        // A chunk of output bytes, and where they go in file
+class   TExportTracksStaging
+{
+public:
+                    TExportTracksStaging ()                 { Origin = -1; }
+
+
+    TArray1<char>   Data;
+    LONGLONG        Origin;             // file position of Data, or -1 to continue from the current position
+
+    void            Resize ( int dim1, int dim2 )           { Data.Resize ( dim1 * dim2 ); }   // as used by TTracksBlocksWriter
+};
+
+
 //----------------------------------------------------------------------------
                                         // Centralized class to save tracks to file
 
@@ -159,6 +181,8 @@ public:
     double          BlockFrequency;
     TStrings        FrequencyNames;
 
+    bool            WriteBehind;        // allowing big binary outputs to be written from a background thread
+
                                         // Either create a new object each time: calling Write will do the all the job
                                         // Or use 1 object multiple times, then call in sequence: Reset, Begin, Write, End
     void            Reset               ();
@@ -221,7 +245,7 @@ public:
     TExportTracks                           ( const TExportTracks &op  );   // copy constructor
     TExportTracks&  operator    =           ( const TExportTracks &op2 );   // assignation operator
 
-                    operator    std::ofstream&   ()     { return  *of; }
+                    operator    std::ofstream&   ()     { SyncStaging (); return  *of; }
     
 protected:
 
@@ -241,11 +265,28 @@ protected:
     double          EdfDigitalMin;
     double          EdfRatio;
     short           EdfValue;
+    TArray1<short>  EdfRecord;          // current record, written at once when complete
+
+                                        // Staging of binary output
+    TExportTracksStaging                        LocalStaging;       // without write-behind
+    TTracksBlocksWriter<TExportTracksStaging>   StagingWriter;      // with write-behind
+    TExportTracksStaging*                       Staging;            // chunk currently being filled, 0 if not staging
+    size_t                                      StagingSize;
+    size_t                                      StagingUsed;
 
 
     bool            OpenStream  ( bool reopen = false );        // open stream - Called automatically
     void            CloseStream ();                             // close stream - Called automatically
     void            PreFillFile ();
+    size_t          GetDataSize () const;
+
+    void            StartStaging ();
+    void            StopStaging  ();
+    void            FlushStaging ();                                // hands the current chunk to be written
+    void            SyncStaging  ();                                // flushes, then waits for all chunks to be written - needed before any direct access to the stream
+    char*           StageReserve ( LONGLONG pos, size_t size );     // room for size bytes going to file position pos (-1 for sequential), or 0 if too big
+    void            Stage        ( LONGLONG pos, const void* data, size_t size );
+    void            WriteStaging ( const TExportTracksStaging& staging, long size );
 
     const char*     GetElectrodeName ( int i, char *name, int maxlen );
     const char*     GetFrequencyName ( int i, char *name, int maxlen );
@@ -16,6 +16,8 @@ limitations under the License.
 
 #pragma once
 
+#include    "TArray1.h"
+
 namespace crtl {
 
 //----------------------------------------------------------------------------
@@ -25,6 +27,12 @@ namespace crtl {
 // needed for the filtering. It will also centralize calls from different types
 // of data structures, usually through a bit of data shuffling, and all at the
 // same place.
+//----------------------------------------------------------------------------
+                                        // Number of tracks processed at once by the multi-tracks filters
+                                        // Data is then interleaved as [numpts][TFilterNumLanes], and loops across lanes can be vectorized by the compiler
+constexpr int   TFilterNumLanes             = 8;
+
+
 //----------------------------------------------------------------------------
                                         // Base class for a single filter
 template <class TypeD>
@@ -37,6 +45,14 @@ public:
 
     virtual void    Apply                   ( TypeD* data, int numpts ) {} // = 0;
 
+                                        // Streaming on consecutive blocks: data has numpts + lookahead values, and state is carried from one block to the next
+                                        // The lookahead values are filtered too, but only as a provisional result that will be recomputed with the next block
+    virtual int     GetStreamStateSize      ()  const   { return 0; }
+    virtual void    ApplyStream             ( TypeD* data, int numpts, int lookahead, double* state )   { Apply ( data, numpts + lookahead ); }
+
+                                        // Filtering TFilterNumLanes tracks at once, data being interleaved - default is to process each lane separately
+    virtual void    ApplyInterleaved        ( TypeD* data, int numpts );
+
 };
 
 
@@ -65,6 +81,9 @@ public:
     void            Add             ( TFilter<TypeD>* filter );
 
     void            Apply           ( TypeD* data, int numpts )         const;
+    int             GetStreamStateSize  ()                              const;
+    void            ApplyStream     ( TypeD* data, int numpts, int lookahead, double* state )   const;
+    void            ApplyInterleaved( TypeD* data, int numpts )         const;
 
 //  void            Show            ( char *title = 0 );
 
@@ -96,6 +115,26 @@ protected:
 
 //----------------------------------------------------------------------------
 // Implementation
+//----------------------------------------------------------------------------
+template <class TypeD>
+void    TFilter<TypeD>::ApplyInterleaved ( TypeD* data, int numpts )
+{
+TArray1<TypeD>      lane ( numpts );
+
+
+for ( int l = 0; l < TFilterNumLanes; l++ ) {
+
+    for ( int ti = 0; ti < numpts; ti++ )
+        lane[ ti ]  = data[ ti * TFilterNumLanes + l ];
+
+    Apply ( lane.GetArray (), numpts );
+
+    for ( int ti = 0; ti < numpts; ti++ )
+        data[ ti * TFilterNumLanes + l ]    = lane[ ti ];
+    }
+}
+
+
 //----------------------------------------------------------------------------
 template <class TypeD>
         TFilters<TypeD>::TFilters ()
@@ -201,6 +240,40 @@ for ( int i = 0; i < GetNumFilters (); i++ )
 }
 
 
+//----------------------------------------------------------------------------
+                                        // States of all filters are simply concatenated
+template <class TypeD>
+int     TFilters<TypeD>::GetStreamStateSize ()    const
+{
+int                 statesize       = 0;
+
+for ( int i = 0; i < GetNumFilters (); i++ )
+    statesize  += Filters[ i ]->GetStreamStateSize ();
+
+return  statesize;
+}
+
+
+template <class TypeD>
+void    TFilters<TypeD>::ApplyStream ( TypeD* data, int numpts, int lookahead, double* state )    const
+{
+for ( int i = 0; i < GetNumFilters (); i++ ) {
+
+    Filters[ i ]->ApplyStream ( data, numpts, lookahead, state );
+
+    state  += Filters[ i ]->GetStreamStateSize ();
+    }
+}
+
+
+template <class TypeD>
+void    TFilters<TypeD>::ApplyInterleaved ( TypeD* data, int numpts )    const
+{
+for ( int i = 0; i < GetNumFilters (); i++ )
+    Filters[ i ]->ApplyInterleaved ( data, numpts );
+}
+
+
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
@@ -31,6 +31,10 @@ public:
 
     void            Apply                   ( TypeD* data, int numpts );
 
+    int             GetStreamStateSize      ()  const   { return 2; }   // DC value + flag
+    void            ApplyStream             ( TypeD* data, int numpts, int lookahead, double* state );
+    void            ApplyInterleaved        ( TypeD* data, int numpts );
+
                         TFilterBaseline     ( const TFilterBaseline& op  );
     TFilterBaseline&    operator    =       ( const TFilterBaseline& op2 );
 };
@@ -74,6 +78,64 @@ for ( int ti = 0; ti < numpts; ti++ )
 }
 
 
+//----------------------------------------------------------------------------
+                                        // Streaming version: the DC is estimated on the first block (and its look-ahead), then kept for the whole stream
+                                        // Removing a different DC on each block would create steps that the following stateful filters will not forgive
+template <class TypeD>
+void    TFilterBaseline<TypeD>::ApplyStream ( TypeD* data, int numpts, int lookahead, double* state )
+{
+int                 numall          = numpts + lookahead;
+
+if ( state[ 1 ] == 0 ) {
+
+    double              sum             = 0;
+
+    for ( int ti = 0; ti < numall; ti++ )
+        sum        += data[ ti ];
+
+    state[ 0 ]  = sum / NonNull ( numall );
+    state[ 1 ]  = 1;                    // DC is now set
+    }
+
+
+for ( int ti = 0; ti < numall; ti++ )
+    data[ ti ] -= state[ 0 ];
+}
+
+
+//----------------------------------------------------------------------------
+template <class TypeD>
+void    TFilterBaseline<TypeD>::ApplyInterleaved ( TypeD* data, int numpts )
+{
+double              sum[ TFilterNumLanes ];
+
+for ( int l = 0; l < TFilterNumLanes; l++ )
+    sum[ l ]    = 0;
+
+
+for ( int ti = 0; ti < numpts; ti++ ) {
+
+    const TypeD*    toti        = data + ti * TFilterNumLanes;
+
+    for ( int l = 0; l < TFilterNumLanes; l++ )
+        sum[ l ]   += toti[ l ];
+    }
+
+
+for ( int l = 0; l < TFilterNumLanes; l++ )
+    sum[ l ]   /= numpts;
+
+
+for ( int ti = 0; ti < numpts; ti++ ) {
+
+    TypeD*          toti        = data + ti * TFilterNumLanes;
+
+    for ( int l = 0; l < TFilterNumLanes; l++ )
+        toti[ l ]  -= sum[ l ];
+    }
+}
+
+
 /*                                      // Sliding window DC
 template <class TypeD>
 void    TFilterBaseline<TypeD>::Apply ( TypeD* data, int numpts )
@@ -72,6 +72,10 @@ public:
 
     void            Apply                   ( TypeD* data, int numpts );
 
+    int             GetStreamStateSize      ()  const   { return  Order; }  // all cascaded sections delayed values
+    void            ApplyStream             ( TypeD* data, int numpts, int lookahead, double* state );
+    void            ApplyInterleaved        ( TypeD* data, int numpts );                // TFilterNumLanes tracks at once
+
 
                                 TFilterButterworthHighPass      ( const TFilterButterworthHighPass& op  );
     TFilterButterworthHighPass&     operator    =               ( const TFilterButterworthHighPass& op2 );
@@ -106,6 +110,10 @@ public:
 
     void            Apply                   ( TypeD* data, int numpts );
 
+    int             GetStreamStateSize      ()  const   { return  Order; }  // all cascaded sections delayed values
+    void            ApplyStream             ( TypeD* data, int numpts, int lookahead, double* state );
+    void            ApplyInterleaved        ( TypeD* data, int numpts );                // TFilterNumLanes tracks at once
+
 
                                 TFilterButterworthLowPass       ( const TFilterButterworthLowPass& op  );
     TFilterButterworthLowPass&      operator    =               ( const TFilterButterworthLowPass& op2 );
@@ -143,6 +151,10 @@ public:
 
     void            Apply                   ( TypeD* data, int numpts );
 
+    int             GetStreamStateSize      ()  const   { return  Order; }  // all cascaded sections delayed values
+    void            ApplyStream             ( TypeD* data, int numpts, int lookahead, double* state );
+    void            ApplyInterleaved        ( TypeD* data, int numpts );                // TFilterNumLanes tracks at once
+
 
                                     TFilterButterworthBandPass  ( const TFilterButterworthBandPass& op  );
     TFilterButterworthBandPass&     operator    =               ( const TFilterButterworthBandPass& op2 );
@@ -183,6 +195,10 @@ public:
 
     void            Apply                   ( TypeD* data, int numpts );
 
+    int             GetStreamStateSize      ()  const   { return  Order; }  // all cascaded sections delayed values
+    void            ApplyStream             ( TypeD* data, int numpts, int lookahead, double* state );
+    void            ApplyInterleaved        ( TypeD* data, int numpts );                // TFilterNumLanes tracks at once
+
 
                                     TFilterButterworthBandStop  ( const TFilterButterworthBandStop& op  );
     TFilterButterworthBandStop&     operator    =               ( const TFilterButterworthBandStop& op2 );
@@ -227,6 +243,136 @@ protected:
 // Note: Cutoff frequency at -3dB corresponds to half power (10 Log ( 0.5 ) = -3), or 0.707 amplitude (20 Log ( 0.707 ) = -3)
 
 
+//----------------------------------------------------------------------------
+                                        // Cascaded sections, common to all the Butterworth filters, and to all the ways to apply them
+                                        // Each section k has NumDelays delayed values w1..wN (2 for Low & High pass, 4 for Band-pass & Band-stop):
+                                        //      w0      = feedback[ 0 ][ k ] * w1 + ... + feedback[ N-1 ][ k ] * wN + input
+                                        //      output  = gain[ k ] * ( w0 + feedforward[ 0 ] * w1 + ... + feedforward[ N-1 ] * wN )
+                                        // Feed-forward coefficients are the same for all sections.
+
+                                        // Feed-forward coefficients of the Low, High and Band pass - Band-stop ones depend on the center frequency
+constexpr double    ButterworthLowPassFeedForward   [ 2 ]   = {  2, 1 };
+constexpr double    ButterworthHighPassFeedForward  [ 2 ]   = { -2, 1 };
+constexpr double    ButterworthBandPassFeedForward  [ 4 ]   = {  0, -2, 0, 1 };
+
+                                        // Max size of the delayed values, per lane: number of sections * NumDelays is the filter order
+constexpr int       ButterworthMaxDelays            = TFilterMaxTwiceOrder;
+
+
+                                        // Single pass from ti1 to ti2 excluded, forward or backward with step
+                                        // Data holds NumLanes interleaved tracks: [numpts][NumLanes], NumLanes being 1 for a single track
+                                        // w holds the delayed values as [numsections][NumDelays][NumLanes], it is both the starting state and the final state
+                                        // The innermost loop runs across the independent lanes, which is the part the compiler can vectorize
+template <int NumDelays, int NumLanes, class TypeD>
+void    ButterworthCascadePass  (   TypeD*          data,           int             ti1,            int             ti2,        int     step,
+                                    int             numsections,    const double*   gain,           const double* const*    feedback,   const double*   feedforward,
+                                    double*         w
+                                )
+{
+double              d [ NumLanes ];
+
+
+for ( int ti = ti1; ti != ti2; ti += step ) {
+
+    TypeD*          toti        = data + ti * NumLanes;
+
+    for ( int l = 0; l < NumLanes; l++ )
+        d[ l ]  = toti[ l ];
+
+
+    for ( int k = 0; k < numsections; k++ ) {
+
+        double*         wk          = w + k * NumDelays * NumLanes;
+                                        // all lanes at once - no dependencies across lanes
+        for ( int l = 0; l < NumLanes; l++ ) {
+
+            double          w0          = feedback[ 0 ][ k ] * wk[ l ];
+
+            for ( int j = 1; j < NumDelays; j++ )
+                w0     += feedback[ j ][ k ] * wk[ j * NumLanes + l ];
+
+            w0         += d[ l ];
+
+
+            double          y           = w0;
+
+            for ( int j = 0; j < NumDelays; j++ )
+                y      += feedforward[ j ] * wk[ j * NumLanes + l ];
+
+            d[ l ]      = gain[ k ] * y;
+
+                                        // shift the delayed values
+            for ( int j = NumDelays - 1; j > 0; j-- )
+                wk[ j * NumLanes + l ]  = wk[ ( j - 1 ) * NumLanes + l ];
+
+            wk[ l ]     = w0;
+            }
+        }
+
+
+    for ( int l = 0; l < NumLanes; l++ )
+        toti[ l ]   = d[ l ];
+    }
+}
+
+
+                                        // Whole filtering, on 1 or NumLanes interleaved tracks
+template <int NumDelays, int NumLanes, class TypeD>
+void    ButterworthCascadeApply (   TypeD*          data,           int             numpts,         FilterCausality         causal,
+                                    int             numsections,    const double*   gain,           const double* const*    feedback,   const double*   feedforward
+                                )
+{
+                                        // on the stack for OpenMP
+double              w [ ButterworthMaxDelays * NumLanes ];
+int                 numw            = numsections * NumDelays * NumLanes;
+
+                                        // apply filter backward - optional in case one doesn't want data "from the future"
+if ( causal == FilterNonCausal ) {
+
+    for ( int i = 0; i < numw; i++ )    w[ i ] = 0;
+
+    ButterworthCascadePass<NumDelays, NumLanes> ( data, numpts - 1, -1, -1, numsections, gain, feedback, feedforward, w );
+    }
+
+
+for ( int i = 0; i < numw; i++ )        w[ i ] = 0;
+
+ButterworthCascadePass<NumDelays, NumLanes> ( data, 0, numpts, 1, numsections, gain, feedback, feedforward, w );
+}
+
+                                        // Streaming version, on a single track:
+                                        //  - the backward pass runs on the block and its look-ahead, starting from a null state, like Apply does with its right margin
+                                        //  - the forward pass starts from the state at the end of the previous block, and saves the state at the end of the current block
+                                        // state has the same layout as the delayed values: [numsections][NumDelays]
+template <int NumDelays, class TypeD>
+void    ButterworthCascadeApplyStream   (   TypeD*          data,           int             numpts,         int                     lookahead,  double*         state,
+                                            FilterCausality causal,
+                                            int             numsections,    const double*   gain,           const double* const*    feedback,   const double*   feedforward
+                                        )
+{
+                                        // on the stack for OpenMP
+double              w [ ButterworthMaxDelays ];
+int                 numw            = numsections * NumDelays;
+int                 numall          = numpts + lookahead;
+
+
+if ( causal == FilterNonCausal ) {
+
+    for ( int i = 0; i < numw; i++ )    w[ i ] = 0;
+
+    ButterworthCascadePass<NumDelays, 1> ( data, numall - 1, -1, -1, numsections, gain, feedback, feedforward, w );
+    }
+
+                                        // forward pass updates the state for next block
+ButterworthCascadePass<NumDelays, 1> ( data, 0, numpts, 1, numsections, gain, feedback, feedforward, state );
+
+                                        // provisional results on the look-ahead, needed by any following filter, from a copy of the state
+for ( int i = 0; i < numw; i++ )        w[ i ] = state[ i ];
+
+ButterworthCascadePass<NumDelays, 1> ( data, numpts, numall, 1, numsections, gain, feedback, feedforward, w );
+}
+
+
 template <class TypeD>
         TFilterButterworthHighPass<TypeD>::TFilterButterworthHighPass ()
       : TFilter<TypeD> ()
@@ -335,58 +481,31 @@ for ( int k = 0; k < order2; k++ ) {
 template <class TypeD>
 void    TFilterButterworthHighPass<TypeD>::Apply ( TypeD* data, int numpts )
 {
-                                        // cascading 2nd order filter elements
-int                 order2          = Order / 2;
-double              d;
-                                        // on the stack for OpenMP
-double              w0 [ TFilterMaxOrder / 2 ];
-double              w1 [ TFilterMaxOrder / 2 ];
-double              w2 [ TFilterMaxOrder / 2 ];
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // init W's to 0
-auto        ResetWs     = [ & ] ( int order2 )      { for ( int k = 0; k < order2; k++ )  w2[ k ] = w1[ k ] = 0; };
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // apply filter backward - optional in case one doesn't want data "from the future"
-if ( Causal == FilterNonCausal ) {
-
-    ResetWs ( order2 );
-
-    for ( int ti = numpts - 1; ti >= 0; ti-- ) {
-        d   = data[ ti ];
-
-        for ( int k = 0; k < order2; k++ ) {
-
-            w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d;
-            d           = A[ k ] * ( w0[ k ] - 2 * w1[ k ] + w2[ k ] );
-            w2  [ k ]   = w1[ k ];
-            w1  [ k ]   = w0[ k ];
-            }
-
-        data[ ti ]  = d;
-        }
-    } // ! Causal
+const double*       feedback    [ 2 ]   = { d1, d2 };
 
+ButterworthCascadeApply<2, 1> ( data, numpts, Causal, Order / 2, A, feedback, ButterworthHighPassFeedForward );
+}
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-ResetWs ( order2 );
+//----------------------------------------------------------------------------
+                                        // Streaming version of Apply - see ButterworthCascadeApplyStream
+template <class TypeD>
+void    TFilterButterworthHighPass<TypeD>::ApplyStream ( TypeD* data, int numpts, int lookahead, double* state )
+{
+const double*       feedback    [ 2 ]   = { d1, d2 };
 
-for ( int ti = 0; ti < numpts; ti++ ) {
-    d   = data[ ti ];
+ButterworthCascadeApplyStream<2> ( data, numpts, lookahead, state, Causal, Order / 2, A, feedback, ButterworthHighPassFeedForward );
+}
 
-    for ( int k = 0; k < order2; k++ ) {
 
-        w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d;
-        d           = A[ k ] * ( w0[ k ] - 2 * w1[ k ] + w2[ k ] );
-        w2  [ k ]   = w1[ k ];
-        w1  [ k ]   = w0[ k ];
-        }
+//----------------------------------------------------------------------------
+                                        // Same as Apply, on TFilterNumLanes interleaved tracks: data is [numpts][TFilterNumLanes]
+template <class TypeD>
+void    TFilterButterworthHighPass<TypeD>::ApplyInterleaved ( TypeD* data, int numpts )
+{
+const double*       feedback    [ 2 ]   = { d1, d2 };
 
-    data[ ti ]  = d;
-    }
+ButterworthCascadeApply<2, TFilterNumLanes> ( data, numpts, Causal, Order / 2, A, feedback, ButterworthHighPassFeedForward );
 }
 
 
@@ -500,58 +619,31 @@ for ( int k = 0; k < order2; k++ ) {
 template <class TypeD>
 void    TFilterButterworthLowPass<TypeD>::Apply ( TypeD* data, int numpts )
 {
-                                        // cascading 2nd order filter elements
-int                 order2          = Order / 2;
-double              d;
-                                        // on the stack for OpenMP
-double              w0 [ TFilterMaxOrder / 2 ];
-double              w1 [ TFilterMaxOrder / 2 ];
-double              w2 [ TFilterMaxOrder / 2 ];
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // init W's to 0
-auto        ResetWs     = [ & ] ( int order2 )      { for ( int k = 0; k < order2; k++ )  w2[ k ] = w1[ k ] = 0; };
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // apply filter backward - optional in case one doesn't want data "from the future"
-if ( Causal == FilterNonCausal ) {
+const double*       feedback    [ 2 ]   = { d1, d2 };
 
-    ResetWs ( order2 );
-
-    for ( int ti = numpts - 1; ti >= 0; ti-- ) {
-        d   = data[ ti ];
-
-        for ( int k = 0; k < order2; k++ ) {
-
-            w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d;
-            d           = A[ k ] * ( w0[ k ] + 2 * w1[ k ] + w2[ k ] );
-            w2  [ k ]   = w1[ k ];
-            w1  [ k ]   = w0[ k ];
-            }
-
-        data[ ti ]  = d;
-        }
-    } // ! Causal
+ButterworthCascadeApply<2, 1> ( data, numpts, Causal, Order / 2, A, feedback, ButterworthLowPassFeedForward );
+}
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-ResetWs ( order2 );
+//----------------------------------------------------------------------------
+                                        // Streaming version of Apply - see ButterworthCascadeApplyStream
+template <class TypeD>
+void    TFilterButterworthLowPass<TypeD>::ApplyStream ( TypeD* data, int numpts, int lookahead, double* state )
+{
+const double*       feedback    [ 2 ]   = { d1, d2 };
 
-for ( int ti = 0; ti < numpts; ti++ ) {
-    d   = data[ ti ];
+ButterworthCascadeApplyStream<2> ( data, numpts, lookahead, state, Causal, Order / 2, A, feedback, ButterworthLowPassFeedForward );
+}
 
-    for ( int k = 0; k < order2; k++ ) {
 
-        w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d;
-        d           = A[ k ] * ( w0[ k ] + 2 * w1[ k ] + w2[ k ] );
-        w2  [ k ]   = w1[ k ];
-        w1  [ k ]   = w0[ k ];
-        }
+//----------------------------------------------------------------------------
+                                        // Multi-tracks version of Apply, on TFilterNumLanes interleaved tracks
+template <class TypeD>
+void    TFilterButterworthLowPass<TypeD>::ApplyInterleaved ( TypeD* data, int numpts )
+{
+const double*       feedback    [ 2 ]   = { d1, d2 };
 
-    data[ ti ]  = d;
-    }
+ButterworthCascadeApply<2, TFilterNumLanes> ( data, numpts, Causal, Order / 2, A, feedback, ButterworthLowPassFeedForward );
 }
 
 
@@ -681,64 +773,31 @@ for ( int k = 0; k < order4; k++ ) {
 template <class TypeD>
 void    TFilterButterworthBandPass<TypeD>::Apply ( TypeD* data, int numpts )
 {
-                                        // cascading 2nd order filter elements, twice
-int                 order4          = Order / 4;
-double              d;
-                                        // on the stack for OpenMP
-double              w0 [ TFilterMaxTwiceOrder / 4 ];
-double              w1 [ TFilterMaxTwiceOrder / 4 ];
-double              w2 [ TFilterMaxTwiceOrder / 4 ];
-double              w3 [ TFilterMaxTwiceOrder / 4 ];
-double              w4 [ TFilterMaxTwiceOrder / 4 ];
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // init W's to 0
-auto        ResetWs     = [ & ] ( int order4 )      { for ( int k = 0; k < order4; k++ )  w4[ k ] = w3[ k ] = w2[ k ] = w1[ k ] = 0; };
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // apply filter backward - optional in case one doesn't want data "from the future"
-if ( Causal == FilterNonCausal ) {
-
-    ResetWs ( order4 );
-
-    for ( int ti = numpts - 1; ti >= 0; ti-- ) {
-        d   = data[ ti ];
-
-        for ( int k = 0; k < order4; k++ ) {
-
-            w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d3[ k ] * w3[ k ]+ d4[ k ] * w4[ k ] + d;
-            d           = A[ k ] * ( w0[ k ] - 2 * w2[ k ] + w4[ k ] );
-            w4  [ k ]   = w3[ k ];
-            w3  [ k ]   = w2[ k ];
-            w2  [ k ]   = w1[ k ];
-            w1  [ k ]   = w0[ k ];
-            }
-
-        data[ ti ]  = d;
-        }
-    } // ! Causal
+const double*       feedback    [ 4 ]   = { d1, d2, d3, d4 };
 
+ButterworthCascadeApply<4, 1> ( data, numpts, Causal, Order / 4, A, feedback, ButterworthBandPassFeedForward );
+}
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-ResetWs ( order4 );
+//----------------------------------------------------------------------------
+                                        // Streaming version of Apply - see ButterworthCascadeApplyStream
+template <class TypeD>
+void    TFilterButterworthBandPass<TypeD>::ApplyStream ( TypeD* data, int numpts, int lookahead, double* state )
+{
+const double*       feedback    [ 4 ]   = { d1, d2, d3, d4 };
 
-for ( int ti = 0; ti < numpts; ti++ ) {
-    d   = data[ ti ];
+ButterworthCascadeApplyStream<4> ( data, numpts, lookahead, state, Causal, Order / 4, A, feedback, ButterworthBandPassFeedForward );
+}
 
-    for ( int k = 0; k < order4; k++ ) {
 
-        w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d3[ k ] * w3[ k ]+ d4[ k ] * w4[ k ] + d;
-        d           = A[ k ] * ( w0[ k ] - 2 * w2[ k ] + w4[ k ] );
-        w4  [ k ]   = w3[ k ];
-        w3  [ k ]   = w2[ k ];
-        w2  [ k ]   = w1[ k ];
-        w1  [ k ]   = w0[ k ];
-        }
+//----------------------------------------------------------------------------
+                                        // Multi-tracks version of Apply, on TFilterNumLanes interleaved tracks
+template <class TypeD>
+void    TFilterButterworthBandPass<TypeD>::ApplyInterleaved ( TypeD* data, int numpts )
+{
+const double*       feedback    [ 4 ]   = { d1, d2, d3, d4 };
 
-    data[ ti ]  = d;
-    }
+ButterworthCascadeApply<4, TFilterNumLanes> ( data, numpts, Causal, Order / 4, A, feedback, ButterworthBandPassFeedForward );
 }
 
 
@@ -880,64 +939,34 @@ ww2     = 2 + 4 * center2;
 template <class TypeD>
 void    TFilterButterworthBandStop<TypeD>::Apply ( TypeD* data, int numpts )
 {
-                                        // cascading 2nd order filter elements, twice
-int                 order4          = Order / 4;
-double              d;
-                                        // on the stack for OpenMP
-double              w0 [ TFilterMaxTwiceOrder / 4 ];
-double              w1 [ TFilterMaxTwiceOrder / 4 ];
-double              w2 [ TFilterMaxTwiceOrder / 4 ];
-double              w3 [ TFilterMaxTwiceOrder / 4 ];
-double              w4 [ TFilterMaxTwiceOrder / 4 ];
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // init W's to 0
-auto        ResetWs     = [ & ] ( int order4 )      { for ( int k = 0; k < order4; k++ )  w4[ k ] = w3[ k ] = w2[ k ] = w1[ k ] = 0; };
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // apply filter backward - optional in case one doesn't want data "from the future"
-if ( Causal == FilterNonCausal ) {
-
-    ResetWs ( order4 );
-
-    for ( int ti = numpts - 1; ti >= 0; ti-- ) {
-        d   = data[ ti ];
-
-        for ( int k = 0; k < order4; k++ ) {
-
-            w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d3[ k ] * w3[ k ]+ d4[ k ] * w4[ k ] + d;
-            d           = A[ k ] * ( w0[ k ] - ww13 * w1[ k ] + ww2 * w2[ k ] - ww13 * w3[ k ] + w4[ k ] );
-            w4  [ k ]   = w3[ k ];
-            w3  [ k ]   = w2[ k ];
-            w2  [ k ]   = w1[ k ];
-            w1  [ k ]   = w0[ k ];
-            }
-
-        data[ ti ]  = d;
-        }
-    } // ! Causal
+const double*       feedback    [ 4 ]   = { d1, d2, d3, d4 };
+const double        feedforward [ 4 ]   = { -ww13, ww2, -ww13, 1 };
 
+ButterworthCascadeApply<4, 1> ( data, numpts, Causal, Order / 4, A, feedback, feedforward );
+}
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-ResetWs ( order4 );
+//----------------------------------------------------------------------------
+                                        // Streaming version of Apply - see ButterworthCascadeApplyStream
+template <class TypeD>
+void    TFilterButterworthBandStop<TypeD>::ApplyStream ( TypeD* data, int numpts, int lookahead, double* state )
+{
+const double*       feedback    [ 4 ]   = { d1, d2, d3, d4 };
+const double        feedforward [ 4 ]   = { -ww13, ww2, -ww13, 1 };
 
-for ( int ti = 0; ti < numpts; ti++ ) {
-    d   = data[ ti ];
+ButterworthCascadeApplyStream<4> ( data, numpts, lookahead, state, Causal, Order / 4, A, feedback, feedforward );
+}
 
-    for ( int k = 0; k < order4; k++ ) {
 
-        w0  [ k ]   = d1[ k ] * w1[ k ] + d2[ k ] * w2[ k ] + d3[ k ] * w3[ k ]+ d4[ k ] * w4[ k ] + d;
-        d           = A[ k ] * ( w0[ k ] - ww13 * w1[ k ] + ww2 * w2[ k ] - ww13 * w3[ k ] + w4[ k ] );
-        w4  [ k ]   = w3[ k ];
-        w3  [ k ]   = w2[ k ];
-        w2  [ k ]   = w1[ k ];
-        w1  [ k ]   = w0[ k ];
-        }
+//----------------------------------------------------------------------------
+                                        // Multi-tracks version of Apply, on TFilterNumLanes interleaved tracks
+template <class TypeD>
+void    TFilterButterworthBandStop<TypeD>::ApplyInterleaved ( TypeD* data, int numpts )
+{
+const double*       feedback    [ 4 ]   = { d1, d2, d3, d4 };
+const double        feedforward [ 4 ]   = { -ww13, ww2, -ww13, 1 };
 
-    data[ ti ]  = d;
-    }
+ButterworthCascadeApply<4, TFilterNumLanes> ( data, numpts, Causal, Order / 4, A, feedback, feedforward );
 }
 
 
@@ -14,6 +14,10 @@ See the License for the specific language governing permissions and
 limitations under the License.
 \************************************************************************/
 
+#if defined(CHECKASSERT)
+#include    <assert.h>
+#endif
+
 #include    "TInterpolateTracks.h"
 
 #include    "Math.Utils.h"
@@ -24,6 +28,7 @@ limitations under the License.
 #include    "Dialogs.TSuperGauge.h"
 
 #include    "TExportTracks.h"
+#include    "TTracksBlocksPipeline.h"
 
 #include    "TTracksDoc.h"
 
@@ -464,6 +469,8 @@ A                       .ARelease ();
 LU                      .Reset ();
 Kernel                  .DeallocateMemory ();
 ToHasSamePositionAsFrom .DeallocateMemory ();
+Transfer                .ARelease ();
+TransferChecksum        = 0;
 
 for ( int d = 0; d < MaxInterpolationDegree; d++ )
     Dest_To_FidPoints_Power[ d ].Reset ();
@@ -1014,6 +1021,163 @@ return  true;
 }
 
 
+//----------------------------------------------------------------------------
+                                        // Solving A * X = B, then evaluating the spline at each "to" electrode, are both linear in the data,
+                                        // so that the whole interpolation boils down to a single ( "to" electrodes x input tracks ) matrix.
+                                        // It only depends on the geometry, the spline parameters and which input tracks are being used,
+                                        // so it is computed once, then re-used as long as these don't change, f.ex. across a batch of files.
+bool    TInterpolateTracks::SetTransfer ( const TSelection& fromgoodsel, int numfromtracks )
+{
+if ( ! IsOpen () )
+    return  false;
+
+
+int                 maxelfrom       = From_To_FidPoints.GetNumPoints ();
+int                 maxelto         = Dest_To_FidPoints.GetNumPoints ();
+
+                                        // checksum of all the parameters - order matters
+uint                checksum        = InterpolationType;
+
+auto                addtochecksum   = [ &checksum ] ( uint v )  { checksum = checksum * 31 + v; };
+
+addtochecksum ( SplineDegree  );
+addtochecksum ( TargetSpace   );
+addtochecksum ( numfromtracks );
+addtochecksum ( maxelfrom     );
+addtochecksum ( maxelto       );
+
+for ( TIteratorSelectedForward eti ( fromgoodsel ); (bool) eti; ++eti )
+    addtochecksum ( eti () );
+
+for ( int frei = 0; frei < maxelfrom; frei++ ) {
+    addtochecksum ( *(uint *) &From_To_FidPoints[ frei ].X );
+    addtochecksum ( *(uint *) &From_To_FidPoints[ frei ].Y );
+    addtochecksum ( *(uint *) &From_To_FidPoints[ frei ].Z );
+    }
+
+for ( int toei = 0; toei < maxelto; toei++ ) {
+    addtochecksum ( *(uint *) &Dest_To_FidPoints[ toei ].X );
+    addtochecksum ( *(uint *) &Dest_To_FidPoints[ toei ].Y );
+    addtochecksum ( *(uint *) &Dest_To_FidPoints[ toei ].Z );
+    addtochecksum ( ToHasSamePositionAsFrom[ toei ] );
+    }
+
+                                        // already computed?
+if ( checksum           == TransferChecksum 
+  && (int) Transfer.n_rows == maxelto 
+  && (int) Transfer.n_cols == numfromtracks )
+
+    return  true;
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // new index of good electrodes -> index of input track
+TArray1<int>        fromtotrack ( maxelfrom );
+
+fromtotrack     = InvalidIndex;
+
+for ( TIteratorSelectedForward eti ( fromgoodsel ); (bool) eti && eti.GetIndex () < maxelfrom; ++eti )
+
+    fromtotrack[ eti.GetIndex () ]  = eti ();
+
+                                        // decide which "to" electrodes need to be interpolated
+TArray1<bool>       dosolve ( maxelto );
+bool                needtosolve     = false;
+
+for ( int toei = 0; toei < maxelto; toei++ ) {
+                                        // current "Dest" electrode possible geometrical match to a "From" electrode
+    int             desttofromindex     = ToHasSamePositionAsFrom[ toei ];
+
+    dosolve[ toei ] =  desttofromindex == InvalidIndex                                  // is current "Dest" electrode NOT an exact geometrical match to a "From" electrode?
+                    || fromgoodsel.IsNotSelected ( desttofromindex )                    // or, it might be a match, but is it a bad electrodes?
+                    || InterpolationType == InterpolationSphericalCurrentDensitySpline; // or are we computing Current Density?
+
+    needtosolve    |= dosolve[ toei ];
+    }
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Spline part: ( to x from ) = ( to x spline ) * A^-1 restricted to its "from" columns
+AMatrix             spline;
+
+if ( needtosolve ) {
+
+    int                 Am              = A.n_rows;
+    int                 An              = A.n_cols;
+
+                                        // solving for each "from" unit vector gives the corresponding columns of A^-1
+    AMatrix             Ainv            = LU.Solve ( AMatrix ( AMatrixIdentity ( Am ).cols ( 0, maxelfrom - 1 ) ) );
+
+                                        // spline evaluated at each "to" electrode, for each spline coefficient
+    AMatrix             W               = AMatrixZero ( maxelto, An );
+
+
+    for ( int toei = 0; toei < maxelto; toei++ ) {
+                                        // K part
+        for ( int i = 0; i < maxelfrom; i++ )
+
+            W ( toei, i )   = Kernel[ toei ][ i ];
+
+                                        // Q part
+        if      ( InterpolationType == Interpolation2DSurfaceSpline ) {
+
+            for ( int d = 0, row = maxelfrom; d < SplineDegree; d++ )
+            for ( int k = 0;                  k <= d;           k++ )
+
+                W ( toei, row++ )   = Dest_To_FidPoints_Power[ d - k ][ toei ].X
+                                    * Dest_To_FidPoints_Power[ k     ][ toei ].Y;
+            }
+
+        else if ( InterpolationType == InterpolationSphericalSpline )
+                                        // constant part
+            W ( toei, maxelfrom )   = 1;
+
+                                        // InterpolationSphericalCurrentDensitySpline has no constant part
+
+        else if ( InterpolationType == Interpolation3DSpline ) {
+
+            for ( int d = 0, row = maxelfrom; d <  SplineDegree; d++ )
+            for ( int k = 0;                  k <= d;            k++ )
+            for ( int g = 0;                  g <= k;            g++ )
+
+                W ( toei, row++ )   = Dest_To_FidPoints_Power[ d - k ][ toei ].X
+                                    * Dest_To_FidPoints_Power[ k - g ][ toei ].Y
+                                    * Dest_To_FidPoints_Power[ g     ][ toei ].Z;
+            }
+        } // for toei
+
+
+    spline      = W * Ainv;
+    }
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Final operator, from all input tracks, including the bad ones which have null weights
+Transfer.AResizeZero ( maxelto, numfromtracks );
+
+
+for ( int toei = 0; toei < maxelto; toei++ )
+
+    if ( dosolve[ toei ] ) {
+
+        for ( int frei = 0; frei < maxelfrom; frei++ )
+
+            if ( IsInsideLimits ( fromtotrack[ frei ], 0, numfromtracks - 1 ) )
+
+                Transfer ( toei, fromtotrack[ frei ] )  = spline ( toei, frei );
+        }
+
+    else if ( IsInsideLimits ( ToHasSamePositionAsFrom[ toei ], 0, numfromtracks - 1 ) )
+                                        // plain copy of original data - a row with a single 1 will not introduce any rounding error
+        Transfer ( toei, ToHasSamePositionAsFrom[ toei ] )  = 1;
+
+
+TransferChecksum    = checksum;
+
+return  true;
+}
+
+
 //----------------------------------------------------------------------------
                                         // Simpler wrapper to full InterpolateTracks method
 bool    TInterpolateTracks::InterpolateTracks   (   const char*         fileeeg,
@@ -1233,232 +1397,110 @@ if ( verbosey == Interactive ) {
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-int                 maxtf           = eegdoc->GetNumTimeFrames();
-int                 maxelfrom       = From_To_FidPoints.GetNumPoints ();
+long                maxtf           = eegdoc->GetNumTimeFrames ();
+int                 numfromtracks   = eegdoc->GetNumElectrodes ();
 int                 maxelto         = Dest_To_FidPoints.GetNumPoints ();
-                                        
-int                 Am              = A.n_rows;     // retrieve matrix dimensions, which can vary according to parameters (actually, Am=An, but anyway...)
-int                 An              = A.n_cols;
-
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Do we really need to mathematically solve anything? Sometimes user just want to downsample data
-bool                needtosolve     = false;
-
-for ( int toei = 0; toei < maxelto; toei++ )
-
-    if (   ToHasSamePositionAsFrom[ toei ] == InvalidIndex 
-        || fromgoodsel.IsNotSelected ( ToHasSamePositionAsFrom[ toei ] )
-        || InterpolationType == InterpolationSphericalCurrentDensitySpline ) {
-
-        needtosolve = true;
-        break;
-        }
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 Gauge.Next ( gaugeinterpolglobal, SuperGaugeUpdateTitle );
 
-TMaps               datain  ( eegdoc->GetDocPath (), 0, AtomTypeScalar, ReferenceAsInFile );
-
-TMaps               dataout ( maxtf, TargetSpace == BackToOriginalElectrodes ? eegdoc->GetNumElectrodes () 
-                                                                             : maxelto );
+                                        // The whole interpolation as a single matrix, computed only once for all files using the same tracks
+if ( ! SetTransfer ( fromgoodsel, numfromtracks ) )
+    return  false;
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                     // accessing From_To_FidPoints, Kernel, SplineDegree, Dest_To_FidPoints_Power
-auto    Interpolate2DSurfaceSpline  = [ this ] ( int    toei,   const AVector&  pq )
-{
-int                 maxelfrom   = From_To_FidPoints.GetNumPoints ();
-double              v           = 0;
-
-                                        // K part
-for ( int i = 0; i < maxelfrom; i++ )
-
-    v      += pq[ i ] * Kernel[ toei ][ i ];
-
-                                        // Q part
-for ( int d = 0, row = maxelfrom; d < SplineDegree; d++ )
-for ( int k = 0;                  k <= d;           k++ )
-
-    v      += pq[ row++ ] * Dest_To_FidPoints_Power[ d - k ][ toei ].X
-                          * Dest_To_FidPoints_Power[ k     ][ toei ].Y;
+                                        // Data are processed by blocks of time frames, so that memory stays bounded whatever the length of the file
+long                blocksize       = Clip ( (long) ( InterpolateTracksBlocksMaxMemory / ( ( numfromtracks + maxelto ) * sizeof ( float ) * TracksBlocksPipelineDepth ) ), 1L, AtLeast ( 1L, maxtf ) );
+int                 numblocks       = ( maxtf + blocksize - 1 ) / blocksize;
+                                        // EDF needs the exact max value in its header, which needs a first pass
+bool                exactmaxvalue   = IsExtension ( neweegfile, FILEEXT_EEGEDF );
 
-return  v;
-};
+                                        // reading is not a const operation
+TTracksDoc*         EEGDoc          = (TTracksDoc*) eegdoc;
+                                        // each block follows the previous one, so temporal filters, if any, can carry on their states
+bool                oldstreaming    = EEGDoc->IsFiltersStreaming ();
 
+EEGDoc->SetFiltersStreaming ( true );
 
-auto    InterpolateSphericalSpline  = [ this ] ( int    toei,   const AVector&  pq )
+                                        // Called from the reading thread
+auto    ReadBlock   = [ EEGDoc, blocksize, maxtf ] ( int blocki, TTracks<float>& eegb )
 {
-int                 maxelfrom   = From_To_FidPoints.GetNumPoints ();
-
-                                        // constant part
-double              v           = pq[ maxelfrom ];
-
-                                        // K part
-for ( int i = 0; i < maxelfrom; i++ )
-
-    v      += pq[ i ] * Kernel[ toei ][ i ];
-
-return  v;
+long                tf1             = blocki * blocksize;
+long                tf2             = min ( tf1 + blocksize, maxtf ) - 1;
+
+EEGDoc->GetTracks   (   tf1,    tf2,
+                        eegb,   0,
+                        AtomTypeScalar,
+                        NoPseudoTracks,
+                        ReferenceAsInFile
+                    );
 };
 
-
-auto    InterpolateSphericalCurrentDensitySpline    = [ this ] ( int    toei,   const AVector&  pq )
+                                        // A single matrix product for the whole block
+auto    ApplyTransfer   = [ this, blocksize ] ( TTracks<float>& eegb, TArray2<float>& eegbout )
 {
-int                 maxelfrom   = From_To_FidPoints.GetNumPoints ();
+static_assert ( std::is_same<AReal, float>::value, "Interpolation blocks are directly mapped as matrices" );
 
-                                        // constant part
-double              v           = 0;
+                                        // input  tracks are stored as ( track, time ), which is a column-major ( time x track ) matrix
+                                        // !with temporal filters, GetTracks can enlarge the time dimension for its margins, so rows are strided by GetDim2, not by blocksize!
+#if defined(CHECKASSERT)
+assert ( eegb.GetDim2 () >= blocksize );
+#endif
 
-                                        // K part
-for ( int i = 0; i < maxelfrom; i++ )
+const AMatrix       datain          ( eegb   .GetArray (), eegb.GetDim2 (), eegb.GetDim1 (), false, true );
 
-    v      += pq[ i ] * Kernel[ toei ][ i ];
+#if defined(CHECKASSERT)
+                                        // last track, last time frame, same value through both views
+assert ( datain ( blocksize - 1, eegb.GetDim1 () - 1 ) == eegb ( eegb.GetDim1 () - 1, blocksize - 1 ) );
+#endif
+                                        // output tracks are stored as ( time, track ), which is a column-major ( track x time ) matrix
+AMatrix             dataout         ( eegbout.GetArray (), Transfer.n_rows, blocksize, false, true );
 
-return  v;
+                                        // past the last time frame, last block might contain left-overs from a previous block, which will not be written anyway
+dataout     = Transfer * datain.submat ( 0, 0, blocksize - 1, Transfer.n_cols - 1 ).t ();
 };
 
 
-auto    Interpolate3DSpline2        = [ this ] ( int    toei,   const AVector&  pq )
-{
-int                 maxelfrom   = From_To_FidPoints.GetNumPoints ();
-double              v           = 0;
-
-                                        // K part
-for ( int i = 0; i < maxelfrom; i++ )
-
-    v      += pq[ i ] * Kernel[ toei ][ i ];
-
-                                        // Q part
-                                        // loop expanded for SplineDegree == 2
-int        &row         = maxelfrom;
-
-v      += pq[ row     ] * Dest_To_FidPoints_Power[ 0 ][ toei ].X
-                        * Dest_To_FidPoints_Power[ 0 ][ toei ].Y
-                        * Dest_To_FidPoints_Power[ 0 ][ toei ].Z
-
-        + pq[ row + 1 ] * Dest_To_FidPoints_Power[ 1 ][ toei ].X
-                        * Dest_To_FidPoints_Power[ 0 ][ toei ].Y
-                        * Dest_To_FidPoints_Power[ 0 ][ toei ].Z
-         
-        + pq[ row + 2 ] * Dest_To_FidPoints_Power[ 0 ][ toei ].X
-                        * Dest_To_FidPoints_Power[ 1 ][ toei ].Y
-                        * Dest_To_FidPoints_Power[ 0 ][ toei ].Z
-         
-        + pq[ row + 3 ] * Dest_To_FidPoints_Power[ 0 ][ toei ].X
-                        * Dest_To_FidPoints_Power[ 0 ][ toei ].Y
-                        * Dest_To_FidPoints_Power[ 1 ][ toei ].Z;
-
-return  v;
-};
-
-
-auto    Interpolate3DSpline         = [ this ] ( int    toei,   const AVector&  pq )
-{
-int                 maxelfrom   = From_To_FidPoints.GetNumPoints ();
-double              v           = 0;
-
-                                        // K part
-for ( int i = 0; i < maxelfrom; i++ )
-
-    v      += pq[ i ] * Kernel[ toei ][ i ];
-
-                                        // Q part
-for ( int d = 0, row = maxelfrom; d <  SplineDegree; d++ )
-for ( int k = 0;                  k <= d;            k++ )
-for ( int g = 0;                  g <= k;            g++ )
-
-    v      += pq[ row++ ] * Dest_To_FidPoints_Power[ d - k ][ toei ].X
-                          * Dest_To_FidPoints_Power[ k - g ][ toei ].Y
-                          * Dest_To_FidPoints_Power[ g     ][ toei ].Z;
-
-return  v;
-};
+Gauge.SetRange ( gaugeinterpol, exactmaxvalue ? 2 * numblocks : numblocks );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // picking the right lambda
-function<double ( int, const AVector& )>    interpolate;
+                                        // Reading and writing are both done in the background
+TTracksBlocksReader<TTracks<float>> blocksreader;
+TArray2<float>                      eegbout;
+TMapAtomType                        maxvalue        = 0;
 
 
-if      ( InterpolationType == Interpolation2DSurfaceSpline                 )   interpolate     = Interpolate2DSurfaceSpline;
-else if ( InterpolationType == InterpolationSphericalSpline                 )   interpolate     = InterpolateSphericalSpline;
-else if ( InterpolationType == InterpolationSphericalCurrentDensitySpline   )   interpolate     = InterpolateSphericalCurrentDensitySpline;
-else if ( InterpolationType == Interpolation3DSpline && SplineDegree == 2   )   interpolate     = Interpolate3DSpline2;     // optimized version
-else if ( InterpolationType == Interpolation3DSpline && SplineDegree >  2   )   interpolate     = Interpolate3DSpline;      // works for all degrees, including 2
+if ( exactmaxvalue ) {
 
+    eegbout.Resize ( blocksize, maxelto );
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+    blocksreader.Start ( numblocks, numfromtracks, blocksize, ReadBlock );
 
-Gauge.SetRange ( gaugeinterpol, maxtf );
+    for ( int blocki = 0; blocki < numblocks; blocki++ ) {
 
+        Gauge.Next ( gaugeinterpol, SuperGaugeUpdateTitle );
 
-OmpParallelBegin
-                                        // allocate B and X
-AVector                     B ( Am );
-AVector                     X ( An );
-TIteratorSelectedForward    eti;
+        long            numtf           = min ( blocksize, maxtf - blocki * blocksize );
 
-OmpFor
+        ApplyTransfer ( blocksreader.Next (), eegbout );
 
-for ( int tf = 0; tf < maxtf; tf++ ) {
+        for ( long tfi = 0; tfi < numtf;   tfi++ )
+        for ( int  e   = 0; e   < maxelto; e++   )
 
-    Gauge.Next ( gaugeinterpol, SuperGaugeUpdateTitle );
-
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Setting B
-
-                                        // clearing whole vector
-    B.AReset ();
-
-                                        // then transferring the (optionally reduced) "from" data
-    if ( hasfrombadelectrodes ) {
-                                        // TIteratorSelectedForward is thread-safe
-        for ( eti.FirstSelected ( fromgoodsel ); (bool) eti && eti.GetIndex () < maxelfrom; ++eti )
-                // new index                       original from index
-            B[ eti.GetIndex () ]    = datain ( tf, eti() );
+            Maxed ( maxvalue, (TMapAtomType) abs ( eegbout ( tfi, e ) ) );
         }
 
-    else {                              // faster by bypassing fromgoodsel
-                                        // even faster if data types are compatible - note that Armadillo advanced constructors can directly point to some memory, like 'mat(ptr_aux_mem, n_rows, n_cols, copy_aux_mem = true, strict = false)'
-        if ( typeid ( AReal ) == typeid ( TMapAtomType ) )
-            CopyVirtualMemory ( B.memptr (), &datain ( tf, 0 ), datain ( 0 ).GetMemorySize () );
-
-        else                            // ol' loop
-            for ( int ei = 0; ei < maxelfrom; ei++ )
-                B[ ei ] = datain ( tf, ei );
-        }
-
-
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // solving A * X = B, with fast option, thread-safe
-    if ( needtosolve )
-
-        LU.Solve ( X, B );
-
+    blocksreader.Stop ();
 
-    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // using spline & transferring results back
-
-                                        // for each "to" electrode
-    for ( int toei = 0; toei < maxelto; toei++ ) {
-
-                                        // current "Dest" electrode possible geometrical match to a "From" electrode
-        int             desttofromindex     = ToHasSamePositionAsFrom[ toei ];
-
-                                        // decide if we need to interpolate current electrode
-        bool            dosolve             =  desttofromindex == InvalidIndex                                  // is current "Dest" electrode NOT an exact geometrical match to a "From" electrode?
-                                            || fromgoodsel.IsNotSelected ( desttofromindex )                    // or, it might be a match, but is it a bad electrodes?
-                                            || InterpolationType == InterpolationSphericalCurrentDensitySpline; // or are we computing Current Density?
-
-        if ( dosolve )  dataout ( tf, toei )    = interpolate ( toei, X );          // do the actual interpolation now
-        else            dataout ( tf, toei )    = datain ( tf, desttofromindex );   // plain copy of original data: faster and will not introduce rounding errors
-        } // for electrode
-    } // for tf
-
-OmpParallelEnd
+    eegbout.DeallocateMemory ();
+    }
+else
+                                        // only EDF actually uses the max value
+    maxvalue    = eegdoc->GetAbsMaxValue ();
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -1478,8 +1520,8 @@ expfile.SamplingFrequency   = eegdoc->GetSamplingFrequency ();
 expfile.DateTime            = eegdoc->DateTime;
 
 expfile.ElectrodesNames     = DestPointsNames;
-                                        // here we have the exact value
-expfile.MaxValue            = dataout.GetAbsMaxValue (); // eegdoc->GetAbsMaxValue ();
+
+expfile.MaxValue            = maxvalue;
 
 expfile.OutputTriggers      = (ExportTriggers) ( TriggersAsTriggers | MarkersAsMarkers );
 expfile.Markers             = *eegdoc;
@@ -1487,8 +1529,43 @@ expfile.NumTags             = eegdoc->GetNumMarkers ();
 expfile.TimeMin             = 0;
 expfile.TimeMax             = expfile.NumTime - 1;
 
-                                        // this should use some fast disk write
-expfile.Write ( dataout );
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Called from the writing thread - expfile is not used by anyone else until the writer is stopped
+auto    WriteBlock  = [ &expfile ] ( const TArray2<float>& eegbout, long numtf )
+{
+for ( long tfi = 0; tfi < numtf;              tfi++ )
+for ( int  e   = 0; e   < eegbout.GetDim2 (); e++   )
+
+    expfile.Write ( eegbout ( tfi, e ) );
+};
+
+TTracksBlocksWriter<TArray2<float>> blockswriter;
+
+blockswriter.Start ( blocksize, maxelto, WriteBlock );
+
+blocksreader.Start ( numblocks, numfromtracks, blocksize, ReadBlock );
+
+
+for ( int blocki = 0; blocki < numblocks; blocki++ ) {
+
+    Gauge.Next ( gaugeinterpol, SuperGaugeUpdateTitle );
+
+    long            numtf           = min ( blocksize, maxtf - blocki * blocksize );
+
+    ApplyTransfer ( blocksreader.Next (), blockswriter.GetBuffer () );
+
+    blockswriter.Push ( numtf );
+    }
+
+                                        // wait for all the blocks to be written
+blockswriter.Stop ();
+blocksreader.Stop ();
+
+expfile.End ();
+
+
+EEGDoc->SetFiltersStreaming ( oldstreaming );
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
@@ -82,6 +82,9 @@ constexpr int       NumLegendreTermsInterpol        = 51;
 
 constexpr int       RemovingElecMaxSize             = 64 * KiloByte;
 
+                                        // Tracks are interpolated by blocks of time frames, all blocks in memory (input & output, read & written in the background) staying below this size
+constexpr double    InterpolateTracksBlocksMaxMemory    = 64 * MegaByte;
+
 
 //----------------------------------------------------------------------------
                 // Surface Spline formula from:
@@ -130,6 +133,7 @@ void            ComputeKernels              (   TracksInterpolationType interpol
 enum    SavingEegFileTypes;
 class   TTracksDoc;
 class   TGoF;
+class   TSelection;
 
 
 class   TInterpolateTracks
@@ -294,10 +298,14 @@ protected:
     TArray2<double>     Kernel;
     TPoints             Dest_To_FidPoints_Power[ MaxInterpolationDegree ];
     TArray1<int>        ToHasSamePositionAsFrom;
+                                                    // Variables used for actual computation - set once per set of input tracks
+    AMatrix             Transfer;                   // Linear operator from all input tracks to all output tracks
+    uint                TransferChecksum;           // of everything Transfer depends on
 
 
     bool                SetTransformMatrices    ();
     bool                SetSpline               ();
+    bool                SetTransfer             ( const TSelection& fromgoodsel, int numfromtracks );
 
 };
 
@@ -1527,56 +1527,138 @@ void    TMaps::CentroidsToLabeling  (   const TMaps&        data,
 {
 //if ( IsNotAllocated () )
 //    return;
-                                        // pointer to specialized function, according to polarity
-bool    (*keepbestlabeling) ( const TMap&, const TMap&, double&, double )   = polarity == PolarityEvaluate ? &KeepBestLabelingEvaluate : &KeepBestLabelingDirect;
-
                                         // reset only these TFs (important in case of partial labeling)
 labels.Reset ( tfmin, tfmax );
 
 
-if ( mapsel == 0 )
+CentroidsToLabelingBlocks ( data, tfmin, tfmax - tfmin + 1, 0, nclusters, mapsel, labels, polarity, limitcorr );
 
-    OmpParallelFor
-                                        // time can be restricted to an epoch (limits are not tested here)
-    for ( long tf = tfmin; tf <= tfmax; tf++ ) {
+                                        // Update all polarity flags
+labels.UpdatePolarities ( data, tfmin, tfmax, *this, polarity );
+}
 
-        UpdateApplication;
+                                        // Same, but for a scattered set of time frames
+void    TMaps::CentroidsToLabeling  (   const TMaps&        data,
+                                        const TSelection&   tfsel,
+                                        int                 nclusters,
+                                        const TSelection*   mapsel,     TLabeling&      labels,
+                                        PolarityType        polarity,   double          limitcorr
+                                    )   const
+{
+TArray1<long>       tflist ( tfsel.NumSet () );
+long                numtf           = 0;
 
-        double          maxcorr     = Lowest ( maxcorr );
-                                        // most of the time (segmentation) we use all maps
-        for ( int nc = 0; nc < nclusters; nc++ )
+for ( TIteratorSelectedForward tfi ( tfsel ); (bool) tfi; ++tfi ) {
 
-            if ( (*keepbestlabeling) (   Maps[ nc ], data[ tf ],  maxcorr, limitcorr ) )
+    labels.Reset ( tfi() );
 
-                labels.SetLabel ( tf, nc );
+    tflist[ numtf++ ]   = tfi();
+    }
 
-        } // for tf
 
-else
+CentroidsToLabelingBlocks ( data, 0, numtf, &tflist, nclusters, mapsel, labels, polarity, limitcorr );
 
-    OmpParallelFor
-                                        // time can be restricted to an epoch (limits are not tested here)
-    for ( long tf = tfmin; tf <= tfmax; tf++ ) {
 
-        UpdateApplication;
+for ( long i = 0; i < numtf; i++ )
 
-        double          maxcorr     = Lowest ( maxcorr );
-                                        // maps can be restricted to a given subset (fitting)
-//      for ( TIteratorSelectedForward nci ( *mapsel ); (bool) nci; ++nci ) // with thread-safe iterator
-        for ( int nc = 0; nc < nclusters; nc++ )
+    labels.UpdatePolarities ( data, tflist[ i ], tflist[ i ], *this, polarity );
+}
 
-            if ( (*mapsel)[ nc ] )
-                                        
-                if ( (*keepbestlabeling) (   Maps[ nc ], data[ tf ],  maxcorr, limitcorr ) )
 
-                    labels.SetLabel ( tf, nc );
+//----------------------------------------------------------------------------
+                                        // Instead of computing each (data, template) scalar product one at a time, blocks of data maps
+                                        // are correlated to all templates at once through a single matrix product, then the best template
+                                        // is picked per column, with polarity and correlation threshold checks.
+                                        // Data and templates are supposed to be normalized, as in all the micro-states processing.
+                                        // Labels are only set, caller has to reset them before, and update the polarities after
+void    TMaps::CentroidsToLabelingBlocks    (   const TMaps&        data,
+                                                long                tfmin,      long            numtf,      const TArray1<long>*    tflist,
+                                                int                 nclusters,
+                                                const TSelection*   mapsel,     TLabeling&      labels,
+                                                PolarityType        polarity,   double          limitcorr
+                                            )   const
+{
+                                        // maps can be restricted to a given subset (fitting), most of the time (segmentation) we use all maps
+TArray1<int>        seltotemplate ( nclusters );
+int                 numsel          = 0;
+
+for ( int nc = 0; nc < nclusters; nc++ )
+
+    if ( mapsel == 0 || (*mapsel)[ nc ] )
+
+        seltotemplate[ numsel++ ]   = nc;
 
-        } // for tf
+
+if ( numsel == 0 || numtf <= 0 )
+    return;
+
+                                        // all selected templates stacked in a single matrix, one template per row
+AMatrix             templates ( numsel, Dimension );
+
+for ( int seli = 0; seli < numsel; seli++ )
+for ( int dim  = 0; dim  < Dimension; dim++ )
+
+    templates ( seli, dim ) = Maps[ seltotemplate[ seli ] ][ dim ];
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // Update all polarity flags
-labels.UpdatePolarities ( data, tfmin, tfmax, *this, polarity );
+int                 numblocks       = ( numtf + LabelingBlockSize - 1 ) / LabelingBlockSize;
+bool                absolute        = polarity == PolarityEvaluate;
+                                        // only the labeling dimension is used, whatever the actual size of the data maps
+size_t              mapmemorysize   = Dimension * sizeof ( AReal );
+
+
+OmpParallelBegin
+                                        // per-thread block buffers
+AMatrix             datablock;
+AMatrix             corrblock;
+
+OmpFor
+                                        // time can be restricted to an epoch (limits are not tested here)
+for ( int blocki = 0; blocki < numblocks; blocki++ ) {
+
+    UpdateApplication;
+
+    long            i1              = (long) blocki * LabelingBlockSize;
+    int             blocksize       = (int) NoMore ( (long) LabelingBlockSize, numtf - i1 );
+
+                                        // data maps transferred as columns
+    datablock.AResizeFast ( Dimension, blocksize );
+
+    for ( int bi = 0; bi < blocksize; bi++ )
+
+        CopyVirtualMemory ( datablock.colptr ( bi ), data[ tflist ? (*tflist)[ i1 + bi ] : tfmin + i1 + bi ].GetArray (), mapmemorysize );
+
+                                        // all correlations of the block at once
+    corrblock   = templates * datablock;
+
+                                        // best template per data map
+    for ( int bi = 0; bi < blocksize; bi++ ) {
+
+        const AReal*    tocorr          = corrblock.colptr ( bi );
+        double          maxcorr         = Lowest ( maxcorr );
+        int             bestsel         = -1;
+
+        for ( int seli = 0; seli < numsel; seli++ ) {
+                                        // Force to remain within boundaries for safety
+            double          corr            = absolute ? Clip ( fabs ( (double) tocorr[ seli ] ), 0.0, 1.0 )
+                                                       : Clip (        (double) tocorr[ seli ], -1.0, 1.0 );
+
+              // above global limit   locally above all maps
+            if ( corr >= limitcorr && corr > maxcorr ) {
+                maxcorr     = corr;
+                bestsel     = seli;
+                }
+            }
+
+        if ( bestsel >= 0 )
+
+            labels.SetLabel ( tflist ? (*tflist)[ i1 + bi ] : tfmin + i1 + bi, seltotemplate[ bestsel ] );
+        } // for bi
+
+    } // for blocki
+
+OmpParallelEnd
 }
 
 
@@ -3350,18 +3432,9 @@ if ( regularization == RegularizationAutoGlobal ) {
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-int                 numel           = ISDoc->GetNumElectrodes();
-//TArray1<TVector3Float>  vinv ( vectorial ? numsp : 0     );
-
-                                        // multiply and save in big buffer - also converts to scalar at the same time
-for ( int nc = 0; nc < NumMaps; nc++ )
-                                        // dispatch according to results                proper way, using fast transfer
-//  if ( vectorial ) {  ISDoc->MultiplyMatrix ( regularization, Maps[ nc ], vinv );     ESI[ nc ].CopyMemoryFrom ( vinv.GetMemoryAddress () ); }
-//  else                ISDoc->MultiplyMatrix ( regularization, Maps[ nc ], ESI[ nc ] );
-
-                                        // dispatch according to results    a bit hacky but skips any transfer, as we do have interlaced X,Y,Z structure - also MultiplyMatrix only access the data array
-    if ( vectorial )    ISDoc->MultiplyMatrix ( regularization, Maps[ nc ], *(TArray1<TVector3Float>*) &ESI[ nc ] );
-    else                ISDoc->MultiplyMatrix ( regularization, Maps[ nc ], ESI[ nc ] );
+                                        // multiply by blocks of maps and save in big buffer - also converts to scalar at the same time
+                                        // results type is given by the dimension of ESI
+ISDoc->MultiplyMatrices ( regularization, *this, ESI );
 
                                         // the one that has been used
 return  regularization;
@@ -3493,14 +3566,18 @@ if ( ! IsZScoreSigned ( how ) )
 
 bool                scanmaxes       = how & ZScoreMaxData;
 int                 dimension       = Dimension;
-TEasyStats          stat ( scanmaxes ? NumMaps / 2 : NumMaps );
-double              center;
-double              sd;
 
 
 zscorevalues.Resize ( NumZValuesCalibration, dimension );
 
                                         // ZScoreSigned_CenterScale is the only case here
+OmpParallelBegin
+                                        // stats are local to each thread
+TEasyStats          stat ( scanmaxes ? NumMaps / 2 : NumMaps );
+double              center;
+double              sd;
+
+OmpForDynamic
 
 for ( int e = 0; e < dimension; e++ ) {
 
@@ -3553,6 +3630,7 @@ for ( int e = 0; e < dimension; e++ ) {
         
     } // for dimension
 
+OmpParallelEnd
 }
 
 
@@ -3595,6 +3673,36 @@ for ( int e = 0; e < dimension; e++ ) {
 }
 
 
+//----------------------------------------------------------------------------
+                                        // Optimal resampling size for a given number of data, then drawing the indexes of the 2 rounds of resampling, for the center then the spread
+                                        // When all dimensions have the same number of data, these draws can be shared by all of them
+void    GetZScoreResamplingIndexes  (   int                 numdata,        int     numresampling, 
+                                        TResampling&        resampling,     TArray2<int>&   randindexes,
+                                        TRandUniform&       randunif 
+                                    )
+{
+resampling.SetNumData       ( numdata );
+
+resampling.SetNumResampling ( numresampling );
+
+resampling.GetSampleSize    ( TMapsResamplingCoverage, TMapsMinSampleSize, Round ( resampling.NumData * TMapsMaxSampleSizeRatio ) );
+
+
+randindexes.Resize ( 2 * numresampling, AtLeast ( 1, resampling.SampleSize ) );
+
+TVector<int>        randindex;
+int                 numdrawn        = NoMore ( resampling.SampleSize, numdata );    // any remaining indexes stay at 0
+
+for ( int i = 0; i < 2 * numresampling; i++ ) {
+
+    randindex.RandomSeries ( numdrawn, numdata, &randunif );
+
+    for ( int j = 0; j < numdrawn; j++ )
+        randindexes ( i, j )    = randindex[ j ];
+    }
+}
+
+
 //----------------------------------------------------------------------------
                                         // Standardizing the norm of 3D vectors (scalar, positive data)
 void    TMaps::ComputeZScorePositive    (   ZScoreType  how,    TArray2<float>&     zscorevalues    )   const
@@ -3611,30 +3719,47 @@ if ( ! IsZScorePositive ( how ) )
 
 bool                scanmaxes       = how & ZScoreMaxData;
 int                 dimensionsp     = Dimension;
-TEasyStats          stat    ( scanmaxes ? NumMaps / 2 : NumMaps );
-double              norm;
-TArray1<double>     normal  ( NumMaps );
-double              center;
-double              sd;
-TRandUniform        randunif;
 
-TResampling         resampling;
 #if defined (_DEBUG)
 int                 numresampling       = 1;
 #else
 int                 numresampling       = TMapsNumResampling;
 #endif
-TEasyStats          statcenter ( NumMaxModeRobustEstimates * numresampling );   // using 4 estimators for the center
-TEasyStats          statsd     ( 1 * numresampling );   // using only 1 estimator for the spreading
-TEasyStats          substats;
-TVector<int>        randindex;
                                         // caller can be specific about the dimensions, it could be 6 in case of vectorial ris from complex data
                                         // otherwise assumes dimensions are 3 (though better if specified by the caller)
 double              (*vectornormtonormal) ( double )    = how & ZScoreDimension6 ? Vector6NormToNormal : Vector3NormToNormal;
 
+                                        // without scanning for maxes, all solution points have the same amount of data, and can share the same resampling draws
+TResampling         sharedresampling;
+TArray2<int>        sharedrandindexes;
+
+if ( ! scanmaxes && ! ( how & ZScorePositive_NocenterScale ) ) {
+
+    TRandUniform        randunif;
+
+    GetZScoreResamplingIndexes ( NumMaps, numresampling, sharedresampling, sharedrandindexes, randunif );
+    }
+
 
 zscorevalues.Resize ( NumZValuesCalibration, dimensionsp );
 
+
+OmpParallelBegin
+                                        // stats and buffers are local to each thread
+TEasyStats          stat    ( scanmaxes ? NumMaps / 2 : NumMaps );
+double              norm;
+TArray1<double>     normal  ( NumMaps );
+double              center;
+double              sd;
+TRandUniform        randunif;
+
+TResampling         localresampling;
+TArray2<int>        localrandindexes;
+TEasyStats          statcenter ( NumMaxModeRobustEstimates * numresampling );   // using 4 estimators for the center
+TEasyStats          statsd     ( 1 * numresampling );   // using only 1 estimator for the spreading
+TEasyStats          substats;
+
+OmpForDynamic
                                         // work on the norm of vector
 for ( int e = 0; e < dimensionsp; e++ ) {
 
@@ -3689,24 +3814,24 @@ for ( int e = 0; e < dimensionsp; e++ ) {
 //      center      = stat.Mean ();                 // regular Z-Score
 //      center      = min ( stat.MaxModeHRM (), stat.MaxModeHistogram () );
 
-                                        // getting the optimal resampling size - could be done per electrode
-        if ( e == 0 || scanmaxes ) {
+                                        // getting the optimal resampling size, and the resampling draws themselves
+        bool                shareddraws     = sharedrandindexes.IsAllocated () && stat.GetNumItems () == NumMaps;
 
-            resampling.SetNumData       ( stat.GetNumItems () );
+        if ( ! shareddraws )
 
-            resampling.SetNumResampling ( numresampling );
+            GetZScoreResamplingIndexes ( stat.GetNumItems (), numresampling, localresampling, localrandindexes, randunif );
 
-            resampling.GetSampleSize    ( TMapsResamplingCoverage, TMapsMinSampleSize, Round ( resampling.NumData * TMapsMaxSampleSizeRatio ) );
-            }
+        const TResampling&  resampling      = shareddraws ? sharedresampling  : localresampling;
+        const TArray2<int>& randindexes     = shareddraws ? sharedrandindexes : localrandindexes;
 
 
         statcenter.Reset ();
                                         // resampling & using for different stats at the same time
         for ( int i = 0; i < numresampling; i++ ) {
 
-            stat.Resample ( substats, resampling.SampleSize, randindex, &randunif );
+            stat.Resample ( substats, resampling.SampleSize, randindexes[ i ] );
                                         // cumulate estimates
-            substats.MaxModeRobust ( statcenter );
+            substats.MaxModeRobust ( statcenter, ThreadSafetyIgnore );
             }
 
         center      = statcenter.Median ( false );
@@ -3727,7 +3852,7 @@ for ( int e = 0; e < dimensionsp; e++ ) {
                                         // resampling & using for different stats at the same time
         for ( int i = 0; i < numresampling; i++ ) {
 
-            stat.Resample ( substats, resampling.SampleSize, randindex, &randunif );
+            stat.Resample ( substats, resampling.SampleSize, randindexes[ numresampling + i ] );
 
                                         // optimal on the left part of center - the background activity should be only here
             substats.MADLeft    ( center, madleft );
@@ -3780,6 +3905,7 @@ for ( int e = 0; e < dimensionsp; e++ ) {
 
     } // for dimension
 
+OmpParallelEnd
 }
 
 
@@ -3913,23 +4039,23 @@ if      ( how & ZScoreVectorial_CenterScaleByComponent ) {
 
 bool                scanmaxes       = how & ZScoreMaxData;
 int                 dimensionsp     = Dimension / 3;
-TEasyStats          stat    ( scanmaxes ? NumMaps / 2 : NumMaps );
-double              norm;
-TArray1<double>     normal ( NumMaps );
-double              center;
-double              sd;
-TRandUniform        randunif;
 
-TResampling         resampling;
 #if defined (_DEBUG)
 int                 numresampling       = 1;
 #else
 int                 numresampling       = TMapsNumResampling;
 #endif
-TEasyStats          statcenter ( NumMaxModeRobustEstimates * numresampling );
-TEasyStats          statsd     ( 1 * numresampling );
-TEasyStats          substats;
-TVector<int>        randindex;
+
+                                        // without scanning for maxes, all solution points have the same amount of data, and can share the same resampling draws
+TResampling         sharedresampling;
+TArray2<int>        sharedrandindexes;
+
+if ( ! scanmaxes && ( how & ZScoreVectorial_CenterVectors_CenterScale ) ) {
+
+    TRandUniform        randunif;
+
+    GetZScoreResamplingIndexes ( NumMaps, numresampling, sharedresampling, sharedrandindexes, randunif );
+    }
 
 
 //if ( how & ( ZScoreVectorial_CenterVectors_CenterScale 
@@ -3940,11 +4066,30 @@ TVector<int>        randindex;
 
 zscorevalues.Resize ( NumZValuesCalibration, dimensionsp );
 
+
+OmpParallelBegin
+                                        // stats and buffers are local to each thread
+TEasyStats          stat    ( scanmaxes ? NumMaps / 2 : NumMaps );
+double              norm;
+TArray1<double>     normal ( NumMaps );
+double              center;
+double              sd;
+TRandUniform        randunif;
+
+TResampling         localresampling;
+TArray2<int>        localrandindexes;
+TEasyStats          statcenter ( NumMaxModeRobustEstimates * numresampling );
+TEasyStats          statsd     ( 1 * numresampling );
+TEasyStats          substats;
+
+OmpForDynamic
                                         // work on the norm of vector
-for ( int e1 = 0, e3 = 0; e1 < dimensionsp; e1++, e3 += 3 ) {
+for ( int e1 = 0; e1 < dimensionsp; e1++ ) {
 
     UpdateApplication;
 
+    int                 e3              = 3 * e1;
+
                                         // Once centered, we look for the spreading, but norm is skewed, so un-skew first
     for ( int nc = 0; nc < NumMaps; nc++ ) {
                                         // recover & Deskew the norms of the vectors
@@ -3996,24 +4141,24 @@ for ( int e1 = 0, e3 = 0; e1 < dimensionsp; e1++, e3 += 3 ) {
 //      sd          = stat.SD   ();
 //      sd          = stat.InterQuartileRange ();
 
-                                        // getting the optimal resampling size - could be done per electrode
-        if ( e1 == 0 || scanmaxes ) {
+                                        // getting the optimal resampling size, and the resampling draws themselves
+        bool                shareddraws     = sharedrandindexes.IsAllocated () && stat.GetNumItems () == NumMaps;
 
-            resampling.SetNumData       ( stat.GetNumItems () );
+        if ( ! shareddraws )
 
-            resampling.SetNumResampling ( numresampling );
+            GetZScoreResamplingIndexes ( stat.GetNumItems (), numresampling, localresampling, localrandindexes, randunif );
 
-            resampling.GetSampleSize    ( TMapsResamplingCoverage, TMapsMinSampleSize, Round ( resampling.NumData * TMapsMaxSampleSizeRatio ) );
-            }
+        const TResampling&  resampling      = shareddraws ? sharedresampling  : localresampling;
+        const TArray2<int>& randindexes     = shareddraws ? sharedrandindexes : localrandindexes;
 
 
         statcenter.Reset ();
                                         // resampling & using for different stats at the same time
         for ( int i = 0; i < numresampling; i++ ) {
 
-            stat.Resample ( substats, resampling.SampleSize, randindex, &randunif );
+            stat.Resample ( substats, resampling.SampleSize, randindexes[ i ] );
                                         // cumulate estimates
-            substats.MaxModeRobust ( statcenter );
+            substats.MaxModeRobust ( statcenter, ThreadSafetyIgnore );
             }
 
         center      = statcenter.Median ( false );
@@ -4027,7 +4172,7 @@ for ( int e1 = 0, e3 = 0; e1 < dimensionsp; e1++, e3 += 3 ) {
                                         // resampling & using for different stats at the same time
         for ( int i = 0; i < numresampling; i++ ) {
 
-            stat.Resample ( substats, resampling.SampleSize, randindex, &randunif );
+            stat.Resample ( substats, resampling.SampleSize, randindexes[ numresampling + i ] );
 
                                         // optimal on the left part of center - the background activity should be only here
             substats.MADLeft    ( center, madleft );
@@ -4056,6 +4201,7 @@ for ( int e1 = 0, e3 = 0; e1 < dimensionsp; e1++, e3 += 3 ) {
 
     } // for dimension
 
+OmpParallelEnd
 }
 
 
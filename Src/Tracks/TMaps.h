@@ -47,6 +47,8 @@ double      Project                     ( const TMaps&  maps1,  const TMaps&  ma
 
 constexpr int       MedoidNumSamples            = 1033;
 constexpr int       LabelingNumSamples          =  599;
+                                        // Number of data maps correlated at once to all templates, during the labeling
+constexpr int       LabelingBlockSize           =  256;
 
 
 TMap        ComputeCentroid             (   const TArray1<TMap*>&   allmaps,
@@ -234,6 +236,7 @@ public:
 
                                         // Functions used during segmentation / fitting
     void            CentroidsToLabeling         ( const TMaps& data, long tfmin, long tfmax, int nclusters, const TSelection *mapsel, TLabeling& labels, PolarityType polarity, double limitcorr )   const;
+    void            CentroidsToLabeling         ( const TMaps& data, const TSelection& tfsel,  int nclusters, const TSelection *mapsel, TLabeling& labels, PolarityType polarity, double limitcorr )   const;   // only the selected time frames
     void            LabelingToCentroids         ( const TMaps& data, const TArray1<TMap *>* todata, int nclusters, TLabeling& labels, PolarityType polarity, CentroidType centroid, bool ranking, bool updatepolarity = true );
 
     TMap            ComputeCentroid             ( CentroidType centroid, AtomType datatype, PolarityType polarity, int maxsamples = MedoidNumSamples, TLabeling* labels = 0, int l = UndefinedLabel, const TMap* ref = 0 )    const;
@@ -290,6 +293,9 @@ protected:
     int             Dimension;
     double          SamplingFrequency;  // in Hertz
 
+                                        // labeling kernel of the CentroidsToLabeling, for tfmin..tfmin+numtf-1, or the numtf time frames listed in tflist
+    void            CentroidsToLabelingBlocks   ( const TMaps& data, long tfmin, long numtf, const TArray1<long>* tflist, int nclusters, const TSelection *mapsel, TLabeling& labels, PolarityType polarity, double limitcorr )   const;
+
 
 private:
 
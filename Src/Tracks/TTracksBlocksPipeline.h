@@ -0,0 +1,387 @@
+/************************************************************************\
+ 2024-2025 Denis Brunet, University of Geneva, Switzerland.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+\************************************************************************/
+
+#pragma once
+
+#include    <thread>
+#include    <mutex>
+#include    <condition_variable>
+#include    <functional>
+#include    <vector>
+
+#include    "CartoolTypes.h"
+#include    "Math.Utils.h"
+
+namespace crtl {
+
+//----------------------------------------------------------------------------
+                                        // Pipelined processing of blocks of tracks, to overlap file I/O with computation
+                                        //  - TTracksBlocksReader: a background thread reads the next block(s) while the caller processes the current one
+                                        //  - TTracksBlocksWriter: the caller fills a block, then a background thread writes it while the next one is being processed
+                                        // Both use a bounded ring of buffers, so memory stays under control.
+                                        // Reading / writing functions are run from the background thread, so they should not touch the UI,
+                                        // nor anything the caller is using in the meantime. Note that TTracksDoc::GetTracks is already serialized
+                                        // with the document reading lock, in case some views are refreshing at the same time.
+
+                                        // Default ring size: 1 block being processed + 1 block being read / written
+constexpr int       TracksBlocksPipelineDepth   = 2;
+                                        // Max memory for all the buffers of the pipelines, the ones being processed included
+constexpr size_t    TracksBlocksPipelineMaxMemory   = 1024 * MegaByte;
+
+                                        // Number of buffers per ring, from the memory of 1 block summed across all the rings in use:
+                                        // the default depth if all the in-flight buffers fit in the budget, otherwise a single buffer,
+                                        // which takes the same memory as the plain, non-pipelined processing
+inline int          TracksBlocksPipelineNumBuffers  ( double blockmemory )  { return  blockmemory * TracksBlocksPipelineDepth <= TracksBlocksPipelineMaxMemory ? TracksBlocksPipelineDepth : 1; }
+
+
+//----------------------------------------------------------------------------
+
+template <class TypeBuffer>
+class   TTracksBlocksReader
+{
+public:
+                    TTracksBlocksReader ();
+                   ~TTracksBlocksReader ();
+
+                                        // Function filling buffer with the content of block blocki - buffer has been allocated to the Start dimensions
+    using           ReadBlockFunc       = std::function< void ( int blocki, TypeBuffer& buffer ) >;
+
+
+    bool            IsRunning           ()  const           { return Thread.joinable (); }
+
+    void            Start               ( int numblocks, int dim1, int dim2, ReadBlockFunc readblock, int numbuffers = TracksBlocksPipelineDepth );
+    TypeBuffer&     Next                ();     // waits for the next block, in sequential order - the block previously returned is given back to the reading thread
+    void            Stop                ();     // can be called at any time, aborting any remaining reading
+
+
+protected:
+
+    std::vector<TypeBuffer> Buffers;
+    ReadBlockFunc           ReadBlock;
+
+    int                     NumBlocks;
+    int                     NumRead;        // blocks [0..NumRead) are available to caller
+    int                     NumDelivered;   // blocks [0..NumDelivered) have been returned to caller
+    int                     NumReleased;    // blocks [0..NumReleased) are done with, their buffers can be re-used
+    bool                    Aborting;
+
+    std::thread             Thread;
+    std::mutex              Lock;
+    std::condition_variable Changed;
+
+
+    void            Run                 ();
+};
+
+
+//----------------------------------------------------------------------------
+
+template <class TypeBuffer>
+class   TTracksBlocksWriter
+{
+public:
+                    TTracksBlocksWriter ();
+                   ~TTracksBlocksWriter ();
+
+                                        // Function writing the first numtf time frames of buffer
+    using           WriteBlockFunc      = std::function< void ( const TypeBuffer& buffer, long numtf ) >;
+
+
+    bool            IsRunning           ()  const           { return Thread.joinable (); }
+
+    void            Start               ( int dim1, int dim2, WriteBlockFunc writeblock, int numbuffers = TracksBlocksPipelineDepth );
+    TypeBuffer&     GetBuffer           ();     // waits for a free buffer, for the caller to fill
+    void            Push                ( long numtf ); // gives the filled buffer to the writing thread
+    void            Flush               ();     // waits for all pushed blocks to be written
+    void            Stop                ();     // flushes, then ends the writing thread
+
+
+protected:
+
+    std::vector<TypeBuffer> Buffers;
+    std::vector<long>       NumTf;
+    WriteBlockFunc          WriteBlock;
+
+    int                     NumPushed;      // blocks [0..NumPushed) have been filled by caller
+    int                     NumWritten;     // blocks [0..NumWritten) have been written, their buffers can be re-used
+    bool                    Finishing;
+
+    std::thread             Thread;
+    std::mutex              Lock;
+    std::condition_variable Changed;
+
+
+    void            Run                 ();
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+                                        // Implementation
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+template <class TypeBuffer>
+        TTracksBlocksReader<TypeBuffer>::TTracksBlocksReader ()
+{
+NumBlocks       = 0;
+NumRead         = 0;
+NumDelivered    = 0;
+NumReleased     = 0;
+Aborting        = false;
+}
+
+
+template <class TypeBuffer>
+        TTracksBlocksReader<TypeBuffer>::~TTracksBlocksReader ()
+{
+Stop ();
+}
+
+
+//----------------------------------------------------------------------------
+template <class TypeBuffer>
+void    TTracksBlocksReader<TypeBuffer>::Start ( int numblocks, int dim1, int dim2, ReadBlockFunc readblock, int numbuffers )
+{
+Stop ();
+
+NumBlocks       = AtLeast ( 0, numblocks );
+NumRead         = 0;
+NumDelivered    = 0;
+NumReleased     = 0;
+Aborting        = false;
+ReadBlock       = readblock;
+
+                                        // no need for more buffers than blocks
+Buffers.resize ( Clip ( numbuffers, 1, AtLeast ( 1, NumBlocks ) ) );
+
+for ( auto& buffer : Buffers )
+    buffer.Resize ( dim1, dim2 );
+
+
+if ( NumBlocks > 0 )
+    Thread      = std::thread ( &TTracksBlocksReader<TypeBuffer>::Run, this );
+}
+
+
+template <class TypeBuffer>
+void    TTracksBlocksReader<TypeBuffer>::Stop ()
+{
+if ( ! Thread.joinable () )
+    return;
+
+{
+std::lock_guard<std::mutex>     lock ( Lock );
+
+Aborting    = true;
+}
+
+Changed.notify_all ();
+
+Thread.join ();
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Reading thread
+template <class TypeBuffer>
+void    TTracksBlocksReader<TypeBuffer>::Run ()
+{
+int                 numbuffers      = (int) Buffers.size ();
+
+for ( int blocki = 0; blocki < NumBlocks; blocki++ ) {
+                                        // wait for a free buffer
+    {
+    std::unique_lock<std::mutex>    lock ( Lock );
+
+    Changed.wait ( lock, [ this, blocki, numbuffers ] { return Aborting || blocki < NumReleased + numbuffers; } );
+
+    if ( Aborting )
+        return;
+    }
+
+                                        // the actual reading is done outside the lock
+    ReadBlock ( blocki, Buffers[ blocki % numbuffers ] );
+
+
+    {
+    std::lock_guard<std::mutex>     lock ( Lock );
+
+    NumRead     = blocki + 1;
+    }
+
+    Changed.notify_all ();
+    }
+}
+
+
+//----------------------------------------------------------------------------
+template <class TypeBuffer>
+TypeBuffer&     TTracksBlocksReader<TypeBuffer>::Next ()
+{
+std::unique_lock<std::mutex>    lock ( Lock );
+
+                                        // caller is done with the block previously returned
+NumReleased     = NumDelivered;
+
+Changed.notify_all ();
+
+                                        // wait for the next block to be read
+Changed.wait ( lock, [ this ] { return Aborting || NumDelivered < NumRead; } );
+
+
+return  Buffers[ NumDelivered++ % Buffers.size () ];
+}
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+template <class TypeBuffer>
+        TTracksBlocksWriter<TypeBuffer>::TTracksBlocksWriter ()
+{
+NumPushed       = 0;
+NumWritten      = 0;
+Finishing       = false;
+}
+
+
+template <class TypeBuffer>
+        TTracksBlocksWriter<TypeBuffer>::~TTracksBlocksWriter ()
+{
+Stop ();
+}
+
+
+//----------------------------------------------------------------------------
+template <class TypeBuffer>
+void    TTracksBlocksWriter<TypeBuffer>::Start ( int dim1, int dim2, WriteBlockFunc writeblock, int numbuffers )
+{
+Stop ();
+
+NumPushed       = 0;
+NumWritten      = 0;
+Finishing       = false;
+WriteBlock      = writeblock;
+
+Buffers.resize ( AtLeast ( 1, numbuffers ) );
+NumTf  .resize ( Buffers.size () );
+
+for ( auto& buffer : Buffers )
+    buffer.Resize ( dim1, dim2 );
+
+
+Thread      = std::thread ( &TTracksBlocksWriter<TypeBuffer>::Run, this );
+}
+
+
+template <class TypeBuffer>
+void    TTracksBlocksWriter<TypeBuffer>::Stop ()
+{
+if ( ! Thread.joinable () )
+    return;
+
+{
+std::lock_guard<std::mutex>     lock ( Lock );
+
+Finishing   = true;
+}
+
+Changed.notify_all ();
+                                        // any remaining blocks will be written before the thread ends
+Thread.join ();
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Writing thread
+template <class TypeBuffer>
+void    TTracksBlocksWriter<TypeBuffer>::Run ()
+{
+int                 numbuffers      = (int) Buffers.size ();
+
+do {
+    int             blocki;
+
+    {
+    std::unique_lock<std::mutex>    lock ( Lock );
+
+    Changed.wait ( lock, [ this ] { return Finishing || NumWritten < NumPushed; } );
+
+    if ( NumWritten == NumPushed )      // Finishing, and nothing left to write
+        return;
+
+    blocki      = NumWritten;
+    }
+
+                                        // the actual writing is done outside the lock
+    WriteBlock ( Buffers[ blocki % numbuffers ], NumTf[ blocki % numbuffers ] );
+
+
+    {
+    std::lock_guard<std::mutex>     lock ( Lock );
+
+    NumWritten  = blocki + 1;
+    }
+
+    Changed.notify_all ();
+
+    } while ( true );
+}
+
+
+//----------------------------------------------------------------------------
+template <class TypeBuffer>
+TypeBuffer&     TTracksBlocksWriter<TypeBuffer>::GetBuffer ()
+{
+std::unique_lock<std::mutex>    lock ( Lock );
+
+                                        // wait for the oldest buffer to be written
+Changed.wait ( lock, [ this ] { return NumPushed - NumWritten < (int) Buffers.size (); } );
+
+
+return  Buffers[ NumPushed % Buffers.size () ];
+}
+
+
+template <class TypeBuffer>
+void    TTracksBlocksWriter<TypeBuffer>::Push ( long numtf )
+{
+{
+std::lock_guard<std::mutex>     lock ( Lock );
+
+NumTf[ NumPushed % NumTf.size () ]  = numtf;
+
+NumPushed++;
+}
+
+Changed.notify_all ();
+}
+
+
+template <class TypeBuffer>
+void    TTracksBlocksWriter<TypeBuffer>::Flush ()
+{
+std::unique_lock<std::mutex>    lock ( Lock );
+
+Changed.wait ( lock, [ this ] { return NumWritten == NumPushed; } );
+}
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+}
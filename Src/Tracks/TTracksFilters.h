@@ -48,6 +48,9 @@ constexpr int       EegMinLowFilterSide             = 25;
 
 constexpr int       MaxNotches                      = 32;
 
+                                        // Upper limit for all the interleaved buffers used by the multi-tracks temporal filtering - above that, each track is filtered in place
+constexpr size_t    TracksFiltersInterleavedMaxMemory   = 512 * MegaByte;
+
                                         // Filters can be qualified as temporal and non-temporal
                                         // Non-temporal filters run faster, as the temporal ones will need additional data margins
                                         // We also used to differentiate between filters that happen before vs after the re-referencing, but now it is all wrapped up in ApplyFilters
@@ -197,6 +200,15 @@ public:
                                                 FilterPrecedence    filterprecedence
                                             );
 
+                                        // Streaming of consecutive blocks - only for the pre-reference temporal filters
+                                        // Envelope needs margins on both sides of the re-referenced data, and a Baseline without High Pass is really meant per block
+    bool            CanStream               ()  const   { return HasTemporalFilter () && ! HasEnvelope () && ! ( HasBaseline () && ! HasButterworthHigh () ); }
+    int             GetStreamStateSize      ()  const;                                  // states size needed for each track
+    void            ApplyTemporalFiltersStream (TArray2<TypeD>&     data,       int                 numel,      
+                                                long                numtf,      int                 lookahead,      int     tfoffset,
+                                                TArray2<double>&    states,     const TSelection*   auxtracks
+                                            );
+
 
                     TTracksFilters          ( const TTracksFilters &op  );
     TTracksFilters& operator    =           ( const TTracksFilters &op2 );
@@ -222,6 +234,64 @@ private:
 };
 
 
+//----------------------------------------------------------------------------
+                                        // Sequential streaming of the temporal filters, for callers reading a file block after block:
+                                        //  - filters states are carried from one block to the next one, so there is no need for a left margin anymore
+                                        //  - the raw look-ahead data are kept, so each time frame is read only once from the file
+                                        //  - the raw tail of the previous block is also kept, so the end of file can be mirrored across blocks, like MirrorData does
+                                        //  - non-causal filters still need some data "from the future", which is bounded by the usual safe margin
+                                        // Streaming is started by a regular call with margins on both sides, then continues as long as blocks are contiguous
+template <class TypeD>
+class   TTracksFiltersStream
+{
+public:
+                    TTracksFiltersStream ()             { Active = false; Reset (); }
+
+
+    bool            IsActive                ()  const   { return Active; }
+    void            SetActive               ( bool active )     { Active = active; Reset (); }
+    void            Reset                   ();         // forget about any previous block - Active state remains
+
+    bool            CanContinue             ( const TTracksFilters<TypeD>& filters, long tf1, int numel, int margin )   const;
+    long            GetFirstTf              ()  const   { return FirstTf;   }   // first TF of the block which started the stream
+    int             GetNumBlocks            ()  const   { return NumBlocks; }   // blocks processed since the stream started
+
+                                        // Starting the stream - data was retrieved with TTracksFiltersLimits, with a margin on each side, at offset 0
+    void            Start                   (   const TTracksFilters<TypeD>& filters,
+                                                TArray2<TypeD>&     data,       int                 numel,
+                                                long                numtf,      int                 margin,
+                                                long                nexttf,     int                 numrawlookahead,
+                                                const TSelection*   auxtracks
+                                            );
+                                        // Continuing the stream - data should be at least numtf + margin long
+    int             RestoreLookAhead        ( TArray2<TypeD>& data, int numel, int tfoffset )   const;  // copy back the raw look-ahead at the beginning of the new block, returns its size
+    void            Continue                (   const TTracksFilters<TypeD>& filters,
+                                                TArray2<TypeD>&     data,       int                 numel,
+                                                long                tf1,        long                tf2,            int     tfoffset,
+                                                long                numtimeframes,
+                                                const TSelection*   auxtracks
+                                            );
+
+protected:
+
+    bool            Active;
+    long            NextTf;             // expected first TF of the next block, or -1
+    long            FirstTf;
+    int             NumBlocks;
+    int             NumElectrodes;
+    int             Margin;
+    int             NumRawLookAhead;    // actual raw data stored in LookAhead, which can be less than Margin at the end of file
+
+    TArray2<double> States;             // [numel][statesize] all filters states, per track
+    TArray2<TypeD>  LookAhead;          // [numel][margin]    raw data following the last block
+    TArray2<TypeD>  RawTail;            // [numel][margin]    raw data ending the last block, RawTail ( el, margin - 1 ) being at NextTf - 1
+
+
+    void            SaveLookAhead           ( const TArray2<TypeD>& data, int numel, int tfoffset, int numrawlookahead );
+    void            SaveRawTail             ( const TArray2<TypeD>& data, int numel, int tfoffset, long numtf );
+};
+
+
 //----------------------------------------------------------------------------
 // Implementation
 //----------------------------------------------------------------------------
@@ -943,12 +1013,79 @@ if ( filterprecedence == NoFilter && ! HasReference ( reference ) )
     return;
 
 
+bool                dotemporalfilters   = IsFlag ( filterprecedence, FilterTemporal ) && ( HasBaseline () || HasButterworthBand () || HasButterworthHigh () || HasButterworthLow () || HasNotches () );
+
+                                        // Temporal filters are run on groups of TFilterNumLanes tracks at once, skipping the auxiliaries
+                                        // Interleaving needs a private buffer per thread, which could be too big for very long blocks
+bool                dointerleaved       = dotemporalfilters 
+                                       && (size_t) numtf * TFilterNumLanes * sizeof ( TypeD ) * GetNumMaxThreads () <= TracksFiltersInterleavedMaxMemory;
+
+TArray1<int>        temporaltracks ( dointerleaved ? numel : 0 );
+int                 numtemporaltracks   = 0;
+
+if ( dointerleaved )
+
+    for ( int el = 0; el < numel; el++ )
+
+        if ( ! ( auxtracks && auxtracks->IsSelected ( el ) ) )
+
+            temporaltracks[ numtemporaltracks++ ]   = el;
+
+int                 numtemporalgroups   = ( numtemporaltracks + TFilterNumLanes - 1 ) / TFilterNumLanes;
+
+
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // Put everything in a big parallel block
 OmpParallelBegin
 
                                         // Pre-Reference, Temporal filters
-if ( IsFlag ( filterprecedence, FilterTemporal ) && ( HasBaseline () || HasButterworthBand () || HasButterworthHigh () || HasButterworthLow () || HasNotches () ) ) {
+if ( dointerleaved ) {
+                                        // Allocate private objects - interleaved tracks [numtf][TFilterNumLanes]
+    TArray1<TypeD>          lanes ( (int) numtf * TFilterNumLanes );
+    TypeD*                  tolanes         = lanes.GetArray ();
+
+    OmpFor
+
+    for ( int gi = 0; gi < numtemporalgroups; gi++ ) {
+
+        int             firsttrack      = gi * TFilterNumLanes;
+        int             numlanes        = min ( TFilterNumLanes, numtemporaltracks - firsttrack );
+
+                                        // interleave - missing lanes of the last group are simply set to 0
+        for ( int l = 0; l < TFilterNumLanes; l++ ) {
+
+            const TypeD*    toeeg       = l < numlanes ? data[ temporaltracks[ firsttrack + l ] ] + tfoffset : 0;
+
+            for ( long ti = 0; ti < numtf; ti++ )
+                tolanes[ ti * TFilterNumLanes + l ] = toeeg ? toeeg[ ti ] : 0;
+            }
+
+                                        // !Always before High Pass!
+        if      ( HasBaseline ()        )   FilterBaseline.ApplyInterleaved            ( tolanes, numtf );
+
+                                        // force Band Pass
+        if      ( HasButterworthBand () )   FilterButterworthBandPass.ApplyInterleaved ( tolanes, numtf );
+
+        else if ( HasButterworthHigh () )   FilterButterworthHighPass.ApplyInterleaved ( tolanes, numtf );
+
+        else if ( HasButterworthLow  () )   FilterButterworthLowPass .ApplyInterleaved ( tolanes, numtf );
+
+
+        if      ( HasNotches ()         )   FilterNotches.ApplyInterleaved             ( tolanes, numtf );
+
+                                        // de-interleave
+        for ( int l = 0; l < numlanes; l++ ) {
+
+            TypeD*          toeeg       = data[ temporaltracks[ firsttrack + l ] ] + tfoffset;
+
+            for ( long ti = 0; ti < numtf; ti++ )
+                toeeg[ ti ] = tolanes[ ti * TFilterNumLanes + l ];
+            }
+        } // for group
+
+    } // FilterTemporal interleaved
+
+else if ( dotemporalfilters ) {
 
     OmpFor
 
@@ -1053,6 +1190,69 @@ OmpParallelEnd
 }
 
 
+//----------------------------------------------------------------------------
+                                        // Concatenation of the states of all temporal filters, in the same order as in ApplyTemporalFiltersStream
+template <class TypeD>
+int     TTracksFilters<TypeD>::GetStreamStateSize ()  const
+{
+if ( ! CanStream () )
+    return  0;
+
+
+int                 statesize       = 0;
+
+if      ( HasBaseline ()        )   statesize  += FilterBaseline.GetStreamStateSize ();
+
+if      ( HasButterworthBand () )   statesize  += FilterButterworthBandPass.GetStreamStateSize ();
+else if ( HasButterworthHigh () )   statesize  += FilterButterworthHighPass.GetStreamStateSize ();
+else if ( HasButterworthLow  () )   statesize  += FilterButterworthLowPass .GetStreamStateSize ();
+
+if      ( HasNotches ()         )   statesize  += FilterNotches.GetStreamStateSize ();
+
+return  statesize;
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Streaming counterpart of the pre-reference temporal filters of ApplyFilters
+                                        // data holds numtf + lookahead time frames from tfoffset, states holds the states from the previous block
+template <class TypeD>
+void    TTracksFilters<TypeD>::ApplyTemporalFiltersStream ( TArray2<TypeD>&     data,       int                 numel,      
+                                                            long                numtf,      int                 lookahead,      int     tfoffset,
+                                                            TArray2<double>&    states,     const TSelection*   auxtracks
+                                                          )
+{
+if ( ! CanStream () )
+    return;
+
+
+OmpParallelFor
+
+for ( int el = 0; el < numel; el++ ) {
+
+    if ( auxtracks && auxtracks->IsSelected ( el ) )
+        continue;
+
+
+    TypeD*          toeeg           = data  [ el ] + tfoffset;
+    double*         tostate         = states[ el ];
+
+                                        // !Always before High Pass!
+    if      ( HasBaseline ()        ) { FilterBaseline.ApplyStream            ( toeeg, numtf, lookahead, tostate );     tostate    += FilterBaseline.GetStreamStateSize ();            }
+
+                                        // force Band Pass
+    if      ( HasButterworthBand () ) { FilterButterworthBandPass.ApplyStream ( toeeg, numtf, lookahead, tostate );     tostate    += FilterButterworthBandPass.GetStreamStateSize (); }
+
+    else if ( HasButterworthHigh () ) { FilterButterworthHighPass.ApplyStream ( toeeg, numtf, lookahead, tostate );     tostate    += FilterButterworthHighPass.GetStreamStateSize (); }
+
+    else if ( HasButterworthLow  () ) { FilterButterworthLowPass .ApplyStream ( toeeg, numtf, lookahead, tostate );     tostate    += FilterButterworthLowPass .GetStreamStateSize (); }
+
+
+    if      ( HasNotches ()         )   FilterNotches.ApplyStream               ( toeeg, numtf, lookahead, tostate );
+    } // for el
+}
+
+
 //----------------------------------------------------------------------------
 template <class TypeD>
 char   *TTracksFilters<TypeD>::ParametersToText ( char *text )    const
@@ -1316,6 +1516,167 @@ SetFromStruct ( fsamp, false );
 }
 
 
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+template <class TypeD>
+void    TTracksFiltersStream<TypeD>::Reset ()
+{
+NextTf              = -1;
+FirstTf             = -1;
+NumBlocks           = 0;
+NumElectrodes       = 0;
+Margin              = 0;
+NumRawLookAhead     = 0;
+
+States   .DeallocateMemory ();
+LookAhead.DeallocateMemory ();
+RawTail  .DeallocateMemory ();
+}
+
+
+//----------------------------------------------------------------------------
+                                        // The new block has to directly follow the previous one, with the same filters & dimensions
+template <class TypeD>
+bool    TTracksFiltersStream<TypeD>::CanContinue ( const TTracksFilters<TypeD>& filters, long tf1, int numel, int margin )   const
+{
+return  Active
+     && NextTf        >= 0
+     && tf1           == NextTf
+     && numel         == NumElectrodes
+     && margin        == Margin
+     && filters.CanStream ()
+     && States.GetDim1 () == numel
+     && States.GetDim2 () == filters.GetStreamStateSize ();
+}
+
+
+//----------------------------------------------------------------------------
+template <class TypeD>
+void    TTracksFiltersStream<TypeD>::SaveLookAhead ( const TArray2<TypeD>& data, int numel, int tfoffset, int numrawlookahead )
+{
+NumRawLookAhead     = Clip ( numrawlookahead, 0, Margin );
+
+for ( int el = 0; el < numel; el++ )
+for ( int tf = 0; tf < NumRawLookAhead; tf++ )
+
+    LookAhead ( el, tf )    = data ( el, tfoffset + tf );
+}
+
+
+                                        // data ( el, tfoffset + numtf - 1 ) is the last TF of the block - older part of the tail is kept if the block is shorter than the margin
+template <class TypeD>
+void    TTracksFiltersStream<TypeD>::SaveRawTail ( const TArray2<TypeD>& data, int numel, int tfoffset, long numtf )
+{
+int                 numkept         = (int) max ( (long) Margin - numtf, 0L );
+
+for ( int el = 0; el < numel; el++ ) {
+                                        // shifting the previous tail to the left
+    for ( int tf = 0; tf < numkept; tf++ )
+
+        RawTail ( el, tf )  = RawTail ( el, tf + Margin - numkept );
+
+    for ( int tf = numkept; tf < Margin; tf++ )
+
+        RawTail ( el, tf )  = data ( el, tfoffset + numtf - Margin + tf );
+    }
+}
+
+
+template <class TypeD>
+int     TTracksFiltersStream<TypeD>::RestoreLookAhead ( TArray2<TypeD>& data, int numel, int tfoffset )  const
+{
+for ( int el = 0; el < numel; el++ )
+for ( int tf = 0; tf < NumRawLookAhead; tf++ )
+
+    data ( el, tfoffset + tf )  = LookAhead ( el, tf );
+
+return  NumRawLookAhead;
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Called instead of the temporal part of ApplyFilters, after MirrorData
+                                        // Data layout is:  [margin][numtf - 2 * margin][margin]
+                                        // Filters states are reset, then set at the end of the actual block, like the regular filtering would do
+template <class TypeD>
+void    TTracksFiltersStream<TypeD>::Start  (   const TTracksFilters<TypeD>& filters,
+                                                TArray2<TypeD>&     data,       int                 numel,
+                                                long                numtf,      int                 margin,
+                                                long                nexttf,     int                 numrawlookahead,
+                                                const TSelection*   auxtracks
+                                            )
+{
+Reset ();
+
+if ( ! ( Active && filters.CanStream () && margin > 0 ) )
+    return;
+
+
+NumElectrodes       = numel;
+Margin              = margin;
+
+States   .Resize ( numel, filters.GetStreamStateSize () );  // all states set to 0
+LookAhead.Resize ( numel, Margin );
+RawTail  .Resize ( numel, Margin );
+
+                                        // save the raw data before filtering - tail might include some left mirroring, which will never be used, as mirroring sources stay within the file
+SaveRawTail   ( data, numel, 0, numtf - Margin );
+SaveLookAhead ( data, numel, (int) ( numtf - Margin ), numrawlookahead );
+
+                                        // left margin is actually used to warm-up the filters
+filters.ApplyTemporalFiltersStream  (   data,       numel,
+                                        numtf - Margin,     Margin,     0,
+                                        States,     auxtracks
+                                    );
+
+NextTf              = nexttf;
+FirstTf             = nexttf - ( numtf - 2 * Margin );
+NumBlocks           = 1;
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Called instead of UpdateTimeRange / MirrorData and the temporal part of ApplyFilters
+                                        // Caller should have called RestoreLookAhead, then read the remaining raw data up to  tf2 + margin  (or the end of file)
+template <class TypeD>
+void    TTracksFiltersStream<TypeD>::Continue   (   const TTracksFilters<TypeD>& filters,
+                                                    TArray2<TypeD>&     data,       int                 numel,
+                                                    long                tf1,        long                tf2,            int     tfoffset,
+                                                    long                numtimeframes,
+                                                    const TSelection*   auxtracks
+                                                )
+{
+long                numtf           = tf2 - tf1 + 1;
+long                lastvalidtf     = min ( tf2 + Margin, numtimeframes - 1 ) - tf1;    // relative to tf1
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // mirror missing part at the end of file, and complete with 0 if too little data - same as MirrorData
+                                        // a short last block mirrors across the raw tail of the previous block(s), down to the beginning of file
+for ( int el = 0; el < numel; el++ )
+for ( long tfr = lastvalidtf + 1, tfl = lastvalidtf - 1; tfr < numtf + Margin; tfr++, tfl-- )
+
+    data ( el, tfoffset + tfr ) = tfl >= 0                          ? data    ( el, tfoffset + tfl )
+                                : tfl >= -Margin && tf1 + tfl >= 0  ? RawTail ( el, Margin   + tfl )
+                                :                                     0;
+
+                                        // save the raw data before filtering
+SaveRawTail   ( data, numel, tfoffset, numtf );
+SaveLookAhead ( data, numel, (int) ( tfoffset + numtf ), (int) ( lastvalidtf - numtf + 1 ) );
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+filters.ApplyTemporalFiltersStream  (   data,       numel,
+                                        numtf,      Margin,     tfoffset,
+                                        States,     auxtracks
+                                    );
+
+NextTf              = tf2 + 1;
+NumBlocks++;
+}
+
+
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
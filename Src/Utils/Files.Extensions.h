@@ -238,6 +238,8 @@ limitations under the License.
 #define     InfixP                  "p"
 #define     Infix1MinusP            "1-p"
 #define     InfixLogP               "-logp"
+#define     InfixMaxStat            "MaxStat"
+#define     InfixClusterMass        "ClusterMass"
 #define     InfixUnpaired           "Unpaired"
 #define     InfixPaired             "Paired"
 #define     InfixTTest              "tTest"
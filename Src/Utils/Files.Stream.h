@@ -137,6 +137,37 @@ protected:
 };
 
 
+//----------------------------------------------------------------------------
+                                        // Read-only memory mapping of a whole file, the system paging in the data on demand
+                                        // All documents / processes mapping the same file share the same physical pages, so memory is bounded by what is actually being read
+                                        // !Accessing a mapped file which becomes unavailable (network drive...) raises a system exception, not an error code!
+class   TFileMapping
+{
+public:
+
+    inline          TFileMapping    ();
+    inline         ~TFileMapping    ();
+
+
+    inline bool     IsOpen          ()  const           { return  View != 0;    }
+
+    inline bool     Open            ( const char* file );
+    inline void     Close           ();
+
+
+    inline LONGLONG     GetSize     ()                  const   { return  Size;                         }
+    inline const char*  GetData     ( LONGLONG pos = 0 )const   { return  (const char*) View + pos;     }
+
+
+protected:
+
+    HANDLE          hfile;
+    HANDLE          hmapping;
+    LPVOID          View;
+    LONGLONG        Size;
+};
+
+
 //----------------------------------------------------------------------------
 // Implementation
 //----------------------------------------------------------------------------
@@ -540,6 +571,84 @@ return  Write ( LONGLONG_to_LARGE_INTEGER ( pos ), FILE_BEGIN, &data, sizeof ( s
 }
 
 
+//----------------------------------------------------------------------------
+        TFileMapping::TFileMapping ()
+      : hfile ( 0 ), hmapping ( 0 ), View ( 0 ), Size ( 0 )
+{
+}
+
+
+        TFileMapping::~TFileMapping ()
+{
+Close ();
+}
+
+
+void    TFileMapping::Close ()
+{
+if ( View     )     UnmapViewOfFile ( View     );
+if ( hmapping )     CloseHandle     ( hmapping );
+if ( hfile    )     CloseHandle     ( hfile    );
+
+hfile       = 0;
+hmapping    = 0;
+View        = 0;
+Size        = 0;
+}
+
+
+bool    TFileMapping::Open ( const char* file )
+{
+Close ();
+
+if ( StringIsEmpty ( file ) )
+    return  false;
+
+                                        // sharing the reading with any other handle, including the ones from TFileStream
+hfile   = CreateFile    (   file,
+                            GENERIC_READ,
+                            FILE_SHARE_READ,
+                            NULL,
+                            OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS,
+                            NULL
+                        );
+
+if ( hfile == INVALID_HANDLE_VALUE ) {
+    hfile       = 0;
+    return  false;
+    }
+
+
+LARGE_INTEGER       filesize;
+                                        // can not map an empty file
+if ( ! GetFileSizeEx ( hfile, &filesize ) || filesize.QuadPart == 0 ) {
+    Close ();
+    return  false;
+    }
+
+Size        = LARGE_INTEGER_to_LONGLONG ( filesize );
+
+
+hmapping    = CreateFileMapping ( hfile, NULL, PAGE_READONLY, 0, 0, NULL );
+
+if ( hmapping == 0 ) {
+    Close ();
+    return  false;
+    }
+
+                                        // whole file view - could fail on lack of contiguous address space
+View        = MapViewOfFile ( hmapping, FILE_MAP_READ, 0, 0, 0 );
+
+if ( View == 0 ) {
+    Close ();
+    return  false;
+    }
+
+return  true;
+}
+
+
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
 
@@ -19,6 +19,10 @@ limitations under the License.
 #pragma     hdrstop
 //-=-=-=-=-=-=-=-=-
 
+#if defined(CHECKASSERT)
+#include    <assert.h>
+#endif
+
 #include    "Math.Utils.h"
 #include    "Math.Stats.h"
 #include    "Math.Random.h"
@@ -28,6 +32,7 @@ limitations under the License.
 #include    "GlobalOptimize.Tracks.h"
 #include    "TList.h"
 #include    "Geometry.TPoints.h"
+#include    "Geometry.TPointsIndex.h"
 #include    "TArray3.h"
 #include    "Files.Stream.h"
 
@@ -201,6 +206,7 @@ OmpCriticalBegin (TPointsReset)
 
 NumPoints   = 0;
 Points.clear ();
+InvalidateIndex ();
 
 OmpCriticalEnd
 }
@@ -218,6 +224,7 @@ OmpCriticalBegin (TPointsResize)
 
 NumPoints   = AtLeast ( 0, newnumpoints );  // safety for negative values, also legal to be 0 for resetting
 Points.resize ( NumPoints );
+InvalidateIndex ();
 
 OmpCriticalEnd
 }
@@ -248,6 +255,9 @@ OmpCriticalBegin (TPointsSet)
 
 NumPoints   = points.NumPoints;
 Points      = points.Points;
+                                        // same points, same index - and same doubts about it
+std::atomic_store ( &Index, std::atomic_load ( &points.Index ) );
+IndexToCheck.store ( points.IndexToCheck.load () );
 
 OmpCriticalEnd
 }
@@ -499,6 +509,8 @@ for ( auto p = points.Points.cbegin (); p != points.Points.cend (); p++ )
 
     Points.push_back ( *p );
 
+InvalidateIndex ();
+
 OmpCriticalEnd
 }
 
@@ -509,6 +521,7 @@ OmpCriticalBegin (TPointsAdd)
 
 NumPoints++;
 Points.push_back ( point );
+InvalidateIndex ();
 
 OmpCriticalEnd
 }
@@ -620,6 +633,8 @@ return  *this;
                                         // !Not thread-safe!
 TPoints&    TPoints::operator+= ( double op2 )
 {
+InvalidateIndex ();
+
 if ( op2 == 0 )
     return  *this;
 
@@ -632,6 +647,8 @@ return  *this;
 
 TPoints&   TPoints::operator+= ( const TPointFloat &op2 )
 {
+InvalidateIndex ();
+
 if ( op2.IsNull () )
     return  *this;
 
@@ -644,6 +661,8 @@ return  *this;
 
 TPoints&   TPoints::operator+= ( const TPointDouble &op2 )
 {
+InvalidateIndex ();
+
 if ( op2.IsNull () )
     return  *this;
 
@@ -664,6 +683,8 @@ return  *this;
                                         // !Not thread-safe!
 TPoints&    TPoints::operator-= ( double op2 )
 {
+InvalidateIndex ();
+
 if ( op2 == 0 )
     return  *this;
 
@@ -676,6 +697,8 @@ return  *this;
 
 TPoints&   TPoints::operator-= ( const TPointFloat &op2 )
 {
+InvalidateIndex ();
+
 if ( op2.IsNull () )
     return  *this;
 
@@ -688,6 +711,8 @@ return  *this;
 
 TPoints&   TPoints::operator-= ( const TPointDouble &op2 )
 {
+InvalidateIndex ();
+
 if ( op2.IsNull () )
     return  *this;
 
@@ -700,6 +725,8 @@ return  *this;
 
 TPoints&   TPoints::operator/= ( double op2 )
 {
+InvalidateIndex ();
+
 if ( op2 == 0 || op2 == 1 )
     return  *this;
 
@@ -712,6 +739,8 @@ return  *this;
 
 TPoints&   TPoints::operator/= ( const TPointFloat &op2 )
 {
+InvalidateIndex ();
+
 for ( int i = 0; i < NumPoints; i++ )
     Points[ i ]    /= op2;
 
@@ -721,6 +750,8 @@ return  *this;
 
 TPoints&   TPoints::operator/= ( const TArray1<float> &op2 )
 {
+InvalidateIndex ();
+
 for ( int i = 0; i < NumPoints; i++ )
     if ( op2[ i ] )
         Points[ i ]    /= op2[ i ];
@@ -731,6 +762,8 @@ return  *this;
                                         // !Not thread-safe!
 TPoints&    TPoints::operator*= ( double op2 )
 {
+InvalidateIndex ();
+
 if ( op2 == 1 )
     return  *this;
 
@@ -743,6 +776,8 @@ return  *this;
                                         // !Not thread-safe!
 TPoints&    TPoints::operator*= ( const TPointFloat& op2 )
 {
+InvalidateIndex ();
+
 for ( int i = 0; i < NumPoints; i++ )
     Points[ i ]    *= op2;
 
@@ -754,6 +789,8 @@ return  *this;
                                         // Remove points too close to each others, aiming at the requested target size
 void    TPoints::DownsamplePoints   (   int     targetsize  )
 {
+InvalidateIndex ();
+
                                         // no need to downsample?
 if ( NumPoints <= targetsize )
     return;
@@ -948,6 +985,8 @@ void    TPoints::KeepTopHeadPoints (
                                 const TMatrix44*    mriabstoguillotine
                                 )
 {
+InvalidateIndex ();
+
 if ( ! mridoc.IsOpen () )
     return;
 
@@ -1141,6 +1180,8 @@ Sort ();
 //----------------------------------------------------------------------------
 void    TPoints::Normalize ()
 {
+InvalidateIndex ();
+
 for ( int i = 0; i < NumPoints; i++ )
     Points[ i ].Normalize ();
 }
@@ -1148,6 +1189,8 @@ for ( int i = 0; i < NumPoints; i++ )
 
 void    TPoints::Invert ()
 {
+InvalidateIndex ();
+
 for ( int i = 0; i < NumPoints; i++ )
     Points[ i ].Invert ();
 }
@@ -1156,6 +1199,8 @@ for ( int i = 0; i < NumPoints; i++ )
 //----------------------------------------------------------------------------
 void    TPoints::Sort ()
 {
+InvalidateIndex ();
+
 OmpCriticalBegin (TPointsSort)
 
                                         // Results in decreasing order
@@ -1812,39 +1857,73 @@ return  true;
 
 
 //----------------------------------------------------------------------------
-double  TPoints::GetMinimumDistance ( const TVector3Float& p )     const
+void    TPoints::InvalidateIndex ()
 {
-double              mind            = DBL_MAX;
+std::atomic_store ( &Index, std::shared_ptr<const TPointsIndex> () );
 
+IndexToCheck.store ( false );
+}
 
-for ( int i = 0; i < NumPoints; i++ )
-                                      // norm of the vectorial difference
-    Mined ( mind, (double) ( Points[ i ] - p ).Norm2 () );
+                                        // Index is built on first call, then kept until the points change:
+                                        //  - the methods modifying the points all reset it
+                                        //  - the non-const accessors could have been used to write to the points, so the index is then compared to the current points, and rebuilt only if they differ
+                                        // Retrieving an index without any non-const access in-between needs neither lock nor comparison
+std::shared_ptr<const TPointsIndex> TPoints::GetIndex ()   const
+{
+std::shared_ptr<const TPointsIndex> index   = std::atomic_load ( &Index );
+
+if ( index && ! IndexToCheck.load () ) {
+
+#if defined(CHECKASSERT)                // points written through a pointer or reference retrieved before the last check?
+    assert ( index->IsSameAs ( Points.data (), NumPoints ) );
+#endif
+
+    return  index;
+    }
+
+
+OmpCriticalBegin (TPointsGetIndex)
+                                        // another thread could have checked or built it in the meantime
+index   = std::atomic_load ( &Index );
+
+if ( index && IndexToCheck.load () && ! index->IsSameAs ( Points.data (), NumPoints ) )
+
+    index.reset ();
+
+
+if ( ! index ) {
+
+    index   = std::make_shared<const TPointsIndex> ( Points.data (), NumPoints );
+
+    std::atomic_store ( &Index, index );
+    }
+
+IndexToCheck.store ( false );
 
+OmpCriticalEnd
 
-return  sqrt ( mind );
+return  index;
 }
 
 
-TVector3Float TPoints::GetClosestPoint ( const TVector3Float& p )   const
+//----------------------------------------------------------------------------
+double  TPoints::GetMinimumDistance ( const TVector3Float& p )     const
 {
-double              d;
-double              mind            = DBL_MAX;
-TVector3Float       minp;
+double              mind2;
 
+GetIndex ()->GetNearest ( p, &mind2 );
 
-for ( int i = 0; i < NumPoints; i++ ) {
-                                        // norm of the vectorial difference
-    d   = ( Points[ i ] - p ).Norm2 ();
 
-    if ( d < mind ) {
-        mind    = d;
-        minp    = Points[ i ];
-        }
-    }
+return  sqrt ( mind2 );
+}
+
 
+TVector3Float TPoints::GetClosestPoint ( const TVector3Float& p )   const
+{
+int                 mini            = GetIndex ()->GetNearest ( p );
 
-return  minp;
+
+return  mini == TIndexNull ? TVector3Float () : Points[ mini ];
 }
 
 
@@ -1852,23 +1931,22 @@ return  minp;
                                         // find the typical (median here) distance between points
 double  TPoints::GetMedianDistance ()  const
 {
-int                 maxscan         = min ( NumPoints - 1, 250 );
-int                 step            = NumPoints < 250 ? 1 : 3;
+                                        // for safety
+if ( NumPoints <= 1 )
+    return  1;
+
+
+auto                index           = GetIndex ();
+int                 maxscan         = min ( NumPoints, 250 );
 double              minnorm2;
 TEasyStats          statd ( maxscan );
 double              mindistance;
 
 
-                                        // first loop is a subsample of all points
+                                        // a subsample of all points is enough, each with its exact nearest neighbor
 for ( int s = 0, i = 0; s < maxscan; s++, i = ( s / (double) ( maxscan - 1 ) ) * ( NumPoints - 1 ) ) {
 
-    minnorm2    = DBL_MAX;
-
-                                        // second loop does not need to see all points either, but going until the end is the point
-    for ( int j = i + 1; j < NumPoints; j += step )
-
-        Mined ( minnorm2, (double) ( Points[ i ] - Points[ j ] ).Norm2 () );
-
+    index->GetNearest ( Points[ i ], &minnorm2, i );
 
     statd.Add ( sqrt ( minnorm2 ) );
     }
@@ -1883,7 +1961,7 @@ statd.Sort ( true );
 mindistance     = statd.Median ( false );
 
                                         // for safety
-if ( NumPoints <= 1 || mindistance <= 0 )
+if ( mindistance <= 0 )
     mindistance = 1;
 
 
@@ -1911,20 +1989,34 @@ if ( NumPoints == 0 )
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
 double              neighdist       = Square ( Neighborhood[ neightype ].MidDistanceCut * ( mediandist <= 0 ? GetMedianDistance () : mediandist ) );
+                                        // radius query is a bit larger, the exact test being done below
+double              neighradius     = sqrt ( neighdist ) * 1.001;
+auto                index           = GetIndex ();
 
-                                        // are these 2 loops small enough? otherwise, creating a volume and scanning it
-for ( int i = 0;     i < NumPoints; i++ )
-for ( int j = i + 1; j < NumPoints; j++ ) {
 
-    if ( ( Points[ j ] - Points[ i ] ).Norm2 () < neighdist ) {
-                                // safety check                               // new neighbor
-        if ( neighbi ( i, 0 ) < numsneigh )  neighbi ( i, ++neighbi ( i, 0 ) ) = j;
-                                        // symmetry saves time
-        if ( neighbi ( j, 0 ) < numsneigh )  neighbi ( j, ++neighbi ( j, 0 ) ) = i;
-        }
+OmpParallelBegin
+
+vector<int>         within;
 
-    } // for i, j
+OmpFor
 
+for ( int i = 0; i < NumPoints; i++ ) {
+
+    index->GetWithinRadius ( Points[ i ], neighradius, within );
+
+    neighbi ( i, 0 )    = 0;
+                                        // indexes come sorted, same order as scanning all points
+    for ( int j : within )
+
+        if ( j != i 
+          && ( Points[ j ] - Points[ i ] ).Norm2 () < neighdist 
+          && neighbi ( i, 0 ) < numsneigh )     // safety check
+
+            neighbi ( i, ++neighbi ( i, 0 ) )   = j;
+
+    } // for i
+
+OmpParallelEnd
 }
 
 
@@ -2051,6 +2143,8 @@ void    TPoints::ResurfacePoints        (
                                         double              inflating
                                         )
 {
+InvalidateIndex ();
+
 if ( IsEmpty () || surface.IsNotAllocated () || center.IsNull () )
     return;
 
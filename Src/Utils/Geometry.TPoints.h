@@ -16,6 +16,9 @@ limitations under the License.
 
 #pragma once
 
+#include    <memory>
+#include    <atomic>
+
 #include    "Geometry.TPoint.h"
 #include    "TSelection.h"
 #include    "Strings.TStrings.h"
@@ -56,6 +59,7 @@ inline  bool        IsGeometryGridAligned   ( int gt )      { return gt == Point
 
 class               TVolumeDoc;
 class               TMatrix44;
+class               TPointsIndex;
 
                                         // Thread-safe list of points
 class   TPoints
@@ -102,6 +106,8 @@ public:
     TVector3Float   GetClosestPoint     ( const TVector3Float& p )  const;
     double          GetMedianDistance   ()  const;
     void            GetNeighborsIndexes ( TArray2<int>&  neighbi, NeighborhoodType neightype, double mediandist = 0 )   const;
+                                        // Spatial index for neighbors queries, built on first call then re-used until the points change - callers in loops should retrieve it only once
+    std::shared_ptr<const TPointsIndex> GetIndex    ()  const;
     TPointFloat     GetCenter           ()  const;
     double          GetRadius           ()  const;
     TPointFloat     GetLimitMin         ()  const;
@@ -136,11 +142,11 @@ public:
     void            ExtractToFile       ( const char* file, const char* exclpoints, TStrings*    names /*, bool removeselection*/ ) const;
 
 
-    TPointFloat&        operator    []              ( int i )       { return Points[ i ]; }
+    TPointFloat&        operator    []              ( int i )       { IndexToCheck.store ( true, std::memory_order_relaxed ); return Points[ i ]; } // caller might write to the points
     const TPointFloat&  operator    []              ( int i ) const { return Points[ i ]; }
                     operator        bool            ()        const { return NumPoints != 0; }
                     operator        int             ()        const { return NumPoints; }
-                    operator        TPointFloat*    ()              { return Points.data (); }
+                    operator        TPointFloat*    ()              { IndexToCheck.store ( true, std::memory_order_relaxed ); return Points.data (); }
                     operator        const TPointFloat*  ()    const { return Points.data (); }
 
 
@@ -168,6 +174,12 @@ protected:
 
     int                         NumPoints;
     std::vector<TPointFloat>    Points;
+
+    mutable std::shared_ptr<const TPointsIndex> Index;          // built on demand, reset by every modification - only accessed through std::atomic_load / std::atomic_store
+    mutable std::atomic<bool>                   IndexToCheck { false };   // points accessed through a non-const accessor since the last check of the index
+
+
+    void            InvalidateIndex     ();
 };
 
 
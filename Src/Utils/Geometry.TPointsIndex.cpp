@@ -0,0 +1,320 @@
+/************************************************************************\
+ 2024-2025 Denis Brunet, University of Geneva, Switzerland.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+\************************************************************************/
+
+#pragma     hdrstop
+//-=-=-=-=-=-=-=-=-
+
+#include    <algorithm>
+
+#include    "Math.Utils.h"
+
+#include    "Geometry.TPointsIndex.h"
+
+using namespace std;
+
+namespace crtl {
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+void    TPointsIndex::Reset ()
+{
+Points      .clear ();
+Nodes       .clear ();
+TreeIndexes .clear ();
+
+GridOrigin.Reset ();
+CellSize    = 1;
+GridDim[ 0 ]    = GridDim[ 1 ]  = GridDim[ 2 ]  = 0;
+CellStart   .clear ();
+CellPoints  .clear ();
+}
+
+
+void    TPointsIndex::Set ( const TPointFloat* points, int numpoints )
+{
+Reset ();
+
+if ( points == 0 || numpoints <= 0 )
+    return;
+
+
+Points.assign ( points, points + numpoints );
+
+                                        // k-d tree
+TreeIndexes.resize ( numpoints );
+
+for ( int i = 0; i < numpoints; i++ )
+    TreeIndexes[ i ]    = i;
+                                        // a balanced tree has less than 2 * N / LeafSize nodes
+Nodes.reserve ( 2 * numpoints / PointsIndexLeafSize + 1 );
+
+BuildTree ( 0, numpoints );
+
+                                        // grid
+BuildGrid ();
+}
+
+
+bool    TPointsIndex::IsSameAs ( const TPointFloat* points, int numpoints )    const
+{
+return  numpoints == GetNumPoints ()
+     && ( numpoints == 0 || memcmp ( points, Points.data (), numpoints * sizeof ( TPointFloat ) ) == 0 );
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Recursively splitting at the median of the axis of largest spread
+int     TPointsIndex::BuildTree ( int from, int to )
+{
+int                 nodei           = (int) Nodes.size ();
+
+Nodes.push_back ( { from, to, TIndexNull, TIndexNull, 0, 0 } );
+
+
+if ( to - from <= PointsIndexLeafSize )
+    return  nodei;
+
+                                        // bounding box of current range
+TPointFloat         pmin            = Points[ TreeIndexes[ from ] ];
+TPointFloat         pmax            = pmin;
+
+for ( int i = from + 1; i < to; i++ ) {
+
+    const TPointFloat&  p       = Points[ TreeIndexes[ i ] ];
+
+    Mined ( pmin.X, p.X );  Maxed ( pmax.X, p.X );
+    Mined ( pmin.Y, p.Y );  Maxed ( pmax.Y, p.Y );
+    Mined ( pmin.Z, p.Z );  Maxed ( pmax.Z, p.Z );
+    }
+
+
+TPointFloat         extent          = pmax - pmin;
+int                 axis            = extent.X >= extent.Y && extent.X >= extent.Z ? 0 
+                                    : extent.Y >= extent.Z                         ? 1 
+                                    :                                                2;
+                                        // all points are identical
+if ( extent[ axis ] == 0 )
+    return  nodei;
+
+
+int                 mid             = ( from + to ) / 2;
+
+nth_element (   TreeIndexes.begin () + from, TreeIndexes.begin () + mid, TreeIndexes.begin () + to,
+                [ this, axis ] ( int i1, int i2 ) { return Points[ i1 ][ axis ] < Points[ i2 ][ axis ]; }
+            );
+
+                                        // left  points are <= Split
+                                        // right points are >= Split
+int                 left            = BuildTree ( from, mid );
+int                 right           = BuildTree ( mid,  to  );
+
+                                        // !Nodes might have been re-allocated by now!
+Nodes[ nodei ].Left     = left;
+Nodes[ nodei ].Right    = right;
+Nodes[ nodei ].Axis     = axis;
+Nodes[ nodei ].Split    = Points[ TreeIndexes[ mid ] ][ axis ];
+
+return  nodei;
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Cell size is set to have a few points per cell on average
+void    TPointsIndex::BuildGrid ()
+{
+int                 numpoints       = GetNumPoints ();
+TPointFloat         pmin            = Points[ 0 ];
+TPointFloat         pmax            = Points[ 0 ];
+
+for ( const auto& p : Points ) {
+    Mined ( pmin.X, p.X );  Maxed ( pmax.X, p.X );
+    Mined ( pmin.Y, p.Y );  Maxed ( pmax.Y, p.Y );
+    Mined ( pmin.Z, p.Z );  Maxed ( pmax.Z, p.Z );
+    }
+
+
+TPointFloat         extent          = pmax - pmin;
+double              maxextent       = max ( extent.X, max ( extent.Y, extent.Z ) );
+
+GridOrigin      = pmin;
+
+if ( maxextent == 0 )
+    CellSize    = 1;
+else {
+                                        // flat or linear sets of points still have some volume
+    double          minextent       = maxextent * 1e-3;
+    double          volume          = AtLeast ( minextent, (double) extent.X ) 
+                                    * AtLeast ( minextent, (double) extent.Y ) 
+                                    * AtLeast ( minextent, (double) extent.Z );
+
+    CellSize    = AtLeast ( maxextent / PointsIndexMaxGridDim, cbrt ( volume * PointsIndexPointsPerCell / numpoints ) );
+    }
+
+
+for ( int d = 0; d < 3; d++ )
+    GridDim[ d ]    = Clip ( (int) ( extent[ d ] / CellSize ) + 1, 1, PointsIndexMaxGridDim );
+
+
+int                 numcells        = GridDim[ 0 ] * GridDim[ 1 ] * GridDim[ 2 ];
+vector<int>         pointcell ( numpoints );
+
+CellStart.assign ( numcells + 1, 0 );
+
+                                        // counting points per cell
+for ( int i = 0; i < numpoints; i++ ) {
+
+    pointcell[ i ]  = ( ToCell ( Points[ i ].Z, 2 )   * GridDim[ 1 ] 
+                      + ToCell ( Points[ i ].Y, 1 ) ) * GridDim[ 0 ] 
+                      + ToCell ( Points[ i ].X, 0 );
+
+    CellStart[ pointcell[ i ] + 1 ]++;
+    }
+                                        // cumulating to starting positions
+for ( int c = 0; c < numcells; c++ )
+    CellStart[ c + 1 ] += CellStart[ c ];
+
+                                        // filling buckets, in increasing index order
+vector<int>         cellfill ( CellStart.begin (), CellStart.end () - 1 );
+
+CellPoints.resize ( numpoints );
+
+for ( int i = 0; i < numpoints; i++ )
+    CellPoints[ cellfill[ pointcell[ i ] ]++ ]  = i;
+}
+
+
+int     TPointsIndex::ToCell ( double v, int axis )   const
+{
+return  Clip ( (int) floor ( ( v - GridOrigin[ axis ] ) / CellSize ), 0, GridDim[ axis ] - 1 );
+}
+
+
+//----------------------------------------------------------------------------
+int     TPointsIndex::GetNearest ( const TPointFloat& p, double* distance2, int excludeindex )   const
+{
+vector<TPointsNeighbor> neighbors;
+
+neighbors.reserve ( 1 );
+
+
+if ( ! IsEmpty () )
+    SearchKNearest ( 0, p, 1, excludeindex, neighbors );
+
+
+if ( distance2 )
+    *distance2  = neighbors.empty () ? Highest<double> () : neighbors[ 0 ].Distance2;
+
+return  neighbors.empty () ? TIndexNull : neighbors[ 0 ].Index;
+}
+
+
+void    TPointsIndex::GetKNearest ( const TPointFloat& p, int k, vector<TPointsNeighbor>& neighbors )  const
+{
+neighbors.clear ();
+
+if ( IsEmpty () || k <= 0 )
+    return;
+
+neighbors.reserve ( k );
+
+SearchKNearest ( 0, p, k, TIndexNull, neighbors );
+}
+
+                                        // neighbors is kept sorted, and holds at most k elements
+void    TPointsIndex::SearchKNearest ( int nodei, const TPointFloat& p, int k, int excludeindex, vector<TPointsNeighbor>& neighbors )  const
+{
+const TKdNode&      node            = Nodes[ nodei ];
+
+
+if ( node.Left == TIndexNull ) {
+
+    for ( int ti = node.From; ti < node.To; ti++ ) {
+
+        TPointsNeighbor     neighbor    = { TreeIndexes[ ti ], Distance2 ( TreeIndexes[ ti ], p ) };
+
+        if ( neighbor.Index == excludeindex 
+          || (int) neighbors.size () == k && ! ( neighbor < neighbors.back () ) )
+            continue;
+
+        if ( (int) neighbors.size () == k )
+            neighbors.pop_back ();
+
+        neighbors.insert ( upper_bound ( neighbors.begin (), neighbors.end (), neighbor ), neighbor );
+        }
+
+    return;
+    }
+
+                                        // closest side first
+double              delta           = p[ node.Axis ] - node.Split;
+
+SearchKNearest ( delta <= 0 ? node.Left : node.Right, p, k, excludeindex, neighbors );
+
+                                        // other side can only hold points at least as far as the splitting plane - equality is still explored for the index tie-breaking
+if ( (int) neighbors.size () < k || delta * delta <= neighbors.back ().Distance2 )
+
+    SearchKNearest ( delta <= 0 ? node.Right : node.Left, p, k, excludeindex, neighbors );
+}
+
+
+//----------------------------------------------------------------------------
+void    TPointsIndex::GetWithinRadius ( const TPointFloat& p, double radius, vector<int>& indexes )    const
+{
+indexes.clear ();
+
+if ( IsEmpty () || radius < 0 )
+    return;
+
+                                        // range of cells overlapping the sphere's bounding box
+int                 cmin[ 3 ];
+int                 cmax[ 3 ];
+
+for ( int d = 0; d < 3; d++ ) {
+                                        // query is completely out of the grid?
+    if ( p[ d ] + radius < GridOrigin[ d ] 
+      || p[ d ] - radius > GridOrigin[ d ] + GridDim[ d ] * CellSize )
+        return;
+
+    cmin[ d ]   = ToCell ( p[ d ] - radius, d );
+    cmax[ d ]   = ToCell ( p[ d ] + radius, d );
+    }
+
+
+double              radius2         = radius * radius;
+
+for ( int cz = cmin[ 2 ]; cz <= cmax[ 2 ]; cz++ )
+for ( int cy = cmin[ 1 ]; cy <= cmax[ 1 ]; cy++ )
+for ( int cx = cmin[ 0 ]; cx <= cmax[ 0 ]; cx++ ) {
+
+    int             c           = ( cz * GridDim[ 1 ] + cy ) * GridDim[ 0 ] + cx;
+
+    for ( int ci = CellStart[ c ]; ci < CellStart[ c + 1 ]; ci++ )
+
+        if ( Distance2 ( CellPoints[ ci ], p ) <= radius2 )
+
+            indexes.push_back ( CellPoints[ ci ] );
+    }
+
+
+sort ( indexes.begin (), indexes.end () );
+}
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+}
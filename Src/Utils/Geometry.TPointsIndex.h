@@ -0,0 +1,108 @@
+/************************************************************************\
+ 2024-2025 Denis Brunet, University of Geneva, Switzerland.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+\************************************************************************/
+
+#pragma once
+
+#include    <vector>
+
+#include    "Geometry.TPoint.h"
+
+namespace crtl {
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+                                        // Spatial index of a fixed set of points, for fast neighbors queries:
+                                        //  - a k-d tree for the k nearest neighbors
+                                        //  - a uniform grid of buckets for the neighbors within a given radius
+                                        // It keeps its own copy of the points, so it doesn't depend on the lifetime of the original array.
+                                        // Once built, all queries are const and thread-safe.
+
+constexpr int       PointsIndexLeafSize         = 8;        // max number of points in a k-d tree leaf
+constexpr double    PointsIndexPointsPerCell    = 8;        // average number of points per grid cell
+constexpr int       PointsIndexMaxGridDim       = 256;      // max number of cells per axis
+
+
+struct  TPointsNeighbor
+{
+    int             Index;
+    double          Distance2;          // squared distance to the query point
+
+                                        // ordered by distance, then by index, so that results are fully deterministic
+    bool            operator    <       ( const TPointsNeighbor& op2 )  const   { return Distance2 < op2.Distance2 || Distance2 == op2.Distance2 && Index < op2.Index; }
+};
+
+
+//----------------------------------------------------------------------------
+
+class   TPointsIndex
+{
+public:
+                    TPointsIndex    ()                                              { Reset (); }
+                    TPointsIndex    ( const TPointFloat* points, int numpoints )     { Set ( points, numpoints ); }
+
+
+    void            Reset           ();
+    void            Set             ( const TPointFloat* points, int numpoints );
+
+    int             GetNumPoints    ()                                              const   { return (int) Points.size (); }
+    bool            IsEmpty         ()                                              const   { return Points.empty (); }
+    bool            IsSameAs        ( const TPointFloat* points, int numpoints )    const;  // true if built from these exact points
+
+
+    int             GetNearest      ( const TPointFloat& p, double* distance2 = 0, int excludeindex = TIndexNull )     const;  // TIndexNull if empty
+    void            GetKNearest     ( const TPointFloat& p, int k, std::vector<TPointsNeighbor>& neighbors )          const;  // up to k neighbors, sorted by increasing distance
+    void            GetWithinRadius ( const TPointFloat& p, double radius, std::vector<int>& indexes )                const;  // all points at distance <= radius, sorted by increasing index
+
+
+protected:
+
+    std::vector<TPointFloat>    Points;         // in original order
+
+                                        // k-d tree
+    struct  TKdNode
+    {
+        int         From;                   // range in TreeIndexes
+        int         To;                     // past the last index
+        int         Left;                   // child nodes, or TIndexNull for leaves
+        int         Right;
+        int         Axis;
+        float       Split;
+    };
+
+    std::vector<TKdNode>        Nodes;
+    std::vector<int>            TreeIndexes;    // points indexes, permuted so that each node covers a contiguous range
+
+                                        // uniform grid, with buckets stored contiguously
+    TPointFloat                 GridOrigin;
+    double                      CellSize;
+    int                         GridDim[ 3 ];
+    std::vector<int>            CellStart;      // first index in CellPoints of each cell, + 1 last entry
+    std::vector<int>            CellPoints;
+
+
+    double          Distance2       ( int i, const TPointFloat& p )                 const   { double dx = Points[ i ].X - p.X; double dy = Points[ i ].Y - p.Y; double dz = Points[ i ].Z - p.Z; return dx * dx + dy * dy + dz * dz; }
+    int             ToCell          ( double v, int axis )                          const;
+
+    int             BuildTree       ( int from, int to );
+    void            BuildGrid       ();
+    void            SearchKNearest  ( int nodei, const TPointFloat& p, int k, int excludeindex, std::vector<TPointsNeighbor>& neighbors )  const;
+};
+
+
+//----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+
+}
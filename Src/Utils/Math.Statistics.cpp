@@ -14,6 +14,8 @@ See the License for the specific language governing permissions and
 limitations under the License.
 \************************************************************************/
 
+#include    <algorithm>
+
 #include    "Math.Statistics.h"
 #include    "TStatisticsDialog.h"       // enums  OutputPType, CorrectionType, StatTimeType, PairedType
 
@@ -604,6 +606,101 @@ else { // unpaired ttest
 
 
 //----------------------------------------------------------------------------
+//----------------------------------------------------------------------------
+                                        // Randomization engine:
+                                        // All the permutations are drawn once, then shared across all variables and time frames.
+                                        // Besides being much faster, this is the correct basis for the max-statistic and the cluster-mass corrections.
+                                        // Permutations are stored as packed bit masks, 8 samples per byte:
+                                        //  - paired:   bit set = sign flip of the sample's difference
+                                        //  - unpaired: bit set = pooled sample goes into group 1
+                                        // Each masked sum is then simply looked up byte per byte, from a table of the 256 partial sums of each byte.
+constexpr int       MaskedSumsTableSize     = 256;
+
+
+int     GetNumMaskBytes ( int numsamples )
+{
+return  ( numsamples + 7 ) / 8;
+}
+
+                                        // Random sign flips, each bit being a fair coin toss
+void    GenerateSignFlipMasks   (   int                 numrand,        int                 numsamples, 
+                                    TRandUniform&       randunif,
+                                    TArray2<uchar>&     masks
+                                )
+{
+int                 numbytes        = GetNumMaskBytes ( numsamples );
+
+masks.Resize ( numrand, numbytes );
+
+                                        // padding bits will be ignored, as their partial sums are null
+for ( int e = 0; e < numrand; e++ )
+for ( int b = 0; b < numbytes; b++ )
+
+    masks ( e, b )  = (uchar) randunif ( (UINT) MaskedSumsTableSize );
+}
+
+                                        // Random group assignments of the pooled samples, group 1 always receiving numsamples1 samples
+                                        // The full permutations are also kept, to handle the variables with missing values
+void    GenerateLabelShuffles   (   int                 numrand,        int                 numsamples1,        int             numsamples2,
+                                    TRandUniform&       randunif,
+                                    TArray2<uchar>&     masks,          TArray2<int>&       orders
+                                )
+{
+int                 numsamples      = numsamples1 + numsamples2;
+int                 numbytes        = GetNumMaskBytes ( numsamples );
+
+masks .Resize ( numrand, numbytes   );
+orders.Resize ( numrand, numsamples );
+
+masks.ResetMemory ();
+
+
+for ( int e = 0; e < numrand; e++ ) {
+
+    int*                order           = orders[ e ];
+
+    for ( int s = 0; s < numsamples; s++ )
+        order[ s ]  = s;
+                                        // Fisher-Yates shuffle
+    for ( int s = numsamples - 1; s > 0; s-- )
+        Permutate ( order[ s ], order[ randunif ( (UINT) ( s + 1 ) ) ] );
+
+                                        // first samples of the permutation go to group 1
+    for ( int s = 0; s < numsamples1; s++ )
+        masks ( e, order[ s ] / 8 ) |= (uchar) ( 1 << ( order[ s ] % 8 ) );
+    }
+}
+
+                                        // For each byte of samples, sums of all the 256 combinations of these 8 samples
+                                        // x has to be padded with 0's to a multiple of 8
+void    SetMaskedSumsTable      (   const TArray1<double>&  x,      TArray2<double>&    table   )
+{
+for ( int b = 0; b < table.GetDim1 (); b++ ) {
+
+    double*             tobyte          = table[ b ];
+
+    tobyte[ 0 ]     = 0;
+
+    for ( int bit = 0, bitmask = 1; bit < 8; bit++, bitmask <<= 1 )
+    for ( int m = bitmask; m < 2 * bitmask; m++ )
+
+        tobyte[ m ] = tobyte[ m - bitmask ] + x[ 8 * b + bit ];
+    }
+}
+
+
+inline double   GetMaskedSum    (   const TArray2<double>&  table,  const uchar*    mask    )
+{
+double              sum             = 0;
+
+for ( int b = 0; b < table.GetDim1 (); b++ )
+
+    sum    += table ( b, mask[ b ] );
+
+return  sum;
+}
+
+
 //----------------------------------------------------------------------------
 void    Run_Randomization_test  (   const TArray3<float>&   data1,              const TArray3<float>&   data2,
                                     StatTimeType            stattime1,          StatTimeType            stattime2,
@@ -642,42 +739,75 @@ ComputeSingleGroupMeasures  (   data2,              stattime2,
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // index to average value (actually an additional data point)
 int                 avgtfi              = GetTimeAverageIndex ( data1 );
+int                 numtf               = jointnumtf;
+                                        // pooled samples for unpaired test
+int                 numsamples          = paired == TestPaired ? jointnumsamples : numsamples1 + numsamples2;
+int                 numbytes            = GetNumMaskBytes ( numsamples );
 
+                                        // draw all the permutations once for all
+TRandUniform        randunif;
+TArray2<uchar>      masks;
+TArray2<int>        orders;
 
-if ( paired == TestPaired ) {
+if ( paired == TestPaired )     GenerateSignFlipMasks   ( numrand, numsamples,                randunif, masks         );
+else                            GenerateLabelShuffles   ( numrand, numsamples1, numsamples2,  randunif, masks, orders );
 
-    int                 numtf           = jointnumtf;
-    int                 numsamples      = jointnumsamples;
+                                        // null distributions of the maximum statistic and of the maximum cluster mass, across all variables and time frames
+TArray1<double>     maxstatnull ( numrand );
+TArray1<double>     maxmassnull ( numrand );
+                                        // observed standardized statistic, and mass of the cluster each data point belongs to
+TArray2<double>     obsstat     ( numtf, numvars );
+TArray2<double>     obsmass     ( numtf, numvars );
 
-                                        // compute the average of difference
-    OmpParallelBegin
-                                        // by safety, allocate a random generator for each thread
-    TRandCoin           randcoin;
-    TArray1<int>        sampleindex ( checkmissingvalues ? numsamples : 0 );
 
-    OmpFor
+OmpParallelBegin
+
+TArray1<int>        sampleindex1    ( checkmissingvalues ? numsamples  : 0 );
+TArray1<int>        sampleindex2    ( checkmissingvalues ? numsamples2 : 0 );
+TArray1<bool>       isreal          ( numsamples );
+TArray1<double>     x               ( 8 * numbytes );
+TArray2<double>     table           ( numbytes, MaskedSumsTableSize );
+                                        // all permutations statistics for current variable
+TArray2<float>      nullstat        ( numtf, numrand );
+TArray1<bool>       isvalid         ( numtf );
+TArray1<double>     critical        ( numtf );
+TArray1<double>     invscale        ( numtf );
+TArray1<float>      sortedstat      ( numrand );
+TArray1<double>     runmass         ( numrand );
+                                        // maximums for the variables of this thread
+TArray1<double>     threadmaxstat   ( numrand );
+TArray1<double>     threadmaxmass   ( numrand );
+
+OmpFor
+
+for ( int v = 0; v < numvars; v++ ) {
+
+    if ( Gauge.IsAlive () )
+        Gauge.SetValue ( SuperGaugeDefaultPart, Percentage ( v * StepThread (), numvars ) );
+
 
     for ( int tf0 = 0; tf0 < numtf; tf0++ ) {
                                         // which index to use according to average
         int                 tf1             = IsTimeSequential ( stattime1 ) ? tf0 : avgtfi;
         int                 tf2             = IsTimeSequential ( stattime2 ) ? tf0 : avgtfi;
-        int                 numrealsamples;
+        float*              tonull          = nullstat[ tf0 ];
+        double              avg;
+        double              sumdata;
+        int                 countabove      = 0;
 
+        isvalid ( tf0 ) = false;
 
-        //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-        for ( int v = 0; v < numvars; v++ ) {
-
-            if ( Gauge.IsAlive () )
-                Gauge.SetValue ( SuperGaugeDefaultPart, Percentage ( tf0 * numvars * StepThread () + v, numtf * numvars ) );
+        if ( paired == TestPaired ) {
 
+            int                 numrealsamples;
 
             if ( checkmissingvalues ) {
 
                 numrealsamples  = GetRealNumberOfSamples    (   data1,          data2,
                                                                 tf1,            tf2,            v,          numsamples,
                                                                 missingvalue, 
-                                                                sampleindex
+                                                                sampleindex1
                                                             );
 
                 if ( numrealsamples == 0 ) {
@@ -686,7 +816,7 @@ if ( paired == TestPaired ) {
                     results2    ( tf0, v, TestNumSamples ) = 0;
                     jointresults( tf0, v, Test_p_value )   = 1.0;
 
-                    continue; // for v
+                    continue; // for tf
                     }
                 } // if checkmissingvalues
             else
@@ -694,92 +824,45 @@ if ( paired == TestPaired ) {
 
 
             //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // compute the data sum of differences
-            long double         sumdata         = 0;
+                                        // differences, missing samples being set to 0 won't contribute to any sum
+            x.ResetMemory ();
 
-            for ( int s = 0; s < numrealsamples; s++ )
+            sumdata     = 0;
 
-                sumdata    += data1 ( tf1, v, checkmissingvalues ? sampleindex[ s ] : s ) 
-                            - data2 ( tf2, v, checkmissingvalues ? sampleindex[ s ] : s );
+            for ( int s = 0; s < numrealsamples; s++ ) {
 
-                                        // !this average retains the sign!
-            long double         avg             = sumdata / numrealsamples;
+                int             si          = checkmissingvalues ? sampleindex1[ s ] : s;
 
-            sumdata     = abs ( sumdata );
+                x[ si ]     = data1 ( tf1, v, si ) - data2 ( tf2, v, si );
+                sumdata    += x[ si ];
+                }
 
+                                        // !this average retains the sign!
+            avg         = sumdata / numrealsamples;
 
-            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // run the permutations
-            int                 countabove      = 0;
+            SetMaskedSumsTable ( x, table );
 
+                                        // run the permutations: flipping the sign of the masked differences
             for ( int e = 0; e < numrand; e++ ) {
 
-                long double         sum             = 0;
-
-                for ( int s = 0; s < numrealsamples; s++ ) {
-
-                    long double         temp    = data1 ( tf1, v, checkmissingvalues ? sampleindex[ s ] : s ) 
-                                                - data2 ( tf2, v, checkmissingvalues ? sampleindex[ s ] : s );
-
-                    if ( randcoin () )      sum -= temp;
-                    else                    sum += temp;
-                    }
+                double          sum         = sumdata - 2 * GetMaskedSum ( table, masks[ e ] );
 
                                         // 2-tailed, does not care for positive or negative
-                if ( abs ( sum ) >= sumdata )
+                if ( fabs ( sum ) >= fabs ( sumdata ) )
                     countabove++;
-                } // for e
-
 
-            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // compute these variables
-            long double         p           = Clip ( (long double) countabove / numrand, (long double) 0.0, (long double) 1.0 );
+                tonull[ e ] = sum / numrealsamples;
+                } // for e
 
-                                        // store results
             jointresults ( tf0, v, TestNumSamples   )   = 2 * numrealsamples;
-            jointresults ( tf0, v, TestMean         )   = avg;
-            jointresults ( tf0, v, Test_p_value     )   = p;
-            } // for variable
-
-        } // for tf
-
-    OmpParallelEnd
-
-    } // if paired
-
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-
-else { // unpaired
-
-    int                 numtf           = jointnumtf;
-
-                                        // compute the difference of average
-    OmpParallelBegin
-                                        // by safety, allocate a random generator for each thread
-    TRandUniform        randunif;
-    TSelection          group1pick ( numsamples1 + numsamples2, OrderSorted );
-
-    TArray1<int>        sampleindex1 ( checkmissingvalues ? numsamples1 : 0 );
-    TArray1<int>        sampleindex2 ( checkmissingvalues ? numsamples2 : 0 );
-
-    OmpFor
-
-    for ( int tf0 = 0; tf0 < numtf; tf0++ ) {
-                                        // which index to use according to average
-        int                 tf1             = IsTimeSequential ( stattime1 ) ? tf0 : avgtfi;
-        int                 tf2             = IsTimeSequential ( stattime2 ) ? tf0 : avgtfi;
-        int                 numrealsamples1;
-        int                 numrealsamples2;
-        int                 numrealsamples;
-
+            } // if paired
 
         //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
 
-        for ( int v = 0; v < numvars; v++ ) {
-
-            if ( Gauge.IsAlive () )
-                Gauge.SetValue ( SuperGaugeDefaultPart, Percentage ( tf0 * numvars * StepThread () + v, numtf * numvars ) );
+        else { // unpaired
 
+            int                 numrealsamples1;
+            int                 numrealsamples2;
 
             if ( checkmissingvalues ) {
             
@@ -802,9 +885,6 @@ else { // unpaired
                 if ( numrealsamples2 == 0 )
                     results2 ( tf0, v, TestNumSamples ) = 0;    // no data available
 
-
-                numrealsamples  = numrealsamples1 + numrealsamples2;
-
                                         // skip actual computation and continue loop
                 if ( numrealsamples1 == 0 || numrealsamples2 == 0 ) {
                     jointresults ( tf0, v, Test_p_value   ) = 1.0;
@@ -815,78 +895,199 @@ else { // unpaired
             else {
                 numrealsamples1 = numsamples1;
                 numrealsamples2 = numsamples2;
-                numrealsamples  = numsamples1 + numsamples2;
                 }
 
 
             //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // compute the data difference of averages
-            long double         sum1        = 0;
+                                        // pooling the 2 groups
+            x     .ResetMemory ();
+            isreal.ResetMemory ();
 
-            for ( int s = 0; s < numrealsamples1; s++ )     sum1 += data1 ( tf1, v, checkmissingvalues ? sampleindex1[ s ] : s );
+            double              sum1        = 0;
+            double              sum2        = 0;
 
+            for ( int s = 0; s < numrealsamples1; s++ ) {
 
-            long double         sum2        = 0;
+                int             si          = checkmissingvalues ? sampleindex1[ s ] : s;
 
-            for ( int s = 0; s < numrealsamples2; s++ )     sum2 += data2 ( tf2, v, checkmissingvalues ? sampleindex2[ s ] : s );
+                x     [ si ]    = data1 ( tf1, v, si );
+                isreal[ si ]    = true;
+                sum1           += x[ si ];
+                }
+
+            for ( int s = 0; s < numrealsamples2; s++ ) {
+
+                int             si          = checkmissingvalues ? sampleindex2[ s ] : s;
 
+                x     [ numsamples1 + si ]  = data2 ( tf2, v, si );
+                isreal[ numsamples1 + si ]  = true;
+                sum2                       += x[ numsamples1 + si ];
+                }
+
+            sumdata     = sum1 + sum2;
                                         // !this average retains the sign!
-            long double         avg         = sum1 / numrealsamples1 
-                                            - sum2 / numrealsamples2;
+            avg         = sum1 / numrealsamples1 
+                        - sum2 / numrealsamples2;
 
-            long double         sumdata     = abs ( avg );
+                                        // all samples present: the shared masks can be used as is
+            bool                usemasks    = numrealsamples1 == numsamples1 
+                                           && numrealsamples2 == numsamples2;
 
+            if ( usemasks )
+                SetMaskedSumsTable ( x, table );
 
-            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
                                         // run the permutations
-            int                 countabove  = 0;
-
             for ( int e = 0; e < numrand; e++ ) {
 
-                sum1    = 0;
-                sum2    = 0;
-                group1pick.Reset ();
-                                        // pick for group1
-                                        // use a selection, to avoid picking the same sample multiple times
-                                        // ?As per the TAnova, there could be a slight bias toward the biggest group, making the p slightly lower?
-                do     group1pick.Set ( randunif ( (uint) numrealsamples ) );
-                while ( group1pick.NumSet () < numrealsamples1 );
+                if ( usemasks )
+
+                    sum1    = GetMaskedSum ( table, masks[ e ] );
 
-                                        // assign to sums from group1
-                for ( int s = 0; s < numrealsamples1; s++ )
+                else {
+                                        // same permutation, but skipping the missing samples: group 1 gets the first numrealsamples1 real samples
+                    const int*      order       = orders[ e ];
 
-                    if ( group1pick[ s ] )                      sum1 += data1 ( tf1, v, checkmissingvalues ? sampleindex1[ s ] : s );
-                    else                                        sum2 += data1 ( tf1, v, checkmissingvalues ? sampleindex1[ s ] : s );
+                    sum1    = 0;
 
-                                        // assign to sums from group2
-                for ( int s = 0; s < numrealsamples2; s++ )
+                    for ( int s = 0, n1 = 0; n1 < numrealsamples1; s++ )
 
-                    if ( group1pick[ s + numrealsamples1 ] )    sum1 += data2 ( tf2, v, checkmissingvalues ? sampleindex2[ s ] : s );
-                    else                                        sum2 += data2 ( tf2, v, checkmissingvalues ? sampleindex2[ s ] : s );
+                        if ( isreal[ order[ s ] ] ) {
+                            sum1   += x[ order[ s ] ];
+                            n1++;
+                            }
+                    }
+
+                double          diff        = sum1               / numrealsamples1 
+                                            - ( sumdata - sum1 ) / numrealsamples2;
 
                                         // 2-tailed, does not care for positive or negative
-                if ( abs (   sum1 / numrealsamples1 
-                           - sum2 / numrealsamples2 ) >= sumdata )
+                if ( fabs ( diff ) >= fabs ( avg ) )
                     countabove++;
 
+                tonull[ e ] = diff;
                 } // for e
 
+            jointresults ( tf0, v, TestNumSamples   )   = numrealsamples1 + numrealsamples2;
+            } // if unpaired
 
-            //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // compute these variables
-            long double         p           = Clip ( (long double) countabove / numrand, (long double) 0.0, (long double) 1.0 );
 
-                                        // compute and store these variables
-            jointresults ( tf0, v, TestNumSamples   )   = numrealsamples;
-            jointresults ( tf0, v, TestMean         )   = avg;
-            jointresults ( tf0, v, Test_p_value     )   = p;
-            } // for variable
+        //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // store results
+        jointresults ( tf0, v, TestMean         )   = avg;
+        jointresults ( tf0, v, Test_p_value     )   = Clip ( (double) countabove / numrand, 0.0, 1.0 );
+
+        isvalid ( tf0 ) = true;
+
+                                        // standardizing by the permutation standard deviation, so that all variables can be compared for the max-statistic
+        double              sumsqr          = 0;
+
+        for ( int e = 0; e < numrand; e++ )
+            sumsqr     += Square ( (double) tonull[ e ] );
+
+        double              scale           = sqrt ( sumsqr / numrand );
+
+        invscale ( tf0 )    = scale > 0 ? 1 / scale : 0;
+
+        obsstat ( tf0, v )  = fabs ( avg ) * invscale ( tf0 );
 
+                                        // cluster-forming threshold, as the ( 1 - alpha ) quantile of the absolute null distribution
+        for ( int e = 0; e < numrand; e++ )
+            sortedstat[ e ] = fabs ( tonull[ e ] );
+
+        int                 quantilei       = Clip ( (int) ceil ( ( 1 - RandomizationClusterAlpha ) * numrand ) - 1, 0, numrand - 1 );
+
+        std::nth_element ( sortedstat.GetArray (), sortedstat.GetArray () + quantilei, sortedstat.GetArray () + numrand );
+
+        critical ( tf0 )    = sortedstat[ quantilei ];
         } // for tf
 
-    OmpParallelEnd
 
-    } // if unpaired
+    //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // null maximum statistic
+    for ( int tf0 = 0; tf0 < numtf; tf0++ ) {
+
+        if ( ! isvalid ( tf0 ) )
+            continue;
+
+        const float*        tonull          = nullstat[ tf0 ];
+
+        for ( int e = 0; e < numrand; e++ )
+            Maxed ( threadmaxstat[ e ], fabs ( tonull[ e ] ) * invscale ( tf0 ) );
+        }
+
+                                        // clusters are runs of consecutive supra-threshold time frames, their mass is the sum of their standardized statistics
+    runmass.ResetMemory ();
+
+    double              obsrun          = 0;
+    int                 obsbegin        = 0;
+
+    for ( int tf0 = 0; tf0 <= numtf; tf0++ ) {
+                                        // last iteration is used to close all the opened clusters
+        bool                isopen          = tf0 < numtf && isvalid ( tf0 );
+        const float*        tonull          = isopen ? nullstat[ tf0 ] : 0;
+
+        for ( int e = 0; e < numrand; e++ )
+
+            if ( isopen && fabs ( tonull[ e ] ) > critical ( tf0 ) )
+
+                runmass[ e ]   += fabs ( tonull[ e ] ) * invscale ( tf0 );
+
+            else if ( runmass[ e ] > 0 ) {
+
+                Maxed ( threadmaxmass[ e ], runmass[ e ] );
+
+                runmass[ e ]    = 0;
+                }
+
+                                        // observed clusters
+        if ( isopen && fabs ( jointresults ( tf0, v, TestMean ) ) > critical ( tf0 ) )
+
+            obsrun     += obsstat ( tf0, v );
+
+        else {
+            for ( int tfi = obsbegin; tfi < tf0; tfi++ )
+                obsmass ( tfi, v )  = obsrun;
+
+            obsrun      = 0;
+            obsbegin    = tf0 + 1;
+            }
+        } // for tf
+
+    } // for variable
+
+
+OmpCriticalBegin (RandomizationMaxStat)
+
+for ( int e = 0; e < numrand; e++ ) {
+
+    Maxed ( maxstatnull[ e ], threadmaxstat[ e ] );
+    Maxed ( maxmassnull[ e ], threadmaxmass[ e ] );
+    }
+
+OmpCriticalEnd
+
+OmpParallelEnd
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // corrected p-values, from the sorted null distributions
+std::sort ( maxstatnull.GetArray (), maxstatnull.GetArray () + numrand );
+std::sort ( maxmassnull.GetArray (), maxmassnull.GetArray () + numrand );
+
+
+OmpParallelFor
+
+for ( int tf0 = 0; tf0 < numtf; tf0++ )
+for ( int v   = 0; v   < numvars; v++ ) {
+
+                                        // number of null maximums above or equal to the observed value
+    int                 countstat       = (int) ( maxstatnull.GetArray () + numrand - std::lower_bound ( maxstatnull.GetArray (), maxstatnull.GetArray () + numrand, obsstat ( tf0, v ) ) );
+    int                 countmass       = (int) ( maxmassnull.GetArray () + numrand - std::lower_bound ( maxmassnull.GetArray (), maxmassnull.GetArray () + numrand, obsmass ( tf0, v ) ) );
+
+                                        // data points without data, or not belonging to any cluster, are not significant
+    jointresults ( tf0, v, Test_p_value_MaxStat     )   = obsstat ( tf0, v ) > 0 ? Clip ( (double) countstat / numrand, 0.0, 1.0 ) : 1.0;
+    jointresults ( tf0, v, Test_p_value_ClusterMass )   = obsmass ( tf0, v ) > 0 ? Clip ( (double) countmass / numrand, 0.0, 1.0 ) : 1.0;
+    }
 
 } // Run_Randomization_test
 
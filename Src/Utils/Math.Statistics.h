@@ -32,12 +32,18 @@ enum        TestVariablesEnum
             TestStandardError,
             Test_t_value,
             Test_p_value,
+            Test_p_value_MaxStat,       // randomization only, corrected with the max-statistic null distribution
+            Test_p_value_ClusterMass,   // randomization only, corrected with the max cluster mass null distribution
             Test_Dissimilarity,
 
             NumTestVariables    
             };
 
 
+                                        // Randomization cluster-forming threshold, as an uncorrected p-value
+constexpr double    RandomizationClusterAlpha   = 0.05;
+
+
 //----------------------------------------------------------------------------
 //----------------------------------------------------------------------------
                                         // Statistics utilities
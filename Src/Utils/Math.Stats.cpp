@@ -17,6 +17,9 @@ limitations under the License.
 #pragma     hdrstop
 //-=-=-=-=-=-=-=-=-
 
+#include    <algorithm>                 // nth_element
+#include    <functional>                // greater
+
 #include    "Math.Resampling.h"
 #include    "Math.Random.h"
 #include    "Math.Stats.h"
@@ -422,6 +425,24 @@ substats.Resize ( AtLeast ( samplesize, substats.MaxSize () ) );
 randindex.RandomSeries ( samplesize, NumItems, randunif );
 
                                         // copy the necessary amount of data
+for ( int i = 0; i < samplesize; i++ )
+
+    substats.Add ( Data[ randindex[ i ] ], ThreadSafetyIgnore );
+}
+
+                                        // Caller is responsible for the indexes to be within [0..NumItems)
+                                        // Drawing the random series is in O(NumItems), so with big data it pays to draw them only once for many stats of the same size
+void    TEasyStats::Resample ( TEasyStats& substats, int samplesize, const int* randindex )    const
+{
+substats.Reset ();
+
+if ( ! IsAllocated () || samplesize <= 0 || randindex == 0 )
+    return;
+
+                                        // Resize upward only, then reset
+substats.Resize ( AtLeast ( samplesize, substats.MaxSize () ) );
+
+
 for ( int i = 0; i < samplesize; i++ )
 
     substats.Add ( Data[ randindex[ i ] ], ThreadSafetyIgnore );
@@ -1067,13 +1088,26 @@ if ( NumItems == 1 )
     return  Data[ 0 ];
                                         // here at least 2 data
 
-Sort ();
-
                                         // get index to half truncated position
 int                 halfi           = ( NumItems - 1 ) / 2;
+bool                average         = ! ( strictvalue || IsOdd ( NumItems ) );
+
+
+if ( ! Sorted ) {
+                                        // Selection instead of a full sort: only the median position is put in place, in linear time
+                                        // Data is then only partially ordered, so we do not set the Sorted flag
+    float*              tobegin         = &Data[ 0 ];
+    float*              toend           = tobegin + NumItems;
+
+    std::nth_element ( tobegin, tobegin + halfi, toend, std::greater<float> () );
+                                        // with descending order, the next value is the biggest of the remaining ones
+    return  average ? ( Data[ halfi ] + *std::max_element ( tobegin + halfi + 1, toend ) ) / 2
+                    :   Data[ halfi ];
+    }
+
 
-return  strictvalue || IsOdd ( NumItems ) ?   Data[ halfi ]                             // return the exact center value, or the closest one to remain within the dataset
-                                          : ( Data[ halfi ] + Data[ halfi + 1 ] ) / 2;  // in case of even numbers, do the average between each sides - the result is NOT part of the original dataset, which sometimes could be problematic
+return  average ? ( Data[ halfi ] + Data[ halfi + 1 ] ) / 2     // in case of even numbers, do the average between each sides - the result is NOT part of the original dataset, which sometimes could be problematic
+                :   Data[ halfi ];                              // return the exact center value, or the closest one to remain within the dataset
 }
 
                                         // Do a Variance separately on right and left
@@ -2241,7 +2275,7 @@ return  maxmodeposition;
                                         // Running the most reliables Max Mode estimates
                                         // !statcenter is NOT reset NOR resized, in case user wants to cumulate results!
                                         // Also statcenter is not required to be robust / allocated
-void    TEasyStats::MaxModeRobust ( TEasyStats& statcenter )
+void    TEasyStats::MaxModeRobust ( TEasyStats& statcenter, ThreadSafety safety )
 {
 //statcenter.Resize ( AtLeast ( MaxSize (), NumMaxModeRobustEstimates ) );
 
@@ -2257,7 +2291,7 @@ if ( ! ( IsAllocated () && NumItems ) ) {
                                         // Degenerate case: all constant values
 if ( Data == Data[ 0 ] ) {
                                         // then mode is this value, no need to mingle with complex histogram
-    statcenter.Add ( Data[ 0 ] );
+    statcenter.Add ( Data[ 0 ], safety );
 
     return;
     }
@@ -2277,11 +2311,11 @@ double              c3      = MaxModeHRM ();        // not bad, but a bit on the
 double              c4      = FirstMode ( 0.50 );   // quite the best for positive data
 
 
-statcenter.Add ( c1 );
-statcenter.Add ( c2 );
-statcenter.Add ( c3 );
+statcenter.Add ( c1, safety );
+statcenter.Add ( c2, safety );
+statcenter.Add ( c3, safety );
                                         // not using this estimator if null
-if ( c4 )   statcenter.Add ( c4 );
+if ( c4 )   statcenter.Add ( c4, safety );
 
 //#endif
 
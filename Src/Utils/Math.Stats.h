@@ -144,6 +144,7 @@ public:
 
     void            Resample    ( TEasyStats& substats,  double percentage, TVector<int>& randindex, TRandUniform* randunif = 0 )   const;                 // random subsampling
     void            Resample    ( TEasyStats& substats,  int    samplesize, TVector<int>& randindex, TRandUniform* randunif = 0 )   const;                 // random subsampling
+    void            Resample    ( TEasyStats& substats,  int    samplesize, const int* randindex )                                  const;                 // subsampling from already drawn indexes, which can be shared across multiple stats
     double          Randomize   ( TEasyStatsFunctionType how, int numresampling, int samplesize, TArray1<double>* params = 0 ); // randomized function, returning the mean of all sampling
     void            KeepWithin  ( double minvalue, double maxvalue );
     void            RemoveNulls ();                 // !Sorts data!
@@ -213,7 +214,7 @@ public:
     double          MaxModeHistogram        ( THistogram* h = 0 );      // #1 estimate for all cases- Compute the histogram, then simply look for max position
     double          MaxModeHRM              ();                         // #2 estimate for 2 modes  - Done by Half Range Mode   ;HRM & HSM will asymptotically behave the same past ~128 samples
     double          MaxModeHSM              ();                         // #2 estimate for 1 mode   - Done by Half Sample Mode  ;HRM & HSM will asymptotically behave the same past ~128 samples
-    void            MaxModeRobust           ( TEasyStats& statcenter );
+    void            MaxModeRobust           ( TEasyStats& statcenter, ThreadSafety safety = ThreadSafetyCare );
     double          Qn                      ( int maxitems );           // Rousseeuw and Croux Qn for Robust Standard Deviation
     double          Quantile                ( double p );               // can return an interpolated value
     double          RobustCoV               ();                         // CoV with Median and MAD: MAD / Median
@@ -24,6 +24,8 @@ namespace crtl {
                                         // general parallel block
 #define OmpParallelBegin                __pragma( omp parallel ) {
 #define OmpParallelEnd                  }
+                                        // general parallel block, only if condition is met, otherwise the block runs serialized, in the current thread
+#define OmpParallelIfBegin(CONDITION)   __pragma( omp parallel if (CONDITION) ) {
 
                                         // Explicit list of sections
 #define OmpParallelSectionsBegin        __pragma( omp parallel sections ) {
@@ -45,6 +47,8 @@ namespace crtl {
                                         // single parallel for, WITHIN an existing parallel block
 #define OmpFor                          __pragma( omp for )
 #define OmpForSum(...)                    __pragma( omp for reduction (+:__VA_ARGS__) )
+                                        // same, but iterations are handed out on demand, for loops with uneven iterations costs
+#define OmpForDynamic                   __pragma( omp for schedule (dynamic) )
                                         // STAND-ALONE, single parallel for(s) - NOT WITHIN an existing parallel block
 #define OmpParallelFor                  __pragma( omp parallel for )
 #define OmpParallelForSum(...)          __pragma( omp parallel for reduction (+:__VA_ARGS__) )
@@ -61,6 +65,8 @@ inline int  GetNumMaxThreads()      { return  omp_get_max_threads (); }
 inline int  StepThread      ()      { return  GetNumThreads (); }
                                         // if code is inside any sort of parallel code
 inline bool IsInParallelCode()      { return  omp_in_parallel (); }
+                                        // if inner parallel blocks would spawn their own threads, instead of running serialized in the calling thread
+inline bool IsNestedParallelism ()  { return  omp_get_nested (); }
 
 
 //SYSTEM_INFO sysinfo; GetSystemInfo ( &sysinfo ); int numCPU = sysinfo.dwNumberOfProcessors;
@@ -1662,6 +1662,9 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                         ReplaceExtension ( fileout.Filename, fileout.GetExtension () );
 
 
+                                        // consecutive TFs: any temporal filter can keep its states from one TF to the next
+                        file1->SetFiltersStreaming ( true );
+
                         for ( int tf = 0; tf < numtf; tf++ ) {
 
                             file1->GetTracks ( tf, tf, eegb );
@@ -1676,6 +1679,8 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                                 else if ( tokop->Code == OpSqrt   )     fileout.Write ( sqrt ( eegb ( e , 0 ) ) );
                             }
 
+                        file1->SetFiltersStreaming ( false );
+
                         if ( file1->CanClose ( true ) )     docmanager->CloseDoc ( file1 );
                         }
 
@@ -1776,6 +1781,9 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                         ReplaceExtension ( fileout.Filename, fileout.GetExtension () );
 
 
+                                        // consecutive TFs: any temporal filter can keep its states from one TF to the next
+                        file1->SetFiltersStreaming ( true );
+
                         for ( int tf = 0; tf < numtf; tf++ ) {
 
                             if ( fileout.IsScalar ( AtomTypeUseOriginal ) ) {
@@ -1794,6 +1802,8 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                                 }
                             }
 
+                        file1->SetFiltersStreaming ( false );
+
                         if ( file1->CanClose ( true ) )     docmanager->CloseDoc ( file1 );
                         } // for file1
 
@@ -1866,6 +1876,10 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                         ReplaceExtension ( fileout.Filename, fileout.GetExtension () );
 
 
+                                        // consecutive TFs: any temporal filter can keep its states from one TF to the next
+                        file1->SetFiltersStreaming ( true );
+                        file2->SetFiltersStreaming ( true );
+
                         for ( int tf = 0; tf < numtf; tf++ ) {
 
                             if ( fileout.IsScalar ( AtomTypeUseOriginal ) ) {
@@ -1886,6 +1900,9 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                                 }
                             }
 
+                        file1->SetFiltersStreaming ( false );
+                        file2->SetFiltersStreaming ( false );
+
                         if ( file1->CanClose ( true ) )     docmanager->CloseDoc ( file1 );
                         if ( file2->CanClose ( true ) )     docmanager->CloseDoc ( file2 );
                         }
@@ -1994,6 +2011,9 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                         ReplaceExtension ( fileout.Filename, fileout.GetExtension () );
 
 
+                                        // consecutive TFs: any temporal filter can keep its states from one TF to the next
+                        file1->SetFiltersStreaming ( true );
+
                         for ( int tf = 0; tf < numtf; tf++ ) {
 
                             if ( fileout.IsScalar ( AtomTypeUseOriginal ) ) {
@@ -2010,6 +2030,8 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                                 }
                             }
 
+                        file1->SetFiltersStreaming ( false );
+
                         if ( file1->CanClose ( true ) )     docmanager->CloseDoc ( file1 );
                         } // for file1
 
@@ -2079,6 +2101,9 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                             ReplaceExtension ( fileout.Filename, fileout.GetExtension () );
 
 
+                                        // consecutive TFs: any temporal filter can keep its states from one TF to the next
+                            file2->SetFiltersStreaming ( true );
+
                             for ( int tf = 0; tf < numtf; tf++ ) {
 
                                 file2->GetTracks ( tf, tf, eegb );
@@ -2092,6 +2117,8 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                                         fileout.Write ( vec1[ sp ] );   // write vectors
                                 }
 
+                            file2->SetFiltersStreaming ( false );
+
                             if ( file2->CanClose ( true ) )     docmanager->CloseDoc ( file2 );
                             } // for file2
 
@@ -2183,6 +2210,9 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                         ReplaceExtension ( fileout.Filename, fileout.GetExtension () );
 
 
+                                        // consecutive TFs: any temporal filter can keep its states from one TF to the next
+                        file1->SetFiltersStreaming ( true );
+
                         for ( int tf = 0; tf < numtf; tf++ ) {
 
                             if ( fileout.IsScalar ( AtomTypeUseOriginal ) ) {
@@ -2199,6 +2229,8 @@ for ( int tokeni = 0; tokeni < Tokens.GetNumTokens (); tokeni++ ) {
                                 }
                             }
 
+                        file1->SetFiltersStreaming ( false );
+
                         if ( file1->CanClose ( true ) )     docmanager->CloseDoc ( file1 );
                         } // for file1
 
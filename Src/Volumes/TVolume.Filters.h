@@ -506,6 +506,9 @@ for ( int x = 0; x < Dim1; x++ ) {
 //----------------------------------------------------------------------------
                                         // Anything stat-like filter
 
+                                        // Max range of integer values for the sliding histogram engine
+constexpr int       FilterStatMaxHistogramBins  = 1 << 16;
+
                                         // Relationship of diameter to # of neighbors:
                                         //      2.00 ->  6 neighbors
                                         //      2.83 -> 18 neighbors
@@ -588,6 +591,428 @@ double              logoffset       = logfilters ? params ( FilterParamLogOffset
 
 
 //- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // Incremental engines for the most common stats:
+                                        // the spherical Kernel is split into runs along z, one per ( xk, yk ), so that sliding the Kernel
+                                        // by 1 voxel along z only needs to update both ends of each run
+struct  TKernelRun
+{
+    int             X;
+    int             Y;
+    int             Z1;
+    int             Z2;
+};
+
+std::vector<TKernelRun> kruns;
+
+for ( int xk = 0; xk < K.GetDim1 (); xk++ )
+for ( int yk = 0; yk < K.GetDim2 (); yk++ ) {
+
+    int                 z1              = -1;
+    int                 z2              = -1;
+
+    for ( int zk = 0; zk < K.GetDim3 (); zk++ )
+
+        if ( K ( xk, yk, zk ) ) {
+            if ( z1 < 0 )   z1  = zk;
+            z2  = zk;
+            }
+
+    if ( z1 >= 0 )
+        kruns.push_back ( { xk, yk, z1, z2 } );
+    } // for xk, yk
+
+
+int                 numkernel       = K.GetNumSet ();
+
+
+auto    CookResult  = [ filterresult ] ( double v ) -> double
+{
+if      ( filterresult == FilterResultNegative )    return  AtLeast ( 0.0, -v );
+else if ( filterresult == FilterResultPositive )    return  AtLeast ( 0.0,  v );
+else if ( filterresult == FilterResultAbsolute )    return  fabs ( v );
+else                                                return  v;
+};
+
+                                        // same formulas as TEasyStats without allocated data
+auto    SDFromSums  = [ numkernel ] ( double sum, double sum2 ) -> double
+{
+return  numkernel > 1 ? sqrt ( AtLeast ( 0.0, ( sum2 - Square ( sum ) / numkernel ) / ( numkernel - 1 ) ) ) : 0;
+};
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // 1) Running sums
+if ( filtertype == FilterTypeSD
+  || filtertype == FilterTypeSDInv
+  || filtertype == FilterTypeCoV
+  || filtertype == FilterTypeLogCoV
+  || filtertype == FilterTypeLogSNR
+  || filtertype == FilterTypeMeanSub
+  || filtertype == FilterTypeLogMeanSub
+  || filtertype == FilterTypeMeanDiv
+  || filtertype == FilterTypeLogMeanDiv ) {
+
+    OmpParallelFor
+
+    for ( int x = 0; x < Dim1; x++ ) {
+
+        Gauge.Next ();
+
+        for ( int y = 0; y < Dim2; y++ ) {
+
+            double              sum             = 0;
+            double              sum2            = 0;
+                                        // whole Kernel for the first voxel of the line
+            for ( const auto& kr : kruns ) {
+
+                const TypeD*        toline          = &temp ( x + kr.X, y + kr.Y, 0 );
+
+                for ( int zk = kr.Z1; zk <= kr.Z2; zk++ ) {
+                    sum    +=          toline[ zk ];
+                    sum2   += Square ( (double) toline[ zk ] );
+                    }
+                }
+
+
+            for ( int z = 0; z < Dim3; z++ ) {
+                                        // slide: remove the first voxel of each run, add the one just after its end
+                if ( z > 0 )
+
+                    for ( const auto& kr : kruns ) {
+
+                        const TypeD*        toline          = &temp ( x + kr.X, y + kr.Y, 0 );
+                        double              vout            = toline[ z - 1 + kr.Z1 ];
+                        double              vin             = toline[ z     + kr.Z2 ];
+
+                        sum    += vin - vout;
+                        sum2   += Square ( vin ) - Square ( vout );
+                        }
+
+
+                double              avg             = sum / numkernel;
+                double              sd              = SDFromSums ( sum, sum2 );
+                double              c               = GetValue ( x, y, z );
+                double              v;
+
+                if      ( filtertype == FilterTypeSD            )   v   = sd;
+                else if ( filtertype == FilterTypeSDInv         )   v   = sd != 0 ? NoMore ( 1e10, 1 / sd ) : 0;
+                else if ( filtertype == FilterTypeCoV           )   v   = avg ? sd / avg : 0;
+                else if ( filtertype == FilterTypeLogCoV        )   v   = Log10 ( ( logoffset + sd ) / ( logoffset + avg ) );
+                else if ( filtertype == FilterTypeLogSNR        )   v   = Log10 ( logoffset + ( sd ? avg / sd : 0 ) );
+                else if ( filtertype == FilterTypeMeanSub       )   v   = c - avg;
+                else if ( filtertype == FilterTypeLogMeanSub    )   v   = Log10 ( logoffset + fabs ( c - avg ) );
+                else if ( filtertype == FilterTypeMeanDiv       )   v   = c / NonNull ( avg );
+                else  /*( filtertype == FilterTypeLogMeanDiv    )*/ v   = Log10 ( ( logoffset + c ) / ( logoffset + avg ) );
+
+                GetValue ( x, y, z )    = (TypeD) CookResult ( v );
+                } // for z
+            } // for y
+        } // for x
+
+    return;
+    }
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // 2) Min / Max: each run of length L is a 1D window along z, for which the min / max is computed
+                                        // for all lines at once with the van Herk / Gil-Werman algorithm, in only 3 comparisons per voxel
+if ( filtertype == FilterTypeMin
+  || filtertype == FilterTypeMax
+  || filtertype == FilterTypeMinMax
+  || filtertype == FilterTypeRange ) {
+
+    bool                needmin         = filtertype != FilterTypeMax;
+    bool                needmax         = filtertype != FilterTypeMin;
+    int                 tempdim3        = temp.GetDim3 ();
+
+    TVolume<TypeD>      kmin;
+    TVolume<TypeD>      kmax;
+    TVolume<TypeD>      slidemin;
+    TVolume<TypeD>      slidemax;
+
+    if ( needmin ) {
+        kmin    .Resize ( Dim1, Dim2, Dim3 );
+        slidemin.Resize ( temp.GetDim1 (), temp.GetDim2 (), tempdim3 );
+
+        for ( int i = 0; i < (int) kmin.GetLinearDim (); i++ )
+            kmin[ i ]   = Highest<TypeD> ();
+        }
+
+    if ( needmax ) {
+        kmax    .Resize ( Dim1, Dim2, Dim3 );
+        slidemax.Resize ( temp.GetDim1 (), temp.GetDim2 (), tempdim3 );
+
+        for ( int i = 0; i < (int) kmax.GetLinearDim (); i++ )
+            kmax[ i ]   = Lowest<TypeD> ();
+        }
+
+                                        // all distinct runs lengths
+    for ( int L = 1; L <= K.GetDim3 (); L++ ) {
+
+        bool                haslength       = false;
+
+        for ( const auto& kr : kruns )
+            haslength  |= kr.Z2 - kr.Z1 + 1 == L;
+
+        if ( ! haslength )
+            continue;
+
+                                        // sliding min / max of length L along each line of temp
+        OmpParallelBegin
+
+        TArray1<TypeD>      gmin ( needmin ? tempdim3 : 0 );
+        TArray1<TypeD>      hmin ( needmin ? tempdim3 : 0 );
+        TArray1<TypeD>      gmax ( needmax ? tempdim3 : 0 );
+        TArray1<TypeD>      hmax ( needmax ? tempdim3 : 0 );
+
+        OmpFor
+
+        for ( int xt = 0; xt < temp.GetDim1 (); xt++ )
+        for ( int yt = 0; yt < temp.GetDim2 (); yt++ ) {
+
+            const TypeD*        toline          = &temp ( xt, yt, 0 );
+
+            if ( needmin ) {
+                                        // forward cumulative min within blocks of L, then backward
+                for ( int z = 0; z < tempdim3; z++ )
+                    gmin[ z ]   = z % L == 0                        ? toline[ z ] : min ( gmin[ z - 1 ], toline[ z ] );
+
+                for ( int z = tempdim3 - 1; z >= 0; z-- )
+                    hmin[ z ]   = z == tempdim3 - 1 || ( z + 1 ) % L == 0 ? toline[ z ] : min ( hmin[ z + 1 ], toline[ z ] );
+
+                TypeD*              toslide         = &slidemin ( xt, yt, 0 );
+
+                for ( int z = 0; z <= tempdim3 - L; z++ )
+                    toslide[ z ]    = min ( hmin[ z ], gmin[ z + L - 1 ] );
+                }
+
+            if ( needmax ) {
+
+                for ( int z = 0; z < tempdim3; z++ )
+                    gmax[ z ]   = z % L == 0                        ? toline[ z ] : max ( gmax[ z - 1 ], toline[ z ] );
+
+                for ( int z = tempdim3 - 1; z >= 0; z-- )
+                    hmax[ z ]   = z == tempdim3 - 1 || ( z + 1 ) % L == 0 ? toline[ z ] : max ( hmax[ z + 1 ], toline[ z ] );
+
+                TypeD*              toslide         = &slidemax ( xt, yt, 0 );
+
+                for ( int z = 0; z <= tempdim3 - L; z++ )
+                    toslide[ z ]    = max ( hmax[ z ], gmax[ z + L - 1 ] );
+                }
+            } // for xt, yt
+
+        OmpParallelEnd
+
+                                        // merging all the runs of length L
+        OmpParallelFor
+
+        for ( int x = 0; x < Dim1; x++ )
+        for ( int y = 0; y < Dim2; y++ )
+        for ( const auto& kr : kruns ) {
+
+            if ( kr.Z2 - kr.Z1 + 1 != L )
+                continue;
+
+            if ( needmin ) {
+                const TypeD*        toslide         = &slidemin ( x + kr.X, y + kr.Y, kr.Z1 );
+                TypeD*              tomin           = &kmin     ( x, y, 0 );
+
+                for ( int z = 0; z < Dim3; z++ )
+                    Mined ( tomin[ z ], toslide[ z ] );
+                }
+
+            if ( needmax ) {
+                const TypeD*        toslide         = &slidemax ( x + kr.X, y + kr.Y, kr.Z1 );
+                TypeD*              tomax           = &kmax     ( x, y, 0 );
+
+                for ( int z = 0; z < Dim3; z++ )
+                    Maxed ( tomax[ z ], toslide[ z ] );
+                }
+            } // for x, y, run
+        } // for L
+
+
+    OmpParallelFor
+
+    for ( int x = 0; x < Dim1; x++ ) {
+
+        Gauge.Next ();
+
+        for ( int y = 0; y < Dim2; y++ )
+        for ( int z = 0; z < Dim3; z++ ) {
+
+            double              vmin            = needmin ? kmin ( x, y, z ) : 0;
+            double              vmax            = needmax ? kmax ( x, y, z ) : 0;
+            double              v;
+
+            if      ( filtertype == FilterTypeMin       )   v   = vmin;
+            else if ( filtertype == FilterTypeMax       )   v   = vmax;
+            else if ( filtertype == FilterTypeRange     )   v   = vmax - vmin;
+            else  /*( filtertype == FilterTypeMinMax    )*/ v   = GetValue ( x, y, z ) <= ( vmin + vmax ) / 2 ? vmin : vmax;
+
+            GetValue ( x, y, z )    = (TypeD) CookResult ( v );
+            } // for y, z
+        } // for x
+
+    return;
+    }
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // 3) Median / MAD on quantized data: sliding histogram with a running median (Huang / Perreault)
+                                        // Kernel has an odd number of voxels, so that the median is always an exact data value
+if ( ( filtertype == FilterTypeMedian
+    || filtertype == FilterTypeMAD
+    || filtertype == FilterTypeMCoV
+    || filtertype == FilterTypeMADSDInv )
+  && IsOdd ( numkernel ) ) {
+                                        // data has to be integer, within a reasonable range
+    double              tempmin         = Highest<double> ();
+    double              tempmax         = Lowest <double> ();
+    bool                quantized       = true;
+
+    for ( int i = 0; i < (int) temp.GetLinearDim () && quantized; i++ ) {
+
+        double              v               = temp[ i ];
+
+        quantized   = v == floor ( v );
+
+        Mined ( tempmin, v );
+        Maxed ( tempmax, v );
+        }
+
+
+    if ( quantized && tempmax - tempmin < FilterStatMaxHistogramBins ) {
+
+        int                 histooffset     = - (int) tempmin;
+        int                 numbins         = (int) ( tempmax - tempmin ) + 1;
+        int                 halfi           = numkernel / 2;
+        bool                needmad         = filtertype != FilterTypeMedian;
+
+
+        OmpParallelBegin
+
+        TArray1<int>        histo ( numbins );
+
+        OmpFor
+
+        for ( int x = 0; x < Dim1; x++ ) {
+
+            Gauge.Next ();
+
+            for ( int y = 0; y < Dim2; y++ ) {
+
+                double              sum             = 0;
+                double              sum2            = 0;
+                int                 medbin          = 0;
+                int                 below           = 0;    // number of values in the bins below medbin
+
+
+                auto    AddValue    = [ & ] ( double v, int count )
+                {
+                int                 bin             = (int) v + histooffset;
+
+                histo[ bin ]   += count;
+
+                if ( bin < medbin )
+                    below  += count;
+
+                sum    += count *          v;
+                sum2   += count * Square ( v );
+                };
+
+                                        // whole Kernel for the first voxel of the line
+                for ( const auto& kr : kruns ) {
+
+                    const TypeD*        toline          = &temp ( x + kr.X, y + kr.Y, 0 );
+
+                    for ( int zk = kr.Z1; zk <= kr.Z2; zk++ )
+                        AddValue ( toline[ zk ], 1 );
+                    }
+
+
+                for ( int z = 0; z < Dim3; z++ ) {
+
+                    if ( z > 0 )
+
+                        for ( const auto& kr : kruns ) {
+
+                            const TypeD*        toline          = &temp ( x + kr.X, y + kr.Y, 0 );
+
+                            AddValue ( toline[ z - 1 + kr.Z1 ], -1 );
+                            AddValue ( toline[ z     + kr.Z2 ],  1 );
+                            }
+
+                                        // move the median bin until it contains the value of rank halfi
+                    while ( below > halfi ) {
+                        medbin--;
+                        below  -= histo[ medbin ];
+                        }
+
+                    while ( below + histo[ medbin ] <= halfi ) {
+                        below  += histo[ medbin ];
+                        medbin++;
+                        }
+
+                    double              median          = medbin - histooffset;
+                    double              mad             = 0;
+
+                                        // median of the absolute deviations, by growing a symmetrical range of bins around the median
+                    if ( needmad ) {
+
+                        int                 count           = histo[ medbin ];
+                        int                 d               = 0;
+
+                        while ( count <= halfi ) {
+
+                            d++;
+
+                            if ( medbin - d >= 0      )     count  += histo[ medbin - d ];
+                            if ( medbin + d < numbins )     count  += histo[ medbin + d ];
+                            }
+                                        // rescaling to be an unbiased estimator of standard deviation sigma
+                        mad     = d * MADToSigma;
+                        }
+
+
+                    double              v;
+
+                    if      ( filtertype == FilterTypeMedian    )   v   = median;
+                    else if ( filtertype == FilterTypeMAD       )   v   = mad;
+                    else if ( filtertype == FilterTypeMCoV      )   v   = median ? mad / median : 0;
+                    else { // FilterTypeMADSDInv
+                        double  sd  = SDFromSums ( sum, sum2 );
+
+                        v   = mad * sd;
+
+                        v   = v  != 0 ? NoMore ( 1e10, 1 / sqrt ( v ) )
+                            : sd != 0 ? NoMore ( 1e10, 1 / sd )
+                            :           0;
+                        }
+
+                    GetValue ( x, y, z )    = (TypeD) CookResult ( v );
+                    } // for z
+
+                                        // empty the histogram for the next line, by removing the last Kernel
+                for ( const auto& kr : kruns ) {
+
+                    const TypeD*        toline          = &temp ( x + kr.X, y + kr.Y, 0 );
+
+                    for ( int zk = Dim3 - 1 + kr.Z1; zk <= Dim3 - 1 + kr.Z2; zk++ )
+                        histo[ (int) toline[ zk ] + histooffset ]--;
+                    }
+                } // for y
+            } // for x
+
+        OmpParallelEnd
+
+        return;
+        } // quantized
+    }
+
+
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // All other stats: full Kernel scan for each voxel
 
 OmpParallelBegin
                                         // private variables
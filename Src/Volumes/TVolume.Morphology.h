@@ -21,116 +21,181 @@ namespace crtl {
 //----------------------------------------------------------------------------
 // Implementation
 //----------------------------------------------------------------------------
-                                        // Dilate & Erode are very similar
+                                        // 1D squared Euclidean distance transform of the sampled function f, computed as the lower envelope of the parabolas rooted at each sample
+                                        // Felzenszwalb, Huttenlocher "Distance Transforms of Sampled Functions" - linear time
+                                        // envv and envz are working buffers of at least n and n + 1 elements
+inline  void    SquaredDistanceTransform1D  ( const double* f, int n, double* d, int* envv, double* envz )
+{
+int                 k               = 0;
+double              s;
+
+envv[ 0 ]   = 0;
+envz[ 0 ]   = -DBL_MAX;
+envz[ 1 ]   =  DBL_MAX;
+
+                                        // building the lower envelope
+for ( int q = 1; q < n; q++ ) {
+                                        // intersection with the rightmost parabola so far, which is dropped if it becomes hidden
+    do {
+        s   = ( ( f[ q ] + Square ( (double) q ) ) - ( f[ envv[ k ] ] + Square ( (double) envv[ k ] ) ) ) / ( 2.0 * ( q - envv[ k ] ) );
+
+        if ( s <= envz[ k ] )   k--;
+        else                    break;
+
+        } while ( true );
+
+    k++;
+    envv[ k     ]   = q;
+    envz[ k     ]   = s;
+    envz[ k + 1 ]   = DBL_MAX;
+    }
+
+                                        // then reading the envelope
+k   = 0;
+
+for ( int q = 0; q < n; q++ ) {
+
+    while ( envz[ k + 1 ] < q )
+        k++;
+
+    d[ q ]  = Square ( (double) ( q - envv[ k ] ) ) + f[ envv[ k ] ];
+    }
+}
+
+
+//----------------------------------------------------------------------------
+                                        // Exact squared Euclidean distances, done separably along each axis, each line being independent
+                                        // Distances are from all voxels to the nearest data voxel, or to the nearest background voxel
+                                        // Outside of the volume counts as background, so it is a feature only when computing the distance to background
+                                        // Saturating the distances above maxdist keeps the values small, while all distances up to maxdist remain exact
 template <class TypeD>
-void    TVolume<TypeD>::FilterDilateErode   ( FctParams& params, bool dilate, bool showprogress )
+void    TVolume<TypeD>::SquaredDistanceTransform ( TVolume<float>& dist2, bool tobackground, double maxdist, bool showprogress )    const
 {
-double              diameter        = params ( FilterParamDiameter );
-bool                erode           = ! dilate;
+dist2.Resize ( Dim1, Dim2, Dim3 );
 
-if ( diameter < 1 )                     // needs at least 1 voxel of element size
+if ( IsNotAllocated () )
     return;
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // create Kernel mask, any size will do, though it is slightly better to be an odd number
-TVolume<uchar>      K      ( diameter, AnySize );
-TPointDouble        Ko     ( K.GetDim1 () / 2.0 - 0.5, K.GetDim2 () / 2.0 - 0.5, K.GetDim3 () / 2.0 - 0.5 );
-                                                               // if even, add the distance from center to corner (1,1,1)
-double              r2              = Square ( diameter / 2 ) + ( IsEven ( K.GetDim1 () ) ? 3 * Square ( 0.5 ) : 0 ) + SingleFloatEpsilon;
-TPointDouble        kp;
-
-
-                                        // compute the Kernel
-for ( int xk = 0; xk < K.GetDim1 (); xk++ )
-for ( int yk = 0; yk < K.GetDim2 (); yk++ )
-for ( int zk = 0; zk < K.GetDim3 (); zk++ ) {
-
-    kp.Set ( xk - Ko.X, yk - Ko.Y, zk - Ko.Z );
-                                        // clip Kernel outside Euclidian norm!
-    K ( xk, yk, zk )    = kp.Norm2 () <= r2;
-    }
+double              fardist2        = Square ( maxdist ) + 1;
+double              borderdist2     = tobackground ? 0 : fardist2;
+int                 maxdim          = max ( Dim1, Dim2, Dim3 );
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // create the border of the Kernel, to directly test neighbors
-                                        // this is done by computing the real radius -> better detection
-TVolume<uchar>      Kborder  ( K.GetDim1 () + 2, K.GetDim2 () + 2, K.GetDim3 () + 2 );
-TPointDouble        Kbordero ( Ko.X + 1, Ko.Y + 1, Ko.Z + 1 );
+TSuperGauge         Gauge ( "Distance Transform", showprogress );
+
+
+OmpParallelBegin
+                                        // here we know the actual number of threads
+if ( showprogress )
+    Gauge.SetRange ( 0, 3 * GetNumThreads () );
+
+                                        // lines have 1 extra sample on each side, for the outside of the volume
+TArray1<double>     f       ( maxdim + 2 );
+TArray1<double>     d       ( maxdim + 2 );
+TArray1<int>        envv    ( maxdim + 2 );
+TArray1<double>     envz    ( maxdim + 3 );
+
 
-double              rborder2        = Square ( ( diameter + 1 ) / 2 ) + ( IsEven ( K.GetDim1 () ) ? 3 * Square ( 0.5 ) : 0 ) + SingleFloatEpsilon;
+Gauge.Next ();
+                                        // 1) along z, the contiguous axis, from the data themselves
+OmpFor
 
-                                        // compute the Kernel border
-for ( int xk = 0; xk < Kborder.GetDim1 (); xk++ )
-for ( int yk = 0; yk < Kborder.GetDim2 (); yk++ )
-for ( int zk = 0; zk < Kborder.GetDim3 (); zk++ ) {
+for ( int x = 0; x < Dim1; x++ )
+for ( int y = 0; y < Dim2; y++ ) {
 
-    kp.Set ( xk - Kbordero.X, yk - Kbordero.Y, zk - Kbordero.Z );
+    f[ 0 ]  = f[ Dim3 + 1 ] = borderdist2;
 
-    Kborder ( xk, yk, zk )  = fabs ( kp.Norm2 () - rborder2 ) <= 1.01
-                          && ! K.GetValueChecked ( xk - 1, yk - 1, zk - 1 );
+    for ( int z = 0; z < Dim3; z++ )
+                                        // feature voxels are at distance 0
+        f[ z + 1 ]  = ( GetValue ( x, y, z ) != 0 ) != tobackground ? 0 : fardist2;
+
+    SquaredDistanceTransform1D ( f.GetArray (), Dim3 + 2, d.GetArray (), envv.GetArray (), envz.GetArray () );
+
+    for ( int z = 0; z < Dim3; z++ )
+        dist2 ( x, y, z )   = NoMore ( fardist2, d[ z + 1 ] );
     }
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
-                                        // give more room: Kernel size + 1 neighbor test
-TPointInt           Kshift ( K.GetDim1 () + 1, K.GetDim2 () + 1, K.GetDim3 () + 1 );
-TPointDouble        Koi    ( K.GetDim1 () / 2, K.GetDim2 () / 2, K.GetDim3 () / 2 );
+Gauge.Next ();
+                                        // 2) along y
+OmpFor
 
+for ( int x = 0; x < Dim1; x++ )
+for ( int z = 0; z < Dim3; z++ ) {
 
-                                        // we need a cloned temp array, which includes a safety border,
-                                        // as we're going to punch a whole Kernel into the data, so it is modified "in advance"
-TVolume<TypeD>      orig ( Dim1 + Kshift.X * 2, Dim2 + Kshift.Y * 2, Dim3 + Kshift.Z * 2 );
+    f[ 0 ]  = f[ Dim2 + 1 ] = borderdist2;
 
-orig.Insert ( *this, Kshift );
+    for ( int y = 0; y < Dim2; y++ )
+        f[ y + 1 ]  = dist2 ( x, y, z );
 
+    SquaredDistanceTransform1D ( f.GetArray (), Dim2 + 2, d.GetArray (), envv.GetArray (), envz.GetArray () );
 
-TypeD               newvalue        = dilate ? GetMaxValue () : 0;
+    for ( int y = 0; y < Dim2; y++ )
+        dist2 ( x, y, z )   = NoMore ( fardist2, d[ y + 1 ] );
+    }
 
 
-//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+Gauge.Next ();
+                                        // 3) along x
+OmpFor
 
-TSuperGauge         Gauge ( FilterPresets[ dilate ? FilterTypeDilate : FilterTypeErode ].Text, showprogress ? orig.GetDim1 () - 2 * Kshift.X : 0 );
+for ( int y = 0; y < Dim2; y++ )
+for ( int z = 0; z < Dim3; z++ ) {
+
+    f[ 0 ]  = f[ Dim1 + 1 ] = borderdist2;
+
+    for ( int x = 0; x < Dim1; x++ )
+        f[ x + 1 ]  = dist2 ( x, y, z );
+
+    SquaredDistanceTransform1D ( f.GetArray (), Dim1 + 2, d.GetArray (), envv.GetArray (), envz.GetArray () );
+
+    for ( int x = 0; x < Dim1; x++ )
+        dist2 ( x, y, z )   = NoMore ( fardist2, d[ x + 1 ] );
+    }
+
+OmpParallelEnd
+}
 
-                                        // Progress bar goes to the roof for erode, as the first thread gets the first slice of MRI, which is often empty, so its processing ends quite quickly
-OmpParallelFor
 
-for ( int x = Kshift.X; x < orig.GetDim1 () - Kshift.X; x++ ) {
+//----------------------------------------------------------------------------
+                                        // Dilate & Erode are very similar
+                                        // Equivalent to rolling a spherical Kernel of the given diameter along the borders of the data, which then extends (dilate) or removes (erode)
+                                        // the data up to this diameter, plus half a voxel from the discrete border
+                                        // Computed from the distance transform, so the cost does not depend on the diameter anymore
+template <class TypeD>
+void    TVolume<TypeD>::FilterDilateErode   ( FctParams& params, bool dilate, bool showprogress )
+{
+double              diameter        = params ( FilterParamDiameter );
+bool                erode           = ! dilate;
 
-    Gauge.Next ();
+if ( diameter < 1 )                     // needs at least 1 voxel of element size
+    return;
 
 
-    for ( int y = Kshift.Y; y < orig.GetDim2 () - Kshift.Y; y++ )
-    for ( int z = Kshift.Z; z < orig.GetDim3 () - Kshift.Z; z++ ) {
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+                                        // dilate: distance from data - erode: distance from background
+double              maxdist         = diameter + 0.5;
+TVolume<float>      dist2;
 
-                                        // Center - dilate: look for empty voxel - erode: look for non-empty voxel
-        if ( dilate &&   orig ( x, y, z )
-          || erode  && ! orig ( x, y, z ) )
-            continue;
+SquaredDistanceTransform ( dist2, erode, maxdist, showprogress );
 
-                                        // check Kernel border
-        for ( int xki = 0, xk = x - (int) Koi.X - 1; xki < Kborder.GetDim1 (); xki++, xk++ )
-        for ( int yki = 0, yk = y - (int) Koi.Y - 1; yki < Kborder.GetDim2 (); yki++, yk++ )
-        for ( int zki = 0, zk = z - (int) Koi.Z - 1; zki < Kborder.GetDim3 (); zki++, zk++ )
 
-            if ( Kborder ( xki, yki, zki ) && ( dilate &&   orig ( xk, yk, zk )
-                                             || erode  && ! orig ( xk, yk, zk ) ) )
-                goto breakloops;
-                                        // reaching that point means Kernel does not touch anything
-        continue;
+//- - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - - -
+
+double              maxdist2        = Square ( maxdist );
+TypeD               newvalue        = dilate ? GetMaxValue () : 0;
 
 
-        breakloops:
-                                        // punch in the FULL mask
-        for ( int xki = 0, xk = x - (int) Koi.X - Kshift.X; xki < K.GetDim1 () && xk >= 0 && xk < Dim1; xki++, xk++ )
-        for ( int yki = 0, yk = y - (int) Koi.Y - Kshift.Y; yki < K.GetDim2 () && yk >= 0 && yk < Dim2; yki++, yk++ )
-        for ( int zki = 0, zk = z - (int) Koi.Z - Kshift.Z; zki < K.GetDim3 () && zk >= 0 && zk < Dim3; zki++, zk++ )
+OmpParallelFor
 
-            if ( K ( xki, yki, zki ) )
+for ( int i = 0; i < LinearDim; i++ )
+                                        // dilate: filling empty voxels close to the data - erode: clearing data voxels close to the background
+    if ( dist2[ i ] <= maxdist2
+      && ( dilate && ! Array[ i ]
+        || erode  &&   Array[ i ] ) )
 
-                GetValue ( xk, yk, zk ) = newvalue;
-        } // for y, z
-    } // for x
+        Array[ i ]  = newvalue;
 }
 
 
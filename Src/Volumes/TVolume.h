@@ -511,6 +511,7 @@ protected:
     void            FilterHistoEquBrain ( FctParams& params, bool showprogress = false );
     void            FilterHistoCompact  ( FctParams& params, bool showprogress = false );
 
+    void            SquaredDistanceTransform ( TVolume<float>& dist2, bool tobackground, double maxdist, bool showprogress = false )  const;  // exact Euclidean distances, in voxels, to the nearest data (or background) voxel - saturated above maxdist
     void            FilterDilateErode   ( FctParams& params, bool dilate, bool showprogress );
     void            FilterErode         ( FctParams& params, bool showprogress = false );
     void            FilterDilate        ( FctParams& params, bool showprogress = false );